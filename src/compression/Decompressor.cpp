@@ -59,7 +59,7 @@ Decompressor::Decompressor(const PPSystemString& fileName) :
 	adjustFilenames(fileName);
 }
 	
-bool Decompressor::identify(XMFile& f)
+bool Decompressor::identify(XMFileBase& f)
 {
 	for (pp_int32 i = 0; i < decompressors.size(); i++)
 	{
@@ -114,23 +114,25 @@ const PPSimpleVector<Descriptor>& Decompressor::getDescriptors(Hints hint) const
 	return descriptors;
 }
 	
-bool Decompressor::decompress(const PPSystemString& outFileName, Hints hint)
+bool Decompressor::decompress(XMFileBase& outFile, Hints hint)
 {
-	bool result = false;
+	const pp_uint32 startPos = outFile.pos();
+
 	for (pp_int32 i = 0; i < decompressors.size(); i++)
 	{
 		if (decompressors.get(i)->identify())
 		{
-			result = decompressors.get(i)->decompress(outFileName, hint);
-			if (result)
-				break;
+			if (decompressors.get(i)->decompress(outFile, hint))
+				return true;
+			
+			// the stream can't be rewound, if anything has been written
+			// it's not safe to let the next decompressor append to it
+			if (outFile.pos() != startPos)
+				return false;
 		}
 	}
 	
-	if (!result)
-		removeFile(outFileName);
-	
-	return result;
+	return false;
 }
 
 DecompressorBase* Decompressor::clone()
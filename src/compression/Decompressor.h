@@ -34,7 +34,7 @@
 #include "BasicTypes.h"
 #include "SimpleVector.h"
 
-class XMFile;
+class XMFileBase;
 
 class DecompressorBase
 {
@@ -58,7 +58,7 @@ public:
 	{
 	}
 	
-	virtual bool identify(XMFile& f) = 0;
+	virtual bool identify(XMFileBase& f) = 0;
 
 	virtual bool identify();
 	
@@ -66,7 +66,8 @@ public:
 	
 	virtual const PPSimpleVector<Descriptor>& getDescriptors(Hints hint) const = 0;
 	
-	virtual bool decompress(const PPSystemString& outFileName, Hints hint) = 0;
+	// decompressed data is written to the current position of the given stream
+	virtual bool decompress(XMFileBase& outFile, Hints hint) = 0;
 	
 	static void removeFile(const PPSystemString& fileName);
 	
@@ -88,13 +89,13 @@ class Decompressor : public DecompressorBase
 public:
 	Decompressor(const PPSystemString& fileName);
 
-	virtual bool identify(XMFile& f);
+	virtual bool identify(XMFileBase& f);
 	
 	virtual bool doesServeHint(Hints hint);
 	
 	virtual const PPSimpleVector<Descriptor>& getDescriptors(Hints hint) const;
 
-	virtual bool decompress(const PPSystemString& outFileName, Hints hint);
+	virtual bool decompress(XMFileBase& outFile, Hints hint);
 	
 	virtual DecompressorBase* clone();
 
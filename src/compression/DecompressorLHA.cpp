@@ -37,7 +37,7 @@
 class XMFileStreamer : public CLhaArchive::StreamerBase
 {
 private:
-	XMFile& f;
+	XMFileBase& f;
 
 	pp_uint32 currentPos;
 
@@ -61,7 +61,7 @@ protected:
 	}
 
 public:		
-	XMFileStreamer(XMFile& f) :
+	XMFileStreamer(XMFileBase& f) :
 		f(f)
 	{
 		currentPos = f.pos();
@@ -100,7 +100,7 @@ DecompressorLHA::DecompressorLHA(const PPSystemString& filename) :
 {
 }
 
-bool DecompressorLHA::identify(XMFile& f)
+bool DecompressorLHA::identify(XMFileBase& f)
 {
 	f.seek(0);	
 
@@ -120,7 +120,7 @@ const PPSimpleVector<Descriptor>& DecompressorLHA::getDescriptors(Hints hint) co
 	return descriptors;
 }		
 	
-bool DecompressorLHA::decompress(const PPSystemString& outFilename, Hints hint)
+bool DecompressorLHA::decompress(XMFileBase& outFile, Hints hint)
 {
 	XMFile f(fileName);
 	
@@ -143,7 +143,6 @@ bool DecompressorLHA::decompress(const PPSystemString& outFilename, Hints hint)
 		const char* id = XModule::identifyModule(archive.GetOutputFile());
 		if (id)
 		{
-			XMFile outFile(outFilename, true);
 			if (!outFile.isOpenForWriting())
 				return false;
 				
@@ -41,14 +41,14 @@ class DecompressorLHA : public DecompressorBase
 public:
 	DecompressorLHA(const PPSystemString& filename);
 
-	virtual bool identify(XMFile& f);
+	virtual bool identify(XMFileBase& f);
 	
 	// this type of archive only contain modules
 	virtual bool doesServeHint(Hints hint) { return (hint == HintAll || hint == HintModules); }
 	
 	virtual const PPSimpleVector<Descriptor>& getDescriptors(Hints hint) const;
 
-	virtual bool decompress(const PPSystemString& outFilename, Hints hint);
+	virtual bool decompress(XMFileBase& outFile, Hints hint);
 	
 	virtual DecompressorBase* clone();
 };
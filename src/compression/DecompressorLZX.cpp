@@ -36,13 +36,12 @@
 
 struct ModuleIdentificator : public Unlzx::FileIdentificator 
 {
-	virtual bool identify(const PPSystemString& filename) const
+	virtual bool identify(XMFileBase& file) const
 	{
-		XMFile file(filename);
-		
 		mp_ubyte buff[XModule::IdentificationBufferSize];
 		memset(buff, 0, sizeof(buff));
 
+		file.seek(0);
 		file.read(buff, 1, sizeof(buff));
 		
 		return XModule::identifyModule(buff) != NULL;
@@ -54,7 +53,7 @@ DecompressorLZX::DecompressorLZX(const PPSystemString& filename) :
 {
 }
 
-bool DecompressorLZX::identify(XMFile& f)
+bool DecompressorLZX::identify(XMFileBase& f)
 {
 	f.seek(0);	
 
@@ -72,7 +71,7 @@ const PPSimpleVector<Descriptor>& DecompressorLZX::getDescriptors(Hints hint) co
 	return descriptors;
 }		
 	
-bool DecompressorLZX::decompress(const PPSystemString& outFilename, Hints hint)
+bool DecompressorLZX::decompress(XMFileBase& outFile, Hints hint)
 {
 	// If client requests something else than a module we can't deal we that
 	if (hint != HintAll &&
@@ -82,7 +81,7 @@ bool DecompressorLZX::decompress(const PPSystemString& outFilename, Hints hint)
 	ModuleIdentificator identificator;
 	Unlzx unlzx(fileName, &identificator);
 	
-	return unlzx.extractFile(true, &outFilename);
+	return unlzx.extractFile(true, &outFile);
 }
 
 DecompressorBase* DecompressorLZX::clone()
@@ -38,7 +38,7 @@ DecompressorPP20::DecompressorPP20(const PPSystemString& fileName) :
 {
 }
 
-bool DecompressorPP20::identify(XMFile& f)
+bool DecompressorPP20::identify(XMFileBase& f)
 {
 	f.seek(0);
 	mp_dword id = f.readDword();
@@ -54,7 +54,7 @@ const PPSimpleVector<Descriptor>& DecompressorPP20::getDescriptors(Hints hint) c
 	return descriptors;
 }	
 	
-bool DecompressorPP20::decompress(const PPSystemString& outFileName, Hints hint)
+bool DecompressorPP20::decompress(XMFileBase& outFile, Hints hint)
 {
 	XMFile f(fileName);	
 	unsigned int size = f.size();
@@ -70,8 +70,6 @@ bool DecompressorPP20::decompress(const PPSystemString& outFileName, Hints hint)
 		return false;
 	}
 	
-	XMFile fOut(outFileName, true);
-
 	pp_uint8* outBuffer = NULL;
 	 
 	unsigned resultSize = pp20.decompress(buffer, size, &outBuffer);
@@ -83,7 +81,7 @@ bool DecompressorPP20::decompress(const PPSystemString& outFileName, Hints hint)
 	if (resultSize == 0)
 		return false;
 
-	fOut.write(outBuffer, 1, resultSize);
+	outFile.write(outBuffer, 1, resultSize);
 
 	delete[] outBuffer;
 
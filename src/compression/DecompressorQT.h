@@ -44,14 +44,14 @@ class DecompressorQT : public DecompressorBase
 public:
 	DecompressorQT(const PPSystemString& filename);
 
-	virtual bool identify(XMFile& f);
+	virtual bool identify(XMFileBase& f);
 	
 	// this type of archive can only contain samples
 	virtual bool doesServeHint(Hints hint) { return (hint == HintAll || hint == HintSamples); }
 
 	virtual const PPSimpleVector<Descriptor>& getDescriptors(Hints hint) const;
 
-	virtual bool decompress(const PPSystemString& outFilename, Hints hint);
+	virtual bool decompress(XMFileBase& outFile, Hints hint);
 	
 	virtual DecompressorBase* clone();
 };
@@ -43,7 +43,7 @@ DecompressorQT::DecompressorQT(const PPSystemString& filename) :
 {
 }
 
-bool DecompressorQT::identify(XMFile& f)
+bool DecompressorQT::identify(XMFileBase& f)
 {
 	bool res = false;
 
@@ -90,7 +90,7 @@ const PPSimpleVector<Descriptor>& DecompressorQT::getDescriptors(Hints hint) con
 	return descriptors;
 }	
 	
-bool DecompressorQT::decompress(const PPSystemString& outFilename, Hints hint)
+bool DecompressorQT::decompress(XMFileBase& outFile, Hints hint)
 {
 	// If client requests something else than a sample we can't deal we that
 	if (hint != HintAll &&
@@ -112,11 +112,20 @@ bool DecompressorQT::decompress(const PPSystemString& outFilename, Hints hint)
 	
 		if (TRUE == [[movie attributeForKey:QTMovieHasAudioAttribute] boolValue]) 
 		{
-			OSStatus err = [aiffWriter exportFromMovie:movie toFile:[NSString stringWithUTF8String:outFilename]];
+			// QTKit can only export into a file, copy that into the stream
+			NSString* tempFile = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSProcessInfo processInfo] globallyUniqueString]];
+			OSStatus err = [aiffWriter exportFromMovie:movie toFile:tempFile];
 			if (err != noErr)
 			{
 				res = false;
 			}
+			else
+			{
+				NSData* data = [NSData dataWithContentsOfFile:tempFile];
+				res = data != nil && 
+					outFile.write([data bytes], 1, [data length]) == (mp_sint32)[data length];
+			}
+			[[NSFileManager defaultManager] removeItemAtPath:tempFile error:nil];
 		} 
 		else 
 		{
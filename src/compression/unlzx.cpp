@@ -610,21 +610,56 @@ void Unlzx::decrunch(struct UnLZX *unlzx)
 	unlzx->global_shift = shift;
 }
 
-XMFile* Unlzx::open_output(const PPSystemString& filename)
+XMFileBase* Unlzx::open_output(struct UnLZX *unlzx)
 {
-	XMFile *file = new XMFile(filename, true);
+	// files are extracted into memory first when there's an output stream,
+	// only the one which is identified ends up in there
+	if (unlzx->outFile)
+		return new XMFileMemory(PPSystemString((const char*)unlzx->work_buffer));
+
+	currentFilename = PPSystemString((const char*)unlzx->work_buffer);
+	XMFile *file = new XMFile(currentFilename, true);
 	
 	if (!file->isOpenForWriting())
+	{
+		delete file;
 		return NULL;
+	}
 	
 	return(file);
 }
 
+bool Unlzx::close_output(XMFileBase* out_file, struct UnLZX *unlzx, bool identify)
+{
+	bool found = false;
+	
+	if (unlzx->outFile)
+	{
+		if (identify && identificator && identificator->identify(*out_file))
+		{
+			XMFileMemory* file = static_cast<XMFileMemory*>(out_file);
+			found = unlzx->outFile->write(file->getBuffer(), 1, file->size()) == (signed)file->size();
+		}
+		delete out_file;
+	}
+	else
+	{
+		delete out_file;
+		if (identify && identificator)
+		{
+			XMFile file(currentFilename);
+			found = identificator->identify(file);
+		}
+	}
+	
+	return found;
+}
+
 signed long Unlzx::extract_normal(XMFile* in_file, struct UnLZX *unlzx, bool& found)
 {
 	found = false;
 	struct filename_node *node;
-	XMFile *out_file = NULL;
+	XMFileBase *out_file = NULL;
 	unsigned char *pos, *temp;
 	unsigned long count;
 	signed long abort = 0;
@@ -638,7 +673,7 @@ signed long Unlzx::extract_normal(XMFile* in_file, struct UnLZX *unlzx, bool& fo
 	for(count = 0; count < 768; count ++) unlzx->literal_len[count] = 0;
 	unlzx->source_end = (unlzx->source = unlzx->read_buffer + 16384) - 1024;
 	pos = unlzx->destination_end = unlzx->destination = unlzx->decrunch_buffer + 65794;
-	for (node = unlzx->filename_list; (!abort) && node; node = node->next)
+	for (node = unlzx->filename_list; (!abort) && (!found) && node; node = node->next)
 	{
 		unlzx->sum = 0;
 		if (unlzx->use_outdir)
@@ -656,7 +691,7 @@ signed long Unlzx::extract_normal(XMFile* in_file, struct UnLZX *unlzx, bool& fo
 #ifdef UNLZX_DEBUG
 			printf("Extracting \"%s\"...", (char *)node->filename);
 #endif			
-			out_file = unlzx->temporaryFile ? open_output(*(unlzx->temporaryFile)) : open_output(PPSystemString((const char*)unlzx->work_buffer));
+			out_file = open_output(unlzx);
 		}
 		else
 		{
@@ -741,16 +776,11 @@ signed long Unlzx::extract_normal(XMFile* in_file, struct UnLZX *unlzx, bool& fo
 		}
 		if (out_file)
 		{
-			PPSystemString fileName = out_file->getFileName();
-			delete out_file;
-			if (!abort)
-			{
 #ifdef UNLZX_DEBUG
+			if (!abort)
 				printf(" crc %s\n", (char *)((node->crc == unlzx->sum) ? "good" : "bad"));
 #endif				
-				if (identificator)
-					found = identificator->identify(fileName);
-			}
+			found = close_output(out_file, unlzx, !abort);
 		}
 	}
 	return(abort);
@@ -759,11 +789,12 @@ signed long Unlzx::extract_normal(XMFile* in_file, struct UnLZX *unlzx, bool& fo
 signed long Unlzx::extract_store(XMFile* in_file, struct UnLZX *unlzx, bool& found)
 {
 	struct filename_node *node;
-	XMFile *out_file = NULL;
+	XMFileBase *out_file = NULL;
 	unsigned long count;
 	signed long abort = 0;
 	
-	for (node = unlzx->filename_list; (!abort) && (node); node = node->next)
+	found = false;
+	for (node = unlzx->filename_list; (!abort) && (!found) && (node); node = node->next)
 	{
 		unlzx->sum = 0;
 		if (unlzx->use_outdir)
@@ -781,7 +812,7 @@ signed long Unlzx::extract_store(XMFile* in_file, struct UnLZX *unlzx, bool& fou
 #ifdef UNLZX_DEBUG
 			printf("Storing \"%s\"...", (char *)node->filename);
 #endif
-			out_file = unlzx->temporaryFile ? open_output(*(unlzx->temporaryFile)) : open_output(PPSystemString((const char*)unlzx->work_buffer));
+			out_file = open_output(unlzx);
 		}
 		else
 		{
@@ -825,16 +856,11 @@ signed long Unlzx::extract_store(XMFile* in_file, struct UnLZX *unlzx, bool& fou
 		}
 		if (out_file)
 		{
-			PPSystemString fileName = out_file->getFileName();
-			delete out_file;
-			if (!abort)
-			{
 #ifdef UNLZX_DEBUG
+			if (!abort)
 				printf(" crc %s\n", (char *)((node->crc == unlzx->sum) ? "good" : "bad"));
 #endif				
-				if (identificator)
-					found = identificator->identify(fileName);
-			}
+			found = close_output(out_file, unlzx, !abort);
 		}
 	}
 	return(abort);
@@ -1323,7 +1349,7 @@ Unlzx::~Unlzx()
 		unlzx_free(unlzx);
 }
 
-bool Unlzx::extractFile(bool extract, const PPSystemString* outFilename)
+bool Unlzx::extractFile(bool extract, XMFileBase* outFile)
 {
 	int result = 0;
 	
@@ -1332,7 +1358,7 @@ bool Unlzx::extractFile(bool extract, const PPSystemString* outFilename)
 		if (extract)
 		{
 			unlzx->mode = 1;
-			unlzx->temporaryFile = outFilename;
+			unlzx->outFile = outFile;
 			bool found = false;
 			// TODO: make this all type safe
 			result = process_archive(archiveFilename, unlzx, found);
@@ -47,10 +47,58 @@ protected:
 	bool		deviceHasStarted;
 	mp_uint32	sampleCounter;
 	
+	// when the next callback is due, see checkCallbackTime
+	mp_uint32	nextCallbackTime;
+	bool		callbackTimeValid;
+	
+	// A callback is late when it comes in more than a whole buffer after 
+	// it was due, by then the device has most likely run dry. Callbacks 
+	// coming in early are fine, some drivers ask for several buffers in a row.
+	void checkCallbackTime(mp_uint32 numFrames)
+	{
+		const mp_uint32 time = mpGetTimeMicros();
+		const mp_sint32 bufferTime = (mp_sint32)(((double)numFrames * 1000000.0) / (double)mixFrequency);
+		
+		if (callbackTimeValid)
+		{
+			const mp_sint32 lateness = (mp_sint32)(time - nextCallbackTime);
+			if (lateness > bufferTime)
+			{
+				mixer->getProfiler().reportLateCallback();
+				nextCallbackTime = time;
+			}
+			// the device clock drifts away from ours, 
+			// don't let the schedule run ahead of it
+			else if (lateness < -bufferTime)
+			{
+				nextCallbackTime = time;
+			}
+		}
+		else
+		{
+			nextCallbackTime = time;
+			callbackTimeValid = true;
+		}
+		
+		nextCallbackTime+=bufferTime;
+	}
+	
+	// after starting or resuming the device the 
+	// callbacks don't follow on from the last ones
+	void resetCallbackTime() { callbackTimeValid = false; }
+	
+	void reportUnderrun() 
+	{ 
+		if (mixer) 
+			mixer->getProfiler().reportUnderrun(); 
+	}
+	
 public:
 	AudioDriver_COMPENSATE() :
 		deviceHasStarted(false),
-		sampleCounter(0)
+		sampleCounter(0),
+		nextCallbackTime(0),
+		callbackTimeValid(false)
 	{
 	}
 
@@ -68,6 +116,8 @@ public:
 		
 		MasterMixer* mixer = this->mixer;
 
+		checkCallbackTime(length>>2);
+
 		// Attention: Sample buffer MUST be 16 bit stereo, otherwise this will not work
 		this->sampleCounter+=length>>2;
 		//mixer->updateSampleCounter(length>>2);
@@ -77,6 +127,29 @@ public:
 		else
 			memset(stream, 0, length);
 	}
+
+	// same as above for drivers which take non-interleaved float buffers
+	void fillAudioWithCompensation(float* streamLeft, float* streamRight, int numFrames)
+	{
+		// sanity check
+		if (!this->deviceHasStarted)
+			return;
+		
+		MasterMixer* mixer = this->mixer;
+
+		checkCallbackTime(numFrames);
+
+		// bufferSize is in words, so it has to be numFrames*MP_NUMCHANNELS
+		this->sampleCounter+=numFrames;
+
+		if (isMixerActive())
+			mixer->mixerHandler(streamLeft, streamRight);
+		else
+		{
+			memset(streamLeft, 0, numFrames*sizeof(float));
+			memset(streamRight, 0, numFrames*sizeof(float));
+		}
+	}
 };
 
 #endif
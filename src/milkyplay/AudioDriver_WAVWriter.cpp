@@ -36,6 +36,7 @@
  */
 
 #include "AudioDriver_WAVWriter.h"
+#include "MasterMixer.h"
 
 struct TWAVHeader
 {
@@ -43,13 +44,19 @@ struct TWAVHeader
 	mp_dword length;			// filesize - 8
 	mp_ubyte WAVE[4];			// "WAVE"
 	mp_ubyte FMT[4];			// "fmt "
-	mp_dword fmtDataLength;		// = 16
+	mp_dword fmtDataLength;		// = 16 (PCM) or 18 (float)
 	mp_uword encodingTag;		
 	mp_uword numChannels;		// Channels: 1 = mono, 2 = stereo
 	mp_dword sampleRate;		// Samples per second: e.g., 44100
 	mp_dword bytesPerSecond;	// sample rate * block align
 	mp_uword blockAlign;		// channels * numBits / 8
-	mp_uword numBits;			// 8 or 16
+	mp_uword numBits;			// 8, 16 or 32
+	// formats other than PCM need the size of the format extension
+	// and a fact chunk with the number of sample frames
+	mp_uword extensionSize;		// = 0
+	mp_ubyte FACT[4];			// "fact"
+	mp_dword factDataLength;	// = 4
+	mp_dword numSampleFrames;
 	mp_ubyte DATA[4];			// "data"
 	mp_dword dataLength;		// sample data size
 };
@@ -73,17 +80,34 @@ static void writeWAVHeader(XMFile* f, const TWAVHeader& hdr)
 	f->writeWord(hdr.blockAlign);
 	f->writeWord(hdr.numBits);
 	
+	if (hdr.fmtDataLength > 16)
+	{
+		f->writeWord(hdr.extensionSize);
+		
+		f->write(hdr.FACT, 1, 4);
+		f->writeDword(hdr.factDataLength);
+		f->writeDword(hdr.numSampleFrames);
+	}
+	
 	f->write(hdr.DATA, 1, 4);	
 	f->writeDword(hdr.dataLength);
 }
 
-WAVWriter::WAVWriter(const SYSCHAR* fileName) :
+// WAVE_FORMAT_PCM and WAVE_FORMAT_IEEE_FLOAT
+enum
+{
+	WAVEncodingPCM = 1,
+	WAVEncodingFloat = 3
+};
+
+WAVWriter::WAVWriter(const SYSCHAR* fileName, bool floatOutput/* = false*/) :
 	AudioDriver_NULL(),
 	f(NULL),
-	mixFreq(44100)
+	mixFreq(44100),
+	floatOutput(floatOutput),
+	floatBuffer(NULL),
+	peak(0.0f)
 {
-	TWAVHeader hdr;
-	
 	f = new XMFile(fileName, true);
 
 	if (!f->isOpenForWriting())
@@ -93,22 +117,7 @@ WAVWriter::WAVWriter(const SYSCHAR* fileName) :
 	}
 	else
 	{
-		// build wav header
-		memcpy(hdr.RIFF, "RIFF", 4);
-		hdr.length = 44 - 8;
-		memcpy(hdr.WAVE, "WAVE", 4);
-		memcpy(hdr.FMT, "fmt ", 4);
-		hdr.fmtDataLength = 16;
-		hdr.encodingTag = 1;
-		hdr.numChannels = 2;
-		hdr.sampleRate = mixFreq;
-		hdr.numBits = 16;
-		hdr.blockAlign = (hdr.numChannels*hdr.numBits) / 8;
-		hdr.bytesPerSecond = hdr.sampleRate*hdr.blockAlign;
-		memcpy(hdr.DATA, "data", 4);
-		hdr.dataLength = 0;	
-		
-		writeWAVHeader(f, hdr);
+		writeHeader(0);
 	}
 }
 
@@ -116,54 +125,111 @@ WAVWriter::~WAVWriter()
 {
 	if (f)
 		delete f;
+		
+	delete[] floatBuffer;
 }
 
-mp_sint32 WAVWriter::initDevice(mp_sint32 bufferSizeInWords, mp_uint32 mixFrequency, MasterMixer* mixer)
+void WAVWriter::writeHeader(mp_uint32 numSamples)
 {
-	mp_sint32 res = AudioDriver_NULL::initDevice(bufferSizeInWords, mixFrequency, mixer);
-	if (res < 0)
-		return res;
-
-	mixFreq = mixFrequency;
-	return MP_OK;
+	writeHeader(f, mixFreq, numSamples, floatOutput);
 }
 
-mp_sint32 WAVWriter::closeDevice()
+void WAVWriter::writeHeader(XMFile* f, mp_uint32 sampleRate, mp_uint32 numSamples, bool floatOutput)
 {
-	if (!f)
-		return MP_DEVICE_ERROR;
-		
 	TWAVHeader hdr;
 	
 	// build wav header
 	memcpy(hdr.RIFF, "RIFF", 4);
-	hdr.length = 44 + numSamplesWritten*4 - 8;
 	memcpy(hdr.WAVE, "WAVE", 4);
 	memcpy(hdr.FMT, "fmt ", 4);
-	hdr.fmtDataLength = 16;
-	hdr.encodingTag = 1;
+	hdr.fmtDataLength = floatOutput ? 18 : 16;
+	hdr.encodingTag = floatOutput ? WAVEncodingFloat : WAVEncodingPCM;
 	hdr.numChannels = 2;
-	hdr.sampleRate = mixFreq;
-	hdr.numBits = 16;
+	hdr.sampleRate = sampleRate;
+	hdr.numBits = floatOutput ? 32 : 16;
 	hdr.blockAlign = (hdr.numChannels*hdr.numBits) / 8;
 	hdr.bytesPerSecond = hdr.sampleRate*hdr.blockAlign;
+	hdr.extensionSize = 0;
+	memcpy(hdr.FACT, "fact", 4);
+	hdr.factDataLength = 4;
+	hdr.numSampleFrames = numSamples;
 	memcpy(hdr.DATA, "data", 4);
-	hdr.dataLength = (numSamplesWritten*2*hdr.numBits)/8;	
+	hdr.dataLength = numSamples*hdr.blockAlign;	
+	// the size of the file up to the sample data is the same
+	// when the header is written again with the final length
+	const mp_dword headerLength = floatOutput ? 44 + 2 + 12 : 44;
+	hdr.length = headerLength + hdr.dataLength - 8;
+		
+	writeWAVHeader(f, hdr);
+}
+
+mp_sint32 WAVWriter::initDevice(mp_sint32 bufferSizeInWords, mp_uint32 mixFrequency, MasterMixer* mixer)
+{
+	mp_sint32 res = AudioDriver_NULL::initDevice(bufferSizeInWords, mixFrequency, mixer);
+	if (res < 0)
+		return res;
+
+	if (floatOutput)
+	{
+		delete[] floatBuffer;
+		floatBuffer = new float[bufferSizeInWords];
+	}
+
+	mixFreq = mixFrequency;
+	return MP_OK;
+}
+
+mp_sint32 WAVWriter::closeDevice()
+{
+	if (!f)
+		return MP_DEVICE_ERROR;
 		
 	f->seek(0);
 
-	writeWAVHeader(f, hdr);
+	writeHeader(numSamplesWritten);
 	
 	return MP_OK;
 }
 
 void WAVWriter::advance()
 {
-	AudioDriver_NULL::advance();
+	if (!floatOutput)
+	{
+		AudioDriver_NULL::advance();
 
-	if (!f)
+		if (!f)
+			return;
+	
+		mp_sint32 maxValue = 0;
+		for (mp_sint32 i = 0; i < bufferSize; i++)
+		{
+			const mp_sint32 value = compensateBuffer[i] < 0 ? -compensateBuffer[i] : compensateBuffer[i];
+			if (value > maxValue)
+				maxValue = value;
+		}
+		if (maxValue > peak*32768.0f)
+			peak = maxValue / 32768.0f;
+	
+		f->writeWords((mp_uword*)compensateBuffer, bufferSize);
 		return;
+	}
+	
+	numSamplesWritten+=bufferSize / MP_NUMCHANNELS;
+	if (!mixer->isPlaying())
+		return;
+		
+	mixer->mixerHandler(floatBuffer);
 	
-	f->writeWords((mp_uword*)compensateBuffer, bufferSize);
+	for (mp_sint32 i = 0; i < bufferSize; i++)
+	{
+		const float value = floatBuffer[i] < 0.0f ? -floatBuffer[i] : floatBuffer[i];
+		if (value > peak)
+			peak = value;
+	}
+	
+	if (!f)
+		return;
+		
+	// floats are written in the byte order of 32 bit words
+	f->writeDwords((const mp_dword*)floatBuffer, bufferSize);
 }
-
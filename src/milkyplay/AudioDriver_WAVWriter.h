@@ -46,9 +46,15 @@ class WAVWriter : public AudioDriver_NULL
 private:
 	XMFile*		f;
 	mp_sint32	mixFreq;
+	bool		floatOutput;
+	float*		floatBuffer;
+	float		peak;
+
+	void		writeHeader(mp_uint32 numSamples);
 	
 public:
-				WAVWriter(const SYSCHAR* fileName);
+				// floatOutput = true writes unclipped 32 bit float samples instead of 16 bit
+				WAVWriter(const SYSCHAR* fileName, bool floatOutput = false);
 
 	virtual		~WAVWriter();
 			
@@ -60,6 +66,12 @@ public:
 	virtual		void		advance();
 
 	bool					isOpen() { return f != NULL; }
+
+	// highest absolute sample value written so far, 1.0 is full scale
+	float					getPeak() const { return peak; }
+
+	// writes a stereo WAV header for numSamples sample frames at the current file position
+	static		void		writeHeader(XMFile* f, mp_uint32 sampleRate, mp_uint32 numSamples, bool floatOutput);
 };
 
 #endif
@@ -42,6 +42,8 @@
 #include "ResamplerFactory.h"
 #include "ResamplerMacros.h"
 #include "AudioDriverManager.h"
+#include "MilkyPlayAtomic.h"
+#include "MixerProfiler.h"
 #include <math.h>
  
 // Ramp out will last (THEBEATLENGTH*RAMPDOWNFRACTION)>>8 samples
@@ -76,15 +78,16 @@ void ChannelMixer::panToVol (ChannelMixer::TMixerChannel *chn, mp_sint32 &volL,
 		volL = volR = 0;
 }
 
-void ChannelMixer::ResamplerBase::addChannelsNormal(ChannelMixer* mixer, mp_uint32 numChannels, mp_sint32* buffer32,mp_sint32 beatNum, mp_sint32 beatlength)
+void ChannelMixer::ResamplerBase::addChannelsNormal(ChannelMixer* mixer, mp_uint32 firstChannel, mp_uint32 lastChannel, mp_sint32* buffer32,mp_sint32 beatNum, mp_sint32 beatlength)
 {
 	ChannelMixer::TMixerChannel* channel = mixer->channel;
 	ChannelMixer::TMixerChannel* newChannel = mixer->newChannel;
 	
-	for (mp_uint32 c=0;c<numChannels;c++) 
+	for (mp_uint32 c=firstChannel;c<lastChannel;c++) 
 	{
 		ChannelMixer::TMixerChannel* chn = &channel[c];
 		chn->index = c;		// For Amiga resampler
+		chn->skipped = false;
 
 		if (!(chn->flags & MP_SAMPLE_PLAY))
 			continue;
@@ -118,21 +121,30 @@ void ChannelMixer::ResamplerBase::addChannelsNormal(ChannelMixer* mixer, mp_uint
 			}
 		}
 		
+		// nothing to hear, just move along the sample
+		if (chn->finalvoll == 0 && chn->finalvolr == 0 && supportsSkipping(chn))
+		{
+			skipChannel(chn, beatlength, beatlength);
+			chn->skipped = true;
+			continue;
+		}
+		
 		// mix here
 		addChannel(chn, buffer32, beatlength, beatlength);
 		
 	}
 }
 
-void ChannelMixer::ResamplerBase::addChannelsRamping(ChannelMixer* mixer, mp_uint32 numChannels, mp_sint32* buffer32,mp_sint32 beatNum, mp_sint32 beatlength)
+void ChannelMixer::ResamplerBase::addChannelsRamping(ChannelMixer* mixer, mp_uint32 firstChannel, mp_uint32 lastChannel, mp_sint32* buffer32,mp_sint32 beatNum, mp_sint32 beatlength)
 {
 	ChannelMixer::TMixerChannel* channel = mixer->channel;
 	ChannelMixer::TMixerChannel* newChannel = mixer->newChannel;
 	
-	for (mp_uint32 c=0;c<numChannels;c++) 
+	for (mp_uint32 c=firstChannel;c<lastChannel;c++) 
 	{	
 		ChannelMixer::TMixerChannel* chn = &channel[c];
 		chn->index = c;		// For Amiga resampler
+		chn->skipped = false;
 		
 		if (!(chn->flags & MP_SAMPLE_PLAY))
 			continue;
@@ -281,6 +293,14 @@ void ChannelMixer::ResamplerBase::addChannelsRamping(ChannelMixer* mixer, mp_uin
 				chn->rampFromVolStepL = (volL-chn->finalvoll)/beatlength;				
 				chn->rampFromVolStepR = (volR-chn->finalvolr)/beatlength;
 				
+				// silent and staying silent, just move along the sample
+				if (volL == 0 && volR == 0 && chn->finalvoll == 0 && chn->finalvolr == 0 && supportsSkipping(chn))
+				{
+					skipChannel(chn, beatlength, beatlength);
+					chn->skipped = true;
+					break;
+				}
+				
 				// mix here
 				addChannel(chn, buffer32, beatlength, beatlength);
 	
@@ -294,14 +314,71 @@ void ChannelMixer::ResamplerBase::addChannelsRamping(ChannelMixer* mixer, mp_uin
 }
 
 void ChannelMixer::ResamplerBase::addChannels(ChannelMixer* mixer, mp_uint32 numChannels, mp_sint32* buffer32,mp_sint32 beatNum, mp_sint32 beatlength)
+{
+	addChannelRange(mixer, 0, numChannels, buffer32, beatNum, beatlength);
+}
+
+void ChannelMixer::ResamplerBase::addChannelsTapped(ChannelMixer* mixer, mp_uint32 firstChannel, mp_uint32 lastChannel, mp_sint32* buffer32,mp_sint32 beatNum, mp_sint32 beatlength)
+{
+	const bool isRamping = this->isRamping();
+	const mp_uint32 numChannels = mixer->scopeTapNumChannels;
+	const mp_uint32 packetSize = mixer->scopeTapPacketSize;
+	const mp_uint32 mask = mixer->scopeTapSize - 1;
+	const mp_uint32 pos = mixer->scopeTapPacket*packetSize;
+	
+	for (mp_uint32 c = firstChannel; c < lastChannel; c++)
+	{
+		const bool tapped = c < numChannels;
+		const bool playing = (mixer->channel[c].flags & MP_SAMPLE_PLAY) != 0;
+		
+		// the output without this channel at the frames we're recording
+		mp_sint32 before[MP_SCOPETAPMAXPACKETSIZE];
+		if (tapped && playing)
+		{
+			const mp_sint32* src = buffer32;
+			for (mp_uint32 i = 0; i < packetSize; i++, src+=MP_SCOPETAPDECIMATION*MP_NUMCHANNELS)
+				before[i] = src[0] + src[1];
+		}
+	
+		if (isRamping)
+			addChannelsRamping(mixer, c, c+1, buffer32, beatNum, beatlength);
+		else
+			addChannelsNormal(mixer, c, c+1, buffer32, beatNum, beatlength);
+			
+		if (!tapped)
+			continue;
+
+		mp_sword* tap = mixer->scopeTapBuffers + c*(mask+1);
+		if (playing)
+		{
+			const mp_sint32* src = buffer32;
+			for (mp_uint32 i = 0; i < packetSize; i++, src+=MP_SCOPETAPDECIMATION*MP_NUMCHANNELS)
+			{
+				mp_sint32 s = (src[0] + src[1] - before[i]) >> 1;
+				if (s < -32768) s = -32768;
+				if (s > 32767) s = 32767;
+				tap[(pos+i) & mask] = (mp_sword)s;
+			}
+		}
+		else
+		{
+			for (mp_uint32 i = 0; i < packetSize; i++)
+				tap[(pos+i) & mask] = 0;
+		}
+	}
+}
+
+void ChannelMixer::ResamplerBase::addChannelRange(ChannelMixer* mixer, mp_uint32 firstChannel, mp_uint32 lastChannel, mp_sint32* buffer32,mp_sint32 beatNum, mp_sint32 beatlength)
 {
 	if (beatNum >= (signed)mixer->getNumBeatPackets())
 		beatNum = mixer->getNumBeatPackets();
 
-	if (isRamping())
-		addChannelsRamping(mixer, numChannels, buffer32, beatNum, beatlength);
+	if (mixer->scopeTapBuffers)
+		addChannelsTapped(mixer, firstChannel, lastChannel, buffer32, beatNum, beatlength);
+	else if (isRamping())
+		addChannelsRamping(mixer, firstChannel, lastChannel, buffer32, beatNum, beatlength);
 	else
-		addChannelsNormal(mixer, numChannels, buffer32, beatNum, beatlength);
+		addChannelsNormal(mixer, firstChannel, lastChannel, buffer32, beatNum, beatlength);
 }
 
 void ChannelMixer::ResamplerBase::addChannel(TMixerChannel* chn, mp_sint32* buffer32, const mp_sint32 beatlength, const mp_sint32 beatSize)
@@ -471,6 +548,125 @@ void ChannelMixer::ResamplerBase::addChannel(TMixerChannel* chn, mp_sint32* buff
 	} 
 }
 
+void ChannelMixer::ResamplerBase::skipChannel(TMixerChannel* chn, const mp_sint32 beatlength, const mp_sint32 beatSize)
+{
+	if (!(chn->flags&MP_SAMPLE_PLAY))
+		return;
+		
+	// forward loop: no matter how often the loop is passed during this 
+	// packet, a single modulo puts the position back into the loop
+	if ((chn->flags & 3) == 1 && !(chn->flags&MP_SAMPLE_BACKWARD) && chn->loopend > chn->loopstart)
+	{
+		skipBlock(chn, beatlength);
+		if (chn->smppos >= chn->loopend)
+			chn->smppos = ((chn->smppos - chn->loopstart)%(chn->loopend-chn->loopstart))+chn->loopstart; 
+		return;
+	}
+	
+	// otherwise walk from one loop boundary to the next like addChannel
+	// does, every step is O(1) as nothing is mixed in between
+	mp_sint32 todo = beatlength; 
+	bool limit = false;
+	while (todo>0) 
+	{ 
+		if (chn->flags&MP_SAMPLE_BACKWARD) 
+		{ 
+			mp_sint32 pos = ((todo*-chn->smpadd - chn->smpposfrac)>>16)+chn->smppos; 
+			if (pos>chn->loopstart) 
+			{ 
+				skipBlock(chn,todo); 
+				break; 
+			} 
+
+			mp_sint32 length = MP_FP_CEIL(ChannelMixer::fixedmul((((chn->smppos-chn->loopstart)<<16)+chn->smpposfrac),chn->rsmpadd)); 
+			if (!length) length++; 
+			if (length>todo) 
+			{
+				length = todo; 
+				limit = true;
+			}
+			// the fade out of a silent channel is flat
+			else if ((chn->flags & 3) == 0) 
+			{
+				chn->rampFromVolStepL = 0; 
+				chn->rampFromVolStepR = 0; 
+			}
+			skipBlock(chn, length);
+			if ((chn->flags & 3) == 0 && !limit) 
+			{ 
+				if (chn->flags & MP_SAMPLE_ONESHOT) 
+				{ 
+					chn->flags &= ~MP_SAMPLE_ONESHOT; 
+					chn->flags |= 1; 
+					chn->loopstart = chn->loopendcopy;
+					chn->smppos = chn->smplen - myMod(chn->smplen - chn->smppos, chn->loopend-chn->loopstart); 
+				} 
+				else 
+					chn->flags&=~MP_SAMPLE_PLAY; 
+				break; 
+			} 
+			else if ((chn->flags & 3) == 1) 
+			{ 
+				chn->smppos = chn->loopend - myMod(chn->loopend - chn->smppos, chn->loopend-chn->loopstart); 
+			} 
+			else if (chn->smppos < chn->loopstart)
+			{ 
+				chn->flags&=~MP_SAMPLE_BACKWARD; 
+				BIDIR_REPOSITION(16, chn->smppos, chn->smpposfrac, chn->loopstart, chn->loopend);
+			} 
+			todo-=length; 
+		} 
+		else 
+		{ 
+			mp_sint32 pos = ((todo*chn->smpadd + chn->smpposfrac)>>16)+chn->smppos; 
+			if (pos<chn->loopend) 
+			{ 
+				skipBlock(chn,todo); 
+				break; 
+			} 
+
+			mp_sint32 length = MP_FP_CEIL(ChannelMixer::fixedmul((((chn->loopend-chn->smppos)<<16)-chn->smpposfrac),chn->rsmpadd)); 
+			if (!length) length++; 
+			if (length>todo) 
+			{
+				length = todo; 
+				limit = true;
+			}
+			else if ((chn->flags & 3) == 0) 
+			{ 
+				chn->rampFromVolStepL = 0; 
+				chn->rampFromVolStepR = 0; 
+			} 
+			skipBlock(chn,length); 
+			if ((chn->flags & 3) == 0 && !limit) 
+			{ 
+				if (chn->flags & MP_SAMPLE_ONESHOT)
+				{ 
+					chn->flags &= ~MP_SAMPLE_ONESHOT; 
+					chn->flags |= 1; 
+					chn->loopend = chn->loopendcopy; 
+					chn->smppos = ((chn->smppos - chn->smplen)%(chn->loopend-chn->loopstart))+chn->loopstart; 
+				} 
+				else 
+					chn->flags&=~MP_SAMPLE_PLAY; 
+				break; 
+			} 
+			else if ((chn->flags & 3) == 1) 
+			{ 
+				chn->smppos = ((chn->smppos - chn->loopstart)%(chn->loopend-chn->loopstart))+chn->loopstart; 
+				if (chn->smppos < 0) 
+					chn->smppos = 0; 
+			} 
+			else if (chn->smppos >= chn->loopend)
+			{ 						
+				chn->flags|=MP_SAMPLE_BACKWARD;
+				BIDIR_REPOSITION(16, chn->smppos, chn->smpposfrac, chn->loopstart, chn->loopend);
+			} 
+			todo-=length; 
+		} 
+	} 
+}
+
 void ChannelMixer::muteChannel(mp_sint32 c, bool m) 
 { 
 	channel[c].flags&=~MP_SAMPLE_MUTE;
@@ -500,6 +696,9 @@ void ChannelMixer::setFrequency(mp_sint32 frequency)
 	
 	mixbuffBeatPacket = new mp_sint32[beatPacketSize*MP_NUMCHANNELS];
 	
+	reallocThreadBuffers();
+	reallocStemBuffers();
+	
 	// channels contain information based on beatPacketSize so this might
 	// have been changed
 	reallocChannels();
@@ -529,6 +728,8 @@ void ChannelMixer::reallocChannels()
 	
 	mixerLastNumAllocatedChannels = mixerNumAllocatedChannels;
 
+	reallocScopeTap();
+
 	if (resamplerType != MIXER_INVALID && resamplerTable[resamplerType])
 		resamplerTable[resamplerType]->setNumChannels(mixerNumAllocatedChannels);
 }
@@ -556,9 +757,28 @@ ChannelMixer::ChannelMixer(mp_uint32 numChannels,
 	paused(false),
 	disableMixing(false),
 	allowFilters(false),
+	threadPool(NULL),
+	threadChannelThreshold(0),
+	threadBuffers(NULL),
+	stemListener(NULL),
+	numStems(0),
+	stemBuffers(NULL),
+	commandHandler(NULL),
+	profiler(NULL),
+	scopeTapEnabled(false),
+	scopeTapNumChannels(0),
+	scopeTapPacketSize(0),
+	scopeTapSize(0),
+	scopeTapBuffers(NULL),
+	scopeTapNumStates(0),
+	scopeTapStates(NULL),
+	scopeTapPacket(0),
+	scopeTapBufferStart(0),
 	initialized(false),
 	sampleCounter(0)
 {	
+	mixJob.mixer = this;
+
 	memset(resamplerTable, 0, sizeof(resamplerTable));
 
 	setFrequency(frequency);
@@ -593,6 +813,11 @@ ChannelMixer::~ChannelMixer()
 	if (mixbuffBeatPacket)
 		delete[] mixbuffBeatPacket;
 
+	delete[] threadBuffers;
+	delete[] stemBuffers;
+	delete[] scopeTapBuffers;
+	delete[] scopeTapStates;
+
 	if (channel) 
 		delete[] channel;
 	
@@ -911,38 +1136,293 @@ void ChannelMixer::playSample(mp_sint32 c, // channel
 	
 }
 
-static inline void storeTimeRecordData(mp_sint32 nb, ChannelMixer::TMixerChannel* chn)
+static inline void storeTimeRecord(ChannelMixer::TTimeRecord& record, const ChannelMixer::TMixerChannel* chn)
 {
 	if (!(chn->flags & ChannelMixer::MP_SAMPLE_PLAY))
 	{
-		if (chn->timeRecord)
-		{
-			chn->timeRecord[nb].flags = chn->flags;
-			chn->timeRecord[nb].sample = NULL;
-			chn->timeRecord[nb].volPan = 128 << 16;
-			chn->timeRecord[nb].smppos = -1;
-		}
+		record.flags = chn->flags;
+		record.sample = NULL;
+		record.volPan = 128 << 16;
+		record.smppos = -1;
 	}
 	else
 	{
-		if (chn->timeRecord)
+		record.flags = chn->flags;
+		record.sample = chn->sample;
+		record.smppos = chn->smppos;
+		record.volPan = chn->vol + (chn->pan << 16);
+		record.smpposfrac = chn->smpposfrac;
+		record.smpadd = chn->smpadd;
+		record.smplen = chn->smplen;
+		if (chn->flags & ChannelMixer::MP_SAMPLE_ONESHOT)
+			record.loopend = chn->loopendcopy;
+		else
+			record.loopend = chn->loopend;
+		record.loopstart = chn->loopstart;
+		record.fixedtime = chn->fixedtime;			
+		record.fixedtimefrac = chn->fixedtimefrac;
+	}
+}
+
+static inline void storeTimeRecordData(mp_sint32 nb, ChannelMixer::TMixerChannel* chn)
+{
+	if (chn->timeRecord)
+		storeTimeRecord(chn->timeRecord[nb], chn);
+}
+
+void ChannelMixer::setThreadPool(MixerThreadPool* threadPool, mp_uint32 channelThreshold)
+{
+	this->threadPool = threadPool;
+	threadChannelThreshold = channelThreshold;
+	
+	reallocThreadBuffers();
+}
+
+void ChannelMixer::reallocThreadBuffers()
+{
+	delete[] threadBuffers;
+	threadBuffers = NULL;
+	
+	if (threadPool && threadPool->getNumThreads() > 1)
+		threadBuffers = new mp_sint32[(threadPool->getNumThreads()-1)*beatPacketSize*MP_NUMCHANNELS];
+}
+
+void ChannelMixer::setStemListener(StemListener* stemListener, mp_uint32 numStems)
+{
+	this->stemListener = stemListener;
+	this->numStems = stemListener ? numStems : 0;
+	
+	reallocStemBuffers();
+}
+
+void ChannelMixer::reallocStemBuffers()
+{
+	delete[] stemBuffers;
+	stemBuffers = NULL;
+	
+	if (numStems)
+		stemBuffers = new mp_sint32[numStems*beatPacketSize*MP_NUMCHANNELS];
+}
+
+void ChannelMixer::setScopeTap(bool enabled)
+{
+	scopeTapEnabled = enabled;
+	
+	reallocScopeTap();
+}
+
+void ChannelMixer::reallocScopeTap()
+{
+	delete[] scopeTapBuffers;
+	scopeTapBuffers = NULL;
+	delete[] scopeTapStates;
+	scopeTapStates = NULL;
+	scopeTapNumChannels = 0;
+	
+	scopeTapPacketSize = (beatPacketSize + MP_SCOPETAPDECIMATION - 1) / MP_SCOPETAPDECIMATION;
+	
+	if (!scopeTapEnabled || !mixerNumAllocatedChannels || !scopeTapPacketSize || 
+		scopeTapPacketSize > MP_SCOPETAPMAXPACKETSIZE)
+		return;
+	
+	// keep the beat packets of two buffers, so the one that's being
+	// played doesn't get overwritten while mixing the next one
+	const mp_uint32 numPackets = 2*(getNumBeatPackets() + 2);
+	for (scopeTapNumStates = 1; scopeTapNumStates < numPackets; scopeTapNumStates <<= 1)
+	{
+	}
+	for (scopeTapSize = 1; scopeTapSize < scopeTapNumStates*scopeTapPacketSize; scopeTapSize <<= 1)
+	{
+	}
+	
+	// must stay addressable by the packed buffer position
+	if (scopeTapSize > MP_SCOPETAPPACKETMASK + 1)
+		return;
+	
+	scopeTapNumChannels = mixerNumAllocatedChannels;
+	scopeTapBuffers = new mp_sword[scopeTapNumChannels*scopeTapSize];
+	memset(scopeTapBuffers, 0, scopeTapNumChannels*scopeTapSize*sizeof(mp_sword));
+	scopeTapStates = new TTimeRecord[scopeTapNumChannels*scopeTapNumStates];
+	
+	scopeTapPacket = 0;
+	scopeTapBufferStart = 0;
+}
+
+void ChannelMixer::storeScopeTapStates()
+{
+	const mp_uint32 numChannels = mixerNumActiveChannels < scopeTapNumChannels ? mixerNumActiveChannels : scopeTapNumChannels;
+	
+	TTimeRecord* state = scopeTapStates + (scopeTapPacket & (scopeTapNumStates-1));
+	for (mp_uint32 c = 0; c < numChannels; c++, state+=scopeTapNumStates)
+		storeTimeRecord(*state, &channel[c]);
+}
+
+void ChannelMixer::locateScopeTap(mp_uint32 smpPos, mp_uint32& packet, mp_uint32& offset) const
+{
+	const mp_uint32 start = (mp_uint32)mpAtomicLoad(&scopeTapBufferStart);
+	
+	if (smpPos >= mixBufferSize)
+		smpPos = mixBufferSize ? mixBufferSize - 1 : 0;
+	
+	offset = (start & ((1 << MP_SCOPETAPOFFSETBITS) - 1)) + smpPos;
+	packet = (start >> MP_SCOPETAPOFFSETBITS) + offset / beatPacketSize;
+	offset %= beatPacketSize;
+}
+
+bool ChannelMixer::getScopeTapData(mp_uint32 c, mp_uint32 smpPos, mp_sword* buffer, mp_uint32 count) const
+{
+	if (scopeTapBuffers == NULL || c >= scopeTapNumChannels)
+		return false;
+	
+	mp_uint32 packet, offset;
+	locateScopeTap(smpPos, packet, offset);
+	
+	// the part of the ring buffer that's not written to while we're reading
+	const mp_uint32 maxCount = scopeTapSize / 2;
+	const mp_uint32 mask = scopeTapSize - 1;
+	const mp_sword* src = scopeTapBuffers + c*scopeTapSize;
+	
+	mp_uint32 pos = packet*scopeTapPacketSize + offset/MP_SCOPETAPDECIMATION - count + 1;
+	for (mp_uint32 i = 0; i < count; i++, pos++)
+		buffer[i] = (count - i > maxCount) ? 0 : src[pos & mask];
+	
+	return true;
+}
+
+bool ChannelMixer::getScopeTapState(mp_uint32 c, mp_uint32 smpPos, TTimeRecord& state) const
+{
+	if (scopeTapStates == NULL || c >= scopeTapNumChannels)
+		return false;
+	
+	mp_uint32 packet, offset;
+	locateScopeTap(smpPos, packet, offset);
+	
+	state = scopeTapStates[c*scopeTapNumStates + (packet & (scopeTapNumStates-1))];
+	return true;
+}
+
+void ChannelMixer::MixJob::execute(mp_uint32 taskIndex)
+{
+	if (stems)
+	{
+		// every channel goes into its own stem buffer
+		for (mp_uint32 c = firstChannel[taskIndex]; c < firstChannel[taskIndex+1]; c++)
 		{
-			chn->timeRecord[nb].flags = chn->flags;
-			chn->timeRecord[nb].sample = chn->sample;
-			chn->timeRecord[nb].smppos = chn->smppos;
-			chn->timeRecord[nb].volPan = chn->vol + (chn->pan << 16);
-			chn->timeRecord[nb].smpposfrac = chn->smpposfrac;
-			chn->timeRecord[nb].smpadd = chn->smpadd;
-			chn->timeRecord[nb].smplen = chn->smplen;
-			if (chn->flags & ChannelMixer::MP_SAMPLE_ONESHOT)
-				chn->timeRecord[nb].loopend = chn->loopendcopy;
-			else
-				chn->timeRecord[nb].loopend = chn->loopend;
-			chn->timeRecord[nb].loopstart = chn->loopstart;
-			chn->timeRecord[nb].fixedtime = chn->fixedtime;			
-			chn->timeRecord[nb].fixedtimefrac = chn->fixedtimefrac;
+			mp_sint32* buffer = mixer->stemBuffers + c*beatPacketSize*MP_NUMCHANNELS;
+			memset(buffer, 0, beatPacketSize*MP_NUMCHANNELS*sizeof(mp_sint32));
+			mixer->resamplerTable[mixer->resamplerType]->addChannelRange(mixer, c, c+1, buffer, beatPacketIndex, beatPacketSize);
 		}
+		return;
+	}
+
+	mp_sint32* buffer = buffer32;
+	
+	// the first task mixes right into the destination buffer
+	if (taskIndex)
+	{
+		buffer = mixer->threadBuffers + (taskIndex-1)*beatPacketSize*MP_NUMCHANNELS;
+		memset(buffer, 0, beatPacketSize*MP_NUMCHANNELS*sizeof(mp_sint32));
+	}
+	
+	mixer->resamplerTable[mixer->resamplerType]->addChannelRange(mixer, firstChannel[taskIndex], firstChannel[taskIndex+1], buffer, beatPacketIndex, beatPacketSize);
+}
+
+mp_uint32 ChannelMixer::getNumPlayingChannels(mp_uint32 numChannels) const
+{
+	mp_uint32 numPlaying = 0;
+	for (mp_uint32 c = 0; c < numChannels; c++)
+		if (channel[c].flags & MP_SAMPLE_PLAY)
+			numPlaying++;
+	
+	return numPlaying;
+}
+
+void ChannelMixer::distributeChannels(mp_uint32 numChannels, mp_uint32 numPlaying, mp_uint32 numTasks)
+{
+	// split up into ranges with about the same number of playing channels,
+	// the ranges stay contiguous, so neighbouring channels don't end up 
+	// being mixed by different threads
+	mp_uint32 c, task = 0, count = 0;
+	mixJob.firstChannel[0] = 0;
+	for (c = 0; c < numChannels && task < numTasks-1; c++)
+	{
+		if (!(channel[c].flags & MP_SAMPLE_PLAY))
+			continue;
+			
+		if (count == (numPlaying * (task+1)) / numTasks)
+			mixJob.firstChannel[++task] = c;
+			
+		count++;
 	}
+	while (task < numTasks)
+		mixJob.firstChannel[++task] = numChannels;
+}
+
+bool ChannelMixer::mixBeatPacketThreaded(mp_uint32 numChannels,
+										 mp_sint32* buffer32,
+										 mp_sint32 beatPacketIndex, 
+										 mp_sint32 beatPacketSize)
+{
+	const mp_uint32 numThreads = threadPool->getNumThreads();
+	if (numThreads <= 1 || threadBuffers == NULL)
+		return false;
+	
+	const mp_uint32 numPlaying = getNumPlayingChannels(numChannels);
+	
+	if (numPlaying < threadChannelThreshold || numPlaying < numThreads)
+		return false;
+	
+	distributeChannels(numChannels, numPlaying, numThreads);
+	
+	mixJob.buffer32 = buffer32;
+	mixJob.beatPacketIndex = beatPacketIndex;
+	mixJob.beatPacketSize = beatPacketSize;
+	mixJob.stems = false;
+	
+	threadPool->run(mixJob, numThreads);
+
+	// sum up in fixed order
+	const mp_sint32* src = threadBuffers;
+	for (mp_uint32 i = 1; i < numThreads; i++)
+	{
+		mp_sint32* dst = buffer32;
+		for (mp_sint32 j = 0; j < beatPacketSize*MP_NUMCHANNELS; j++)
+			*dst++ += *src++;
+	}
+	
+	return true;
+}
+
+void ChannelMixer::mixBeatPacketStems(mp_uint32 numChannels,
+									  mp_sint32* buffer32,
+									  mp_sint32 beatPacketIndex, 
+									  mp_sint32 beatPacketSize)
+{
+	const mp_uint32 numStems = this->numStems < numChannels ? this->numStems : numChannels;
+	
+	// the stems don't need to be summed up, so unlike mixBeatPacketThreaded
+	// there is no channel threshold, any spare thread is a win here
+	mp_uint32 numTasks = threadPool ? threadPool->getNumThreads() : 1;
+	const mp_uint32 numPlaying = getNumPlayingChannels(numStems);
+	if (numTasks > numPlaying)
+		numTasks = numPlaying ? numPlaying : 1;
+	
+	distributeChannels(numStems, numPlaying, numTasks);
+	
+	mixJob.buffer32 = buffer32;
+	mixJob.beatPacketIndex = beatPacketIndex;
+	mixJob.beatPacketSize = beatPacketSize;
+	mixJob.stems = true;
+	
+	if (numTasks > 1)
+		threadPool->run(mixJob, numTasks);
+	else
+		mixJob.execute(0);
+	
+	if (numStems < numChannels)
+		resamplerTable[resamplerType]->addChannelRange(this, numStems, numChannels, buffer32, beatPacketIndex, beatPacketSize);
+	
+	stemListener->stemsMixed(stemBuffers, numStems, beatPacketSize);
 }
 
 void ChannelMixer::mix(mp_sint32* mixbuff32, mp_uint32 bufferSize)
@@ -961,6 +1441,11 @@ void ChannelMixer::mix(mp_sint32* mixbuff32, mp_uint32 bufferSize)
 
 		mp_sint32 done = 0;
 
+		// the buffer might start with the rest of the last beat packet
+		const mp_uint32 scopeTapStart = lastBeatRemainder ? 
+			(((scopeTapPacket-1) & MP_SCOPETAPPACKETMASK) << MP_SCOPETAPOFFSETBITS) + (beatLength - lastBeatRemainder) :
+			((scopeTapPacket & MP_SCOPETAPPACKETMASK) << MP_SCOPETAPOFFSETBITS);
+
 		if (lastBeatRemainder)
 		{
 			mp_sint32 todo = lastBeatRemainder;
@@ -1001,8 +1486,12 @@ void ChannelMixer::mix(mp_sint32* mixbuff32, mp_uint32 bufferSize)
 
 			const bool isRamping = this->isRamping();
 
+			MixerProfiler* const profiler = this->profiler;
+
 			for (nb=0;nb<numbeats;nb++) 
 			{
+				mp_uint32 profileTime = profiler ? mpGetTimeMicros() : 0;
+
 				if (isRamping)
 				{
 					const TMixerChannel* src = channel;
@@ -1038,16 +1527,28 @@ void ChannelMixer::mix(mp_sint32* mixbuff32, mp_uint32 bufferSize)
 					}
 				}
 
+				if (profiler)
+					profileTime = profiler->addStageTime(MixerProfiler::StageRampingFiltering, profileTime);
+
 				timer(nb);
 
+				if (profiler)
+					profileTime = profiler->addStageTime(MixerProfiler::StageSequencing, profileTime);
+
 				if (!disableMixing)
 				{
 					// do some in between state recording 
 					// to be able to show smooth updates even if the buffer is large
 					for (mp_uint32 c=0;c<mixerNumActiveChannels;c++) 
 						storeTimeRecordData(nb, &channel[c]);
+					if (scopeTapStates)
+						storeScopeTapStates();
 
 					mixBeatPacket(mixerNumActiveChannels, buffer+nb*beatLength*MP_NUMCHANNELS, nb, beatLength);	
+					scopeTapPacket++;
+
+					if (profiler)
+						profiler->addStageTime(MixerProfiler::StageResampling, profileTime);
 				}
 			}		
 
@@ -1057,6 +1558,8 @@ void ChannelMixer::mix(mp_sint32* mixbuff32, mp_uint32 bufferSize)
 			{
 				memset(mixbuffBeatPacket, 0, beatLength*MP_NUMCHANNELS*sizeof(mp_sint32));
 
+				mp_uint32 profileTime = profiler ? mpGetTimeMicros() : 0;
+
 				if (isRamping)
 				{
 					const TMixerChannel* src = channel;
@@ -1092,16 +1595,28 @@ void ChannelMixer::mix(mp_sint32* mixbuff32, mp_uint32 bufferSize)
 					}
 				}
 
+				if (profiler)
+					profileTime = profiler->addStageTime(MixerProfiler::StageRampingFiltering, profileTime);
+
 				timer(numbeats);
 
+				if (profiler)
+					profileTime = profiler->addStageTime(MixerProfiler::StageSequencing, profileTime);
+
 				if (!disableMixing)
 				{
 					// do some in between state recording 
 					// to be able to show smooth updates even if the buffer is large
 					for (mp_uint32 c=0;c<mixerNumActiveChannels;c++) 
 						storeTimeRecordData(nb, &channel[c]);
+					if (scopeTapStates)
+						storeScopeTapStates();
 
 					mixBeatPacket(mixerNumActiveChannels, mixbuffBeatPacket, numbeats, beatLength);	
+					scopeTapPacket++;
+
+					if (profiler)
+						profiler->addStageTime(MixerProfiler::StageResampling, profileTime);
 				}
 
 				mp_sint32 todo = mixBufferSize - done;
@@ -1117,6 +1632,10 @@ void ChannelMixer::mix(mp_sint32* mixbuff32, mp_uint32 bufferSize)
 				}
 			}
 		}
+
+		// everything up to the end of the buffer has been recorded now
+		if (scopeTapBuffers && !disableMixing)
+			mpAtomicStore(&scopeTapBufferStart, (mp_sint32)scopeTapStart);
 	}
 	
 }
@@ -1223,6 +1742,17 @@ mp_sint32 ChannelMixer::getNumActiveChannels()
 	return i;
 }
 
+mp_sint32 ChannelMixer::getNumSkippedChannels()
+{	
+	mp_sint32 i = 0;
+
+	for (mp_uint32 j = 0; j < mixerNumActiveChannels; j++)
+		if (channel[j].skipped)
+			i++;
+
+	return i;
+}
+
 mp_sint32 ChannelMixer::getBeatIndexFromSamplePos(mp_uint32 smpPos) const
 {
 	mp_sint32 maxLen = (mixBufferSize/beatPacketSize)-1;
@@ -43,6 +43,7 @@
 #include "MilkyPlayCommon.h"
 #include "AudioDriverBase.h"
 #include "Mixable.h"
+#include "MixerThreadPool.h"
 
 #define MP_FP_CEIL(x)			(((x)+65535)>>16)
 #define MP_FP_MUL(a, b)			((mp_sint32)(((mp_int64)(a)*(mp_int64)(b))>>16))
@@ -64,7 +65,7 @@ class MixerSettings
 protected:
 	enum
 	{
-		NUMRESAMPLERTYPES = 21,
+		NUMRESAMPLERTYPES = 23,
 	};
 
 public:
@@ -102,6 +103,9 @@ public:
 		MIXER_AMIGA1200LED,
 		MIXER_AMIGA1200LED_RAMPING,
 
+		MIXER_POLYPHASE,
+		MIXER_POLYPHASE_RAMPING,
+
 		MIXER_DUMMY,
 		
 		MIXER_INVALID
@@ -136,7 +140,14 @@ public:
 		MP_SAMPLE_BACKWARD	= 128,
 		
 		MP_INVALID_VALUE	= 0x7FFFFFFF,
-		MP_FILTERPRECISION	= 8		
+		MP_FILTERPRECISION	= 8,
+		// scope tap: one sample is taken every MP_SCOPETAPDECIMATION frames
+		MP_SCOPETAPDECIMATION	= 2,
+		MP_SCOPETAPMAXPACKETSIZE = 512,		// in scope tap samples
+		// the position published to other threads is packed into 32 bits:
+		// beat packet index in the upper, frame offset in the lower bits
+		MP_SCOPETAPOFFSETBITS	= 12,
+		MP_SCOPETAPPACKETMASK	= (1 << (32-MP_SCOPETAPOFFSETBITS)) - 1
 	};
 
 	static inline mp_sint32 fixedmul(mp_sint32 a,mp_sint32 b) { return MP_FP_MUL(a,b); }
@@ -220,6 +231,8 @@ public:
 		mp_uint32			timeRecordSize;
 		TTimeRecord*		timeRecord;
 		mp_sint32			index;					// For Amiga resampler
+		
+		bool				skipped;				// silent in the last beat packet, only moved along
 
 		TMixerChannel() :
 			timeRecordSize(0),
@@ -272,6 +285,7 @@ public:
 			fixedtime			= 0;
 			fixedtimefrac		= 0;
 			index				= -1;		// is filled during runtime
+			skipped				= false;
 			
 			if (timeRecord)
 				memset(timeRecord, 0, sizeof(TTimeRecord) * timeRecordSize);
@@ -289,9 +303,11 @@ public:
 	{
 	private:
 		// add channels without volume ramping
-		void addChannelsNormal(ChannelMixer* mixer, mp_uint32 numChannels, mp_sint32* buffer32,mp_sint32 beatNum, mp_sint32 beatlength);		
+		void addChannelsNormal(ChannelMixer* mixer, mp_uint32 firstChannel, mp_uint32 lastChannel, mp_sint32* buffer32,mp_sint32 beatNum, mp_sint32 beatlength);		
 		// add channels with volume ramping
-		void addChannelsRamping(ChannelMixer* mixer, mp_uint32 numChannels, mp_sint32* buffer32,mp_sint32 beatNum, mp_sint32 beatlength);		
+		void addChannelsRamping(ChannelMixer* mixer, mp_uint32 firstChannel, mp_uint32 lastChannel, mp_sint32* buffer32,mp_sint32 beatNum, mp_sint32 beatlength);		
+		// add channels one by one and record what each of them adds, see setScopeTap
+		void addChannelsTapped(ChannelMixer* mixer, mp_uint32 firstChannel, mp_uint32 lastChannel, mp_sint32* buffer32,mp_sint32 beatNum, mp_sint32 beatlength);		
 
 	public:
 		virtual ~ResamplerBase()
@@ -299,7 +315,12 @@ public:
 		}
 		
 		void addChannels(ChannelMixer* mixer, mp_uint32 numChannels, mp_sint32* buffer32,mp_sint32 beatNum, mp_sint32 beatlength);
+		// add channels firstChannel up to (but not including) lastChannel
+		void addChannelRange(ChannelMixer* mixer, mp_uint32 firstChannel, mp_uint32 lastChannel, mp_sint32* buffer32,mp_sint32 beatNum, mp_sint32 beatlength);
 		void addChannel(TMixerChannel* chn, mp_sint32* buffer32, const mp_sint32 beatlength, const mp_sint32 beatSize);		
+		// walk along the sample like addChannel does but without mixing anything,
+		// for channels which can't be heard
+		void skipChannel(TMixerChannel* chn, const mp_sint32 beatlength, const mp_sint32 beatSize);
 		
 		// walk along the sample
 		// intpart is the 32 bit integer part of the position
@@ -334,6 +355,19 @@ public:
 			ASSERT(false);	
 		}
 		
+		// if a silent channel may be skipped instead of being mixed, resamplers 
+		// which keep state that depends on the sample data can't do this
+		virtual bool supportsSkipping(const TMixerChannel* chn) { return true; }
+		
+		// move a silent channel count samples along without mixing it, 
+		// anything else the resampler keeps track of has to be moved as well
+		virtual void skipBlock(TMixerChannel* chn, mp_uint32 count)
+		{
+			const mp_sint32 smpadd = (chn->flags&MP_SAMPLE_BACKWARD) ? -chn->smpadd : chn->smpadd;
+			mp_sint32 fp = smpadd*count;
+			MP_INCREASESMPPOS(chn->smppos, chn->smpposfrac, fp, 16);
+		}
+		
 		// in case the resampler needs to get hold of the current mixing frequency
 		virtual void setFrequency(mp_sint32 frequency) { }
 
@@ -343,7 +377,53 @@ public:
 
 	friend class ChannelMixer::ResamplerBase;
 
+	// receives every channel mixed on its own instead of the sum of all 
+	// channels, see setStemListener
+	class StemListener
+	{
+	public:
+		virtual ~StemListener()
+		{
+		}
+		
+		// called after every beat packet, the interleaved stereo output of 
+		// channel c starts at buffers + c*numSamples*MP_NUMCHANNELS
+		virtual void stemsMixed(const mp_sint32* buffers, mp_uint32 numStems, mp_uint32 numSamples) = 0;
+	};
+
+	// lets other threads change the state of the mixer (or the player 
+	// derived from it) in sync with the mixing, see setCommandHandler
+	class CommandHandler
+	{
+	public:
+		virtual ~CommandHandler()
+		{
+		}
+		
+		// called on the mixing thread at the start of every beat packet,
+		// right before the timer handler
+		virtual void handleCommands(ChannelMixer& mixer) = 0;
+	};
+
 private:	
+	// mixes a range of channels of the current beat packet into 
+	// a partial buffer, see mixBeatPacketThreaded
+	class MixJob : public MixerThreadPool::Job
+	{
+	public:
+		ChannelMixer*	mixer;
+		mp_sint32*		buffer32;
+		mp_sint32		beatPacketIndex;
+		mp_sint32		beatPacketSize;
+		bool			stems;
+		mp_uint32		firstChannel[MixerThreadPool::MAXTHREADS+1];
+
+		virtual void execute(mp_uint32 taskIndex);
+	};
+	
+	friend class MixJob;
+	
+
 	mp_uint32	mixerNumAllocatedChannels;	// Number of channels to be allocated by mixer
 	mp_uint32	mixerNumActiveChannels;		// Number of channels to be mixed
 	mp_uint32	mixerLastNumAllocatedChannels;
@@ -372,18 +452,66 @@ private:
 	bool			disableMixing;
 	bool			allowFilters;
 
+	MixerThreadPool* threadPool;			// not owned, may be shared among several mixers
+	mp_uint32		threadChannelThreshold;	// minimum number of playing channels for threaded mixing
+	mp_sint32*		threadBuffers;			// one beat packet for every thread except the calling one
+	MixJob			mixJob;
+
+	StemListener*	stemListener;			// not owned
+	mp_uint32		numStems;
+	mp_sint32*		stemBuffers;			// one beat packet for every stem
+
+	CommandHandler*	commandHandler;			// not owned
+
+	class MixerProfiler* profiler;			// not owned
+
+	bool			scopeTapEnabled;
+	mp_uint32		scopeTapNumChannels;
+	mp_uint32		scopeTapPacketSize;		// scope tap samples per beat packet
+	mp_uint32		scopeTapSize;			// scope tap samples per channel, power of 2
+	mp_sword*		scopeTapBuffers;
+	mp_uint32		scopeTapNumStates;		// beat packets per channel, power of 2
+	TTimeRecord*	scopeTapStates;
+	mp_uint32		scopeTapPacket;			// index of the beat packet being mixed
+	volatile mp_sint32 scopeTapBufferStart;	// packed position of the last mixed buffer
+
 	void			setFrequency(mp_sint32 frequency);
 	
+	void			reallocThreadBuffers();
+	void			reallocStemBuffers();
+	void			reallocScopeTap();
+	
+	void			storeScopeTapStates();
+	void			locateScopeTap(mp_uint32 smpPos, mp_uint32& packet, mp_uint32& offset) const;
+	
+	mp_uint32		getNumPlayingChannels(mp_uint32 numChannels) const;
+	void			distributeChannels(mp_uint32 numChannels, mp_uint32 numPlaying, mp_uint32 numTasks);
+	
+	bool			mixBeatPacketThreaded(mp_uint32 numChannels,
+										  mp_sint32* buffer32,
+										  mp_sint32 beatPacketIndex, 
+										  mp_sint32 beatPacketSize);
+	
+	void			mixBeatPacketStems(mp_uint32 numChannels,
+									   mp_sint32* buffer32,
+									   mp_sint32 beatPacketIndex, 
+									   mp_sint32 beatPacketSize);
+	
 	void			mixBeatPacket(mp_uint32 numChannels,
 								  mp_sint32* buffer32,
 								  mp_sint32 beatPacketIndex, 
 								  mp_sint32 beatPacketSize) 
 	{ 
-		resamplerTable[resamplerType]->addChannels(this, numChannels, buffer32, beatPacketIndex, beatPacketSize);
+		if (stemListener)
+			mixBeatPacketStems(numChannels, buffer32, beatPacketIndex, beatPacketSize);
+		else if (threadPool == NULL || !mixBeatPacketThreaded(numChannels, buffer32, beatPacketIndex, beatPacketSize))
+			resamplerTable[resamplerType]->addChannels(this, numChannels, buffer32, beatPacketIndex, beatPacketSize);
 	}
 	
 	inline void		timer(mp_uint32 beatIndex)
 	{
+		if (commandHandler)
+			commandHandler->handleCommands(*this);
 		timerHandler(beatIndex <= getNumBeatPackets() ? beatIndex : getNumBeatPackets());
 	}
 	
@@ -412,6 +540,46 @@ public:
 	void			setAllowFilters(bool allowFilters) { this->allowFilters = allowFilters; }
 	bool			getAllowFilters() const { return allowFilters; }
 
+	// Spread the channels of each beat packet over the threads of the given pool
+	// as soon as at least channelThreshold channels are playing.
+	// Each thread mixes into its own buffer, those get summed up afterwards
+	// so the output is exactly the same as with single threaded mixing.
+	// Pass NULL to disable.
+	void			setThreadPool(MixerThreadPool* threadPool, mp_uint32 channelThreshold);
+	MixerThreadPool* getThreadPool() const { return threadPool; }
+
+	// Mix the first numStems channels each into a buffer of their own and 
+	// hand them to the listener after every beat packet (stem export).
+	// The regular output then only contains the remaining channels.
+	// Channels are spread over the thread pool whenever one is set.
+	// Pass NULL to disable.
+	void			setStemListener(StemListener* stemListener, mp_uint32 numStems);
+
+	// The command handler gets called before every beat packet, that's where
+	// commands queued up by other threads (see LockFreeQueue) can safely 
+	// be applied, without suspending the mixing. Pass NULL to disable.
+	void			setCommandHandler(CommandHandler* commandHandler) { this->commandHandler = commandHandler; }
+	CommandHandler*	getCommandHandler() const { return commandHandler; }
+
+	// The time spent in the timer handler, the resampler and on the ramping 
+	// state is added to the stages of the profiler. Pass NULL to disable.
+	void			setProfiler(MixerProfiler* profiler) { this->profiler = profiler; }
+	MixerProfiler*	getProfiler() const { return profiler; }
+
+	// Record a decimated mono copy of what every channel really adds to the
+	// output (after volume, panning and ramping), together with the channel
+	// state of every beat packet. Both are kept in ring buffers which other 
+	// threads can read without locking, see getScopeTapData/getScopeTapState.
+	void			setScopeTap(bool enabled);
+	bool			isScopeTapEnabled() const { return scopeTapEnabled; }
+	
+	// Fetch the last count samples of channel c up to the frame at smpPos
+	// of the last mixed buffer, i.e. what's audible right now if smpPos is 
+	// the position of the audio driver. Returns false if there is no tap.
+	bool			getScopeTapData(mp_uint32 c, mp_uint32 smpPos, mp_sword* buffer, mp_uint32 count) const;
+	// Channel state at the start of the beat packet containing smpPos
+	bool			getScopeTapState(mp_uint32 c, mp_uint32 smpPos, TTimeRecord& state) const;
+
 	void			resetChannelsFull();
 	void			resetChannelsWithoutMuting();
 	
@@ -439,6 +607,9 @@ public:
 	bool			isPlaying() const { return startPlay; }
 
 	mp_sint32		getNumActiveChannels();
+	// playing channels which were silent in the last beat packet and 
+	// have only been moved along instead of being mixed
+	mp_sint32		getNumSkippedChannels();
 	mp_sint32		getNumAllocatedChannels() const { return mixerNumActiveChannels; }
 
 	mp_int64		getSampleCounter() const { return sampleCounter; }
@@ -44,6 +44,20 @@ mp_uint32 LittleEndian::GET_DWORD(const void* ptr)
 	return ((mp_uint32)buffer[0]+((mp_uint32)buffer[1]<<8)+((mp_uint32)buffer[2]<<16)+((mp_uint32)buffer[3]<<24));
 }
 
+void LittleEndian::GET_WORDS(const void* src, mp_uword* dst, mp_uint32 count)
+{
+	const mp_ubyte* buffer = (const mp_ubyte*)src;
+	for (mp_uint32 i = 0; i < count; i++, buffer+=2)
+		dst[i] = ((mp_uword)buffer[0]+((mp_uword)buffer[1]<<8));
+}
+
+void LittleEndian::GET_DWORDS(const void* src, mp_uint32* dst, mp_uint32 count)
+{
+	const mp_ubyte* buffer = (const mp_ubyte*)src;
+	for (mp_uint32 i = 0; i < count; i++, buffer+=4)
+		dst[i] = ((mp_uint32)buffer[0]+((mp_uint32)buffer[1]<<8)+((mp_uint32)buffer[2]<<16)+((mp_uint32)buffer[3]<<24));
+}
+
 //////////////////////////////////////////////////////////////////////////
 // system independent loading of big endian numbers						//
 //////////////////////////////////////////////////////////////////////////
@@ -58,3 +72,17 @@ mp_uint32 BigEndian::GET_DWORD(const void* ptr)
 	const mp_ubyte* buffer = (const mp_ubyte*)ptr;
 	return ((mp_uint32)buffer[3]+((mp_uint32)buffer[2]<<8)+((mp_uint32)buffer[1]<<16)+((mp_uint32)buffer[0]<<24));
 }
+
+void BigEndian::GET_WORDS(const void* src, mp_uword* dst, mp_uint32 count)
+{
+	const mp_ubyte* buffer = (const mp_ubyte*)src;
+	for (mp_uint32 i = 0; i < count; i++, buffer+=2)
+		dst[i] = ((mp_uword)buffer[1]+((mp_uword)buffer[0]<<8));
+}
+
+void BigEndian::GET_DWORDS(const void* src, mp_uint32* dst, mp_uint32 count)
+{
+	const mp_ubyte* buffer = (const mp_ubyte*)src;
+	for (mp_uint32 i = 0; i < count; i++, buffer+=4)
+		dst[i] = ((mp_uint32)buffer[3]+((mp_uint32)buffer[2]<<8)+((mp_uint32)buffer[1]<<16)+((mp_uint32)buffer[0]<<24));
+}
@@ -44,6 +44,10 @@ class LittleEndian
 public:
 	static mp_uword			GET_WORD(const void* ptr);
 	static mp_uint32		GET_DWORD(const void* ptr);
+
+	// whole arrays, src and dst may point to the same memory
+	static void				GET_WORDS(const void* src, mp_uword* dst, mp_uint32 count);
+	static void				GET_DWORDS(const void* src, mp_uint32* dst, mp_uint32 count);
 };
 
 class BigEndian
@@ -51,6 +55,9 @@ class BigEndian
 public:
 	static mp_uword			GET_WORD(const void* ptr);
 	static mp_uint32		GET_DWORD(const void* ptr);
+
+	static void				GET_WORDS(const void* src, mp_uword* dst, mp_uint32 count);
+	static void				GET_DWORDS(const void* src, mp_uint32* dst, mp_uint32 count);
 };
 
 #endif
@@ -119,7 +119,7 @@ const char* LoaderMOD::identifyModule(const mp_ubyte* buffer)
 	if (!*uBuffer || *uBuffer > 128)
 		return NULL;
 
-	*uBuffer+=2;
+	uBuffer+=2;
 
 	for (i = 0; i < 128; i++)
 		if (uBuffer[i] > 128)
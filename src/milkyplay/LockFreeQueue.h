@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2009, The MilkyTracker Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the name of the <ORGANIZATION> nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ *  LockFreeQueue.h
+ *  MilkyPlay
+ *
+ *  Bounded queue for handing commands from one thread to exactly one
+ *  other thread (single producer, single consumer) without any locking,
+ *  so the audio thread can never be blocked by the thread feeding it.
+ *
+ */
+
+#ifndef __LOCKFREEQUEUE_H__
+#define __LOCKFREEQUEUE_H__
+
+#include "MilkyPlayAtomic.h"
+
+// size must be 2^n, Type must be copyable
+template<class Type, mp_uint32 size>
+class LockFreeQueue
+{
+private:
+	Type				items[size];
+	
+	// only ever incremented, the producer owns writeIndex, the consumer readIndex
+	volatile mp_sint32	readIndex;
+	volatile mp_sint32	writeIndex;
+	
+public:
+	LockFreeQueue() :
+		readIndex(0),
+		writeIndex(0)
+	{
+	}
+
+	// producer side, returns false if the queue is full
+	bool push(const Type& item)
+	{
+		const mp_uint32 index = (mp_uint32)writeIndex;
+		if (index - (mp_uint32)mpAtomicLoad(&readIndex) >= size)
+			return false;
+			
+		items[index & (size-1)] = item;
+		// publish the item after it has been written completely
+		mpAtomicStore(&writeIndex, (mp_sint32)(index+1));
+		return true;
+	}
+	
+	// consumer side, returns false if the queue is empty
+	bool pop(Type& item)
+	{
+		const mp_uint32 index = (mp_uint32)readIndex;
+		if (index == (mp_uint32)mpAtomicLoad(&writeIndex))
+			return false;
+		
+		item = items[index & (size-1)];
+		mpAtomicStore(&readIndex, (mp_sint32)(index+1));
+		return true;
+	}
+	
+	bool isEmpty() const 
+	{
+		return mpAtomicLoad(&readIndex) == mpAtomicLoad(&writeIndex);
+	}
+	
+	// Running counts of pushed and popped items, the producer can wait
+	// for the consumer to pick up everything it has pushed so far:
+	// hasPopped(getNumPushed())
+	mp_sint32 getNumPushed() const { return mpAtomicLoad(&writeIndex); }
+	bool hasPopped(mp_sint32 numPushed) const { return (mp_sint32)((mp_uint32)mpAtomicLoad(&readIndex) - (mp_uint32)numPushed) >= 0; }
+};
+
+#endif
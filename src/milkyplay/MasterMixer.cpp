@@ -39,6 +39,8 @@
 #include "MilkyPlayCommon.h"
 #include "AudioDriverBase.h"
 #include "AudioDriverManager.h"
+#include "MilkyPlayAtomic.h"
+#include "MilkyPlayTimer.h"
 
 enum
 {
@@ -58,12 +60,20 @@ MasterMixer::MasterMixer(mp_uint32 sampleRate,
 	numDevices(numDevices),
 	filterHook(0),
 	devices(new DeviceDescriptor[numDevices]),
+	mixerDevices(new DeviceDescriptor[numDevices]),
+	threadPool(0),
+	mixerThreadPool(0),
+	deviceBuffers(0),
+	mixerDeviceBuffers(0),
+	activeDevices(new mp_uint32[numDevices]),
+	numActiveDevices(0),
 	audioDriverManager(0),
 	audioDriver(audioDriver),
 	initialized(false),
 	started(false),
 	paused(false)
 {
+	mixJob.mixer = this;
 }
 
 MasterMixer::~MasterMixer()
@@ -72,6 +82,8 @@ MasterMixer::~MasterMixer()
 
 	delete audioDriverManager;
 	delete[] devices;
+	delete[] mixerDevices;
+	delete[] activeDevices;
 }
 
 void MasterMixer::setMasterMixerNotificationListener(MasterMixerNotificationListener* listener) 
@@ -119,6 +131,11 @@ mp_sint32 MasterMixer::openAudioDevice()
 	}
 	
 	buffer = new mp_sint32[bufferSize*MP_NUMCHANNELS];	
+	reallocDeviceBuffers();
+	// nothing is mixing yet
+	mixerDeviceBuffers = deviceBuffers;
+	
+	profiler.setBufferTime((mp_uint32)(((double)bufferSize * 1000000.0) / (double)sampleRate));
 	
 	initialized = true;	
 	return 0;
@@ -176,7 +193,11 @@ mp_sint32 MasterMixer::stop()
 
 	mp_sint32 res = audioDriver->stop();
 	if (res == 0)
+	{
 		started = false;
+		// the audio thread is gone, apply what it didn't get to
+		handleDeviceCommands();
+	}
 		
 	return res;
 }
@@ -205,6 +226,9 @@ mp_sint32 MasterMixer::setBufferSize(mp_uint32 bufferSize)
 		this->bufferSize = bufferSize;
 		delete[] buffer;
 		buffer = NULL;
+		delete[] deviceBuffers;
+		deviceBuffers = NULL;
+		mixerDeviceBuffers = NULL;
 		
 		notifyListener(MasterMixerNotificationBufferSizeChanged);
 	}
@@ -226,6 +250,113 @@ mp_sint32 MasterMixer::setSampleRate(mp_uint32 sampleRate)
 	return 0;
 }
 
+void MasterMixer::postDeviceCommand(DeviceCommands command, Mixable* mixable, bool paused/* = false*/, MixerThreadPool* threadPool/* = 0*/, mp_sint32* deviceBuffers/* = 0*/)
+{
+	TDeviceCommand deviceCommand;
+	deviceCommand.command = command;
+	deviceCommand.mixable = mixable;
+	deviceCommand.paused = paused;
+	deviceCommand.threadPool = threadPool;
+	deviceCommand.deviceBuffers = deviceBuffers;
+	
+	// nobody is mixing, so we're free to touch the mixer's device list
+	if (!started)
+	{
+		handleDeviceCommands();
+		applyDeviceCommand(deviceCommand);
+		return;
+	}
+	
+	if (!deviceCommands.push(deviceCommand))
+	{
+		// the audio thread has stopped picking up commands for some reason
+		waitForDeviceCommands();
+		if (!deviceCommands.push(deviceCommand))
+			applyDeviceCommand(deviceCommand);
+	}
+}
+
+bool MasterMixer::waitForDeviceCommands()
+{
+	if (!started)
+		return true;
+
+	const mp_sint32 numPushed = deviceCommands.getNumPushed();
+	
+	// this is going to loop infinitely when the audio device is not running
+	double waitMillis = ((double)(bufferSize/2) / (double)sampleRate) * 1000.0 * 2.0;
+	if (waitMillis < 1.0)
+		waitMillis = 1.0;
+	if (waitMillis > (double)BlockTimeOut)
+		waitMillis = (double)BlockTimeOut;
+	
+	// the commands are picked up at the start of the next buffer,
+	// poll in small steps so we don't wait much longer than that
+	mp_uint32 time = 0;
+	const mp_uint32 sleepTime = 1;
+	while (!deviceCommands.hasPopped(numPushed) && time < (mp_uint32)waitMillis)
+	{
+		audioDriver->msleep(sleepTime);
+		time+=sleepTime;
+	}
+	
+	// on timeout the commands stay queued, the audio thread
+	// still applies them before it mixes anything again
+	return deviceCommands.hasPopped(numPushed);
+}
+
+void MasterMixer::handleDeviceCommands()
+{
+	TDeviceCommand deviceCommand;
+	while (deviceCommands.pop(deviceCommand))
+		applyDeviceCommand(deviceCommand);
+}
+
+void MasterMixer::applyDeviceCommand(const TDeviceCommand& command)
+{
+	mp_uint32 i;
+	
+	switch (command.command)
+	{
+		case DeviceCommandAdd:
+			for (i = 0; i < numDevices; i++)
+			{
+				if (mixerDevices[i].mixable == NULL)
+				{
+					mixerDevices[i].mixable = command.mixable;
+					mixerDevices[i].paused = command.paused;
+					break;
+				}
+			}
+			break;
+			
+		case DeviceCommandRemove:
+		case DeviceCommandPause:
+		case DeviceCommandResume:
+			for (i = 0; i < numDevices; i++)
+			{
+				if (mixerDevices[i].mixable == command.mixable)
+				{
+					if (command.command == DeviceCommandRemove)
+						mixerDevices[i].mixable = NULL;
+					else
+						mixerDevices[i].paused = command.command == DeviceCommandPause;
+					break;
+				}
+			}
+			break;
+			
+		case DeviceCommandSetThreadPool:
+			mixerThreadPool = command.threadPool;
+			mixerDeviceBuffers = command.deviceBuffers;
+			break;
+			
+		case DeviceCommandFreeDeviceBuffers:
+			delete[] command.deviceBuffers;
+			break;
+	}
+}
+
 bool MasterMixer::addDevice(Mixable* device, bool paused/* = false*/)
 {
 	for (mp_uint32 i = 0; i < numDevices; i++)
@@ -233,9 +364,8 @@ bool MasterMixer::addDevice(Mixable* device, bool paused/* = false*/)
 		if (devices[i].mixable == NULL)
 		{
 			devices[i].mixable = device;
-			devices[i].markedForRemoval = false;
-			devices[i].markedForPause = false;
 			devices[i].paused = paused;
+			postDeviceCommand(DeviceCommandAdd, device, paused);
 			return true;
 		}
 	}
@@ -249,39 +379,13 @@ bool MasterMixer::removeDevice(Mixable* device, bool blocking/* = true*/)
 	{
 		if (devices[i].mixable == device)
 		{
-			if (!started)
-			{
-				devices[i].markedForRemoval = false;
-				devices[i].mixable = 0;
-				return true;				
-			}
-		
-			devices[i].markedForRemoval = true;
+			devices[i].mixable = NULL;
+			devices[i].paused = false;
+			postDeviceCommand(DeviceCommandRemove, device);
 			
+			// make sure the device is no longer being mixed
 			if (blocking)
-			{
-				// this is going to loop infinitely when the audio device is not running
-				double waitMillis = ((double)(bufferSize/2) / (double)sampleRate) * 1000.0 * 2.0;
-				if (waitMillis < 1.0)
-					waitMillis = 1.0;
-				if (waitMillis > (double)BlockTimeOut)
-					waitMillis = (double)BlockTimeOut;
-				
-				mp_uint32 time = 0;
-				const mp_uint32 sleepTime = 10;
-				while (devices[i].mixable && time < (mp_uint32)waitMillis)
-				{
-					audioDriver->msleep(sleepTime);
-					time+=sleepTime;
-				}
-				
-				// timeout
-				if (time >= waitMillis && devices[i].mixable)
-				{
-					devices[i].mixable = 0;
-					devices[i].markedForRemoval = false;
-				}
-			}
+				waitForDeviceCommands();
 			
 			return true;
 		}
@@ -309,39 +413,12 @@ bool MasterMixer::pauseDevice(Mixable* device, bool blocking/* = true*/)
 	{
 		if (devices[i].mixable == device)
 		{
-			if (!started)
-			{
-				devices[i].markedForPause = false;
-				devices[i].paused = true;
-				return true;				
-			}
-
-			devices[i].markedForPause = true;
+			devices[i].paused = true;
+			postDeviceCommand(DeviceCommandPause, device);
 
+			// make sure the device is no longer being mixed
 			if (blocking)
-			{
-				// this is going to loop infinitely when the audio device is not running
-				double waitMillis = ((double)(bufferSize/2) / (double)sampleRate) * 1000.0 * 2.0;
-				if (waitMillis < 1.0)
-					waitMillis = 1.0;
-				if (waitMillis > (double)BlockTimeOut)
-					waitMillis = (double)BlockTimeOut;
-				
-				mp_uint32 time = 0;
-				const mp_uint32 sleepTime = 10;
-				while (!devices[i].paused && time < (mp_uint32)waitMillis)
-				{
-					audioDriver->msleep(sleepTime);
-					time+=sleepTime;
-				}
-				
-				// timeout
-				if (time >= waitMillis && !devices[i].paused)
-				{
-					devices[i].paused = true;
-					devices[i].markedForPause = false;
-				}
-			}
+				waitForDeviceCommands();
 
 			return true;
 		}
@@ -357,6 +434,7 @@ bool MasterMixer::resumeDevice(Mixable* device)
 		if (devices[i].mixable == device && devices[i].paused)
 		{
 			devices[i].paused = false;
+			postDeviceCommand(DeviceCommandResume, device);
 			return true;
 		}
 	}
@@ -377,36 +455,123 @@ bool MasterMixer::isDevicePaused(Mixable* device)
 	return false;
 }
 
+bool MasterMixer::setThreadPool(MixerThreadPool* threadPool)
+{
+	if (threadPool == this->threadPool)
+		return true;
+	
+	// the audio thread has to let go of the old pool and 
+	// the device buffers before they can be replaced
+	postDeviceCommand(DeviceCommandSetThreadPool, NULL, false, NULL, NULL);
+	const bool released = waitForDeviceCommands();
+	
+	mp_sint32* oldDeviceBuffers = deviceBuffers;
+	deviceBuffers = NULL;
+	
+	this->threadPool = threadPool;
+	reallocDeviceBuffers();
+	
+	if (threadPool)
+		postDeviceCommand(DeviceCommandSetThreadPool, NULL, false, threadPool, deviceBuffers);
+
+	if (!released && oldDeviceBuffers)
+	{
+		// the audio thread is late and might still be mixing into the old
+		// buffers, it frees them itself after it has let go of them.
+		// If it doesn't pick up commands at all they are rather leaked.
+		TDeviceCommand deviceCommand;
+		deviceCommand.command = DeviceCommandFreeDeviceBuffers;
+		deviceCommand.mixable = NULL;
+		deviceCommand.paused = false;
+		deviceCommand.threadPool = NULL;
+		deviceCommand.deviceBuffers = oldDeviceBuffers;
+		deviceCommands.push(deviceCommand);
+		return false;
+	}
+	
+	delete[] oldDeviceBuffers;
+	return released;
+}
+
+void MasterMixer::reallocDeviceBuffers()
+{
+	delete[] deviceBuffers;
+	deviceBuffers = NULL;
+	
+	// the first device always mixes right into the output buffer
+	if (threadPool && threadPool->getNumThreads() > 1 && numDevices > 1 && buffer)
+		deviceBuffers = new mp_sint32[(numDevices-1)*bufferSize*MP_NUMCHANNELS];
+}
+
+mp_uint32 MasterMixer::getDeviceMixTime(Mixable* device) const
+{
+	for (mp_uint32 i = 0; i < numDevices; i++)
+	{
+		if (mixerDevices[i].mixable == device)
+			return (mp_uint32)mpAtomicLoad(&mixerDevices[i].mixTime);
+	}
+	
+	return 0;
+}
+
 void MasterMixer::mixerHandler(mp_sword* buffer)
 {
+	const mp_uint32 startTime = mpGetTimeMicros();
+
 	if (!disableMixing)
 		prepareBuffer();
 	
-	const register mp_sint32 numDevices = this->numDevices;
-	const register mp_uint32 bufferSize = this->bufferSize;
-	mp_sint32* mixBuffer = this->buffer;
+	mixDevices();
 	
-	DeviceDescriptor* device = this->devices;	
-	for (mp_sint32 i = 0; i < numDevices; i++, device++)
+	if (!disableMixing)
 	{
-		if (device->markedForRemoval && device->mixable)
-		{
-			device->markedForRemoval = false;
-			device->mixable = 0;
-		}  
-		else if (device->mixable && device->markedForPause)
-		{
-			device->markedForPause = false;
-			device->paused = true;
-		}
-		else if (device->mixable && !device->paused)
-		{
-			device->mixable->mix(mixBuffer, bufferSize);
-		}
+		filterBuffer();
+		const mp_uint32 outputTime = mpGetTimeMicros();
+		swapOutBuffer(buffer);
+		profiler.addStageTime(MixerProfiler::StageOutput, outputTime);
 	}
 	
+	profiler.endBuffer(startTime);
+}
+
+void MasterMixer::mixerHandler(float* buffer)
+{
+	const mp_uint32 startTime = mpGetTimeMicros();
+
+	if (!disableMixing)
+		prepareBuffer();
+	
+	mixDevices();
+	
 	if (!disableMixing)
+	{
+		filterBuffer();
+		const mp_uint32 outputTime = mpGetTimeMicros();
 		swapOutBuffer(buffer);
+		profiler.addStageTime(MixerProfiler::StageOutput, outputTime);
+	}
+	
+	profiler.endBuffer(startTime);
+}
+
+void MasterMixer::mixerHandler(float* bufferLeft, float* bufferRight)
+{
+	const mp_uint32 startTime = mpGetTimeMicros();
+
+	if (!disableMixing)
+		prepareBuffer();
+	
+	mixDevices();
+	
+	if (!disableMixing)
+	{
+		filterBuffer();
+		const mp_uint32 outputTime = mpGetTimeMicros();
+		swapOutBuffer(bufferLeft, bufferRight);
+		profiler.addStageTime(MixerProfiler::StageOutput, outputTime);
+	}
+	
+	profiler.endBuffer(startTime);
 }
 
 void MasterMixer::notifyListener(MasterMixerNotifications notification)
@@ -428,6 +593,10 @@ void MasterMixer::cleanup()
 		delete[] buffer;	
 		buffer = 0;
 	}
+	
+	delete[] deviceBuffers;
+	deviceBuffers = 0;
+	mixerDeviceBuffers = 0;
 }
 
 inline void MasterMixer::prepareBuffer()
@@ -435,11 +604,94 @@ inline void MasterMixer::prepareBuffer()
 	memset(buffer, 0, bufferSize*MP_NUMCHANNELS*sizeof(mp_sint32)); 
 }
 
-inline void MasterMixer::swapOutBuffer(mp_sword* bufferOut)
+inline void MasterMixer::mixDevices()
+{
+	handleDeviceCommands();
+
+	const register mp_sint32 numDevices = this->numDevices;
+	
+	numActiveDevices = 0;
+	DeviceDescriptor* device = this->mixerDevices;	
+	for (mp_sint32 i = 0; i < numDevices; i++, device++)
+	{
+		if (device->mixable && !device->paused)
+			activeDevices[numActiveDevices++] = i;
+		else
+			mpAtomicStore(&device->mixTime, 0);
+	}
+	
+	if (numActiveDevices > 1 && mixerThreadPool && mixerDeviceBuffers)
+	{
+		mixDevicesThreaded();
+		return;
+	}
+
+	mp_sint32* mixBuffer = this->buffer;
+	for (mp_uint32 i = 0; i < numActiveDevices; i++)
+		mixDevice(mixerDevices[activeDevices[i]], mixBuffer);
+}
+
+inline void MasterMixer::mixDevice(DeviceDescriptor& device, mp_sint32* buffer)
+{
+	const mp_uint32 startTime = mpGetTimeMicros();
+	
+	device.mixable->mix(buffer, bufferSize);
+	
+	mpAtomicStore(&device.mixTime, (mp_sint32)(mpGetTimeMicros() - startTime));
+}
+
+void MasterMixer::MixJob::execute(mp_uint32 taskIndex)
+{
+	mp_sint32* buffer = mixer->buffer;
+	
+	// the first device mixes right into the output buffer
+	if (taskIndex)
+	{
+		buffer = mixer->mixerDeviceBuffers + (taskIndex-1)*mixer->bufferSize*MP_NUMCHANNELS;
+		if (!mixer->disableMixing)
+			memset(buffer, 0, mixer->bufferSize*MP_NUMCHANNELS*sizeof(mp_sint32));
+	}
+	
+	mixer->mixDevice(mixer->mixerDevices[mixer->activeDevices[taskIndex]], buffer);
+}
+
+void MasterMixer::mixDevicesThreaded()
+{
+	mixerThreadPool->run(mixJob, numActiveDevices);
+	
+	if (disableMixing)
+		return;
+	
+	// sum up in device order
+	const mp_sint32 bufferSize = this->bufferSize*MP_NUMCHANNELS;
+	const mp_sint32* src = mixerDeviceBuffers;
+	for (mp_uint32 i = 1; i < numActiveDevices; i++)
+	{
+		mp_sint32* dst = buffer;
+		for (mp_sint32 j = 0; j < bufferSize; j++)
+			*dst++ += *src++;
+	}
+}
+
+inline void MasterMixer::filterBuffer()
 {
 	if (filterHook)
+	{
+		const mp_uint32 startTime = mpGetTimeMicros();
 		filterHook->mix(buffer, bufferSize);
+		profiler.addStageTime(MixerProfiler::StageRampingFiltering, startTime);
+	}
+}
+
+// the devices mix with 16 bit full scale and the sample shift
+// as headroom, so scale that to [-1.0, 1.0]
+inline float MasterMixer::getFloatScale() const
+{
+	return 1.0f / (32768.0f * (float)(1 << sampleShift));
+}
 
+inline void MasterMixer::swapOutBuffer(mp_sword* bufferOut)
+{
 	register mp_sint32* bufferIn = buffer;
 	const register mp_sint32 sampleShift = this->sampleShift; 
 	const register mp_sint32 lowerBound = -((128<<sampleShift)*256); 
@@ -453,7 +705,7 @@ inline void MasterMixer::swapOutBuffer(mp_sword* bufferOut)
 		else if (b<lowerBound) b = lowerBound; 
 		*bufferOut++ = b>>sampleShift;
 	}
-	
+
 	/*
 	mp_sint32* buffer32 = mixbuff32;
 	mp_sint32 lsampleShift = sampleShift; 
@@ -514,6 +766,29 @@ inline void MasterMixer::swapOutBuffer(mp_sword* bufferOut)
 	}*/
 }
 
+inline void MasterMixer::swapOutBuffer(float* bufferOut)
+{
+	register const mp_sint32* bufferIn = buffer;
+	const float scale = getFloatScale();
+	const register mp_sint32 bufferSize = this->bufferSize*MP_NUMCHANNELS;
+	
+	for (mp_sint32 i = 0; i < bufferSize; i++)
+		*bufferOut++ = (float)(*bufferIn++) * scale;
+}
+
+inline void MasterMixer::swapOutBuffer(float* bufferOutLeft, float* bufferOutRight)
+{
+	register const mp_sint32* bufferIn = buffer;
+	const float scale = getFloatScale();
+	const register mp_sint32 bufferSize = this->bufferSize;
+	
+	for (mp_sint32 i = 0; i < bufferSize; i++)
+	{
+		*bufferOutLeft++ = (float)(*bufferIn++) * scale;
+		*bufferOutRight++ = (float)(*bufferIn++) * scale;
+	}
+}
+
 const char*	MasterMixer::getCurrentAudioDriverName() const
 {
 	if (audioDriver)
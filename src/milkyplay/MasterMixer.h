@@ -39,6 +39,9 @@
 #define __MASTERMIXER_H__
 
 #include "Mixable.h"
+#include "LockFreeQueue.h"
+#include "MixerThreadPool.h"
+#include "MixerProfiler.h"
 
 class MasterMixer
 {
@@ -94,8 +97,33 @@ public:
 	bool pauseDevice(Mixable* device, bool blocking = true);
 	bool resumeDevice(Mixable* device);
 	bool isDevicePaused(Mixable* device);
+
+	// With a thread pool (not owned, can be shared with the devices) the 
+	// devices are mixed in parallel, each of them into a buffer of its own. 
+	// The buffers are summed up in device order, so the output is the same 
+	// as without a pool. Devices mixing on the pool themselves will mix 
+	// on a single thread then, so this only pays off with several busy devices.
+	// NULL mixes one device after another on the audio thread.
+	// Returns false if the audio thread might still be using the old pool.
+	bool setThreadPool(MixerThreadPool* threadPool);
+	MixerThreadPool* getThreadPool() const { return threadPool; }
+
+	// time in microseconds it took to mix the last buffer of the device,
+	// 0 if the device isn't being mixed
+	mp_uint32 getDeviceMixTime(Mixable* device) const;
+
+	// load of the audio thread, see MixerProfiler. The devices only 
+	// add to the stages when they're given the profiler as well 
+	// (see ChannelMixer::setProfiler), the audio drivers report 
+	// underruns and late callbacks to it.
+	MixerProfiler& getProfiler() { return profiler; }
 		
+	// 16 bit interleaved stereo output, clipped
 	void mixerHandler(mp_sword* buffer);
+	// 32 bit float interleaved stereo output, not clipped (1.0 = full scale)
+	void mixerHandler(float* buffer);
+	// 32 bit float non-interleaved stereo output, not clipped (1.0 = full scale)
+	void mixerHandler(float* bufferLeft, float* bufferRight);
 	
 	// allows to control the loudness of the resulting output stream
 	// by bit-shifting the output *right* (dividing by 2^shift)
@@ -132,20 +160,70 @@ private:
 	struct DeviceDescriptor
 	{
 		Mixable* mixable;
-		bool markedForRemoval;
-		bool markedForPause;
 		bool paused;
-	
+		// only used in the mixer's copy, written by the audio thread
+		volatile mp_sint32 mixTime;
+		
 		DeviceDescriptor() :
 			mixable(0),
-			markedForRemoval(false),
-			markedForPause(false),
-			paused(false)
+			paused(false),
+			mixTime(0)
 		{
 		}
 	};
+
+	// Changes to the device list are queued up for the audio thread which
+	// applies them to its own copy of the list before mixing the next buffer,
+	// so the audio thread never sees a half updated device
+	enum DeviceCommands
+	{
+		DeviceCommandAdd,
+		DeviceCommandRemove,
+		DeviceCommandPause,
+		DeviceCommandResume,
+		DeviceCommandSetThreadPool,
+		DeviceCommandFreeDeviceBuffers
+	};
 	
-	DeviceDescriptor* devices;
+	struct TDeviceCommand
+	{
+		mp_sint32 command;
+		Mixable* mixable;
+		bool paused;
+		MixerThreadPool* threadPool;
+		mp_sint32* deviceBuffers;
+	};
+
+	// mixes one of the active devices, see mixDevicesThreaded
+	class MixJob : public MixerThreadPool::Job
+	{
+	public:
+		MasterMixer* mixer;
+
+		virtual void execute(mp_uint32 taskIndex);
+	};
+	
+	friend class MixJob;
+
+	enum
+	{
+		// must be 2^n
+		DeviceCommandQueueSize = 64
+	};
+
+	DeviceDescriptor* devices;			// the devices as requested, never touched by the audio thread
+	DeviceDescriptor* mixerDevices;		// the devices as mixed, only touched by the audio thread
+	LockFreeQueue<TDeviceCommand, DeviceCommandQueueSize> deviceCommands;
+
+	MixerThreadPool* threadPool;		// as requested
+	MixerThreadPool* mixerThreadPool;	// as used by the audio thread
+	mp_sint32* deviceBuffers;			// one buffer for every device except the first one
+	mp_sint32* mixerDeviceBuffers;		// as used by the audio thread
+	mp_uint32* activeDevices;			// indices of the devices mixed in the current buffer
+	mp_uint32 numActiveDevices;
+	MixJob mixJob;
+	
+	MixerProfiler profiler;
 	
 	mutable class AudioDriverManager* audioDriverManager;
 	AudioDriverInterface* audioDriver;
@@ -155,11 +233,25 @@ private:
 	bool paused;
 	
 	void notifyListener(MasterMixerNotifications notification);
+
+	void postDeviceCommand(DeviceCommands command, Mixable* mixable, bool paused = false, MixerThreadPool* threadPool = 0, mp_sint32* deviceBuffers = 0);
+	// false if the audio thread hasn't picked up the commands in time
+	bool waitForDeviceCommands();
+	void handleDeviceCommands();
+	void applyDeviceCommand(const TDeviceCommand& command);
 	
 	void cleanup();
+	void reallocDeviceBuffers();
 	
 	inline void prepareBuffer();
+	inline void mixDevices();
+	inline void mixDevice(DeviceDescriptor& device, mp_sint32* buffer);
+	void mixDevicesThreaded();
+	inline void filterBuffer();
+	inline float getFloatScale() const;
 	inline void swapOutBuffer(mp_sword* bufferOut);
+	inline void swapOutBuffer(float* bufferOut);
+	inline void swapOutBuffer(float* bufferOutLeft, float* bufferOutRight);
 };
 
 #endif
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2009, The MilkyTracker Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the name of the <ORGANIZATION> nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ *  MilkyPlayAtomic.h
+ *  MilkyPlay
+ *
+ *  Minimal set of atomic operations on 32 bit integers, used for 
+ *  communication between the audio thread and other threads.
+ *  All operations imply a full memory barrier.
+ *
+ */
+
+#ifndef __MILKYPLAYATOMIC_H__
+#define __MILKYPLAYATOMIC_H__
+
+#include "MilkyPlayCommon.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// atomically add delta to value and return the new value
+static inline mp_sint32 mpAtomicAdd(volatile mp_sint32* value, mp_sint32 delta)
+{
+#if defined(_MSC_VER)
+	return _InterlockedExchangeAdd((volatile long*)value, delta) + delta;
+#else
+	return __sync_add_and_fetch(value, delta);
+#endif
+}
+
+// replace value with newValue if it still equals oldValue
+static inline bool mpAtomicCompareAndSwap(volatile mp_sint32* value, mp_sint32 oldValue, mp_sint32 newValue)
+{
+#if defined(_MSC_VER)
+	return _InterlockedCompareExchange((volatile long*)value, newValue, oldValue) == oldValue;
+#else
+	return __sync_bool_compare_and_swap(value, oldValue, newValue);
+#endif
+}
+
+static inline void mpMemoryBarrier()
+{
+#if defined(_MSC_VER)
+	_ReadWriteBarrier();
+	MemoryBarrier();
+#else
+	__sync_synchronize();
+#endif
+}
+
+// read a value written by another thread
+// everything written before the corresponding mpAtomicStore is visible afterwards 
+static inline mp_sint32 mpAtomicLoad(const volatile mp_sint32* value)
+{
+	const mp_sint32 result = *value;
+	mpMemoryBarrier();
+	return result;
+}
+
+// publish a value to other threads, see mpAtomicLoad
+static inline void mpAtomicStore(volatile mp_sint32* value, mp_sint32 newValue)
+{
+	mpMemoryBarrier();
+	*value = newValue;
+}
+
+#endif
@@ -89,7 +89,10 @@
 
 #define MP_NUMEFFECTS 4
 
-#if defined(WIN32) || defined(_WIN32_WCE) && !defined(__FORCE_SDL_AUDIO__)
+#if defined(__FORCE_NULL_AUDIO__)
+	// headless, e.g. command line tools which only render to files
+	#define DRIVER_NULL
+#elif defined(WIN32) || defined(_WIN32_WCE) && !defined(__FORCE_SDL_AUDIO__)
 	#define DRIVER_WIN32
 #elif defined(__APPLE__) && !defined(__FORCE_SDL_AUDIO__)
 	#define DRIVER_OSX
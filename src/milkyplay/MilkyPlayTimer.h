@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2009, The MilkyTracker Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the name of the <ORGANIZATION> nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ *  MilkyPlayTimer.h
+ *  MilkyPlay
+ *
+ *  High resolution clock for measuring how long the mixer takes.
+ *  Only meant for differences, the result wraps around every 71 minutes,
+ *  so always subtract as unsigned.
+ *
+ */
+
+#ifndef __MILKYPLAYTIMER_H__
+#define __MILKYPLAYTIMER_H__
+
+#include "MilkyPlayCommon.h"
+
+#if !defined(WIN32) && !defined(_WIN32_WCE)
+#include <sys/time.h>
+#endif
+
+// current time in microseconds
+static inline mp_uint32 mpGetTimeMicros()
+{
+#if defined(WIN32) || defined(_WIN32_WCE)
+	static LARGE_INTEGER frequency = {0};
+	if (frequency.QuadPart == 0)
+		QueryPerformanceFrequency(&frequency);
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	// split up so the multiplication can't overflow
+	return (mp_uint32)((counter.QuadPart / frequency.QuadPart) * 1000000 + 
+					   ((counter.QuadPart % frequency.QuadPart) * 1000000) / frequency.QuadPart);
+#else
+	timeval tv;
+	gettimeofday(&tv, NULL);
+	return (mp_uint32)tv.tv_sec * 1000000 + (mp_uint32)tv.tv_usec;
+#endif
+}
+
+#endif
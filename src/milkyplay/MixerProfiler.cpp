@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2009, The MilkyTracker Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the name of the <ORGANIZATION> nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ *  MixerProfiler.cpp
+ *  MilkyPlay
+ *
+ *  The stats are published like a sequence lock: the audio thread makes 
+ *  the sequence odd while it's writing, readers copy the stats and try 
+ *  again when the sequence was odd or has changed in the meantime.
+ *  The audio thread never waits for a reader.
+ *
+ */
+
+#include "MixerProfiler.h"
+
+// weight of the latest buffer in the averages
+#define MP_PROFILERAVERAGEWEIGHT (1.0f/16.0f)
+
+MixerProfiler::MixerProfiler() :
+	numUnderruns(0),
+	numLateCallbacks(0),
+	numUnderrunsAtReset(0),
+	numLateCallbacksAtReset(0),
+	resetRequested(0),
+	sequence(0),
+	bufferTime(0),
+	averageMixTime(0.0f)
+{
+	memset(&stats, 0, sizeof(stats));
+
+	for (mp_sint32 i = 0; i < NumStages; i++)
+	{
+		stageTimes[i] = 0;
+		averageStageTimes[i] = 0.0f;
+	}
+}
+
+void MixerProfiler::setBufferTime(mp_uint32 bufferTime)
+{
+	this->bufferTime = bufferTime;
+	reset();
+}
+
+void MixerProfiler::endBuffer(mp_uint32 startTime)
+{
+	const mp_uint32 mixTime = mpGetTimeMicros() - startTime;
+	
+	// take out what has been collected, subtracting it keeps 
+	// whatever another thread might have added in the meantime
+	mp_uint32 times[NumStages];
+	mp_sint32 i;
+	for (i = 0; i < NumStages; i++)
+	{
+		times[i] = (mp_uint32)mpAtomicLoad(&stageTimes[i]);
+		mpAtomicAdd(&stageTimes[i], -(mp_sint32)times[i]);
+	}
+	
+	const bool reset = mpAtomicCompareAndSwap(&resetRequested, 1, 0);
+	
+	if (reset)
+	{
+		averageMixTime = (float)mixTime;
+		for (i = 0; i < NumStages; i++)
+			averageStageTimes[i] = (float)times[i];
+	}
+	else
+	{
+		averageMixTime+=((float)mixTime - averageMixTime) * MP_PROFILERAVERAGEWEIGHT;
+		for (i = 0; i < NumStages; i++)
+			averageStageTimes[i]+=((float)times[i] - averageStageTimes[i]) * MP_PROFILERAVERAGEWEIGHT;
+	}
+	
+	mpAtomicAdd(&sequence, 1);
+	
+	if (reset)
+	{
+		stats.numBuffers = 0;
+		stats.peakMixTime = 0;
+		for (i = 0; i < NumStages; i++)
+			stats.peakStageTimes[i] = 0;
+	}
+	
+	stats.numBuffers++;
+	stats.bufferTime = bufferTime;
+	stats.mixTime = mixTime;
+	stats.averageMixTime = (mp_uint32)(averageMixTime + 0.5f);
+	if (mixTime > stats.peakMixTime)
+		stats.peakMixTime = mixTime;
+	
+	for (i = 0; i < NumStages; i++)
+	{
+		stats.stageTimes[i] = times[i];
+		stats.averageStageTimes[i] = (mp_uint32)(averageStageTimes[i] + 0.5f);
+		if (times[i] > stats.peakStageTimes[i])
+			stats.peakStageTimes[i] = times[i];
+	}
+	
+	mpAtomicAdd(&sequence, 1);
+}
+
+void MixerProfiler::getStats(Stats& stats) const
+{
+	for (;;)
+	{
+		const mp_sint32 start = mpAtomicLoad(&sequence);
+		if (start & 1)
+			continue;
+
+		stats = this->stats;
+		
+		if (mpAtomicLoad(&sequence) == start)
+			break;
+	}
+	
+	// the counters don't depend on the mixer running
+	stats.numUnderruns = (mp_uint32)(mpAtomicLoad(&numUnderruns) - mpAtomicLoad(&numUnderrunsAtReset));
+	stats.numLateCallbacks = (mp_uint32)(mpAtomicLoad(&numLateCallbacks) - mpAtomicLoad(&numLateCallbacksAtReset));
+	stats.bufferTime = bufferTime;
+}
+
+void MixerProfiler::reset()
+{
+	mpAtomicStore(&numUnderrunsAtReset, mpAtomicLoad(&numUnderruns));
+	mpAtomicStore(&numLateCallbacksAtReset, mpAtomicLoad(&numLateCallbacks));
+	
+	// the audio thread takes care of the rest
+	mpAtomicStore(&resetRequested, 1);
+}
+
+const char* MixerProfiler::getStageName(Stages stage)
+{
+	switch (stage)
+	{
+		case StageSequencing:
+			return "Sequencing";
+		case StageResampling:
+			return "Resampling";
+		case StageRampingFiltering:
+			return "Ramping/filtering";
+		case StageOutput:
+			return "Output";
+		default:
+			return "";
+	}
+}
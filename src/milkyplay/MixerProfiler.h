@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2009, The MilkyTracker Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the name of the <ORGANIZATION> nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ *  MixerProfiler.h
+ *  MilkyPlay
+ *
+ *  Keeps track of how long the audio thread takes for every buffer and 
+ *  which part of the mixing the time goes to, along with the underruns 
+ *  and late callbacks the audio driver has noticed.
+ *  The mixer writes the figures after every buffer, any other thread can 
+ *  read them at any time without locking (see getStats).
+ *  All times are in microseconds.
+ *
+ */
+
+#ifndef __MIXERPROFILER_H__
+#define __MIXERPROFILER_H__
+
+#include "MilkyPlayAtomic.h"
+#include "MilkyPlayTimer.h"
+
+class MixerProfiler
+{
+public:
+	enum Stages
+	{
+		// the players' timer handlers, that's where the song is played
+		StageSequencing,
+		// mixing the channels, volume ramping and the channel filters
+		// are part of the resamplers and can't be told apart from it
+		StageResampling,
+		// saving the ramping and filter states between the beat packets 
+		// and the master filter hook
+		StageRampingFiltering,
+		// conversion of the mix to the format of the audio driver
+		StageOutput,
+		NumStages
+	};
+	
+	struct Stats
+	{
+		mp_uint32 numBuffers;					// buffers mixed since the last reset
+		mp_uint32 bufferTime;					// how long one buffer plays
+		mp_uint32 mixTime;						// audio thread time of the last buffer
+		mp_uint32 averageMixTime;
+		mp_uint32 peakMixTime;					// since the last reset
+		// time spent in the stages during the last buffer, when the
+		// devices or channels are mixed on several threads this adds up
+		// the time of all threads, so it can exceed the mix time
+		mp_uint32 stageTimes[NumStages];
+		mp_uint32 averageStageTimes[NumStages];
+		mp_uint32 peakStageTimes[NumStages];
+		mp_uint32 numUnderruns;					// since the last reset
+		mp_uint32 numLateCallbacks;				// since the last reset
+		
+		// time in percent of the buffer time
+		mp_uint32 getLoad(mp_uint32 time) const 
+		{ 
+			return bufferTime ? (mp_uint32)(((double)time * 100.0) / (double)bufferTime + 0.5) : 0; 
+		}
+	};
+
+private:
+	// collected while the current buffer is mixed, from any thread
+	volatile mp_sint32 stageTimes[NumStages];
+	
+	// reported by the audio driver
+	volatile mp_sint32 numUnderruns;
+	volatile mp_sint32 numLateCallbacks;
+	volatile mp_sint32 numUnderrunsAtReset;
+	volatile mp_sint32 numLateCallbacksAtReset;
+	
+	volatile mp_sint32 resetRequested;
+
+	// odd while stats is being written
+	volatile mp_sint32 sequence;
+	Stats stats;
+	
+	// only touched by the audio thread
+	mp_uint32 bufferTime;
+	float averageMixTime;
+	float averageStageTimes[NumStages];
+
+public:
+	MixerProfiler();
+	
+	// the mixer tells how long a buffer plays when the audio device 
+	// is opened, the figures start over then
+	void setBufferTime(mp_uint32 bufferTime);
+	
+	// adds the time since startTime (see mpGetTimeMicros) to the given 
+	// stage of the current buffer and returns the current time, so the 
+	// next stage can be measured right away. Can be called from any thread.
+	mp_uint32 addStageTime(Stages stage, mp_uint32 startTime)
+	{
+		const mp_uint32 time = mpGetTimeMicros();
+		mpAtomicAdd(&stageTimes[stage], (mp_sint32)(time - startTime));
+		return time;
+	}
+	
+	// the mixer is done with a buffer it started at startTime
+	void endBuffer(mp_uint32 startTime);
+
+	// called by the audio drivers, from any thread
+	void reportUnderrun() { mpAtomicAdd(&numUnderruns, 1); }
+	void reportLateCallback() { mpAtomicAdd(&numLateCallbacks, 1); }
+	
+	// consistent copy of the figures of the last buffer, from any thread
+	void getStats(Stats& stats) const;
+	
+	// start over with the peaks and counters
+	void reset();
+	
+	static const char* getStageName(Stages stage);
+};
+
+#endif
@@ -0,0 +1,306 @@
+/*
+ * Copyright (c) 2009, The MilkyTracker Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the name of the <ORGANIZATION> nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ *  MixerThreadPool.cpp
+ *  MilkyPlay
+ *
+ *  Every worker takes part in every job (even if there is nothing left to
+ *  do for it), run() only returns after all workers have checked in. 
+ *  That way no worker can still be busy with a previous job when the next
+ *  one is set up. Workers spin for a short while after each job because
+ *  the mixer usually hands out several jobs in a row (one per beat packet).
+ *
+ */
+
+#include "MixerThreadPool.h"
+#include "MilkyPlayAtomic.h"
+
+#if defined(__PSP__) || defined(_WIN32_WCE)
+	#define __MPNOTHREADS__
+#elif defined(WIN32)
+	#define __MPTHREADS_WIN32__
+	#include <windows.h>
+#else
+	#define __MPTHREADS_PTHREAD__
+	#include <pthread.h>
+	#include <sched.h>
+	#include <unistd.h>
+#endif
+
+// how many times a worker polls for new work before it goes to sleep
+#define MP_WORKERSPINCOUNT 4096
+
+static inline void cpuRelax()
+{
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+	__builtin_ia32_pause();
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+	YieldProcessor();
+#endif
+}
+
+static inline void yieldThread()
+{
+#if defined(__MPTHREADS_WIN32__)
+	SwitchToThread();
+#elif defined(__MPTHREADS_PTHREAD__)
+	sched_yield();
+#endif
+}
+
+#if defined(__MPTHREADS_WIN32__)
+
+struct MixerThreadPool::TPlatformData
+{
+	HANDLE threads[MAXTHREADS];
+	HANDLE wakeUp;
+};
+
+static DWORD WINAPI threadProc(LPVOID pool)
+{
+	MixerThreadPool::workerEntry(pool);
+	return 0;
+}
+
+#elif defined(__MPTHREADS_PTHREAD__)
+
+struct MixerThreadPool::TPlatformData
+{
+	pthread_t threads[MAXTHREADS];
+	pthread_mutex_t mutex;
+	pthread_cond_t wakeUp;
+	// the thread the workers have taken their scheduling from
+	pthread_t caller;
+	bool hasCaller;
+};
+
+#else
+
+struct MixerThreadPool::TPlatformData
+{
+};
+
+#endif
+
+MixerThreadPool::MixerThreadPool(mp_uint32 numThreads) :
+	numThreads(numThreads),
+	platformData(NULL),
+	job(NULL),
+	numTasks(0),
+	nextTask(0),
+	generation(0),
+	workersDone(0),
+	busy(0),
+	quit(0)
+{
+	// more threads than processors would just make the threads wait for each other
+	if (this->numThreads == 0 || this->numThreads > getNumProcessors())
+		this->numThreads = getNumProcessors();
+	if (this->numThreads > MAXTHREADS)
+		this->numThreads = MAXTHREADS;
+	
+	platformData = new TPlatformData;
+
+	mp_uint32 i;
+	
+#if defined(__MPTHREADS_WIN32__)
+	platformData->wakeUp = CreateSemaphore(NULL, 0, MAXTHREADS*1024, NULL);
+	for (i = 1; i < this->numThreads; i++)
+	{
+		platformData->threads[i] = CreateThread(NULL, 0, threadProc, this, 0, NULL);
+		if (platformData->threads[i] == NULL)
+			break;
+		SetThreadPriority(platformData->threads[i], THREAD_PRIORITY_TIME_CRITICAL);
+	}
+	this->numThreads = i;
+#elif defined(__MPTHREADS_PTHREAD__)
+	pthread_mutex_init(&platformData->mutex, NULL);
+	pthread_cond_init(&platformData->wakeUp, NULL);
+	platformData->hasCaller = false;
+	for (i = 1; i < this->numThreads; i++)
+	{
+		if (pthread_create(&platformData->threads[i], NULL, workerEntry, this) != 0)
+			break;
+	}
+	this->numThreads = i;
+#else
+	this->numThreads = 1;
+#endif
+}
+
+MixerThreadPool::~MixerThreadPool()
+{
+	mpAtomicStore(&quit, 1);
+
+	mp_uint32 i;
+	
+#if defined(__MPTHREADS_WIN32__)
+	ReleaseSemaphore(platformData->wakeUp, numThreads, NULL);
+	for (i = 1; i < numThreads; i++)
+	{
+		WaitForSingleObject(platformData->threads[i], INFINITE);
+		CloseHandle(platformData->threads[i]);
+	}
+	CloseHandle(platformData->wakeUp);
+#elif defined(__MPTHREADS_PTHREAD__)
+	pthread_mutex_lock(&platformData->mutex);
+	pthread_cond_broadcast(&platformData->wakeUp);
+	pthread_mutex_unlock(&platformData->mutex);
+	for (i = 1; i < numThreads; i++)
+		pthread_join(platformData->threads[i], NULL);
+	pthread_cond_destroy(&platformData->wakeUp);
+	pthread_mutex_destroy(&platformData->mutex);
+#endif
+
+	delete platformData;
+}
+
+void MixerThreadPool::processTasks()
+{
+	const mp_sint32 numTasks = this->numTasks;
+	Job* job = this->job;
+	
+	mp_sint32 task;
+	while ((task = mpAtomicAdd(&nextTask, 1) - 1) < numTasks)
+		job->execute(task);
+}
+
+void* MixerThreadPool::workerEntry(void* pool)
+{
+	static_cast<MixerThreadPool*>(pool)->workerLoop();
+	return NULL;
+}
+
+void MixerThreadPool::workerLoop()
+{
+	mp_sint32 lastGeneration = 0;
+
+	for (;;)
+	{
+		mp_sint32 spin = MP_WORKERSPINCOUNT;
+		while (mpAtomicLoad(&generation) == lastGeneration && !mpAtomicLoad(&quit) && spin--)
+			cpuRelax();
+
+#if defined(__MPTHREADS_WIN32__)
+		while (mpAtomicLoad(&generation) == lastGeneration && !mpAtomicLoad(&quit))
+			WaitForSingleObject(platformData->wakeUp, INFINITE);
+#elif defined(__MPTHREADS_PTHREAD__)
+		if (mpAtomicLoad(&generation) == lastGeneration && !mpAtomicLoad(&quit))
+		{
+			pthread_mutex_lock(&platformData->mutex);
+			while (mpAtomicLoad(&generation) == lastGeneration && !mpAtomicLoad(&quit))
+				pthread_cond_wait(&platformData->wakeUp, &platformData->mutex);
+			pthread_mutex_unlock(&platformData->mutex);
+		}
+#endif
+
+		if (mpAtomicLoad(&quit))
+			break;
+		
+		lastGeneration = mpAtomicLoad(&generation);
+		
+		processTasks();
+		
+		mpAtomicAdd(&workersDone, 1);
+	}
+}
+
+void MixerThreadPool::run(Job& job, mp_uint32 numTasks)
+{
+	if (numThreads <= 1 || numTasks <= 1 || !mpAtomicCompareAndSwap(&busy, 0, 1))
+	{
+		for (mp_uint32 i = 0; i < numTasks; i++)
+			job.execute(i);
+		return;
+	}
+
+	this->job = &job;
+	this->numTasks = numTasks;
+	this->workersDone = 0;
+	mpAtomicStore(&nextTask, 0);
+	
+#if defined(__MPTHREADS_WIN32__)
+	mpAtomicAdd(&generation, 1);
+	ReleaseSemaphore(platformData->wakeUp, numThreads - 1, NULL);
+#elif defined(__MPTHREADS_PTHREAD__)
+	// The calling thread waits for the workers, so they need its scheduling 
+	// policy and priority, otherwise a realtime audio thread would be held up 
+	// by anything which preempts the workers. Taken over whenever another 
+	// thread starts using the pool, without the permission to change the 
+	// scheduling the workers just stay where they are.
+	const pthread_t caller = pthread_self();
+	if (!platformData->hasCaller || !pthread_equal(caller, platformData->caller))
+	{
+		platformData->caller = caller;
+		platformData->hasCaller = true;
+		
+		int policy;
+		sched_param param;
+		if (pthread_getschedparam(caller, &policy, &param) == 0)
+		{
+			for (mp_uint32 i = 1; i < numThreads; i++)
+				pthread_setschedparam(platformData->threads[i], policy, &param);
+		}
+	}
+
+	pthread_mutex_lock(&platformData->mutex);
+	mpAtomicAdd(&generation, 1);
+	pthread_cond_broadcast(&platformData->wakeUp);
+	pthread_mutex_unlock(&platformData->mutex);
+#endif
+
+	processTasks();
+	
+	// wait for all workers to check in
+	mp_sint32 spin = 0;
+	while (mpAtomicLoad(&workersDone) < (mp_sint32)numThreads - 1)
+	{
+		if (++spin < MP_WORKERSPINCOUNT)
+			cpuRelax();
+		else
+			yieldThread();
+	}
+	
+	mpAtomicStore(&busy, 0);
+}
+
+mp_uint32 MixerThreadPool::getNumProcessors()
+{
+#if defined(__MPTHREADS_WIN32__)
+	SYSTEM_INFO systemInfo;
+	GetSystemInfo(&systemInfo);
+	return systemInfo.dwNumberOfProcessors;
+#elif defined(__MPTHREADS_PTHREAD__) && defined(_SC_NPROCESSORS_ONLN)
+	const long numProcessors = sysconf(_SC_NPROCESSORS_ONLN);
+	return numProcessors > 0 ? (mp_uint32)numProcessors : 1;
+#else
+	return 1;
+#endif
+}
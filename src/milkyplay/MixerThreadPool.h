@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2009, The MilkyTracker Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the name of the <ORGANIZATION> nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ *  MixerThreadPool.h
+ *  MilkyPlay
+ *
+ *  A small pool of worker threads for splitting up mixing work on the 
+ *  audio thread. The calling thread always takes part in the work, so a 
+ *  pool with one thread just runs everything on the calling thread.
+ *
+ */
+
+#ifndef __MIXERTHREADPOOL_H__
+#define __MIXERTHREADPOOL_H__
+
+#include "MilkyPlayTypes.h"
+
+class MixerThreadPool
+{
+public:
+	enum
+	{
+		MAXTHREADS = 32
+	};
+
+	class Job
+	{
+	public:
+		virtual ~Job()
+		{
+		}
+		
+		// called exactly once for every task index, from any of the pool's threads
+		virtual void execute(mp_uint32 taskIndex) = 0;
+	};
+
+private:
+	struct TPlatformData;
+
+	mp_uint32				numThreads;
+	TPlatformData*			platformData;
+
+	Job* volatile			job;
+	volatile mp_sint32		numTasks;
+	volatile mp_sint32		nextTask;
+	volatile mp_sint32		generation;
+	volatile mp_sint32		workersDone;
+	volatile mp_sint32		busy;
+	volatile mp_sint32		quit;
+
+	void					processTasks();
+	void					workerLoop();
+	
+public:
+	// thread entry point, not to be called directly
+	static void*			workerEntry(void* pool);
+
+
+	// numThreads is the total number of threads including the calling thread,
+	// it's limited to the number of available processors (which is also used for 0)
+							MixerThreadPool(mp_uint32 numThreads);
+							~MixerThreadPool();
+	
+	mp_uint32				getNumThreads() const { return numThreads; }
+
+	// Executes job.execute(0) ... job.execute(numTasks-1) and returns 
+	// when all of them are finished.
+	// When the pool is already running a job (e.g. run is called 
+	// from within a job) the tasks are executed on the calling thread.
+	void					run(Job& job, mp_uint32 numTasks);
+	
+	static mp_uint32		getNumProcessors();
+};
+
+#endif
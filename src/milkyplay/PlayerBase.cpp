@@ -331,6 +331,45 @@ void PlayerBase::setPatternPos(mp_uint32 pos, mp_uint32 row/* = 0*/, bool resetC
 	}
 }
 
+void PlayerBase::saveBaseState(TBaseState& state) const
+{
+	state.mainVolume = mainVolume;
+	state.tickSpeed = tickSpeed;
+	state.baseBpm = baseBpm;
+	state.bpm = bpm;
+	state.rowcnt = rowcnt;
+	state.poscnt = poscnt;
+}
+
+void PlayerBase::restoreBaseState(const TBaseState& state)
+{
+	mainVolume = state.mainVolume;
+	tickSpeed = state.tickSpeed;
+	baseBpm = state.baseBpm;
+	bpm = state.bpm;
+	rowcnt = state.rowcnt;
+	poscnt = state.poscnt;
+	
+	ticker = 0;
+	halted = false;
+	lastUnvisitedPos = poscnt;
+	
+	updateTimeRecord();
+}
+
+bool PlayerBase::skipToPosition(mp_sint32 pos, mp_sint32 row, mp_sint32 maxRows)
+{
+	for (mp_sint32 i = 0; i < maxRows; i++)
+	{
+		if (poscnt == pos && rowcnt == row)
+			return true;
+
+		if (!skipRow())
+			return false;
+	}
+
+	return poscnt == pos && rowcnt == row;
+}
 
 void PlayerBase::timerHandler(mp_sint32 currentBeatPacket)
 {
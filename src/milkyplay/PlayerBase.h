@@ -187,6 +187,20 @@ protected:
 
 	virtual mp_sint32 allocateStructures() { return 0; }
 
+	// song state shared by all players, see saveState()
+	struct TBaseState
+	{
+		mp_sint32	mainVolume;
+		mp_sint32	tickSpeed;
+		mp_sint32	baseBpm;
+		mp_sint32	bpm;
+		mp_sint32	rowcnt;
+		mp_sint32	poscnt;
+	};
+	
+	void			saveBaseState(TBaseState& state) const;
+	void			restoreBaseState(const TBaseState& state);
+
 	virtual void clearEffectMemory() { }	
 
 public:
@@ -300,6 +314,23 @@ public:
 	virtual void			lastPattern();
 	virtual void			setPatternPos(mp_uint32 pos, mp_uint32 row = 0, bool resetChannels = true, bool resetFXMemory = true);
 
+	// where the song is right now, getOrder() and getRow() return what's audible
+	void					getCurrentPosition(mp_sint32& order, mp_sint32& row) const { order = poscnt; row = rowcnt; }
+
+	// Song state snapshots: saveState() writes everything that is needed to
+	// continue playing from the start of the current row (speed, volumes,
+	// effect memory, envelopes...) into getStateSize() bytes, restoreState()
+	// continues playing from such a snapshot. Voices in the mixer are not part
+	// of the state. Snapshots can only be taken in between two rows.
+	virtual mp_uint32		getStateSize() const { return 0; }
+	virtual bool			saveState(void* state) const { return false; }
+	virtual bool			restoreState(const void* state) { return false; }
+	
+	// Process the current row without mixing anything, returns false when the song has stopped
+	virtual bool			skipRow() { return false; }
+	// Skip rows until pos/row is reached, gives up after maxRows rows
+	bool					skipToPosition(mp_sint32 pos, mp_sint32 row, mp_sint32 maxRows);
+
 	virtual void			setTempo(mp_sint32 tempo) 
 	{ 
 		bpm = tempo;
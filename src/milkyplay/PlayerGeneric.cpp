@@ -40,6 +40,7 @@
 #include "MasterMixer.h"
 #include "XModule.h"
 #include "AudioDriver_WAVWriter.h"
+#include "StemWriter.h"
 #include "AudioDriverManager.h"
 #include "PlayerBase.h"
 #include "PlayerSTD.h"
@@ -175,6 +176,7 @@ PlayerGeneric::PlayerGeneric(mp_sint32 frequency, AudioDriverInterface* audioDri
 	repeat = false;
 	resetOnStopFlag = false;
 	autoAdjustPeak = false;
+	exportFloatOutput = false;
 	disableMixing = false;
 	allowFilters = false;
 #ifdef __FORCEPOWEROFTWOBUFFERSIZE__
@@ -183,6 +185,8 @@ PlayerGeneric::PlayerGeneric(mp_sint32 frequency, AudioDriverInterface* audioDri
 	compensateBufferFlag = false;
 #endif
 	masterVolume = panningSeparation = numMaxVirChannels = 256;
+	threadPool = NULL;
+	threadChannelThreshold = 0;
 	resetMainVolumeOnStartPlayFlag = true;
 	playMode = PlayMode_Auto;
 
@@ -274,6 +278,11 @@ void PlayerGeneric::setPeakAutoAdjust(bool b)
 	this->autoAdjustPeak = b;
 }
 
+void PlayerGeneric::setExportFloatOutput(bool b)
+{
+	this->exportFloatOutput = b;
+}
+
 mp_sint32 PlayerGeneric::adjustFrequency(mp_uint32 frequency)
 {
 	this->frequency = frequency;
@@ -577,6 +586,7 @@ mp_sint32 PlayerGeneric::startPlaying(XModule* module,
 			
 			player->setDisableMixing(disableMixing);
 			player->setAllowFilters(allowFilters);
+			player->setThreadPool(threadPool, threadChannelThreshold);
 			//if (paused)
 			//	player->pausePlaying();
 
@@ -711,6 +721,15 @@ bool PlayerGeneric::getAllowFilters() const
 	return allowFilters;
 }
 
+void PlayerGeneric::setThreadPool(MixerThreadPool* threadPool, mp_uint32 channelThreshold)
+{
+	this->threadPool = threadPool;
+	threadChannelThreshold = channelThreshold;
+	
+	if (player)
+		player->setThreadPool(threadPool, channelThreshold);
+}
+
 // volume control
 void PlayerGeneric::setMasterVolume(mp_sint32 vol)
 {
@@ -916,7 +935,7 @@ struct PeakAutoAdjustFilter : public Mixable
 	}
 };
 
-// export to 16bit stereo WAV
+// export to 16bit or 32bit float stereo WAV
 mp_sint32 PlayerGeneric::exportToWAV(const SYSCHAR* fileName, XModule* module, 
 									 mp_sint32 startOrder/* = 0*/, mp_sint32 endOrder/* = -1*/, 
 									 const mp_ubyte* mutingArray/* = NULL*/, mp_uint32 mutingNumChannels/* = 0*/,
@@ -924,23 +943,61 @@ mp_sint32 PlayerGeneric::exportToWAV(const SYSCHAR* fileName, XModule* module,
 									 AudioDriverBase* preferredDriver/* = NULL*/,
 									 mp_sint32* timingLUT/* = NULL*/)
 {
-	PlayerBase* player = NULL;
+	if (preferredDriver)
+		return exportToDriver(preferredDriver, module, startOrder, endOrder, mutingArray, mutingNumChannels, customPanningTable, timingLUT);
+
+	WAVWriter wavWriter(fileName, exportFloatOutput);
+	if (!wavWriter.isOpen())
+		return MP_DEVICE_ERROR;
+
+	return exportToDriver(&wavWriter, module, startOrder, endOrder, mutingArray, mutingNumChannels, customPanningTable, timingLUT);
+}
+
+mp_sint32 PlayerGeneric::exportStemsToWAV(const SYSCHAR* const* fileNames, XModule* module, 
+										  mp_sint32 startOrder/* = 0*/, mp_sint32 endOrder/* = -1*/, 
+										  const mp_ubyte* customPanningTable/* = NULL*/,
+										  float* peaks/* = NULL*/)
+{
+	const mp_uint32 numStems = module->header.channum;
+
+	StemWriter stemWriter(fileNames, numStems, frequency, sampleShift, exportFloatOutput);
+	if (!stemWriter.isOpen())
+		return MP_DEVICE_ERROR;
 	
-	AudioDriverBase* wavWriter = preferredDriver;
-	bool isWAVWriterDriver = false;
+	// channels which don't end up in a file don't need to be mixed at all
+	mp_ubyte* muting = new mp_ubyte[numStems];
+	for (mp_uint32 i = 0; i < numStems; i++)
+		muting[i] = fileNames[i] == NULL;
 	
-	if (wavWriter == NULL)
-	{
-		wavWriter = new WAVWriter(fileName);
-		isWAVWriterDriver = true;
+	// the regular output is empty, all channels go into the stems
+	AudioDriver_NULL nullDriver;
+	mp_sint32 res = exportToDriver(&nullDriver, module, startOrder, endOrder, muting, numStems, customPanningTable, NULL, &stemWriter, numStems);
 	
-		if (!static_cast<WAVWriter*>(wavWriter)->isOpen())
-		{
-			delete wavWriter;
-			return MP_DEVICE_ERROR;
-		}
+	delete[] muting;
+	
+	if (res < 0)
+		return res;
+	
+	res = stemWriter.finish();
+	
+	if (peaks)
+	{
+		for (mp_uint32 i = 0; i < numStems; i++)
+			peaks[i] = stemWriter.getPeak(i);
 	}
 	
+	return res;
+}
+
+mp_sint32 PlayerGeneric::exportToDriver(AudioDriverBase* wavWriter, XModule* module, 
+										mp_sint32 startOrder, mp_sint32 endOrder, 
+										const mp_ubyte* mutingArray, mp_uint32 mutingNumChannels,
+										const mp_ubyte* customPanningTable,
+										mp_sint32* timingLUT,
+										ChannelMixer::StemListener* stemListener/* = NULL*/, mp_uint32 numStems/* = 0*/)
+{
+	PlayerBase* player = NULL;
+	
 	MasterMixer mixer(frequency, bufferSize, 1, wavWriter);
 	mixer.setSampleShift(sampleShift);
 	mixer.setDisableMixing(disableMixing);
@@ -961,6 +1018,8 @@ mp_sint32 PlayerGeneric::exportToWAV(const SYSCHAR* fileName, XModule* module,
 		player->setPlayMode(playMode);
 		player->setDisableMixing(disableMixing);
 		player->setAllowFilters(allowFilters);		
+		player->setThreadPool(threadPool, threadChannelThreshold);
+		player->setStemListener(stemListener, numStems);
 #ifndef MILKYTRACKER
 		if (player->getType() == PlayerBase::PlayerType_IT)
 		{
@@ -1025,12 +1084,7 @@ mp_sint32 PlayerGeneric::exportToWAV(const SYSCHAR* fileName, XModule* module,
 
 	delete player;
 
-	mp_sint32 numWrittenSamples = wavWriter->getNumPlayedSamples();
-	
-	if (isWAVWriterDriver)
-		delete wavWriter;
-
-	return numWrittenSamples;
+	return wavWriter->getNumPlayedSamples();
 }
 
 bool PlayerGeneric::grabChannelInfo(mp_sint32 chn, TPlayerChannelInfo& channelInfo) const
@@ -97,15 +97,34 @@ private:
 	bool				resetMainVolumeOnStartPlayFlag;
 	// remember to auto adjust the peak
 	bool				autoAdjustPeak;
+	// remember to export 32 bit float WAVs
+	bool				exportFloatOutput;
 	// remember our mixer mastervolume
 	mp_sint32			masterVolume;
 	// remember our mixer panning separation
 	mp_sint32			panningSeparation;
 	// remember maximum amount of virtual channels
 	mp_sint32			numMaxVirChannels;
+	// remember mixer thread pool
+	MixerThreadPool*	threadPool;
+	// remember minimum number of playing channels for threaded mixing
+	mp_uint32			threadChannelThreshold;
 
 	void				adjustSettings();
 
+	/**
+	 * Play the song through the given driver, see exportToWAV
+	 * @param  stemListener			optional: receives the channels mixed one by one, see ChannelMixer::setStemListener
+	 * @param  numStems				number of channels to be passed to the stem listener
+	 */
+	mp_sint32			exportToDriver(AudioDriverBase* driver,
+									   XModule* module, 
+									   mp_sint32 startOrder, mp_sint32 endOrder, 
+									   const mp_ubyte* mutingArray, mp_uint32 mutingNumChannels,
+									   const mp_ubyte* customPanningTable,
+									   mp_sint32* timingLUT,
+									   ChannelMixer::StemListener* stemListener = NULL, mp_uint32 numStems = 0);
+
 	/**
 	 * Determine the best player type for a given module 
 	 * @param  module	the module which should be played
@@ -177,6 +196,14 @@ public:
 	 * @param  b		true or false
 	 */
 	void				setPeakAutoAdjust(bool b);
+
+	/**
+	 * Let exportToWAV write 32 bit float samples instead of 16 bit.
+	 * The float output is not clipped, so there is no need to find
+	 * a mixer volume which avoids clipping before exporting.
+	 * @param  b		true or false
+	 */
+	void				setExportFloatOutput(bool b);
 	
 	/**
 	 * Set the desired output frequency
@@ -493,6 +520,14 @@ public:
 	 * @see				setAllowFilters
 	 */
 	bool				getAllowFilters() const;
+
+	/**
+	 * Mix the channels on several threads when many channels are playing.
+	 * The pool is not owned by the player and might be shared with other players.
+	 * @param  threadPool			pool of mixing threads, NULL for single threaded mixing
+	 * @param  channelThreshold		minimum number of playing channels to make use of the pool
+	 */
+	void				setThreadPool(MixerThreadPool* threadPool, mp_uint32 channelThreshold);
 	
 	/**
 	 * Set master volume for the mixer
@@ -645,6 +680,27 @@ public:
 									const mp_ubyte* customPanningTable = NULL,
 									AudioDriverBase* preferredDriver = NULL,
 									mp_sint32* timingLUT = NULL);
+
+	/**
+	 * Export every channel of the song into a WAV file of its own (stems).
+	 * Unlike exporting the channels one by one the song is only played once,
+	 * the channels are mixed on the threads of the thread pool (if any) 
+	 * and the files are written on a separate thread.
+	 * @param  fileNames			one file name per channel (module->header.channum entries),
+	 *								channels with a NULL file name are skipped
+	 * @param  module				the module to export
+	 * @param  startOrder			the start position within the order list of the song
+	 * @param  endOrder				the last order to be played
+	 * @param  customPanningTable	When specifying a custom panning table the panning default from the module is ignored
+	 * @param  peaks				if not NULL receives the peak of every stem (1.0 = full scale), 
+	 *								module->header.channum entries
+	 * @return						the number of sample frames written to each file or an error code
+	 */
+	mp_sint32			exportStemsToWAV(const SYSCHAR* const* fileNames,
+										 XModule* module, 
+										 mp_sint32 startOrder = 0, mp_sint32 endOrder = -1, 
+										 const mp_ubyte* customPanningTable = NULL,
+										 float* peaks = NULL);
 	
 	/**
 	 * Grab current channel data from a module channel
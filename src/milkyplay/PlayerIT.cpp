@@ -280,12 +280,118 @@ mp_sint32	PlayerIT::getlogperiod(mp_sint32 note,mp_sint32 relnote,mp_sint32 fine
 }
 
 
+PlayerIT::TVirtualChannelHeap::TVirtualChannelHeap() :
+	heap(NULL),
+	pos(NULL),
+	keys(NULL),
+	size(0),
+	numChannels(0)
+{
+}
+
+PlayerIT::TVirtualChannelHeap::~TVirtualChannelHeap()
+{
+	alloc(0);
+}
+
+void PlayerIT::TVirtualChannelHeap::alloc(mp_sint32 numChannels)
+{
+	delete[] heap;
+	delete[] pos;
+	delete[] keys;
+	heap = pos = keys = NULL;
+	
+	this->numChannels = numChannels;
+	if (numChannels)
+	{
+		heap = new mp_sint32[numChannels];
+		pos = new mp_sint32[numChannels];
+		keys = new mp_sint32[numChannels];
+	}
+	clear();
+}
+
+void PlayerIT::TVirtualChannelHeap::clear()
+{
+	for (mp_sint32 i = 0; i < numChannels; i++)
+		pos[i] = -1;
+	size = 0;
+}
+
+void PlayerIT::TVirtualChannelHeap::siftUp(mp_sint32 i)
+{
+	const mp_sint32 index = heap[i];
+	while (i > 0)
+	{
+		const mp_sint32 parent = (i-1) >> 1;
+		if (!less(index, heap[parent]))
+			break;
+		place(i, heap[parent]);
+		i = parent;
+	}
+	place(i, index);
+}
+
+void PlayerIT::TVirtualChannelHeap::siftDown(mp_sint32 i)
+{
+	const mp_sint32 index = heap[i];
+	for (;;)
+	{
+		mp_sint32 child = (i << 1) + 1;
+		if (child >= size)
+			break;
+		if (child+1 < size && less(heap[child+1], heap[child]))
+			child++;
+		if (!less(heap[child], index))
+			break;
+		place(i, heap[child]);
+		i = child;
+	}
+	place(i, index);
+}
+
+void PlayerIT::TVirtualChannelHeap::insert(mp_sint32 index, mp_sint32 key)
+{
+	if (contains(index))
+		return;
+	
+	keys[index] = key;
+	place(size++, index);
+	siftUp(size-1);
+}
+
+void PlayerIT::TVirtualChannelHeap::remove(mp_sint32 index)
+{
+	const mp_sint32 i = pos[index];
+	if (i < 0)
+		return;
+	
+	pos[index] = -1;
+	if (i == --size)
+		return;
+	
+	// move the last one into the gap and restore the order from there
+	place(i, heap[size]);
+	if (i > 0 && less(heap[i], heap[(i-1) >> 1]))
+		siftUp(i);
+	else
+		siftDown(i);
+}
+
+void PlayerIT::TVirtualChannelHeap::rebuild()
+{
+	for (mp_sint32 i = (size >> 1) - 1; i >= 0; i--)
+		siftDown(i);
+}
+
 PlayerIT::PlayerIT(mp_uint32 frequency) : 
 	PlayerBase(frequency)
 {
 	chninfo		= NULL;
 	vchninfo	= NULL;
 	attick		= NULL;	
+	releasedVirChannels = NULL;
+	backgroundVolumesChanged = false;
 	// fill in some default values, don't know if this is necessary
 
 	tickSpeed			= 6;				// our tickspeed
@@ -425,6 +531,16 @@ void PlayerIT::reset()
 	curMaxVirChannels = 0;
 	memset(chninfo, 0, sizeof(TModuleChannel)*numModuleChannels);
 	memset(vchninfo, 0, sizeof(TVirtualChannel)*numVirtualChannels);
+	
+	// all virtual channels are free now
+	freeVirChannels.clear();
+	backgroundVirChannels.clear();
+	backgroundVolumesChanged = false;
+	if (vchninfo)
+	{
+		for (mp_sint32 i = 0; i < numVirtualChannels; i++)
+			freeVirChannels.insert(i, 0);
+	}
 	RESET_ALL_LOOPING
 }
 
@@ -444,6 +560,9 @@ mp_sint32 PlayerIT::allocateStructures()
 	chninfo			= new TModuleChannel[numModuleChannels];
 	vchninfo		= new TVirtualChannel[numVirtualChannels];
 	attick			= new mp_ubyte[numModuleChannels];
+	releasedVirChannels = new mp_sint32[numVirtualChannels];
+	freeVirChannels.alloc(numVirtualChannels);
+	backgroundVirChannels.alloc(numVirtualChannels);
 	return MP_OK;
 }
 
@@ -464,6 +583,13 @@ void PlayerIT::freeMemory()
 		delete[] attick; 
 		attick = NULL; 
 	}
+	if (releasedVirChannels) 
+	{ 
+		delete[] releasedVirChannels; 
+		releasedVirChannels = NULL; 
+	}
+	freeVirChannels.alloc(0);
+	backgroundVirChannels.alloc(0);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////
@@ -502,49 +628,57 @@ void PlayerIT::clearEffectMemory()
 
 PlayerIT::TVirtualChannel* PlayerIT::allocateVirtualChannel()
 {
-	const mp_sint32 numVirtualChannels = this->numVirtualChannels;
+	mp_sint32 chnIndex;
 	
-	mp_sint32 i;
-
-	TVirtualChannel* vchn = vchninfo;	
-	for (i = 0; i < numVirtualChannels; i++, vchn++)
+	// lowest free background channel
+	if (!freeVirChannels.isEmpty())
 	{
-		if (vchn->getBackground())
-		{
-			if (!vchn->getActive())
-			{
-				if (i+1 > curMaxVirChannels)
-					curMaxVirChannels = i+1;
-				vchn->setChannelIndex(i);
-				return vchn;
-			}
-		}
+		chnIndex = freeVirChannels.top();
+		if (chnIndex+1 > curMaxVirChannels)
+			curMaxVirChannels = chnIndex+1;
 	}
-	
-	mp_sint32 chnIndex = -1;
-	mp_sint32 vol = 0x7FFFFFFF;
-	vchn = vchninfo;	
-	for (i = 0; i < curMaxVirChannels; i++, vchn++)
+	// none left, steal the quietest background channel
+	else if (!backgroundVirChannels.isEmpty())
 	{
-		if (vchn->getBackground())
+		// volumes have changed since the keys were set, update them all at once
+		if (backgroundVolumesChanged)
 		{
-			mp_sint32 newVol = vchn->getResultingVolume();
-			if (newVol < vol)
+			for (mp_sint32 i = 0; i < backgroundVirChannels.getSize(); i++)
 			{
-				vol = newVol;
-				chnIndex = i;
+				mp_sint32 index = backgroundVirChannels.get(i);
+				backgroundVirChannels.setKey(index, vchninfo[index].getResultingVolume());
 			}
+			backgroundVirChannels.rebuild();
+			backgroundVolumesChanged = false;
 		}
+		chnIndex = backgroundVirChannels.top();
 	}
+	else
+		return NULL;
 	
-	if (chnIndex != -1)
-	{
-		vchn = vchninfo + chnIndex;
-		vchn->setChannelIndex(chnIndex);
-		return vchn;
-	}
-	
-	return NULL;
+	// the channel stays in its heap until it gets linked to a module channel
+	TVirtualChannel* vchn = vchninfo + chnIndex;
+	vchn->setChannelIndex(chnIndex);
+	return vchn;
+}
+
+void PlayerIT::linkVirtualChannel(TModuleChannel* chnInf, TVirtualChannel* vchn)
+{
+	const mp_sint32 index = (mp_sint32)(vchn - vchninfo);
+	freeVirChannels.remove(index);
+	backgroundVirChannels.remove(index);
+	chnInf->linkVchn(vchn);
+}
+
+PlayerIT::TVirtualChannel* PlayerIT::unlinkVirtualChannel(TModuleChannel* chnInf)
+{
+	TVirtualChannel* vchn = chnInf->unlinkVchn();
+	const mp_sint32 index = (mp_sint32)(vchn - vchninfo);
+	if (vchn->getActive())
+		backgroundVirChannels.insert(index, vchn->getResultingVolume());
+	else
+		freeVirChannels.insert(index, 0);
+	return vchn;
 }
 
 void PlayerIT::handleNoteOFF(TChnState& state)
@@ -579,6 +713,8 @@ void PlayerIT::handleNoteOFF(TChnState& state)
 	}
 	
 	state.setKeyon(false);
+	
+	backgroundVolumesChanged = true;
 }
 
 void PlayerIT::handlePastNoteAction(TModuleChannel* chnInf, mp_ubyte pastNoteActionType)
@@ -670,7 +806,7 @@ bool PlayerIT::handleDCT(TModuleChannel* chnInf, const TNNATriggerInfo& triggerI
 				{
 					// important: first set host to NULL
 					// THEN set key on flag
-					TVirtualChannel* oldvchn = chnInf->unlinkVchn();
+					TVirtualChannel* oldvchn = unlinkVirtualChannel(chnInf);
 					handleNoteOFF(oldvchn->getRealState());
 				}
 			}
@@ -685,7 +821,7 @@ bool PlayerIT::handleDCT(TModuleChannel* chnInf, const TNNATriggerInfo& triggerI
 				{
 					// important: first set host to NULL
 					// THEN set fade out
-					chnInf->unlinkVchn()->setFadeout(true);
+					unlinkVirtualChannel(chnInf)->setFadeout(true);
 				}
 			}
 		}
@@ -744,8 +880,8 @@ bool PlayerIT::handleNNAs(TModuleChannel* chnInf, const TNNATriggerInfo& trigger
 		// NNA = continue
 		else if (NNA == 1)
 		{
-			chnInf->unlinkVchn();			
-			chnInf->linkVchn(newVchn);
+			unlinkVirtualChannel(chnInf);			
+			linkVirtualChannel(chnInf, newVchn);
 			return true;
 		}
 		// NNA = note off
@@ -753,9 +889,9 @@ bool PlayerIT::handleNNAs(TModuleChannel* chnInf, const TNNATriggerInfo& trigger
 		{
 			// important: first set host to NULL
 			// THEN set key on flag
-			TVirtualChannel* oldvchn = chnInf->unlinkVchn();
+			TVirtualChannel* oldvchn = unlinkVirtualChannel(chnInf);
 			handleNoteOFF(oldvchn->getRealState());
-			chnInf->linkVchn(newVchn);
+			linkVirtualChannel(chnInf, newVchn);
 			return true;
 		}
 		// NNA = note fade
@@ -763,14 +899,14 @@ bool PlayerIT::handleNNAs(TModuleChannel* chnInf, const TNNATriggerInfo& trigger
 		{
 			// important: first set host to NULL
 			// THEN set fade out
-			chnInf->unlinkVchn()->setFadeout(true);
-			chnInf->linkVchn(newVchn);
+			unlinkVirtualChannel(chnInf)->setFadeout(true);
+			linkVirtualChannel(chnInf, newVchn);
 			return true;
 		}
 	}
 	else
 	{
-		chnInf->linkVchn(newVchn);
+		linkVirtualChannel(chnInf, newVchn);
 	}	
 	
 	return true;
@@ -779,38 +915,43 @@ bool PlayerIT::handleNNAs(TModuleChannel* chnInf, const TNNATriggerInfo& trigger
 void PlayerIT::adjustVirtualChannels()
 {
 	mp_sint32 i;
-
-	TVirtualChannel* vchn = vchninfo;	
-	for (i = 0; i < curMaxVirChannels; i++, vchn++)
+	
+	// only channels playing in the background can be released
+	mp_sint32 numReleased = 0;
+	mp_sint32 highest = -1;
+	for (i = 0; i < backgroundVirChannels.getSize(); i++)
 	{
-		if (!vchn->getActive())
-			continue;
-			
-		if (vchn->getBackground())
+		const mp_sint32 index = backgroundVirChannels.get(i);
+		TVirtualChannel* vchn = vchninfo + index;
+		
+		if (!isChannelPlaying(index) ||
+			!vchn->getVol() ||
+			!vchn->getMasterVol() ||
+			!vchn->getFadevolstart() ||
+			vchn->getVenv().cutted(vchn->getKeyon()))
 		{
-			if (!isChannelPlaying(i) ||
-				!vchn->getVol() ||
-				!vchn->getMasterVol() ||
-				!vchn->getFadevolstart() ||
-				vchn->getVenv().cutted(vchn->getKeyon()))
-			{
-				//bool cutted = vchn->getVenv().cutted(vchn->getKeyon());
-				mp_sint32 index = vchn->getChannelIndex();
-				stopSample(index);
-				releaseVirtualChannel(vchn);
-				continue;
-			}
+			releasedVirChannels[numReleased++] = index;
+			if (index > highest)
+				highest = index;
 		}
-		/*else
-		{
-			if (!vchn->getFadevolstart() ||
-				vchn->getVenv().cutted(vchn->getKeyon()))
-			{
-				mp_sint32 index = vchn->getChannelIndex();
-				stopSample(index);
-				continue;
-			}
-		}*/
+	}
+	
+	// releasing changes the heap, so do it afterwards
+	// the highest channel goes last, it's the only one which may lower 
+	// curMaxVirChannels, same as releasing them in ascending order
+	for (i = 0; i < numReleased; i++)
+	{
+		const mp_sint32 index = releasedVirChannels[i];
+		if (index == highest)
+			continue;
+		stopSample(index);
+		releaseVirtualChannel(vchninfo + index);
+	}
+	
+	if (highest >= 0)
+	{
+		stopSample(highest);
+		releaseVirtualChannel(vchninfo + highest);
 	}
 }
 
@@ -3327,6 +3468,9 @@ void PlayerIT::update()
 {
 	mp_sint32 c;
 	
+	// volumes are about to change, the next stolen channel needs fresh keys
+	backgroundVolumesChanged = true;
+	
 	TVirtualChannel* chn = vchninfo;
 	const mp_sint32 curMaxVirChannels = this->curMaxVirChannels;
 	for (c = 0; c < curMaxVirChannels; c++, chn++) 
@@ -3431,6 +3575,8 @@ void PlayerIT::updateBPMIndependent()
 {
 	mp_int64 dummy;
 
+	backgroundVolumesChanged = true;
+	
 	TVirtualChannel* chn = vchninfo;
 	const mp_sint32 curMaxVirChannels = this->curMaxVirChannels;
 	for (mp_sint32 c = 0; c < curMaxVirChannels; c++,chn++) 
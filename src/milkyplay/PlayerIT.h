@@ -454,6 +454,48 @@ private:
 
 #undef DEFINE_STATINTERFACE
 	
+	// indexed min heap of virtual channel indices, ordered by their keys
+	// and by the channel index if the keys are equal
+	class TVirtualChannelHeap
+	{
+	private:
+		mp_sint32*	heap;		// channel indices
+		mp_sint32*	pos;		// position of every channel within heap, -1 if it's not in there
+		mp_sint32*	keys;		// key of every channel
+		mp_sint32	size;
+		mp_sint32	numChannels;
+		
+		bool		less(mp_sint32 a, mp_sint32 b) const 
+		{ 
+			return keys[a] < keys[b] || (keys[a] == keys[b] && a < b); 
+		}
+		
+		void		place(mp_sint32 i, mp_sint32 index) { heap[i] = index; pos[index] = i; }
+		void		siftUp(mp_sint32 i);
+		void		siftDown(mp_sint32 i);
+		
+	public:
+		TVirtualChannelHeap();
+		~TVirtualChannelHeap();
+		
+		void		alloc(mp_sint32 numChannels);
+		void		clear();
+		
+		mp_sint32	getSize() const { return size; }
+		bool		isEmpty() const { return size == 0; }
+		// channels in heap order, i from 0 to getSize()-1
+		mp_sint32	get(mp_sint32 i) const { return heap[i]; }
+		mp_sint32	top() const { return heap[0]; }
+		bool		contains(mp_sint32 index) const { return pos[index] >= 0; }
+		
+		void		insert(mp_sint32 index, mp_sint32 key);
+		void		remove(mp_sint32 index);
+		
+		// change a key without restoring the order, call rebuild afterwards
+		void		setKey(mp_sint32 index, mp_sint32 key) { keys[index] = key; }
+		void		rebuild();
+	};
+	
 private:
 
 	static const mp_sint32	vibtab[32];
@@ -465,6 +507,11 @@ private:
 	TModuleChannel	*chninfo;				// our channel information
 	TVirtualChannel *vchninfo;				// our virtual channels
 	
+	TVirtualChannelHeap freeVirChannels;	// background channels which aren't playing, lowest index first
+	TVirtualChannelHeap backgroundVirChannels;	// playing background channels, lowest resulting volume first
+	bool			backgroundVolumesChanged;	// keys of backgroundVirChannels are out of date
+	mp_sint32		*releasedVirChannels;	// scratch buffer for adjustVirtualChannels
+	
 	mp_ubyte		*attick;
 	
 	mp_sint32		patternIndex;			// holds current pattern index
@@ -518,7 +565,19 @@ private:
 		vchn->setActive(false);
 		if (vchn->getChannelIndex() == curMaxVirChannels-1)
 			curMaxVirChannels--;
+		
+		if (vchn->getBackground())
+		{
+			const mp_sint32 index = (mp_sint32)(vchn - vchninfo);
+			backgroundVirChannels.remove(index);
+			freeVirChannels.insert(index, 0);
+		}
 	}
+	
+	// these keep track of which virtual channels are free or playing in 
+	// the background, always use them instead of TModuleChannel::linkVchn/unlinkVchn
+	void				linkVirtualChannel(TModuleChannel* chnInf, TVirtualChannel* vchn);
+	TVirtualChannel*	unlinkVirtualChannel(TModuleChannel* chnInf);
 		
 	struct TNNATriggerInfo
 	{
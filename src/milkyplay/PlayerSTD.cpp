@@ -3089,6 +3089,84 @@ bool PlayerSTD::grabChannelInfo(mp_sint32 chn, TPlayerChannelInfo& channelInfo)
 	return true;
 }
 
+mp_uint32 PlayerSTD::getStateSize() const
+{
+	return sizeof(TState) + initialNumChannels*sizeof(TModuleChannel);
+}
+
+bool PlayerSTD::saveState(void* state) const
+{
+	// we're in the middle of a row
+	if (!module || !chninfo || ticker)
+		return false;
+
+	TState* dst = reinterpret_cast<TState*>(state);
+	
+	saveBaseState(dst->base);
+	dst->patternIndex = patternIndex;
+	dst->startNextRow = startNextRow;
+	dst->numChannels = initialNumChannels;
+	
+	memcpy(dst+1, chninfo, initialNumChannels*sizeof(TModuleChannel));
+	
+	return true;
+}
+
+bool PlayerSTD::restoreState(const void* state)
+{
+	if (!module || !chninfo)
+		return false;
+
+	const TState* src = reinterpret_cast<const TState*>(state);
+	
+	restoreBaseState(src->base);
+	patternIndex = src->patternIndex;
+	startNextRow = src->startNextRow;
+	
+	patDelay = false;
+	patDelayCount = 0;
+	haltFlag = false;
+	
+	this->adder = getbpmrate(this->bpm);
+	
+	// additional channels (e.g. used for jamming) keep their state
+	const mp_sint32 numChannels = src->numChannels < initialNumChannels ? src->numChannels : initialNumChannels;
+	const mp_ubyte* chnState = reinterpret_cast<const mp_ubyte*>(src+1);
+	for (mp_sint32 i = 0; i < numChannels; i++, chnState+=sizeof(TModuleChannel))
+		chninfo[i].restoreState(chnState);
+	
+	memset(rowHits, 0, sizeof(rowHits));
+
+	mp_sint32 i;
+	for (i = 0; i < poscnt; i++)
+		for (mp_sint32 j = 0; j < 256; j++)
+			visitRow(i*256+j);
+	
+	for (i = 0; i < rowcnt; i++)
+		visitRow(poscnt*256+i);
+		
+	return true;
+}
+
+bool PlayerSTD::skipRow()
+{
+	if (!module || !chninfo || halted || idle)
+		return false;
+
+	// this is not meant to be heard
+	StatusEventListener* statusEventListener = this->statusEventListener;
+	this->statusEventListener = NULL;
+	
+	do
+	{
+		tickhandler();
+	} while (ticker && !halted);
+	
+	this->statusEventListener = statusEventListener;
+	
+	return !halted;
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////
 // for MilkyTracker use
 //////////////////////////////////////////////////////////////////////////////////////////
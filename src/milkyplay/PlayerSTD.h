@@ -241,6 +241,34 @@ private:
 			fenv.reallocTimeRecord(size);
 			vibenv.reallocTimeRecord(size);			
 		}
+		
+		// take over a channel state stored by saveState(),
+		// the envelope time records stay with this channel
+		void restoreState(const void* state)
+		{
+			TPrEnv::TTimeRecord* venvTimeRecord = venv.timeRecord;
+			TPrEnv::TTimeRecord* penvTimeRecord = penv.timeRecord;
+			TPrEnv::TTimeRecord* fenvTimeRecord = fenv.timeRecord;
+			TPrEnv::TTimeRecord* vibenvTimeRecord = vibenv.timeRecord;
+			const mp_uint32 timeTrackSize = venv.timeTrackSize;
+			
+			memcpy((void*)this, state, sizeof(TModuleChannel));
+			
+			venv.timeRecord = venvTimeRecord;
+			penv.timeRecord = penvTimeRecord;
+			fenv.timeRecord = fenvTimeRecord;
+			vibenv.timeRecord = vibenvTimeRecord;
+			venv.timeTrackSize = penv.timeTrackSize = fenv.timeTrackSize = vibenv.timeTrackSize = timeTrackSize;
+		}
+	};
+	
+	// layout of a saved state, followed by numChannels TModuleChannels
+	struct TState
+	{
+		TBaseState		base;
+		mp_sint32		patternIndex;
+		mp_sint32		startNextRow;
+		mp_sint32		numChannels;
 	};
 	
 private:
@@ -469,6 +497,12 @@ public:
 
 	virtual bool	grabChannelInfo(mp_sint32 chn, TPlayerChannelInfo& channelInfo) const;
 
+	virtual mp_uint32 getStateSize() const;
+	virtual bool	saveState(void* state) const;
+	virtual bool	restoreState(const void* state);
+	
+	virtual bool	skipRow();
+
 	// milkytracker
 	virtual void	playNote(mp_ubyte chn, mp_sint32 note, mp_sint32 ins, mp_sint32 vol = -1);
 							 
@@ -208,6 +208,8 @@ public:
 	virtual bool isRamping() { return false; }
 	virtual bool supportsFullChecking() { return false; }
 	virtual bool supportsNoChecking() { return true; }
+	// the BLEP state depends on every sample played
+	virtual bool supportsSkipping(const ChannelMixer::TMixerChannel* chn) { return false; }
 	
 	inline void addBlockNoCheck(mp_sint32* buffer, ChannelMixer::TMixerChannel* chn, mp_uint32 count)
 	{
@@ -35,6 +35,9 @@
  *
  */
 
+#ifndef __RESAMPLERCUBIC_H__
+#define __RESAMPLERCUBIC_H__
+
 /*
  * Cubic 4 Point 3rd order polynomial interpolation resampler                 
  *
@@ -214,3 +217,5 @@ public:
 
 #undef __DEIP__
 #undef fpmul
+
+#endif
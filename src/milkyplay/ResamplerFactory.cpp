@@ -39,10 +39,165 @@
 #include "ResamplerCubic.h"
 #include "ResamplerFast.h"
 #include "ResamplerSinc.h"
+#include "ResamplerPolyphase.h"
 #include "ResamplerAmiga.h"
+#include "ResamplerSIMD.h"
+
+#if defined(__MPSIMD_X86__) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+static ResamplerFactory::SIMDLevels detectSIMDLevel()
+{
+#if defined(__MPSIMD_X86__) && defined(__GNUC__)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return ResamplerFactory::SIMD_AVX2;
+	if (__builtin_cpu_supports("sse2"))
+		return ResamplerFactory::SIMD_SSE2;
+#elif defined(__MPSIMD_X86__) && defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	const int numIDs = info[0];
+	bool avx2 = false;
+	if (numIDs >= 7)
+	{
+		__cpuid(info, 1);
+		// OS must save the YMM registers
+		const bool osxsave = (info[2] & (1 << 27)) != 0;
+		const bool avx = (info[2] & (1 << 28)) != 0;
+		if (osxsave && avx && (_xgetbv(0) & 6) == 6)
+		{
+			__cpuidex(info, 7, 0);
+			avx2 = (info[1] & (1 << 5)) != 0;
+		}
+	}
+	if (avx2)
+		return ResamplerFactory::SIMD_AVX2;
+	__cpuid(info, 1);
+	if (info[3] & (1 << 26))
+		return ResamplerFactory::SIMD_SSE2;
+#elif defined(__MPSIMD_NEON__)
+	// NEON is a compile time decision (always present on AArch64)
+	return ResamplerFactory::SIMD_NEON;
+#endif
+	return ResamplerFactory::SIMD_NONE;
+}
+
+ResamplerFactory::SIMDLevels ResamplerFactory::getSIMDLevel()
+{
+	static SIMDLevels level = detectSIMDLevel();
+	return level;
+}
+
+const char* ResamplerFactory::getSIMDLevelName(SIMDLevels level)
+{
+	switch (level)
+	{
+		case SIMD_SSE2:
+			return "SSE2";
+		case SIMD_AVX2:
+			return "AVX2";
+		case SIMD_NEON:
+			return "NEON";
+		default:
+			return "none";
+	}
+}
+
+#ifdef __MPSIMD__
+template<template<class, mp_uint32> class Kernel>
+static ChannelMixer::ResamplerBase* createSIMDResampler(MixerSettings::ResamplerTypes type)
+{
+	switch (type)
+	{
+		case MixerSettings::MIXER_LERPING:
+			return new ResamplerLerpSIMD<Kernel>();
+
+		case MixerSettings::MIXER_LERPING_RAMPING:
+			return new ResamplerLerpRampFilterSIMD<Kernel>();
+
+		case MixerSettings::MIXER_LAGRANGE:
+			return new ResamplerLagrangeSIMD<false, CubicResamplerLagrange, Kernel>();
+
+		case MixerSettings::MIXER_LAGRANGE_RAMPING:
+			return new ResamplerLagrangeSIMD<true, CubicResamplerLagrange, Kernel>();
+
+		case MixerSettings::MIXER_SPLINE:
+			return new ResamplerLagrangeSIMD<false, CubicResamplerSpline, Kernel>();
+
+		case MixerSettings::MIXER_SPLINE_RAMPING:
+			return new ResamplerLagrangeSIMD<true, CubicResamplerSpline, Kernel>();
+
+		case MixerSettings::MIXER_SINCTABLE:
+			return new ResamplerSincTableSIMD<false, 16, Kernel>();
+
+		case MixerSettings::MIXER_SINCTABLE_RAMPING:
+			return new ResamplerSincTableSIMD<true, 16, Kernel>();
+			
+		default:
+			return NULL;
+	}
+}
+#endif
+
+ResamplerFactory::SIMDLevels ResamplerFactory::getSIMDLevel(ResamplerTypes type)
+{
+	switch (type)
+	{
+		case MIXER_LERPING:
+		case MIXER_LERPING_RAMPING:
+			return getSIMDLevel();
+			
+		// with only four lanes the SSE2 kernels of the resamplers which gather 
+		// several source samples per output frame spend about as much time 
+		// on shuffling as they save, depending on the CPU they're even slower
+		// than the scalar code (see tools/resamplerbench)
+		case MIXER_LAGRANGE:
+		case MIXER_LAGRANGE_RAMPING:
+		case MIXER_SPLINE:
+		case MIXER_SPLINE_RAMPING:
+		case MIXER_SINCTABLE:
+		case MIXER_SINCTABLE_RAMPING:
+			return getSIMDLevel() != SIMD_SSE2 ? getSIMDLevel() : SIMD_NONE;
+			
+		// there are no vector versions of the others
+		default:
+			return SIMD_NONE;
+	}
+}
 
 ChannelMixer::ResamplerBase* ResamplerFactory::createResampler(ResamplerTypes type)
 {
+	return createResampler(type, getSIMDLevel(type));
+}
+
+ChannelMixer::ResamplerBase* ResamplerFactory::createResampler(ResamplerTypes type, SIMDLevels simdLevel)
+{
+	ChannelMixer::ResamplerBase* resampler = NULL;
+
+	switch (simdLevel)
+	{
+#ifdef __MPSIMD_X86__
+		case SIMD_SSE2:
+			resampler = createSIMDResampler<ResamplerSIMDKernelSSE2>(type);
+			break;
+		case SIMD_AVX2:
+			resampler = createSIMDResampler<ResamplerSIMDKernelAVX2>(type);
+			break;
+#endif
+#ifdef __MPSIMD_NEON__
+		case SIMD_NEON:
+			resampler = createSIMDResampler<ResamplerSIMDKernelNEON>(type);
+			break;
+#endif
+		default:
+			break;
+	}
+	
+	if (resampler)
+		return resampler;
+
 	switch (type)
 	{
 		case MIXER_NORMAL:
@@ -81,6 +236,12 @@ ChannelMixer::ResamplerBase* ResamplerFactory::createResampler(ResamplerTypes ty
 		case MIXER_SINC_RAMPING:
 			return new ResamplerSinc<true, 128>();
 
+		case MIXER_POLYPHASE:
+			return new ResamplerPolyphase<false, 32>();
+
+		case MIXER_POLYPHASE_RAMPING:
+			return new ResamplerPolyphase<true, 32>();
+
 		case MIXER_AMIGA500:
 			return new ResamplerAmiga<0>();
 
@@ -43,7 +43,26 @@
 class ResamplerFactory : public MixerSettings
 {
 public:
+	enum SIMDLevels
+	{
+		SIMD_NONE,
+		SIMD_SSE2,
+		SIMD_AVX2,
+		SIMD_NEON
+	};
+
+	// best vector instruction set supported by this CPU (and build)
+	static SIMDLevels getSIMDLevel();
+	// instruction set createResampler picks for the given type, 
+	// vector code which doesn't pay off is left out
+	static SIMDLevels getSIMDLevel(ResamplerTypes type);
+	static const char* getSIMDLevelName(SIMDLevels level);
+
+	// creates the best resampler for the current CPU
 	static ChannelMixer::ResamplerBase* createResampler(ResamplerTypes type);
+	// creates a resampler for an explicit instruction set, falls back to 
+	// the scalar version if there is no vector version of the requested type
+	static ChannelMixer::ResamplerBase* createResampler(ResamplerTypes type, SIMDLevels simdLevel);
 };
 
 #endif
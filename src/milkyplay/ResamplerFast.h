@@ -195,6 +195,12 @@ public:
 	virtual bool supportsFullChecking() { return true; }
 	virtual bool supportsNoChecking() { return true; }
 
+	// the filter history keeps being fed while the channel is silent
+	virtual bool supportsSkipping(const ChannelMixer::TMixerChannel* chn)
+	{
+		return chn->cutoff == ChannelMixer::MP_INVALID_VALUE || chn->resonance == ChannelMixer::MP_INVALID_VALUE;
+	}
+
 	virtual void addBlockFull(mp_sint32* buffer, ChannelMixer::TMixerChannel* chn, mp_uint32 count)
 	{
 		mp_sint32 voll = chn->finalvoll;
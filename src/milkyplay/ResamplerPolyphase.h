@@ -0,0 +1,310 @@
+/*
+ * Copyright (c) 2009, The MilkyTracker Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the name of the <ORGANIZATION> nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ *  ResamplerPolyphase.h
+ *  MilkyPlay
+ *
+ *  Windowed sinc resampler using a precomputed polyphase table.
+ *
+ */
+
+#ifndef __RESAMPLERPOLYPHASE_H__
+#define __RESAMPLERPOLYPHASE_H__
+
+#include <math.h>
+
+#ifndef M_PI 
+#define M_PI 3.14159265358979323846 
+#endif
+
+// The table holds one filter kernel (numTaps coefficients) per phase,
+// adjacent phases are linearly interpolated. There is one set of phases per
+// cutoff frequency: when a channel is played faster than the mixing rate 
+// (smpadd > 1.0) the kernel with the next lower cutoff is used, so high 
+// notes don't alias. Kernels are Kaiser windowed and normalized to unity 
+// gain at DC.
+template<mp_sint32 numTaps>
+class ResamplerPolyphaseTableBase : public ChannelMixer::ResamplerBase
+{
+protected:
+	enum 
+	{
+		NUMTAPS = numTaps, // must be even
+		WIDTH = (NUMTAPS / 2),
+		PHASESHIFT = 8,
+		NUMPHASES = (1 << PHASESHIFT),
+		SUBPHASESHIFT = 16 - PHASESHIFT,
+		// one extra row so the last phase can be interpolated too
+		PHASETABLESIZE = (NUMPHASES + 1) * NUMTAPS,
+		NUMCUTOFFS = 8
+	};
+
+	static float* table;
+	static bool tableInit;
+	
+	static double besselI0(double x)
+	{
+		double sum = 1.0, term = 1.0;
+		const double halfx = x * 0.5;
+		for (mp_sint32 k = 1; k < 64 && term > sum * 1e-12; k++)
+		{
+			term *= (halfx / k) * (halfx / k);
+			sum += term;
+		}
+		return sum;
+	}
+	
+	// highest channel step (16.16) each cutoff is suitable for
+	static mp_sint32 getMaxStep(mp_sint32 cutoffIndex)
+	{
+		static const mp_sint32 maxSteps[NUMCUTOFFS] = 
+		{
+			65536,		// 1.0
+			81920,		// 1.25
+			98304,		// 1.5
+			131072,		// 2.0
+			163840,		// 2.5
+			196608,		// 3.0
+			262144,		// 4.0
+			393216		// 6.0
+		};
+		return maxSteps[cutoffIndex];
+	}
+	
+	static mp_sint32 getCutoffIndex(mp_sint32 smpadd)
+	{
+		mp_sint32 i;
+		for (i = 0; i < NUMCUTOFFS-1; i++)
+			if (smpadd <= getMaxStep(i))
+				break;
+		return i;
+	}
+
+	void makeTable()
+	{
+		// leave some room for the transition band below nyquist
+		const double rolloff = 0.91;
+		const double beta = NUMTAPS >= 32 ? 8.0 : 6.0;
+		const double i0beta = besselI0(beta);
+	
+		for (mp_sint32 c = 0; c < NUMCUTOFFS; c++)
+		{
+			const double cutoff = rolloff * 65536.0 / getMaxStep(c);
+			float* phases = table + c*PHASETABLESIZE;
+			
+			for (mp_sint32 p = 0; p <= NUMPHASES; p++)
+			{
+				const double t = (double)p / NUMPHASES;
+				double coeffs[NUMTAPS];
+				double sum = 0.0;
+				
+				for (mp_sint32 k = 0; k < NUMTAPS; k++)
+				{
+					const double x = (double)(k - (WIDTH-1)) - t;
+					const double r = x / WIDTH;
+					const double window = r*r < 1.0 ? besselI0(beta * sqrt(1.0 - r*r)) / i0beta : 0.0;
+					const double sx = M_PI * cutoff * x;
+					const double sinc = x == 0.0 ? 1.0 : sin(sx) / sx;
+					coeffs[k] = cutoff * sinc * window;
+					sum += coeffs[k];
+				}
+				
+				for (mp_sint32 k = 0; k < NUMTAPS; k++)
+					phases[p*NUMTAPS + k] = (float)(coeffs[k] / sum);
+			}
+		}
+	}
+
+	ResamplerPolyphaseTableBase()
+	{
+		if (!tableInit)
+		{
+			table = new float[PHASETABLESIZE*NUMCUTOFFS];
+			makeTable();
+			tableInit = true;
+		}
+	}
+};
+
+template<mp_sint32 numTaps>
+bool ResamplerPolyphaseTableBase<numTaps>::tableInit = false;
+template<mp_sint32 numTaps>
+float* ResamplerPolyphaseTableBase<numTaps>::table = NULL;
+
+template<bool ramping, mp_sint32 numTaps, class bufferType, mp_uint32 shift>
+class PolyphaseResamplerDummy : public ResamplerPolyphaseTableBase<numTaps>
+{
+private:
+	typedef ResamplerPolyphaseTableBase<numTaps> Base;
+
+	static inline mp_sint32 wrap(mp_sint32 pos, mp_sint32 len)
+	{
+		pos %= len;
+		return pos < 0 ? pos + len : pos;
+	}
+
+	// slow path: fetch the taps one by one obeying the loop, outside 
+	// of the loop the sample is treated as a finite signal
+	static inline void gatherTaps(bufferType* taps,
+								  const bufferType* sample, 
+								  const mp_sint32 first,
+								  const bool inLoop,
+								  const mp_sint32 flags,
+								  const mp_sint32 loopstart,
+								  const mp_sint32 loopend,
+								  const mp_sint32 smplen)
+	{
+		const mp_sint32 looplen = loopend - loopstart;
+		for (mp_sint32 k = 0; k < Base::NUMTAPS; k++)
+		{
+			mp_sint32 pos = first + k;
+			if (inLoop)
+			{
+				if ((flags & 3) == 1)
+					pos = loopstart + wrap(pos - loopstart, looplen);
+				else
+				{
+					// ping-pong: the end points are played twice
+					pos = wrap(pos - loopstart, looplen*2);
+					if (pos >= looplen)
+						pos = looplen*2 - 1 - pos;
+					pos += loopstart;
+				}
+				taps[k] = sample[pos];
+			}
+			else
+			{
+				taps[k] = (pos >= 0 && pos < smplen) ? sample[pos] : 0;
+			}
+		}
+	}
+
+public:
+	static inline void addBlock(mp_sint32* buffer, ChannelMixer::TMixerChannel* chn, mp_uint32 count)
+	{
+		const bufferType* sample = (const bufferType*)chn->sample;
+
+		mp_sint32 voll = chn->finalvoll;
+		mp_sint32 volr = chn->finalvolr;
+		
+		const mp_sint32 rampFromVolStepL = ramping ? chn->rampFromVolStepL : 0;
+		const mp_sint32 rampFromVolStepR = ramping ? chn->rampFromVolStepR : 0;		
+		
+		mp_sint32 smppos = chn->smppos;
+		mp_sint32 smpposfrac = chn->smpposfrac;
+		const mp_sint32 smpadd = (chn->flags&ChannelMixer::MP_SAMPLE_BACKWARD) ? -chn->smpadd : chn->smpadd;
+		
+		const mp_sint32 flags = chn->flags;
+		const mp_sint32 loopstart = chn->loopstart;
+		const mp_sint32 loopend = chn->loopend;
+		const mp_sint32 smplen = chn->smplen;
+		const bool looping = (flags & 3) && loopend > loopstart;
+		
+		const float* phases = Base::table + Base::getCutoffIndex(chn->smpadd)*Base::PHASETABLESIZE;
+		const float subPhaseScale = 1.0f / (1 << Base::SUBPHASESHIFT);
+		const float scale = (float)(1 << (16-shift));
+
+		bufferType taps[Base::NUMTAPS];
+		
+		while (count--)
+		{
+			const mp_sint32 first = smppos - (Base::WIDTH-1);
+			const bool inLoop = looping && smppos >= loopstart && smppos < loopend;
+			const mp_sint32 lower = inLoop ? loopstart : 0;
+			const mp_sint32 upper = inLoop ? loopend : smplen;
+			
+			// fast path: all taps are straight sample data
+			const bufferType* src = sample + first;
+			if (first < lower || first + Base::NUMTAPS > upper)
+			{
+				gatherTaps(taps, sample, first, inLoop, flags, loopstart, loopend, smplen);
+				src = taps;
+			}
+			
+			const float* row = phases + (smpposfrac >> Base::SUBPHASESHIFT)*Base::NUMTAPS;
+			const float* nextRow = row + Base::NUMTAPS;
+			
+			float sum = 0.0f, nextSum = 0.0f;
+			for (mp_sint32 k = 0; k < Base::NUMTAPS; k++)
+			{
+				const float s = (float)src[k];
+				sum += s * row[k];
+				nextSum += s * nextRow[k];
+			}
+			
+			const float subPhase = (float)(smpposfrac & ((1 << Base::SUBPHASESHIFT)-1)) * subPhaseScale;
+			const mp_sint32 final = (mp_sint32)((sum + (nextSum - sum) * subPhase) * scale);
+			
+			(*buffer++)+=((final*(voll>>15))>>15); 
+			(*buffer++)+=((final*(volr>>15))>>15); 
+
+			if (ramping)
+			{
+				voll+=rampFromVolStepL; 
+				volr+=rampFromVolStepR; 
+			}
+			
+			MP_INCREASESMPPOS(smppos, smpposfrac, smpadd, 16);
+		}
+		
+		chn->smppos = smppos;
+		chn->smpposfrac = smpposfrac;
+
+		if (ramping)
+		{
+			chn->finalvoll = voll;
+			chn->finalvolr = volr;	
+		}
+	}
+};
+
+template<bool ramping, mp_sint32 numTaps>
+class ResamplerPolyphase : public ResamplerPolyphaseTableBase<numTaps>
+{
+public:
+	ResamplerPolyphase() :
+		ResamplerPolyphaseTableBase<numTaps>()
+	{
+	}
+
+	virtual bool isRamping() { return ramping; }
+	virtual bool supportsFullChecking() { return false; }
+	virtual bool supportsNoChecking() { return true; }
+
+	virtual void addBlockNoCheck(mp_sint32* buffer, ChannelMixer::TMixerChannel* chn, mp_uint32 count)
+	{
+		if (chn->flags & 4)
+			PolyphaseResamplerDummy<ramping, numTaps, mp_sword, 16>::addBlock(buffer, chn, count);		
+		else
+			PolyphaseResamplerDummy<ramping, numTaps, mp_sbyte, 8>::addBlock(buffer, chn, count);
+	}
+};
+
+#endif
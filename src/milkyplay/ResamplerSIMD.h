@@ -0,0 +1,581 @@
+/*
+ * Copyright (c) 2009, The MilkyTracker Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the name of the <ORGANIZATION> nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ *  ResamplerSIMD.h
+ *  MilkyPlay
+ *
+ *  SSE2/AVX2/NEON versions of the lerp, lagrange/spline and sinc table 
+ *  resamplers. The vector kernels live in ResamplerSIMDKernels.h, this file 
+ *  provides the vector operations for each instruction set and wraps the 
+ *  kernels into resamplers. ResamplerFactory picks the best variant 
+ *  supported by the CPU at runtime.
+ *
+ *  Compile with -D__MPNOSIMD__ to get rid of all of this.
+ */
+
+#ifndef __RESAMPLERSIMD_H__
+#define __RESAMPLERSIMD_H__
+
+#include "ResamplerFast.h"
+#include "ResamplerCubic.h"
+#include "ResamplerSinc.h"
+
+#ifndef __MPNOSIMD__
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+	#define __MPSIMD_X86__
+	#define MP_SIMD_INLINE inline __attribute__((always_inline))
+	#define MP_SIMD_TARGET_SSE2 __attribute__((target("sse2")))
+	#define MP_SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+	#define __MPSIMD_X86__
+	#define MP_SIMD_INLINE __forceinline
+	#define MP_SIMD_TARGET_SSE2
+	#define MP_SIMD_TARGET_AVX2
+#elif (defined(__ARM_NEON) || defined(__ARM_NEON__)) && defined(__GNUC__)
+	#define __MPSIMD_NEON__
+	#define MP_SIMD_INLINE inline __attribute__((always_inline))
+	#define MP_SIMD_TARGET_NEON
+#endif
+
+#if defined(__MPSIMD_X86__) || defined(__MPSIMD_NEON__)
+#include <string.h>
+
+// unaligned 32 bit load
+static MP_SIMD_INLINE mp_sint32 ResamplerSIMDLoad32(const void* src)
+{
+	mp_sint32 result;
+	memcpy(&result, src, sizeof(result));
+	return result;
+}
+#endif
+
+#ifdef __MPSIMD_X86__
+#include <immintrin.h>
+
+/*
+ * SSE2: 4 lanes
+ */
+class ResamplerSIMDOpsSSE2
+{
+public:
+	typedef __m128i vec;
+	enum { LANES = 4 };
+	
+	MP_SIMD_TARGET_SSE2 static MP_SIMD_INLINE vec zero() { return _mm_setzero_si128(); }
+	MP_SIMD_TARGET_SSE2 static MP_SIMD_INLINE vec set1(mp_sint32 a) { return _mm_set1_epi32(a); }
+	MP_SIMD_TARGET_SSE2 static MP_SIMD_INLINE vec load(const mp_sint32* src) { return _mm_loadu_si128((const __m128i*)src); }
+	MP_SIMD_TARGET_SSE2 static MP_SIMD_INLINE void store(mp_sint32* dst, vec a) { _mm_storeu_si128((__m128i*)dst, a); }
+	MP_SIMD_TARGET_SSE2 static MP_SIMD_INLINE vec add(vec a, vec b) { return _mm_add_epi32(a, b); }
+	MP_SIMD_TARGET_SSE2 static MP_SIMD_INLINE vec sub(vec a, vec b) { return _mm_sub_epi32(a, b); }
+	MP_SIMD_TARGET_SSE2 static MP_SIMD_INLINE vec and_(vec a, vec b) { return _mm_and_si128(a, b); }
+	MP_SIMD_TARGET_SSE2 static MP_SIMD_INLINE vec cmpgt(vec a, vec b) { return _mm_cmpgt_epi32(a, b); }
+	template<int n>
+	MP_SIMD_TARGET_SSE2 static MP_SIMD_INLINE vec srai(vec a) { return _mm_srai_epi32(a, n); }
+	template<int n>
+	MP_SIMD_TARGET_SSE2 static MP_SIMD_INLINE vec slli(vec a) { return _mm_slli_epi32(a, n); }
+
+	MP_SIMD_TARGET_SSE2 static MP_SIMD_INLINE vec abs(vec a) 
+	{ 
+		const __m128i sign = _mm_srai_epi32(a, 31);
+		return _mm_sub_epi32(_mm_xor_si128(a, sign), sign); 
+	}
+
+	// start, start+step, start+2*step...
+	MP_SIMD_TARGET_SSE2 static MP_SIMD_INLINE vec ramp(mp_sint32 start, mp_sint32 step) 
+	{ 
+		return _mm_set_epi32(start+step*3, start+step*2, start+step, start); 
+	}
+	
+	// 32 bit words from base+offsets[i] (offsets in bytes)
+	MP_SIMD_TARGET_SSE2 static MP_SIMD_INLINE vec gather(const void* base, vec offsets)
+	{
+		mp_sint32 o[4];
+		_mm_storeu_si128((__m128i*)o, offsets);
+		const mp_ubyte* src = (const mp_ubyte*)base;
+		return _mm_setr_epi32(ResamplerSIMDLoad32(src+o[0]), ResamplerSIMDLoad32(src+o[1]), 
+							  ResamplerSIMDLoad32(src+o[2]), ResamplerSIMDLoad32(src+o[3]));
+	}
+	
+	// sign extended sample data
+	MP_SIMD_TARGET_SSE2 static MP_SIMD_INLINE vec loadSamples(const mp_sbyte* src)
+	{
+		__m128i a = _mm_cvtsi32_si128(ResamplerSIMDLoad32(src));
+		a = _mm_unpacklo_epi8(a, a);
+		return _mm_srai_epi32(_mm_unpacklo_epi16(a, a), 24);
+	}
+	
+	MP_SIMD_TARGET_SSE2 static MP_SIMD_INLINE vec loadSamples(const mp_sword* src)
+	{
+		const __m128i a = _mm_loadl_epi64((const __m128i*)src);
+		return _mm_srai_epi32(_mm_unpacklo_epi16(a, a), 16);
+	}
+	
+	// low 32 bits of a*b, SSE2 has no pmulld
+	MP_SIMD_TARGET_SSE2 static MP_SIMD_INLINE vec mullo(vec a, vec b)
+	{
+		const __m128i even = _mm_mul_epu32(a, b);
+		const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+		return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0,0,2,0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0,0,2,0)));
+	}
+	
+	// MP_FP_MUL: (a*b)>>16 with a 64 bit intermediate
+	MP_SIMD_TARGET_SSE2 static MP_SIMD_INLINE vec fpmul(vec a, vec b)
+	{
+		// unsigned products, upper halves are corrected for signed operands
+		const __m128i correction = _mm_add_epi32(_mm_and_si128(_mm_srai_epi32(a, 31), b), 
+												 _mm_and_si128(_mm_srai_epi32(b, 31), a));
+		__m128i even = _mm_mul_epu32(a, b);
+		__m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+		even = _mm_sub_epi32(even, _mm_slli_epi64(correction, 32));
+		odd = _mm_sub_epi32(odd, _mm_slli_epi64(_mm_srli_epi64(correction, 32), 32));
+		even = _mm_srli_epi64(even, 16);
+		odd = _mm_srli_epi64(odd, 16);
+		return _mm_or_si128(_mm_srli_epi64(_mm_slli_epi64(even, 32), 32), _mm_slli_epi64(odd, 32));
+	}
+	
+	// add l and r interleaved to a stereo buffer
+	MP_SIMD_TARGET_SSE2 static MP_SIMD_INLINE void addInterleaved(mp_sint32* buffer, vec l, vec r)
+	{
+		__m128i* dst = (__m128i*)buffer;
+		_mm_storeu_si128(dst, _mm_add_epi32(_mm_loadu_si128(dst), _mm_unpacklo_epi32(l, r)));
+		_mm_storeu_si128(dst + 1, _mm_add_epi32(_mm_loadu_si128(dst + 1), _mm_unpackhi_epi32(l, r)));
+	}
+	
+	MP_SIMD_TARGET_SSE2 static MP_SIMD_INLINE mp_sint32 hsum(vec a)
+	{
+		a = _mm_add_epi32(a, _mm_shuffle_epi32(a, _MM_SHUFFLE(1,0,3,2)));
+		a = _mm_add_epi32(a, _mm_shuffle_epi32(a, _MM_SHUFFLE(2,3,0,1)));
+		return _mm_cvtsi128_si32(a);
+	}
+};
+
+/*
+ * AVX2: 8 lanes
+ */
+class ResamplerSIMDOpsAVX2
+{
+public:
+	typedef __m256i vec;
+	enum { LANES = 8 };
+	
+	MP_SIMD_TARGET_AVX2 static MP_SIMD_INLINE vec zero() { return _mm256_setzero_si256(); }
+	MP_SIMD_TARGET_AVX2 static MP_SIMD_INLINE vec set1(mp_sint32 a) { return _mm256_set1_epi32(a); }
+	MP_SIMD_TARGET_AVX2 static MP_SIMD_INLINE vec load(const mp_sint32* src) { return _mm256_loadu_si256((const __m256i*)src); }
+	MP_SIMD_TARGET_AVX2 static MP_SIMD_INLINE void store(mp_sint32* dst, vec a) { _mm256_storeu_si256((__m256i*)dst, a); }
+	MP_SIMD_TARGET_AVX2 static MP_SIMD_INLINE vec add(vec a, vec b) { return _mm256_add_epi32(a, b); }
+	MP_SIMD_TARGET_AVX2 static MP_SIMD_INLINE vec sub(vec a, vec b) { return _mm256_sub_epi32(a, b); }
+	MP_SIMD_TARGET_AVX2 static MP_SIMD_INLINE vec and_(vec a, vec b) { return _mm256_and_si256(a, b); }
+	MP_SIMD_TARGET_AVX2 static MP_SIMD_INLINE vec cmpgt(vec a, vec b) { return _mm256_cmpgt_epi32(a, b); }
+	template<int n>
+	MP_SIMD_TARGET_AVX2 static MP_SIMD_INLINE vec srai(vec a) { return _mm256_srai_epi32(a, n); }
+	template<int n>
+	MP_SIMD_TARGET_AVX2 static MP_SIMD_INLINE vec slli(vec a) { return _mm256_slli_epi32(a, n); }
+	MP_SIMD_TARGET_AVX2 static MP_SIMD_INLINE vec abs(vec a) { return _mm256_abs_epi32(a); }
+	MP_SIMD_TARGET_AVX2 static MP_SIMD_INLINE vec mullo(vec a, vec b) { return _mm256_mullo_epi32(a, b); }
+
+	MP_SIMD_TARGET_AVX2 static MP_SIMD_INLINE vec ramp(mp_sint32 start, mp_sint32 step) 
+	{ 
+		return _mm256_add_epi32(_mm256_set1_epi32(start), 
+								_mm256_mullo_epi32(_mm256_set1_epi32(step), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7))); 
+	}
+	
+	MP_SIMD_TARGET_AVX2 static MP_SIMD_INLINE vec gather(const void* base, vec offsets)
+	{
+		return _mm256_i32gather_epi32((const int*)base, offsets, 1);
+	}
+	
+	MP_SIMD_TARGET_AVX2 static MP_SIMD_INLINE vec loadSamples(const mp_sbyte* src)
+	{
+		return _mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i*)src));
+	}
+	
+	MP_SIMD_TARGET_AVX2 static MP_SIMD_INLINE vec loadSamples(const mp_sword* src)
+	{
+		return _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)src));
+	}
+	
+	MP_SIMD_TARGET_AVX2 static MP_SIMD_INLINE vec fpmul(vec a, vec b)
+	{
+		const __m256i even = _mm256_srli_epi64(_mm256_mul_epi32(a, b), 16);
+		const __m256i odd = _mm256_srli_epi64(_mm256_mul_epi32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32)), 16);
+		return _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xAA);
+	}
+	
+	MP_SIMD_TARGET_AVX2 static MP_SIMD_INLINE void addInterleaved(mp_sint32* buffer, vec l, vec r)
+	{
+		// unpack works on 128 bit lanes, the permutes restore frame order
+		const __m256i lo = _mm256_unpacklo_epi32(l, r);
+		const __m256i hi = _mm256_unpackhi_epi32(l, r);
+		__m256i* dst = (__m256i*)buffer;
+		_mm256_storeu_si256(dst, _mm256_add_epi32(_mm256_loadu_si256(dst), _mm256_permute2x128_si256(lo, hi, 0x20)));
+		_mm256_storeu_si256(dst + 1, _mm256_add_epi32(_mm256_loadu_si256(dst + 1), _mm256_permute2x128_si256(lo, hi, 0x31)));
+	}
+	
+	MP_SIMD_TARGET_AVX2 static MP_SIMD_INLINE mp_sint32 hsum(vec a)
+	{
+		__m128i b = _mm_add_epi32(_mm256_castsi256_si128(a), _mm256_extracti128_si256(a, 1));
+		b = _mm_add_epi32(b, _mm_shuffle_epi32(b, _MM_SHUFFLE(1,0,3,2)));
+		b = _mm_add_epi32(b, _mm_shuffle_epi32(b, _MM_SHUFFLE(2,3,0,1)));
+		return _mm_cvtsi128_si32(b);
+	}
+};
+
+#define SIMD_KERNEL_NAME ResamplerSIMDKernelSSE2
+#define SIMD_KERNEL_OPS ResamplerSIMDOpsSSE2
+#define SIMD_KERNEL_TARGET MP_SIMD_TARGET_SSE2
+#include "ResamplerSIMDKernels.h"
+#undef SIMD_KERNEL_NAME
+#undef SIMD_KERNEL_OPS
+#undef SIMD_KERNEL_TARGET
+
+#define SIMD_KERNEL_NAME ResamplerSIMDKernelAVX2
+#define SIMD_KERNEL_OPS ResamplerSIMDOpsAVX2
+#define SIMD_KERNEL_TARGET MP_SIMD_TARGET_AVX2
+#include "ResamplerSIMDKernels.h"
+#undef SIMD_KERNEL_NAME
+#undef SIMD_KERNEL_OPS
+#undef SIMD_KERNEL_TARGET
+
+#endif // __MPSIMD_X86__
+
+#ifdef __MPSIMD_NEON__
+#include <arm_neon.h>
+
+/*
+ * NEON: 4 lanes
+ */
+class ResamplerSIMDOpsNEON
+{
+public:
+	typedef int32x4_t vec;
+	enum { LANES = 4 };
+	
+	static MP_SIMD_INLINE vec zero() { return vdupq_n_s32(0); }
+	static MP_SIMD_INLINE vec set1(mp_sint32 a) { return vdupq_n_s32(a); }
+	static MP_SIMD_INLINE vec load(const mp_sint32* src) { return vld1q_s32(src); }
+	static MP_SIMD_INLINE void store(mp_sint32* dst, vec a) { vst1q_s32(dst, a); }
+	static MP_SIMD_INLINE vec add(vec a, vec b) { return vaddq_s32(a, b); }
+	static MP_SIMD_INLINE vec sub(vec a, vec b) { return vsubq_s32(a, b); }
+	static MP_SIMD_INLINE vec and_(vec a, vec b) { return vandq_s32(a, b); }
+	static MP_SIMD_INLINE vec cmpgt(vec a, vec b) { return vreinterpretq_s32_u32(vcgtq_s32(a, b)); }
+	template<int n>
+	static MP_SIMD_INLINE vec srai(vec a) { return vshrq_n_s32(a, n); }
+	template<int n>
+	static MP_SIMD_INLINE vec slli(vec a) { return vshlq_n_s32(a, n); }
+	static MP_SIMD_INLINE vec abs(vec a) { return vabsq_s32(a); }
+	static MP_SIMD_INLINE vec mullo(vec a, vec b) { return vmulq_s32(a, b); }
+
+	static MP_SIMD_INLINE vec ramp(mp_sint32 start, mp_sint32 step) 
+	{ 
+		const mp_sint32 values[4] = { start, start+step, start+step*2, start+step*3 };
+		return vld1q_s32(values);
+	}
+	
+	static MP_SIMD_INLINE vec gather(const void* base, vec offsets)
+	{
+		const mp_ubyte* src = (const mp_ubyte*)base;
+		vec result = vdupq_n_s32(ResamplerSIMDLoad32(src+vgetq_lane_s32(offsets, 0)));
+		result = vsetq_lane_s32(ResamplerSIMDLoad32(src+vgetq_lane_s32(offsets, 1)), result, 1);
+		result = vsetq_lane_s32(ResamplerSIMDLoad32(src+vgetq_lane_s32(offsets, 2)), result, 2);
+		return vsetq_lane_s32(ResamplerSIMDLoad32(src+vgetq_lane_s32(offsets, 3)), result, 3);
+	}
+	
+	static MP_SIMD_INLINE vec loadSamples(const mp_sbyte* src)
+	{
+		const int8x8_t a = vreinterpret_s8_s32(vdup_n_s32(ResamplerSIMDLoad32(src)));
+		return vmovl_s16(vget_low_s16(vmovl_s8(a)));
+	}
+	
+	static MP_SIMD_INLINE vec loadSamples(const mp_sword* src)
+	{
+		return vmovl_s16(vld1_s16((const int16_t*)src));
+	}
+
+	static MP_SIMD_INLINE vec fpmul(vec a, vec b)
+	{
+		// narrowing shift keeps the low 32 bits, just like the scalar version
+		return vcombine_s32(vshrn_n_s64(vmull_s32(vget_low_s32(a), vget_low_s32(b)), 16),
+							vshrn_n_s64(vmull_s32(vget_high_s32(a), vget_high_s32(b)), 16));
+	}
+	
+	static MP_SIMD_INLINE void addInterleaved(mp_sint32* buffer, vec l, vec r)
+	{
+		int32x4x2_t frames = vld2q_s32(buffer);
+		frames.val[0] = vaddq_s32(frames.val[0], l);
+		frames.val[1] = vaddq_s32(frames.val[1], r);
+		vst2q_s32(buffer, frames);
+	}
+	
+	static MP_SIMD_INLINE mp_sint32 hsum(vec a)
+	{
+		const int32x2_t b = vadd_s32(vget_low_s32(a), vget_high_s32(a));
+		return vget_lane_s32(vpadd_s32(b, b), 0);
+	}
+};
+
+#define SIMD_KERNEL_NAME ResamplerSIMDKernelNEON
+#define SIMD_KERNEL_OPS ResamplerSIMDOpsNEON
+#define SIMD_KERNEL_TARGET MP_SIMD_TARGET_NEON
+#include "ResamplerSIMDKernels.h"
+#undef SIMD_KERNEL_NAME
+#undef SIMD_KERNEL_OPS
+#undef SIMD_KERNEL_TARGET
+
+#endif // __MPSIMD_NEON__
+
+#if defined(__MPSIMD_X86__) || defined(__MPSIMD_NEON__)
+#define __MPSIMD__
+
+/*
+ * Linear interpolation without ramping
+ */
+template<template<class, mp_uint32> class Kernel>
+class ResamplerLerpSIMD : public ResamplerLerp
+{
+public:
+	virtual void addBlockNoCheck(mp_sint32* buffer, ChannelMixer::TMixerChannel* chn, mp_uint32 count)
+	{
+		mp_sint32 voll = chn->finalvoll;
+		mp_sint32 volr = chn->finalvolr;
+
+		const mp_sint32 smpadd = (chn->flags&ChannelMixer::MP_SAMPLE_BACKWARD) ? -chn->smpadd : chn->smpadd;
+		const mp_sint32 basepos = chn->smppos;
+		const mp_sint32 posfixed = chn->smpposfrac;
+
+		mp_sint32 fp = smpadd*count;
+		MP_INCREASESMPPOS(chn->smppos, chn->smpposfrac, fp, 16);
+
+		if ((voll == 0) && (volr == 0)) return;
+		
+		if (chn->flags & 4)
+			Kernel<mp_sword, 16>::addBlockLerp(buffer, (const mp_sword*)chn->sample + basepos, posfixed, smpadd, count, voll, volr, 0, 0);
+		else
+			Kernel<mp_sbyte, 8>::addBlockLerp(buffer, chn->sample + basepos, posfixed, smpadd, count, voll, volr, 0, 0);
+	}
+};
+
+/*
+ * Linear interpolation with ramping, filtered channels are 
+ * left to the scalar resampler
+ */
+template<template<class, mp_uint32> class Kernel>
+class ResamplerLerpRampFilterSIMD : public ResamplerLerpRampFilter
+{
+public:
+	virtual void addBlockNoCheck(mp_sint32* buffer, ChannelMixer::TMixerChannel* chn, mp_uint32 count)
+	{
+		if (chn->cutoff != ChannelMixer::MP_INVALID_VALUE && chn->resonance != ChannelMixer::MP_INVALID_VALUE)
+		{
+			ResamplerLerpRampFilter::addBlockNoCheck(buffer, chn, count);
+			return;
+		}
+		
+		mp_sint32 voll = chn->finalvoll;
+		mp_sint32 volr = chn->finalvolr;
+		
+		const mp_sint32 rampFromVolStepL = chn->rampFromVolStepL;
+		const mp_sint32 rampFromVolStepR = chn->rampFromVolStepR;		
+		
+		const mp_sint32 smpadd = (chn->flags&ChannelMixer::MP_SAMPLE_BACKWARD) ? -chn->smpadd : chn->smpadd;
+		const mp_sint32 basepos = chn->smppos;
+		const mp_sint32 posfixed = chn->smpposfrac;
+		
+		mp_sint32 fp = smpadd*count;
+		MP_INCREASESMPPOS(chn->smppos, chn->smpposfrac, fp, 16);
+		
+		if ((voll == 0 && rampFromVolStepL == 0) && (volr == 0 && rampFromVolStepR == 0)) return;
+		
+		if (chn->flags & 4)
+			Kernel<mp_sword, 16>::addBlockLerp(buffer, (const mp_sword*)chn->sample + basepos, posfixed, smpadd, count, voll, volr, rampFromVolStepL, rampFromVolStepR);
+		else
+			Kernel<mp_sbyte, 8>::addBlockLerp(buffer, chn->sample + basepos, posfixed, smpadd, count, voll, volr, rampFromVolStepL, rampFromVolStepR);
+		
+		chn->finalvoll = voll;
+		chn->finalvolr = volr;	
+	}
+};
+
+/*
+ * Cubic lagrange/spline interpolation
+ */
+template<bool ramping, CubicResamplers type, template<class, mp_uint32> class Kernel>
+class ResamplerLagrangeSIMD : public ResamplerLagrange<ramping, type>
+{
+public:
+	virtual void addBlockNoCheck(mp_sint32* buffer, ChannelMixer::TMixerChannel* chn, mp_uint32 count)
+	{
+		mp_sint32 voll = chn->finalvoll;
+		mp_sint32 volr = chn->finalvolr;
+		
+		const mp_sint32 rampFromVolStepL = ramping ? chn->rampFromVolStepL : 0;
+		const mp_sint32 rampFromVolStepR = ramping ? chn->rampFromVolStepR : 0;		
+		
+		const mp_sint32 smpadd = (chn->flags&ChannelMixer::MP_SAMPLE_BACKWARD) ? -chn->smpadd : chn->smpadd;
+		const mp_sint32 basepos = chn->smppos;
+		const mp_sint32 posfixed = chn->smpposfrac;
+		
+		mp_sint32 fp = smpadd*count;
+		MP_INCREASESMPPOS(chn->smppos, chn->smpposfrac, fp, 16);
+		
+		if (chn->flags & 4)
+			Kernel<mp_sword, 16>::template addBlockCubic<type>(buffer, (const mp_sword*)chn->sample + basepos, posfixed, smpadd, count, voll, volr, rampFromVolStepL, rampFromVolStepR);
+		else
+			Kernel<mp_sbyte, 8>::template addBlockCubic<type>(buffer, chn->sample + basepos, posfixed, smpadd, count, voll, volr, rampFromVolStepL, rampFromVolStepR);
+
+		if (ramping)
+		{
+			chn->finalvoll = voll;
+			chn->finalvolr = volr;	
+		}
+	}
+};
+
+/*
+ * Sinc table resampler: whenever the whole window lies in between 
+ * the loop points (or sample boundaries) the taps are consecutive in memory 
+ * and get convolved by the vector kernel, otherwise the scalar loop aware 
+ * version is used.
+ */
+template<bool ramping, mp_sint32 windowSize, template<class, mp_uint32> class Kernel>
+class ResamplerSincTableSIMD : public ResamplerSincTable<ramping, windowSize>
+{
+private:
+	typedef ResamplerSincTableBase<windowSize> Base;
+
+	template<class bufferType, mp_uint32 shift>
+	static inline void addBlock(mp_sint32* buffer, ChannelMixer::TMixerChannel* chn, mp_uint32 count)
+	{
+		typedef SincTableResamplerDummy<ramping, windowSize, bufferType, shift> Scalar;
+		typedef Kernel<bufferType, shift> Vector;
+		
+		enum { WIDTH = Base::WIDTH };
+	
+		const bufferType* sample = (const bufferType*)chn->sample;
+		const mp_sint32* sincTable = Base::sinc_table;
+
+		mp_sint32 voll = chn->finalvoll;
+		mp_sint32 volr = chn->finalvolr;
+		
+		const mp_sint32 rampFromVolStepL = ramping ? chn->rampFromVolStepL : 0;
+		const mp_sint32 rampFromVolStepR = ramping ? chn->rampFromVolStepR : 0;		
+		
+		mp_sint32 smppos = chn->smppos;
+		mp_sint32 smpposfrac = chn->smpposfrac;
+		const mp_sint32 smpadd = (chn->flags&ChannelMixer::MP_SAMPLE_BACKWARD) ? -chn->smpadd : chn->smpadd;
+		const mp_sint32 rsmpadd = chn->rsmpadd;
+		
+		const mp_sint32 flags = chn->flags;
+		const mp_sint32 loopstart = chn->loopstart;
+		const mp_sint32 loopend = chn->loopend;
+		const mp_sint32 loopendcopy = chn->loopendcopy;
+		const mp_sint32 smplen = chn->smplen;
+		
+		mp_sint32 fixedtimefrac = chn->fixedtimefrac;
+		const mp_sint32 timeadd = chn->smpadd;
+		const bool downsampling = timeadd >= 65536;
+	
+		const mp_sint32 negflags = smpadd < 0 ? (flags & ~ChannelMixer::MP_SAMPLE_BACKWARD) : ((flags & ~ChannelMixer::MP_SAMPLE_BACKWARD) | ChannelMixer::MP_SAMPLE_BACKWARD);
+		const mp_sint32 posflags = smpadd > 0 ? (flags & ~ChannelMixer::MP_SAMPLE_BACKWARD) : ((flags & ~ChannelMixer::MP_SAMPLE_BACKWARD) | ChannelMixer::MP_SAMPLE_BACKWARD);
+		
+		// the "negative" half of the window walks against the playing direction
+		const mp_sint32 negDir = smpadd < 0 ? 1 : -1;
+		const mp_sint32 step = downsampling ? rsmpadd : 65536;
+		
+		while (count--)
+		{
+			mp_sint32 windowstart = 0;
+			mp_sint32 windowend = smplen;
+			if ((flags & 3) && smppos >= loopstart && smppos < loopend)
+			{
+				windowstart = loopstart;
+				windowend = loopend;
+			}
+		
+			mp_sint32 result;
+			if (smpadd && smppos - (WIDTH-1) >= windowstart && smppos + (WIDTH-1) < windowend)
+			{
+				mp_sint32 time = downsampling ? MP_FP_MUL(fixedtimefrac, rsmpadd) : fixedtimefrac;
+				if (!time && (flags & ChannelMixer::MP_SAMPLE_BACKWARD)) 
+					time = 65536;
+				
+				// time of the first tap in memory order
+				time-=negDir*(WIDTH-1)*step;
+				
+				if (downsampling)
+					result = Vector::template convolveSinc<WIDTH, Base::SAMPLES_PER_ZERO_CROSSING_SHIFT, true>(sample + smppos - (WIDTH-1), sincTable, time, negDir*step, rsmpadd);
+				else
+					result = Vector::template convolveSinc<WIDTH, Base::SAMPLES_PER_ZERO_CROSSING_SHIFT, false>(sample + smppos - (WIDTH-1), sincTable, time, negDir*step, rsmpadd);
+			}
+			else if (downsampling)
+				result = Scalar::template convolve<true>(sample, smppos, fixedtimefrac, rsmpadd, flags, negflags, posflags, loopstart, loopend, loopendcopy, smplen);
+			else
+				result = Scalar::template convolve<false>(sample, smppos, fixedtimefrac, rsmpadd, flags, negflags, posflags, loopstart, loopend, loopendcopy, smplen);
+			
+			(*buffer++)+=(((result)*(voll>>15))>>15); 
+			(*buffer++)+=(((result)*(volr>>15))>>15); 
+			
+			if (ramping)
+			{
+				voll+=rampFromVolStepL; 
+				volr+=rampFromVolStepR; 
+			}
+			
+			MP_INCREASESMPPOS(smppos, smpposfrac, smpadd, 16);
+			fixedtimefrac=(fixedtimefrac+timeadd) & 65535;
+		}
+		
+		chn->smppos = smppos;
+		chn->smpposfrac = smpposfrac;
+
+		chn->fixedtimefrac = fixedtimefrac;
+		
+		if (ramping)
+		{
+			chn->finalvoll = voll;
+			chn->finalvolr = volr;	
+		}
+	}
+	
+public:
+	virtual void addBlockNoCheck(mp_sint32* buffer, ChannelMixer::TMixerChannel* chn, mp_uint32 count)
+	{
+		if (chn->flags & 4)
+			addBlock<mp_sword, 16>(buffer, chn, count);		
+		else
+			addBlock<mp_sbyte, 8>(buffer, chn, count);
+	}
+};
+
+#endif
+
+#endif // __MPNOSIMD__
+
+#endif
@@ -0,0 +1,298 @@
+/*
+ * Copyright (c) 2009, The MilkyTracker Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the name of the <ORGANIZATION> nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ *  ResamplerSIMDKernels.h
+ *  MilkyPlay
+ *
+ *  Vectorized inner loops for the lerp, cubic and sinc table resamplers.
+ *
+ *  This file is included once per instruction set by ResamplerSIMD.h
+ *  (hence no include guard). Before including it define:
+ *
+ *  SIMD_KERNEL_NAME	name of the resulting kernel class template
+ *  SIMD_KERNEL_OPS		class providing the vector operations (see ResamplerSIMD.h)
+ *  SIMD_KERNEL_TARGET	function attribute enabling the instruction set
+ *
+ *  All kernels use exactly the same integer arithmetic as their scalar 
+ *  counterparts in ResamplerMacros.h, ResamplerCubic.h and ResamplerSinc.h,
+ *  so the output is bit exact.
+ */
+
+template<class bufferType, mp_uint32 shift>
+class SIMD_KERNEL_NAME
+{
+private:
+	typedef SIMD_KERNEL_OPS V;
+
+	// byte offsets of the sample points idx
+	SIMD_KERNEL_TARGET static MP_SIMD_INLINE V::vec offsets(V::vec idx)
+	{
+		return V::slli<sizeof(bufferType)-1>(idx);
+	}
+
+	// extract sample point k from a 32 bit word fetched by V::gather
+	// (2 points for 16 bit, 4 points for 8 bit samples), 
+	// the masking just keeps the shift count valid for unused k
+	template<mp_sint32 k>
+	SIMD_KERNEL_TARGET static MP_SIMD_INLINE V::vec point(V::vec words)
+	{
+		return V::slli<16-shift>(V::srai<32-shift>(V::slli<(32-shift*(k+1)) & 31>(words)));
+	}
+
+public:
+	/*
+	 * Linear interpolation, see NOCHECKMIXER_XXBIT_LERP(_RAMP)
+	 * sample points to the integer sample position, posfixed is the 16.16
+	 * position relative to it. Pass zero ramping steps for non ramping mixers.
+	 */
+	SIMD_KERNEL_TARGET static void addBlockLerp(mp_sint32* buffer, 
+												const bufferType* sample, 
+												mp_sint32 posfixed, 
+												const mp_sint32 smpadd, 
+												mp_uint32 count,
+												mp_sint32& voll, 
+												mp_sint32& volr,
+												const mp_sint32 rampFromVolStepL, 
+												const mp_sint32 rampFromVolStepR)
+	{
+		V::vec vl = V::ramp(voll, rampFromVolStepL);
+		V::vec vr = V::ramp(volr, rampFromVolStepR);
+		const V::vec stepl = V::set1(rampFromVolStepL*V::LANES);
+		const V::vec stepr = V::set1(rampFromVolStepR*V::LANES);
+		
+		V::vec pos = V::ramp(posfixed, smpadd);
+		const V::vec step = V::set1(smpadd*V::LANES);
+		const V::vec fracMask = V::set1(0xfff);
+		
+		mp_uint32 blockCount = count / V::LANES;
+		mp_uint32 remainCount = count % V::LANES;
+
+		voll+=rampFromVolStepL*(mp_sint32)(blockCount*V::LANES);
+		volr+=rampFromVolStepR*(mp_sint32)(blockCount*V::LANES);
+		posfixed+=smpadd*(mp_sint32)(blockCount*V::LANES);
+		
+		while (blockCount--)
+		{
+			// both sample points come with a single fetch
+			const V::vec words = V::gather(sample, offsets(V::srai<16>(pos)));
+			const V::vec sd1 = point<0>(words);
+			const V::vec sd2 = point<1>(words);
+			const V::vec f = V::and_(V::srai<4>(pos), fracMask);
+
+			const V::vec sd = V::srai<12>(V::add(V::slli<12>(sd1), V::mullo(f, V::sub(sd2, sd1))));
+			
+			V::addInterleaved(buffer, 
+							  V::srai<15>(V::mullo(sd, V::srai<15>(vl))), 
+							  V::srai<15>(V::mullo(sd, V::srai<15>(vr))));
+			buffer+=V::LANES*2;
+			
+			pos = V::add(pos, step);
+			vl = V::add(vl, stepl);
+			vr = V::add(vr, stepr);
+		}
+
+		while (remainCount--)
+		{
+			mp_sint32 sd1 = (mp_sint32)sample[posfixed>>16] << (16-shift);
+			const mp_sint32 sd2 = (mp_sint32)sample[(posfixed>>16)+1] << (16-shift);
+			sd1 =((sd1<<12)+((posfixed>>4)&0xfff)*(sd2-sd1))>>12;
+			(*buffer++)+=((sd1*(voll>>15))>>15);
+			(*buffer++)+=((sd1*(volr>>15))>>15);
+			voll+=rampFromVolStepL;
+			volr+=rampFromVolStepR;
+			posfixed+=smpadd;
+		}
+	}
+	
+	/*
+	 * 4 point lagrange/spline interpolation, see CubicResamplerDummy
+	 */
+	template<CubicResamplers type>
+	SIMD_KERNEL_TARGET static void addBlockCubic(mp_sint32* buffer, 
+												 const bufferType* sample, 
+												 mp_sint32 posfixed, 
+												 const mp_sint32 smpadd, 
+												 mp_uint32 count,
+												 mp_sint32& voll, 
+												 mp_sint32& volr,
+												 const mp_sint32 rampFromVolStepL, 
+												 const mp_sint32 rampFromVolStepR)
+	{
+		V::vec vl = V::ramp(voll, rampFromVolStepL);
+		V::vec vr = V::ramp(volr, rampFromVolStepR);
+		const V::vec stepl = V::set1(rampFromVolStepL*V::LANES);
+		const V::vec stepr = V::set1(rampFromVolStepR*V::LANES);
+
+		V::vec pos = V::ramp(posfixed, smpadd);
+		const V::vec step = V::set1(smpadd*V::LANES);
+		const V::vec fracMask = V::set1(65535);
+		const V::vec one = V::set1(1);
+
+		const V::vec oneThird = V::set1(65536/3);
+		const V::vec oneSixth = V::set1(65536/6);
+		const V::vec twoThirds = V::set1(65536*2/3);
+		
+		mp_uint32 blockCount = count / V::LANES;
+		mp_uint32 remainCount = count % V::LANES;
+
+		voll+=rampFromVolStepL*(mp_sint32)(blockCount*V::LANES);
+		volr+=rampFromVolStepR*(mp_sint32)(blockCount*V::LANES);
+		posfixed+=smpadd*(mp_sint32)(blockCount*V::LANES);
+
+		while (blockCount--)
+		{
+			const V::vec idx = V::srai<16>(pos);
+			V::vec y0, y1, y2, y3;
+			if (shift == 8)
+			{
+				const V::vec words = V::gather(sample, offsets(V::sub(idx, one)));
+				y0 = point<0>(words);
+				y1 = point<1>(words);
+				y2 = point<2>(words);
+				y3 = point<3>(words);
+			}
+			else
+			{
+				const V::vec words01 = V::gather(sample, offsets(V::sub(idx, one)));
+				const V::vec words23 = V::gather(sample, offsets(V::add(idx, one)));
+				y0 = point<0>(words01);
+				y1 = point<1>(words01);
+				y2 = point<0>(words23);
+				y3 = point<1>(words23);
+			}
+			const V::vec xv = V::and_(pos, fracMask);
+			
+			V::vec c0, c1, c2, c3;
+			switch (type)
+			{
+				case CubicResamplerLagrange:
+					c0 = y1;
+					c1 = V::sub(V::sub(V::sub(y2, V::srai<16>(V::mullo(y0, oneThird))), 
+										   V::srai<16>(V::mullo(y3, oneSixth))), 
+								 V::srai<1>(y1));
+					c2 = V::sub(V::srai<1>(V::add(y0, y2)), y1);
+					c3 = V::add(V::srai<16>(V::mullo(oneSixth, V::sub(y3, y0))), 
+								V::srai<1>(V::sub(y1, y2)));
+					break;
+				case CubicResamplerSpline:
+				{
+					const V::vec ym1py1 = V::add(y0, y2);
+					c0 = V::srai<16>(V::add(V::mullo(oneSixth, ym1py1), V::mullo(twoThirds, y1)));
+					c1 = V::srai<1>(V::sub(y2, y0));
+					c2 = V::sub(V::srai<1>(ym1py1), y1);
+					c3 = V::add(V::srai<1>(V::sub(y1, y2)), 
+								V::srai<16>(V::mullo(oneSixth, V::sub(y3, y0))));
+					break;
+				}
+			}
+			
+			const V::vec s = V::add(V::fpmul(V::add(V::fpmul(V::add(V::fpmul(c3, xv), c2), xv), c1), xv), c0);
+			
+			V::addInterleaved(buffer, 
+							  V::srai<15>(V::mullo(s, V::srai<15>(vl))), 
+							  V::srai<15>(V::mullo(s, V::srai<15>(vr))));
+			buffer+=V::LANES*2;
+			
+			pos = V::add(pos, step);
+			vl = V::add(vl, stepl);
+			vr = V::add(vr, stepr);
+		}
+		
+		while (remainCount--)
+		{
+			mp_sint32 s;
+			switch (type)
+			{
+				case CubicResamplerLagrange:
+					s = CubicResamplerDummy<false, CubicResamplerLagrange, bufferType, shift>::interpolate_lagrange4Point(sample, posfixed);
+					break;
+				case CubicResamplerSpline:
+					s = CubicResamplerDummy<false, CubicResamplerSpline, bufferType, shift>::interpolate_spline4Point(sample, posfixed);
+					break;
+			}
+			(*buffer++)+=(s*(voll>>15))>>15; 
+			(*buffer++)+=(s*(volr>>15))>>15; 
+			voll+=rampFromVolStepL;
+			volr+=rampFromVolStepR;
+			posfixed+=smpadd;
+		}
+	}
+	
+	/*
+	 * Windowed sinc convolution of 2*width-1 consecutive sample points 
+	 * (memory order) starting at taps, see SincTableResamplerDummy::convolve
+	 * The sinc function is evaluated at time + i*timeStep for tap i.
+	 * When downsampling each coefficient is additionally scaled by rsmpadd.
+	 * Reads up to LANES-1 sample points past the last tap, those are masked out.
+	 */
+	template<mp_sint32 width, mp_sint32 zeroCrossingShift, bool downsampling>
+	SIMD_KERNEL_TARGET static mp_sint32 convolveSinc(const bufferType* taps, 
+													 const mp_sint32* sincTable, 
+													 const mp_sint32 time, 
+													 const mp_sint32 timeStep,
+													 const mp_sint32 rsmpadd)
+	{
+		enum 
+		{ 
+			NUMTAPS = width*2-1,
+			NUMBLOCKS = (NUMTAPS + V::LANES - 1) / V::LANES,
+			LASTBLOCKTAPS = NUMTAPS - (NUMBLOCKS-1) * V::LANES
+		};
+		
+		const V::vec maxTime = V::set1(width-1);
+		const V::vec scale = V::set1(rsmpadd);
+		V::vec times = V::ramp(time, timeStep);
+		const V::vec step = V::set1(timeStep*V::LANES);
+		V::vec acc = V::zero();
+		
+		for (mp_sint32 block = 0; block < NUMBLOCKS; block++)
+		{
+			const V::vec t = V::abs(times);
+			// taps outside the window are zero
+			V::vec inside = V::cmpgt(maxTime, V::srai<16>(t));
+			if (block == NUMBLOCKS-1)
+				inside = V::and_(inside, V::cmpgt(V::set1(LASTBLOCKTAPS), V::ramp(0, 1)));
+			
+			const V::vec idx = V::and_(V::srai<16-zeroCrossingShift>(t), inside);
+			const V::vec tableOffsets = V::slli<2>(idx);
+			const V::vec t0 = V::gather(sincTable, tableOffsets);
+			const V::vec t1 = V::gather(sincTable + 1, tableOffsets);
+			
+			V::vec coeff = V::and_(V::add(t0, V::fpmul(V::sub(t1, t0), idx)), inside);
+			if (downsampling)
+				coeff = V::fpmul(coeff, scale);
+			
+			acc = V::add(acc, V::srai<shift>(V::mullo(V::loadSamples(taps + block*V::LANES), coeff)));
+			times = V::add(times, step);
+		}
+		
+		return V::hsum(acc);
+	}
+};
@@ -35,6 +35,9 @@
  *
  */
 
+#ifndef __RESAMPLERSINC_H__
+#define __RESAMPLERSINC_H__
+
 #include <math.h>
 
 /*
@@ -315,6 +318,12 @@ public:
 	virtual bool supportsFullChecking() { return false; }
 	virtual bool supportsNoChecking() { return true; }
 
+	virtual void skipBlock(ChannelMixer::TMixerChannel* chn, mp_uint32 count)
+	{
+		ChannelMixer::ResamplerBase::skipBlock(chn, count);
+		chn->fixedtimefrac = (mp_sint32)((chn->fixedtimefrac + (mp_uint32)chn->smpadd*count) & 65535);
+	}
+
 	virtual void addBlockNoCheck(mp_sint32* buffer, ChannelMixer::TMixerChannel* chn, mp_uint32 count)
 	{
 		if (chn->flags & 4)
@@ -389,6 +398,84 @@ template<bool ramping, mp_sint32 windowSize, class bufferType, mp_uint32 shift>
 class SincTableResamplerDummy : public ResamplerSincTableBase<windowSize>
 {
 public:
+	// convolve a single output sample at smppos, walking along the sample 
+	// in both directions and obeying loop points.
+	// when downsampling, the sinc function is stretched by rsmpadd
+	template<bool downsampling>
+	static inline mp_sint32 convolve(const bufferType* sample, 
+									 const mp_sint32 smppos, 
+									 const mp_sint32 fixedtimefrac, 
+									 const mp_sint32 rsmpadd, 
+									 const mp_sint32 flags, 
+									 const mp_sint32 negflags, 
+									 const mp_sint32 posflags, 
+									 const mp_sint32 loopstart, 
+									 const mp_sint32 loopend, 
+									 const mp_sint32 loopendcopy, 
+									 const mp_sint32 smplen)
+	{
+		mp_sint32 result = 0;
+		
+		mp_sint32 tmpsmppos = smppos; 
+		mp_sint32 tmploopstart = loopstart;
+		mp_sint32 tmploopend = loopend;
+		mp_sint32 tmpflags = negflags; 
+		// check whether we are outside loop points
+		// if that's the case we're treating the sample as a normal finite signal
+		// note that this is still not totally correct treatment
+		const bool outSideLoop = !(((flags & 3) && tmpsmppos >= loopstart && tmpsmppos < loopend));
+		if (outSideLoop)
+		{
+			tmploopstart = 0;
+			tmploopend = smplen;
+			tmpflags &= ~3;
+		}
+		
+		const mp_sint32 timeadd = downsampling ? rsmpadd : 65536;
+		
+		mp_sint32 time = downsampling ? fpmul(fixedtimefrac, rsmpadd) : fixedtimefrac;
+		if (!time && (flags & ChannelMixer::MP_SAMPLE_BACKWARD)) 
+			time = 65536;
+		
+		mp_sint32 j;				
+		for (j = 0; j<ResamplerSincTableBase<windowSize>::WIDTH; j++)
+		{
+			if (downsampling)
+				result += (sample[tmpsmppos] * fpmul(SINC(time), rsmpadd)) >> shift;
+			else
+				result += (sample[tmpsmppos] * SINC(time)) >> shift;
+			
+			time+=timeadd;
+			advancePos(tmpsmppos, tmpflags, tmploopstart, tmploopend, loopendcopy);
+			if (!(tmpflags & ChannelMixer::MP_SAMPLE_PLAY))
+				break;
+		}
+		
+		tmpsmppos = smppos; 
+		tmpflags = posflags; 
+		if (outSideLoop)
+			tmpflags &= ~3;
+		
+		time = downsampling ? fpmul(fixedtimefrac, rsmpadd) : fixedtimefrac;
+		if (!time && (flags & ChannelMixer::MP_SAMPLE_BACKWARD)) 
+			time = 65536;
+		
+		for (j = 1; j<ResamplerSincTableBase<windowSize>::WIDTH; j++)
+		{							
+			advancePos(tmpsmppos, tmpflags, tmploopstart, tmploopend, loopendcopy);
+			time-=timeadd;
+			if (!(tmpflags & ChannelMixer::MP_SAMPLE_PLAY))
+				break;
+			
+			if (downsampling)
+				result += (sample[tmpsmppos] * fpmul(SINC(time), rsmpadd)) >> shift;
+			else
+				result += (sample[tmpsmppos] * SINC(time)) >> shift;
+		}
+		
+		return result;
+	}
+
 	static inline void addBlock(mp_sint32* buffer, ChannelMixer::TMixerChannel* chn, mp_uint32 count)
 	{
 		const bufferType* sample = (const bufferType*)chn->sample;
@@ -416,66 +503,11 @@ public:
 		const mp_sint32 negflags = smpadd < 0 ? (flags & ~ChannelMixer::MP_SAMPLE_BACKWARD) : ((flags & ~ChannelMixer::MP_SAMPLE_BACKWARD) | ChannelMixer::MP_SAMPLE_BACKWARD);
 		const mp_sint32 posflags = smpadd > 0 ? (flags & ~ChannelMixer::MP_SAMPLE_BACKWARD) : ((flags & ~ChannelMixer::MP_SAMPLE_BACKWARD) | ChannelMixer::MP_SAMPLE_BACKWARD);
 		
-		mp_sint32 tmpsmppos;
-		mp_sint32 tmpflags;
-		mp_sint32 tmploopstart;
-		mp_sint32 tmploopend;
-		
 		if (timeadd < 65536)
 		{
 			while (count--)
 			{
-				mp_sint32 result = 0;
-				
-				tmpsmppos = smppos; 
-				tmploopstart = loopstart;
-				tmploopend = loopend;
-				tmpflags = negflags; 
-				// check whether we are outside loop points
-				// if that's the case we're treating the sample as a normal finite signal
-				// note that this is still not totally correct treatment
-				const bool outSideLoop = !(((flags & 3) && tmpsmppos >= loopstart && tmpsmppos < loopend));
-				if (outSideLoop)
-				{
-					tmploopstart = 0;
-					tmploopend = smplen;
-					tmpflags &= ~3;
-				}
-				
-				mp_sint32 time = fixedtimefrac;
-				if (!time && (flags & ChannelMixer::MP_SAMPLE_BACKWARD)) 
-					time = 65536;
-				
-				mp_sint32 j;				
-				for (j = 0; j<ResamplerSincTableBase<windowSize>::WIDTH; j++)
-				{
-					result += (sample[tmpsmppos] * SINC(time)) >> shift;
-					
-					time+=65536;
-					advancePos(tmpsmppos, tmpflags, tmploopstart, tmploopend, loopendcopy);
-					if (!(tmpflags & ChannelMixer::MP_SAMPLE_PLAY))
-						break;
-				}
-				
-				tmpsmppos = smppos; 
-				tmpflags = posflags; 
-				if (outSideLoop)
-					tmpflags &= ~3;
-				
-				time = fixedtimefrac;
-				if (!time && (flags & ChannelMixer::MP_SAMPLE_BACKWARD)) 
-					time = 65536;
-				
-				for (j = 1; j<ResamplerSincTableBase<windowSize>::WIDTH; j++)
-				{							
-					advancePos(tmpsmppos, tmpflags, tmploopstart, tmploopend, loopendcopy);
-					time-=65536;
-					if (!(tmpflags & ChannelMixer::MP_SAMPLE_PLAY))
-						break;
-					
-					result += (sample[tmpsmppos] * SINC(time)) >> shift;
-				}					
-				
+				const mp_sint32 result = convolve<false>(sample, smppos, fixedtimefrac, rsmpadd, flags, negflags, posflags, loopstart, loopend, loopendcopy, smplen);
 				
 				(*buffer++)+=(((result)*(voll>>15))>>15); 
 				(*buffer++)+=(((result)*(volr>>15))>>15); 
@@ -494,56 +526,7 @@ public:
 		{
 			while (count--)
 			{
-				mp_sint32 result = 0;
-				
-				tmpsmppos = smppos; 
-				tmploopstart = loopstart;
-				tmploopend = loopend;
-				tmpflags = negflags; 
-				// check whether we are outside loop points
-				// if that's the case we're treating the sample as a normal finite signal
-				// note that this is still not totally correct treatment
-				const bool outSideLoop = !(((flags & 3) && tmpsmppos >= loopstart && tmpsmppos < loopend));
-				if (outSideLoop)
-				{
-					tmploopstart = 0;
-					tmploopend = smplen;
-					tmpflags &= ~3;
-				}
-				
-				mp_sint32 time = fpmul(fixedtimefrac, rsmpadd);
-				if (!time && (flags & ChannelMixer::MP_SAMPLE_BACKWARD)) 
-					time = 65536;
-				
-				mp_sint32 j;				
-				for (j = 0; j<ResamplerSincTableBase<windowSize>::WIDTH; j++)
-				{
-					result += (sample[tmpsmppos] * fpmul(SINC(time), rsmpadd)) >> shift;
-					
-					advancePos(tmpsmppos, tmpflags, tmploopstart, tmploopend, loopendcopy);
-					time+=rsmpadd;
-					if (!(tmpflags & ChannelMixer::MP_SAMPLE_PLAY))
-						break;
-				}
-				
-				tmpsmppos = smppos; 
-				tmpflags = posflags;
-				if (outSideLoop)
-					tmpflags &= ~3;
-				
-				time = fpmul(fixedtimefrac, rsmpadd);
-				if (!time && (flags & ChannelMixer::MP_SAMPLE_BACKWARD)) 
-					time = 65536;
-				
-				for (j = 1; j<ResamplerSincTableBase<windowSize>::WIDTH; j++)
-				{							
-					advancePos(tmpsmppos, tmpflags, tmploopstart, tmploopend, loopendcopy);
-					time-=rsmpadd;
-					if (!(tmpflags & ChannelMixer::MP_SAMPLE_PLAY))
-						break;
-					
-					result += (sample[tmpsmppos] * fpmul(SINC(time), rsmpadd)) >> shift;				
-				}
+				const mp_sint32 result = convolve<true>(sample, smppos, fixedtimefrac, rsmpadd, flags, negflags, posflags, loopstart, loopend, loopendcopy, smplen);
 								
 				(*buffer++)+=(((result)*(voll>>15))>>15); 
 				(*buffer++)+=(((result)*(volr>>15))>>15); 
@@ -585,6 +568,12 @@ public:
 	virtual bool supportsFullChecking() { return false; }
 	virtual bool supportsNoChecking() { return true; }
 
+	virtual void skipBlock(ChannelMixer::TMixerChannel* chn, mp_uint32 count)
+	{
+		ChannelMixer::ResamplerBase::skipBlock(chn, count);
+		chn->fixedtimefrac = (mp_sint32)((chn->fixedtimefrac + (mp_uint32)chn->smpadd*count) & 65535);
+	}
+
 	virtual void addBlockNoCheck(mp_sint32* buffer, ChannelMixer::TMixerChannel* chn, mp_uint32 count)
 	{
 		if (chn->flags & 4)
@@ -601,3 +590,5 @@ public:
 #undef SINCTAB
 
 #undef fpmul
+
+#endif
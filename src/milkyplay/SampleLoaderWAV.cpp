@@ -85,323 +85,115 @@ mp_sint32 SampleLoaderWAV::parseFMTChunk(XMFile& f, TWAVHeader& hdr)
 	return MP_OK;
 }
 
+// Sample value of one channel, same scaling as XModule::loadSample would apply
+static inline mp_sint32 getWAVSampleValue(const mp_ubyte* src, mp_uint32 numBits, mp_uint32 encodingTag)
+{
+	switch (numBits)
+	{
+		case 8:
+			// unsigned
+			return (mp_sbyte)(src[0]^127);
+		case 16:
+			return (mp_sword)((mp_sint32)src[0] + (((mp_sint32)src[1])<<8));
+		case 24:
+			return (mp_sword)((mp_sint32)src[1] + (((mp_sint32)src[2])<<8));
+		case 32:
+		{
+			mp_uint32 value = (mp_uint32)src[0] + ((mp_uint32)src[1]<<8) + ((mp_uint32)src[2]<<16) + ((mp_uint32)src[3]<<24);
+			if (encodingTag == 0x03)
+			{
+				float f;
+				memcpy(&f, &value, sizeof(f));
+				return (mp_sint32)(f*32767.0f);
+			}
+			return ((mp_sint32)value)>>16;
+		}
+	}
+	
+	return 0;
+}
+
 mp_sint32 SampleLoaderWAV::parseDATAChunk(XMFile& f, TWAVHeader& hdr, mp_sint32 index, mp_sint32 channelIndex)
 {
 	TXMSample* smp = &theModule.smp[index];
 	
 	if (hdr.dataLength)
 	{
+		const mp_uint32 bytesPerSample = hdr.numBits >> 3;
 		
-		if (hdr.numBits == 8)
-		{
-			if (smp->sample)
-			{
-				theModule.freeSampleMem((mp_ubyte*)smp->sample);
-				smp->sample = NULL;
-			}					
-			smp->samplen = hdr.dataLength;					
-			if (hdr.numChannels == 2)
-			{
-				mp_sbyte* buffer = new mp_sbyte[smp->samplen];						
-				if (buffer == NULL)
-					return MP_OUT_OF_MEMORY;						
-				theModule.loadSample(f, buffer, smp->samplen, smp->samplen, XModule::ST_UNSIGNED);						
-				smp->samplen>>=1;						
-				smp->sample = (mp_sbyte*)theModule.allocSampleMem(smp->samplen);						
-				if (smp->sample == NULL)
-				{
-					delete[] buffer;
-					return MP_OUT_OF_MEMORY;
-				}						
-				// Downmix channels
-				if (channelIndex < 0)
-				{
-					for (mp_uint32 i = 0; i < smp->samplen; i++)
-					{
-						mp_sint32 s1 = buffer[i*2];
-						mp_sint32 s2 = buffer[i*2+1];
-						smp->sample[i] = (mp_sbyte)((s1+s2)>>1);
-					}
-				}
-				// take left channel
-				else if (channelIndex == 0)
-				{
-					for (mp_uint32 i = 0; i < smp->samplen; i++)
-						smp->sample[i] = buffer[i*2];
-				}
-				// take right channel
-				else if (channelIndex == 1)
-				{
-					for (mp_uint32 i = 0; i < smp->samplen; i++)
-						smp->sample[i] = buffer[i*2+1];
-				}
-				else 
-					ASSERT(false);						
-				delete[] buffer;
-			}
-			else
-			{
-				smp->sample = (mp_sbyte*)theModule.allocSampleMem(smp->samplen);						
-				if (smp->sample == NULL)
-					return MP_OUT_OF_MEMORY;						
-				theModule.loadSample(f, smp->sample, smp->samplen, smp->samplen, XModule::ST_UNSIGNED);
-			}					
-			smp->type = 0;
-		}
-		else if (hdr.numBits == 16)
+		if (smp->sample)
 		{
-			if (smp->sample)
-			{
-				theModule.freeSampleMem((mp_ubyte*)smp->sample);
-				smp->sample = NULL;
-			}					
-			smp->samplen = hdr.dataLength>>1;					
-			if (hdr.numChannels == 2)
-			{
-				mp_sword* buffer = new mp_sword[smp->samplen];						
-				if (buffer == NULL)
-					return MP_OUT_OF_MEMORY;						
-				theModule.loadSample(f, buffer, hdr.dataLength, smp->samplen, XModule::ST_16BIT);						
-				smp->samplen>>=1;						
-				smp->sample = (mp_sbyte*)theModule.allocSampleMem(smp->samplen*2);						
-				if (smp->sample == NULL)
-				{
-					delete[] buffer;
-					return MP_OUT_OF_MEMORY;
-				}						
-				mp_sword* sample = (mp_sword*)smp->sample;
-				// Downmix channels
-				if (channelIndex < 0)
-				{
-					for (mp_uint32 i = 0; i < smp->samplen; i++)
-					{
-						mp_sint32 s1 = buffer[i*2];
-						mp_sint32 s2 = buffer[i*2+1];
-						sample[i] = (mp_sword)((s1+s2)>>1);
-					}
-				}
-				// take left channel
-				else if (channelIndex == 0)
-				{
-					for (mp_uint32 i = 0; i < smp->samplen; i++)
-						sample[i] = buffer[i*2];
-				}
-				// take right channel
-				else if (channelIndex == 1)
-				{
-					for (mp_uint32 i = 0; i < smp->samplen; i++)
-						sample[i] = buffer[i*2+1];
-				}
-				else 
-					ASSERT(false);							
-				delete[] buffer;
-			}
-			else
-			{
-				smp->sample = (mp_sbyte*)theModule.allocSampleMem(smp->samplen*2);						
-				if (smp->sample == NULL)
-					return MP_OUT_OF_MEMORY;						
-				theModule.loadSample(f, smp->sample, hdr.dataLength, smp->samplen, XModule::ST_16BIT);
-			}					
-			smp->type = 16;
+			theModule.freeSampleMem((mp_ubyte*)smp->sample);
+			smp->sample = NULL;
 		}
-		else if (hdr.numBits == 24)
+		
+		const mp_uint32 numChannels = hdr.numChannels == 2 ? 2 : 1;
+		const mp_uint32 frameSize = bytesPerSample*numChannels;
+		const mp_uint32 dataEnd = f.pos() + (hdr.dataLength / bytesPerSample) * bytesPerSample;
+		
+		smp->samplen = hdr.dataLength / frameSize;
+		smp->type = hdr.numBits == 8 ? 0 : 16;
+		smp->sample = (mp_sbyte*)theModule.allocSampleMem(hdr.numBits == 8 ? smp->samplen : smp->samplen*2);
+		if (smp->sample == NULL)
+			return MP_OUT_OF_MEMORY;
+		
+		// Mono 8 and 16 bit data is loaded as it is
+		if (numChannels == 1 && hdr.numBits == 8)
+			theModule.loadSample(f, smp->sample, smp->samplen, smp->samplen, XModule::ST_UNSIGNED);
+		else if (numChannels == 1 && hdr.numBits == 16)
+			theModule.loadSample(f, smp->sample, smp->samplen*2, smp->samplen, XModule::ST_16BIT);
+		else
 		{
-			if (smp->sample)
-			{
-				theModule.freeSampleMem((mp_ubyte*)smp->sample);
-				smp->sample = NULL;
-			}					
-			smp->samplen = hdr.dataLength/3;					
-			if (hdr.numChannels == 2)
+			// Convert block by block, straight from the file's memory if it's mapped,
+			// otherwise through a buffer on the stack
+			const mp_uint32 blockSize = 16384;
+			mp_ubyte block[blockSize];
+			
+			for (mp_uint32 i = 0; i < smp->samplen; )
 			{
-				mp_ubyte* buffer = new mp_ubyte[smp->samplen*3];						
-				if (buffer == NULL)
-					return MP_OUT_OF_MEMORY;												
-				f.read(buffer, 3, smp->samplen);
-				smp->samplen>>=1;						
-				smp->sample = (mp_sbyte*)theModule.allocSampleMem(smp->samplen*2);						
-				if (smp->sample == NULL)
-				{
-					delete[] buffer;
-					return MP_OUT_OF_MEMORY;
-				}						
-				mp_sword* sample = (mp_sword*)smp->sample;
-				// Downmix channels
-				if (channelIndex < 0)
-				{
-					for (mp_uint32 i = 0; i < smp->samplen; i++)
-					{
-						mp_sword s1 = ((mp_sint32)buffer[i*6+1] + (((mp_sint32)buffer[i*6+2])<<8));
-						mp_sword s2 = ((mp_sint32)buffer[i*6+4] + (((mp_sint32)buffer[i*6+5])<<8));
-						sample[i] = ((mp_sint32)s1 + (mp_sint32)s2) >> 1;
-					}
-				}
-				// take left channel
-				else if (channelIndex == 0)
-				{
-					for (mp_uint32 i = 0; i < smp->samplen; i++)
-						sample[i] = ((mp_sint32)buffer[i*6+1] + (((mp_sint32)buffer[i*6+2])<<8));
-				}
-				// take right channel
-				else if (channelIndex == 1)
+				mp_uint32 numFrames = blockSize / frameSize;
+				if (numFrames > smp->samplen - i)
+					numFrames = smp->samplen - i;
+				
+				const mp_ubyte* src = f.readDirect(numFrames*frameSize);
+				if (src == NULL)
 				{
-					for (mp_uint32 i = 0; i < smp->samplen; i++)
-						sample[i] = ((mp_sint32)buffer[i*6+4] + (((mp_sint32)buffer[i*6+5])<<8));
+					memset(block, 0, numFrames*frameSize);
+					f.read(block, 1, numFrames*frameSize);
+					src = block;
 				}
-				else 
-					ASSERT(false);							
-				delete[] buffer;
-			}
-			else
-			{
-				smp->sample = (mp_sbyte*)theModule.allocSampleMem(smp->samplen*2);						
-				if (smp->sample == NULL)
-					return MP_OUT_OF_MEMORY;
-				mp_ubyte* buffer = new mp_ubyte[smp->samplen*3];						
-				if (buffer == NULL)
-					return MP_OUT_OF_MEMORY;												
-				f.read(buffer, 3, smp->samplen);
-				mp_sword* sample = (mp_sword*)smp->sample;
-				for (mp_uint32 i = 0; i < smp->samplen; i++)
-					sample[i] = ((mp_sint32)buffer[i*3+1] + (((mp_sint32)buffer[i*3+2])<<8));
-				delete[] buffer;
-			}					
-			smp->type = 16;
-		}
-		else if (hdr.numBits == 32)
-		{
-			// 32 bit DWORD sample data?
-			if (hdr.encodingTag == 0x01)
-			{
-				if (smp->sample)
-				{
-					theModule.freeSampleMem((mp_ubyte*)smp->sample);
-					smp->sample = NULL;
-				}					
-				smp->samplen = hdr.dataLength>>2;					
 				
-				if (hdr.numChannels == 2)
+				for (mp_uint32 j = 0; j < numFrames; j++, i++, src+=frameSize)
 				{
-					mp_sint32* buffer = new mp_sint32[smp->samplen];						
-					if (buffer == NULL)
-						return MP_OUT_OF_MEMORY;												
-					f.readDwords((mp_dword*)buffer, smp->samplen);
-					smp->samplen>>=1;						
-					smp->sample = (mp_sbyte*)theModule.allocSampleMem(smp->samplen*2);						
-					if (smp->sample == NULL)
-					{
-						delete[] buffer;
-						return MP_OUT_OF_MEMORY;
-					}						
-					mp_sword* sample = (mp_sword*)smp->sample;
+					mp_sint32 value;
 					// Downmix channels
-					if (channelIndex < 0)
+					if (numChannels == 2 && channelIndex < 0)
 					{
-						for (mp_uint32 i = 0; i < smp->samplen; i++)
-						{
-							mp_sint32 s1 = buffer[i*2]>>16;
-							mp_sint32 s2 = buffer[i*2+1]>>16;
-							sample[i] = (mp_sword)((s1+s2)>>1);
-						}
-					}
-					// take left channel
-					else if (channelIndex == 0)
-					{
-						for (mp_uint32 i = 0; i < smp->samplen; i++)
-							sample[i] = buffer[i*2]>>16;
+						mp_sint32 s1 = getWAVSampleValue(src, hdr.numBits, hdr.encodingTag);
+						mp_sint32 s2 = getWAVSampleValue(src + bytesPerSample, hdr.numBits, hdr.encodingTag);
+						value = (s1+s2)>>1;
 					}
 					// take right channel
-					else if (channelIndex == 1)
+					else if (numChannels == 2 && channelIndex == 1)
 					{
-						for (mp_uint32 i = 0; i < smp->samplen; i++)
-							sample[i] = buffer[i*2+1]>>16;
-					}
-					else 
-						ASSERT(false);							
-					delete[] buffer;
-				}
-				else
-				{
-					smp->sample = (mp_sbyte*)theModule.allocSampleMem(smp->samplen*2);						
-					if (smp->sample == NULL)
-						return MP_OUT_OF_MEMORY;
-					mp_sint32* buffer = new mp_sint32[smp->samplen];						
-					if (buffer == NULL)
-						return MP_OUT_OF_MEMORY;												
-					f.readDwords((mp_dword*)buffer, smp->samplen);
-					mp_sword* sample = (mp_sword*)smp->sample;
-					for (mp_uint32 i = 0; i < smp->samplen; i++)
-						sample[i] = buffer[i]>>16;
-					delete[] buffer;
-				}
-			}
-			else if (hdr.encodingTag == 0x03)
-			{
-				if (smp->sample)
-				{
-					theModule.freeSampleMem((mp_ubyte*)smp->sample);
-					smp->sample = NULL;
-				}					
-				smp->samplen = hdr.dataLength>>2;					
-				
-				if (hdr.numChannels == 2)
-				{
-					float* buffer = new float[smp->samplen];						
-					if (buffer == NULL)
-						return MP_OUT_OF_MEMORY;												
-					f.readDwords(reinterpret_cast<mp_dword*>(buffer), smp->samplen);
-					smp->samplen>>=1;						
-					smp->sample = (mp_sbyte*)theModule.allocSampleMem(smp->samplen*2);						
-					if (smp->sample == NULL)
-					{
-						delete[] buffer;
-						return MP_OUT_OF_MEMORY;
-					}						
-					mp_sword* sample = (mp_sword*)smp->sample;
-					// Downmix channels
-					if (channelIndex < 0)
-					{
-						for (mp_uint32 i = 0; i < smp->samplen; i++)
-						{
-							mp_sint32 s1 = (mp_sint32)(buffer[i*2]*32767.0f);
-							mp_sint32 s2 = (mp_sint32)(buffer[i*2+1]*32767.0f);
-							sample[i] = (mp_sword)((s1+s2)>>1);
-						}
+						value = getWAVSampleValue(src + bytesPerSample, hdr.numBits, hdr.encodingTag);
 					}
 					// take left channel
-					else if (channelIndex == 0)
+					else
 					{
-						for (mp_uint32 i = 0; i < smp->samplen; i++)
-							sample[i] = (mp_sint32)(buffer[i*2]*32767.0f);
+						value = getWAVSampleValue(src, hdr.numBits, hdr.encodingTag);
 					}
-					// take right channel
-					else if (channelIndex == 1)
-					{
-						for (mp_uint32 i = 0; i < smp->samplen; i++)
-							sample[i] = (mp_sint32)(buffer[i*2+1]*32767.0f);
-					}
-					else 
-						ASSERT(false);							
-					delete[] buffer;
-				}
-				else
-				{
-					smp->sample = (mp_sbyte*)theModule.allocSampleMem(smp->samplen*2);						
-					if (smp->sample == NULL)
-						return MP_OUT_OF_MEMORY;
-					float* buffer = new float[smp->samplen];						
-					if (buffer == NULL)
-						return MP_OUT_OF_MEMORY;												
-					f.readDwords(reinterpret_cast<mp_dword*>(buffer), smp->samplen);
-					mp_sword* sample = (mp_sword*)smp->sample;
-					for (mp_uint32 i = 0; i < smp->samplen; i++)
-						sample[i] = (mp_sint32)(buffer[i]*32767.0f);
-					delete[] buffer;
+				
+					if (hdr.numBits == 8)
+						smp->sample[i] = (mp_sbyte)value;
+					else
+						((mp_sword*)smp->sample)[i] = (mp_sword)value;
 				}
 			}
-			smp->type = 16;
-		}								
+		}
+		
+		f.seek(dataEnd);
+		
 		smp->loopstart = 0;
 		smp->looplen = 0; 
 		
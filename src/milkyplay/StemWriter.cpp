@@ -0,0 +1,372 @@
+/*
+ * Copyright (c) 2009, The MilkyTracker Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the name of the <ORGANIZATION> nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ *  StemWriter.cpp
+ *  MilkyPlay
+ *
+ *  The mixing thread and the writer thread hand the blocks back and forth
+ *  through two counters: filled blocks waiting to be written and free 
+ *  blocks waiting to be filled. Blocks are always used in ring order.
+ *
+ */
+
+#include "StemWriter.h"
+#include "AudioDriver_WAVWriter.h"
+#include "XMFile.h"
+
+#if defined(__PSP__) || defined(_WIN32_WCE)
+	#define __MPNOTHREADS__
+#elif defined(WIN32)
+	#define __MPTHREADS_WIN32__
+	#include <windows.h>
+#else
+	#define __MPTHREADS_PTHREAD__
+	#include <pthread.h>
+#endif
+
+#if defined(__MPTHREADS_WIN32__)
+
+struct StemWriter::TPlatformData
+{
+	HANDLE thread;
+	HANDLE filledBlocks;
+	HANDLE freeBlocks;
+};
+
+static DWORD WINAPI threadProc(LPVOID writer)
+{
+	StemWriter::writerEntry(writer);
+	return 0;
+}
+
+#elif defined(__MPTHREADS_PTHREAD__)
+
+struct StemWriter::TPlatformData
+{
+	pthread_t thread;
+	pthread_mutex_t mutex;
+	pthread_cond_t changed;
+	mp_uint32 filledBlocks;
+	mp_uint32 freeBlocks;
+};
+
+static void waitForBlock(pthread_mutex_t* mutex, pthread_cond_t* changed, mp_uint32* count)
+{
+	pthread_mutex_lock(mutex);
+	while (*count == 0)
+		pthread_cond_wait(changed, mutex);
+	(*count)--;
+	pthread_mutex_unlock(mutex);
+}
+
+static void releaseBlock(pthread_mutex_t* mutex, pthread_cond_t* changed, mp_uint32* count)
+{
+	pthread_mutex_lock(mutex);
+	(*count)++;
+	pthread_cond_broadcast(changed);
+	pthread_mutex_unlock(mutex);
+}
+
+#else
+
+struct StemWriter::TPlatformData
+{
+};
+
+#endif
+
+StemWriter::StemWriter(const SYSCHAR* const* fileNames, mp_uint32 numStems, 
+					   mp_uint32 sampleRate, mp_sint32 sampleShift, bool floatOutput) :
+	files(NULL),
+	peaks(NULL),
+	numStems(numStems),
+	sampleRate(sampleRate),
+	sampleShift(sampleShift),
+	floatOutput(floatOutput),
+	open(true),
+	finished(false),
+	currentBlock(0),
+	numSamples(0),
+	platformData(NULL),
+	threaded(false),
+	convertBuffer16(NULL),
+	convertBufferFloat(NULL)
+{
+	mp_uint32 i;
+	
+	files = new XMFile*[numStems];
+	peaks = new float[numStems];
+	for (i = 0; i < numStems; i++)
+	{
+		files[i] = NULL;
+		peaks[i] = 0.0f;
+		if (fileNames[i] == NULL)
+			continue;
+		
+		files[i] = new XMFile(fileNames[i], true);
+		if (!files[i]->isOpenForWriting())
+		{
+			delete files[i];
+			files[i] = NULL;
+			open = false;
+			continue;
+		}
+
+		// placeholder, the real header is written by finish()
+		WAVWriter::writeHeader(files[i], sampleRate, 0, floatOutput);
+	}
+
+	for (i = 0; i < NUMBLOCKS; i++)
+	{
+		blocks[i].buffer = new mp_sint32[numStems*BLOCKSIZE*MP_NUMCHANNELS];
+		blocks[i].numSamples = 0;
+	}
+	
+	if (floatOutput)
+		convertBufferFloat = new float[BLOCKSIZE*MP_NUMCHANNELS];
+	else
+		convertBuffer16 = new mp_sword[BLOCKSIZE*MP_NUMCHANNELS];
+	
+	platformData = new TPlatformData;
+	
+	// the mixing thread starts out with the first block
+#if defined(__MPTHREADS_WIN32__)
+	platformData->filledBlocks = CreateSemaphore(NULL, 0, NUMBLOCKS, NULL);
+	platformData->freeBlocks = CreateSemaphore(NULL, NUMBLOCKS-1, NUMBLOCKS, NULL);
+	platformData->thread = CreateThread(NULL, 0, threadProc, this, 0, NULL);
+	threaded = platformData->thread != NULL;
+#elif defined(__MPTHREADS_PTHREAD__)
+	pthread_mutex_init(&platformData->mutex, NULL);
+	pthread_cond_init(&platformData->changed, NULL);
+	platformData->filledBlocks = 0;
+	platformData->freeBlocks = NUMBLOCKS-1;
+	threaded = pthread_create(&platformData->thread, NULL, writerEntry, this) == 0;
+#endif
+}
+
+StemWriter::~StemWriter()
+{
+	if (!finished)
+		finish();
+
+#if defined(__MPTHREADS_WIN32__)
+	CloseHandle(platformData->filledBlocks);
+	CloseHandle(platformData->freeBlocks);
+#elif defined(__MPTHREADS_PTHREAD__)
+	pthread_cond_destroy(&platformData->changed);
+	pthread_mutex_destroy(&platformData->mutex);
+#endif
+	delete platformData;
+
+	for (mp_uint32 i = 0; i < NUMBLOCKS; i++)
+		delete[] blocks[i].buffer;
+	
+	for (mp_uint32 i = 0; i < numStems; i++)
+		delete files[i];
+	delete[] files;
+	delete[] peaks;
+	
+	delete[] convertBuffer16;
+	delete[] convertBufferFloat;
+}
+
+void StemWriter::submitBlock()
+{
+	if (!threaded)
+	{
+		writeBlock(blocks[currentBlock]);
+		blocks[currentBlock].numSamples = 0;
+		return;
+	}
+
+#if defined(__MPTHREADS_WIN32__)
+	ReleaseSemaphore(platformData->filledBlocks, 1, NULL);
+	WaitForSingleObject(platformData->freeBlocks, INFINITE);
+#elif defined(__MPTHREADS_PTHREAD__)
+	releaseBlock(&platformData->mutex, &platformData->changed, &platformData->filledBlocks);
+	waitForBlock(&platformData->mutex, &platformData->changed, &platformData->freeBlocks);
+#endif
+
+	currentBlock = (currentBlock+1) % NUMBLOCKS;
+	blocks[currentBlock].numSamples = 0;
+}
+
+void StemWriter::writeBlock(const TBlock& block)
+{
+	const mp_sint32 count = block.numSamples*MP_NUMCHANNELS;
+
+	for (mp_uint32 i = 0; i < numStems; i++)
+	{
+		if (files[i] == NULL)
+			continue;
+		
+		const mp_sint32* src = block.buffer + i*BLOCKSIZE*MP_NUMCHANNELS;
+		
+		if (floatOutput)
+		{
+			// same scaling as MasterMixer's float output
+			const float scale = 1.0f / (32768.0f * (float)(1 << sampleShift));
+			float peak = peaks[i];
+			for (mp_sint32 j = 0; j < count; j++)
+			{
+				const float value = (float)src[j] * scale;
+				if (value > peak) peak = value;
+				else if (-value > peak) peak = -value;
+				convertBufferFloat[j] = value;
+			}
+			peaks[i] = peak;
+		
+			// floats are written in the byte order of 32 bit words
+			files[i]->writeDwords((const mp_dword*)convertBufferFloat, count);
+		}
+		else
+		{
+			const mp_sint32 lowerBound = -((128<<sampleShift)*256); 
+			const mp_sint32 upperBound = ((128<<sampleShift)*256)-1;
+			mp_sint32 maxValue = 0;
+			for (mp_sint32 j = 0; j < count; j++)
+			{
+				mp_sint32 b = src[j];
+				if (b>upperBound) b = upperBound; 
+				else if (b<lowerBound) b = lowerBound; 
+				b>>=sampleShift;
+				if (b > maxValue) maxValue = b;
+				else if (-b > maxValue) maxValue = -b;
+				convertBuffer16[j] = b;
+			}
+			// same scale as WAVWriter's peak
+			if (maxValue > peaks[i]*32768.0f)
+				peaks[i] = maxValue / 32768.0f;
+			
+			files[i]->writeWords((const mp_uword*)convertBuffer16, count);
+		}
+	}
+}
+
+void* StemWriter::writerEntry(void* writer)
+{
+	static_cast<StemWriter*>(writer)->writerLoop();
+	return NULL;
+}
+
+void StemWriter::writerLoop()
+{
+	mp_uint32 index = 0;
+	
+	for (;;)
+	{
+#if defined(__MPTHREADS_WIN32__)
+		WaitForSingleObject(platformData->filledBlocks, INFINITE);
+#elif defined(__MPTHREADS_PTHREAD__)
+		waitForBlock(&platformData->mutex, &platformData->changed, &platformData->filledBlocks);
+#endif
+
+		// an empty block is only submitted by finish()
+		if (blocks[index].numSamples == 0)
+			break;
+			
+		writeBlock(blocks[index]);
+		index = (index+1) % NUMBLOCKS;
+
+#if defined(__MPTHREADS_WIN32__)
+		ReleaseSemaphore(platformData->freeBlocks, 1, NULL);
+#elif defined(__MPTHREADS_PTHREAD__)
+		releaseBlock(&platformData->mutex, &platformData->changed, &platformData->freeBlocks);
+#endif
+	}
+}
+
+void StemWriter::stemsMixed(const mp_sint32* buffers, mp_uint32 numStems, mp_uint32 numSamples)
+{
+	if (numStems > this->numStems)
+		numStems = this->numStems;
+
+	mp_uint32 done = 0;
+	while (done < numSamples)
+	{
+		TBlock& block = blocks[currentBlock];
+		
+		mp_uint32 todo = BLOCKSIZE - block.numSamples;
+		if (todo > numSamples - done)
+			todo = numSamples - done;
+		
+		for (mp_uint32 i = 0; i < this->numStems; i++)
+		{
+			mp_sint32* dst = block.buffer + (i*BLOCKSIZE + block.numSamples)*MP_NUMCHANNELS;
+			if (i < numStems)
+				memcpy(dst, buffers + (i*numSamples + done)*MP_NUMCHANNELS, todo*MP_NUMCHANNELS*sizeof(mp_sint32));
+			else
+				memset(dst, 0, todo*MP_NUMCHANNELS*sizeof(mp_sint32));
+		}
+		
+		block.numSamples+=todo;
+		done+=todo;
+		
+		if (block.numSamples == BLOCKSIZE)
+			submitBlock();
+	}
+	
+	this->numSamples+=numSamples;
+}
+
+mp_uint32 StemWriter::finish()
+{
+	if (finished)
+		return numSamples;
+
+	if (blocks[currentBlock].numSamples)
+		submitBlock();
+	
+	if (threaded)
+	{
+		// the current block is empty now, which stops the writer thread
+#if defined(__MPTHREADS_WIN32__)
+		ReleaseSemaphore(platformData->filledBlocks, 1, NULL);
+		WaitForSingleObject(platformData->thread, INFINITE);
+		CloseHandle(platformData->thread);
+#elif defined(__MPTHREADS_PTHREAD__)
+		releaseBlock(&platformData->mutex, &platformData->changed, &platformData->filledBlocks);
+		pthread_join(platformData->thread, NULL);
+#endif
+		threaded = false;
+	}
+	
+	for (mp_uint32 i = 0; i < numStems; i++)
+	{
+		if (files[i] == NULL)
+			continue;
+			
+		files[i]->seek(0);
+		WAVWriter::writeHeader(files[i], sampleRate, numSamples, floatOutput);
+	}
+
+	finished = true;
+	return numSamples;
+}
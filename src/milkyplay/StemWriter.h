@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2009, The MilkyTracker Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the name of the <ORGANIZATION> nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ *  StemWriter.h
+ *  MilkyPlay
+ *
+ *  Writes the stems of ChannelMixer's stem mode into one WAV file per
+ *  channel. The mixing thread only copies the stems into a few large
+ *  blocks, converting and writing them to disk happens on a thread of
+ *  its own, so disk I/O never stalls the mixing.
+ *
+ */
+
+#ifndef __STEMWRITER_H__
+#define __STEMWRITER_H__
+
+#include "ChannelMixer.h"
+
+class XMFile;
+
+class StemWriter : public ChannelMixer::StemListener
+{
+public:
+	enum
+	{
+		NUMBLOCKS = 3,
+		BLOCKSIZE = 8192		// sample frames per stem and block
+	};
+
+private:
+	struct TPlatformData;
+
+	struct TBlock
+	{
+		mp_sint32*		buffer;				// BLOCKSIZE stereo frames for every stem
+		mp_uint32		numSamples;
+	};
+
+	XMFile**				files;
+	float*					peaks;				// written by the writer thread
+	mp_uint32				numStems;
+	mp_uint32				sampleRate;
+	mp_sint32				sampleShift;
+	bool					floatOutput;
+	bool					open;
+	bool					finished;
+	
+	TBlock					blocks[NUMBLOCKS];
+	mp_uint32				currentBlock;		// the block the mixing thread is filling
+	mp_uint32				numSamples;
+	
+	TPlatformData*			platformData;
+	bool					threaded;
+	
+	mp_sword*				convertBuffer16;
+	float*					convertBufferFloat;
+
+	void					submitBlock();
+	void					writeBlock(const TBlock& block);
+	void					writerLoop();
+
+public:
+	// fileNames has numStems entries, stems with a NULL file name are dropped
+	StemWriter(const SYSCHAR* const* fileNames, mp_uint32 numStems, 
+			   mp_uint32 sampleRate, mp_sint32 sampleShift, bool floatOutput);
+	virtual ~StemWriter();
+	
+	// false if any of the files couldn't be created
+	bool					isOpen() const { return open; }
+	
+	virtual void			stemsMixed(const mp_sint32* buffers, mp_uint32 numStems, mp_uint32 numSamples);
+
+	// writes the remaining samples, waits for the writer thread and 
+	// completes the WAV headers, returns the length of the stems in sample frames
+	mp_uint32				finish();
+
+	// highest absolute sample value of a stem (1.0 = full scale), call after finish
+	float					getPeak(mp_uint32 stem) const { return stem < numStems ? peaks[stem] : 0.0f; }
+
+	// thread entry point, not to be called directly
+	static void*			writerEntry(void* writer);
+};
+
+#endif
@@ -32,6 +32,7 @@
 // to make future porting easier										//
 //////////////////////////////////////////////////////////////////////////
 #include "XMFile.h"
+#include "LittleEndian.h"
 
 XMFileBase::XMFileBase() :
 	baseOffset(0)
@@ -101,14 +102,30 @@ mp_dword XMFileBase::readDword()
 
 void XMFileBase::readWords(mp_uword* buffer,mp_sint32 count)
 {
-	for (mp_sint32 i = 0; i < count; i++)
-		*buffer++ = readWord();
+	if (count <= 0)
+		return;
+
+	// read everything at once and convert in place,
+	// whatever couldn't be read is zero like with readWord
+	mp_sint32 bytesRead = read(buffer, 2, count);
+	if (bytesRead < 0)
+		bytesRead = 0;
+	memset((mp_ubyte*)buffer + bytesRead, 0, count*2 - bytesRead);
+
+	LittleEndian::GET_WORDS(buffer, buffer, count);
 }
 
 void XMFileBase::readDwords(mp_dword* buffer,mp_sint32 count)
 {
-	for (mp_sint32 i = 0; i < count; i++)
-		*buffer++ = readDword();
+	if (count <= 0)
+		return;
+
+	mp_sint32 bytesRead = read(buffer, 4, count);
+	if (bytesRead < 0)
+		bytesRead = 0;
+	memset((mp_ubyte*)buffer + bytesRead, 0, count*4 - bytesRead);
+
+	LittleEndian::GET_DWORDS(buffer, buffer, count);
 }
 
 void XMFileBase::writeByte(mp_ubyte b)
@@ -162,6 +179,58 @@ void XMFileBase::writeString(const char* string)
 
 #define BUFFERSIZE 16384
 
+//////////////////////////////////////////////////////////////////////////
+// Reading from memory, used by mapped files and memory streams			//
+//////////////////////////////////////////////////////////////////////////
+static mp_sint32 readFromMemory(const mp_ubyte* data, mp_uint32 length, mp_uint32& position,
+								void* ptr, mp_sint32 size, mp_sint32 count)
+{
+	if (size <= 0 || count <= 0 || position >= length)
+		return 0;
+
+	// only whole elements, like fread
+	mp_uint32 available = (length - position) / size;
+	if ((mp_uint32)count > available)
+		count = available;
+
+	const mp_uint32 bytes = count*size;
+	memcpy(ptr, data + position, bytes);
+	position+=bytes;
+
+	return (mp_sint32)bytes;
+}
+
+static void seekInMemory(mp_uint32 length, mp_uint32& position, 
+						 mp_uint32 pos, XMFileBase::SeekOffsetTypes seekOffsetType)
+{
+	// relative offsets can be negative
+	switch (seekOffsetType)
+	{
+		case XMFileBase::SeekOffsetTypeCurrent:
+			position+=pos;
+			break;
+		case XMFileBase::SeekOffsetTypeEnd:
+			position = length + pos;
+			break;
+		default:
+			position = pos;
+	}
+
+	if ((mp_sint32)position < 0)
+		position = 0;
+}
+
+static const mp_ubyte* readDirectFromMemory(const mp_ubyte* data, mp_uint32 length, mp_uint32& position, 
+											mp_uint32 size)
+{
+	if (data == NULL || position > length || size > length - position)
+		return NULL;
+
+	const mp_ubyte* result = data + position;
+	position+=size;
+	return result;
+}
+
 //////////////////////////////////////////////////////////////////////////
 // WIN32 implentation													//
 //////////////////////////////////////////////////////////////////////////
@@ -172,7 +241,11 @@ void XMFileBase::writeString(const char* string)
 XMFile::XMFile(const SYSCHAR*	fileName, bool writeAccess /* = false*/) :
 	XMFileBase(),
 	fileName(fileName),
-	cacheBuffer(NULL)
+	cacheBuffer(NULL),
+	mappedData(NULL),
+	mappedSize(0),
+	mappedPos(0),
+	mapping(NULL)
 {
 	this->writeAccess = writeAccess;
 
@@ -193,6 +266,10 @@ XMFile::XMFile(const SYSCHAR*	fileName, bool writeAccess /* = false*/) :
 		cacheBuffer = new mp_ubyte[BUFFERSIZE+16];
 		currentCacheBufferPtr = cacheBuffer;
 	}
+	else if (handle != INVALID_HANDLE_VALUE)
+	{
+		map();
+	}
 }
 
 bool XMFile::isOpen()
@@ -200,11 +277,50 @@ bool XMFile::isOpen()
 	return handle != INVALID_HANDLE_VALUE;
 }
 
+void XMFile::map()
+{
+#ifndef _WIN32_WCE
+	DWORD sizeHigh = 0;
+	DWORD size = GetFileSize(handle, &sizeHigh);
+	if (size == INVALID_FILE_SIZE || size == 0 || sizeHigh || size > 0x7FFFFFFF)
+		return;
+
+	mapping = CreateFileMapping(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL)
+		return;
+
+	mappedData = (mp_ubyte*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (mappedData == NULL)
+	{
+		CloseHandle(mapping);
+		mapping = NULL;
+		return;
+	}
+
+	mappedSize = size;
+	mappedPos = 0;
+#endif
+}
+
+void XMFile::unmap()
+{
+#ifndef _WIN32_WCE
+	if (mappedData)
+		UnmapViewOfFile(mappedData);
+	if (mapping)
+		CloseHandle(mapping);
+#endif
+	mappedData = NULL;
+	mapping = NULL;
+}
+
 XMFile::~XMFile()
 {
 	if (writeAccess && handle != INVALID_HANDLE_VALUE)
 		flush();
 
+	unmap();
+
 	if (cacheBuffer)
 		delete[] cacheBuffer;
 
@@ -213,6 +329,13 @@ XMFile::~XMFile()
 
 mp_sint32 XMFile::read(void* ptr,mp_sint32 size,mp_sint32 count)
 {
+	if (mappedData)
+	{
+		mp_sint32 bytes = readFromMemory(mappedData, mappedSize, mappedPos, ptr, size, count);
+		bytesRead += bytes;
+		return bytes;
+	}
+
 	unsigned long NumberOfBytesRead;
 	bool bResult = (bool)ReadFile(handle,ptr,size*count,&NumberOfBytesRead,NULL);
 	bytesRead+=(mp_uint32)NumberOfBytesRead;
@@ -282,6 +405,12 @@ mp_sint32 XMFile::write(const void* ptr,mp_sint32 size,mp_sint32 count)
 
 void XMFile::seek(mp_uint32 pos, SeekOffsetTypes seekOffsetType/* = SeekOffsetTypeStart*/)
 {
+	if (mappedData)
+	{
+		seekInMemory(mappedSize, mappedPos, pos, seekOffsetType);
+		return;
+	}
+
 	if (writeAccess)
 	{
 		flush();
@@ -299,11 +428,17 @@ void XMFile::seek(mp_uint32 pos, SeekOffsetTypes seekOffsetType/* = SeekOffsetTy
 
 mp_uint32 XMFile::pos()
 {
+	if (mappedData)
+		return mappedPos;
+
 	return SetFilePointer(handle, 0, NULL, FILE_CURRENT);
 }
 
 mp_uint32 XMFile::size()
 {
+	if (mappedData)
+		return mappedSize;
+
 	mp_uint32 size = 0;
 	mp_uint32 curPos = pos();
 	SetFilePointer(handle, 0, NULL, FILE_END);
@@ -358,12 +493,19 @@ const char* XMFile::getFileNameASCII()
 #else
 
 #include <unistd.h>
+#ifdef _POSIX_MAPPED_FILES
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 XMFile::XMFile(const SYSCHAR*	fileName, bool writeAccess /* = false*/) :
 	XMFileBase(),
 	fileName(fileName),
 	fileNameASCII(NULL),
-	cacheBuffer(NULL)
+	cacheBuffer(NULL),
+	mappedData(NULL),
+	mappedSize(0),
+	mappedPos(0)
 {
 	this->writeAccess = writeAccess;
 
@@ -377,6 +519,10 @@ XMFile::XMFile(const SYSCHAR*	fileName, bool writeAccess /* = false*/) :
 		cacheBuffer = new mp_ubyte[BUFFERSIZE];
 		currentCacheBufferPtr = cacheBuffer;
 	}
+	else if (handle != NULL)
+	{
+		map();
+	}
 }
 
 XMFile::~XMFile()
@@ -384,6 +530,8 @@ XMFile::~XMFile()
 	if (writeAccess && handle != NULL)
 		flush();
 	
+	unmap();
+	
 	if (handle != NULL)
 		fclose(handle);
 	
@@ -399,8 +547,46 @@ bool XMFile::isOpen()
 	return handle != NULL;
 }
 
+void XMFile::map()
+{
+#ifdef _POSIX_MAPPED_FILES
+	struct stat st;
+	if (fstat(fileno(handle), &st) != 0 || !S_ISREG(st.st_mode) ||
+		st.st_size <= 0 || st.st_size > 0x7FFFFFFF)
+		return;
+
+	void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fileno(handle), 0);
+	if (data == MAP_FAILED)
+		return;
+
+#ifdef POSIX_MADV_SEQUENTIAL
+	posix_madvise(data, st.st_size, POSIX_MADV_SEQUENTIAL);
+#endif
+
+	mappedData = (mp_ubyte*)data;
+	mappedSize = (mp_uint32)st.st_size;
+	mappedPos = 0;
+#endif
+}
+
+void XMFile::unmap()
+{
+#ifdef _POSIX_MAPPED_FILES
+	if (mappedData)
+		munmap(mappedData, mappedSize);
+#endif
+	mappedData = NULL;
+}
+
 mp_sint32 XMFile::read(void* ptr, mp_sint32 size, mp_sint32 count)
 {
+	if (mappedData)
+	{
+		mp_sint32 bytes = readFromMemory(mappedData, mappedSize, mappedPos, ptr, size, count);
+		bytesRead += bytes;
+		return bytes;
+	}
+
 	unsigned long NumberOfBytesRead = fread(ptr,size,count,handle)*size;
 	bytesRead += NumberOfBytesRead;
 	return (mp_sint32)NumberOfBytesRead;
@@ -452,6 +638,12 @@ mp_sint32 XMFile::write(const void* ptr, mp_sint32 size, mp_sint32 count)
 
 void XMFile::seek(mp_uint32 pos, SeekOffsetTypes seekOffsetType/* = SeekOffsetTypeStart*/)
 {
+	if (mappedData)
+	{
+		seekInMemory(mappedSize, mappedPos, pos, seekOffsetType);
+		return;
+	}
+
 	if (writeAccess)
 	{
 		flush();
@@ -470,11 +662,17 @@ void XMFile::seek(mp_uint32 pos, SeekOffsetTypes seekOffsetType/* = SeekOffsetTy
 
 mp_uint32 XMFile::pos()
 {
+	if (mappedData)
+		return mappedPos;
+
 	return ftell(handle);
 }
 
 mp_uint32 XMFile::size()
 {
+	if (mappedData)
+		return mappedSize;
+
 	mp_uint32 size = 0;
 	mp_uint32 curPos = pos();
 	fseek(handle,0,SEEK_END);
@@ -514,3 +712,150 @@ const char* XMFile::getFileNameASCII()
 }
 
 #endif
+
+const mp_ubyte* XMFile::readDirect(mp_uint32 size)
+{
+	return readDirectFromMemory(mappedData, mappedSize, mappedPos, size);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Memory streams														//
+//////////////////////////////////////////////////////////////////////////
+XMFileMemory::XMFileMemory(const SYSCHAR* fileName/* = NULL*/) :
+	XMFileBase(),
+	fileName(NULL),
+	fileNameASCII(NULL),
+	buffer(NULL),
+	bufferSize(0),
+	length(0),
+	position(0),
+	ownsBuffer(true)
+{
+	setFileName(fileName);
+}
+
+XMFileMemory::XMFileMemory(const void* data, mp_uint32 size, const SYSCHAR* fileName/* = NULL*/) :
+	XMFileBase(),
+	fileName(NULL),
+	fileNameASCII(NULL),
+	buffer((mp_ubyte*)data),
+	bufferSize(size),
+	length(size),
+	position(0),
+	ownsBuffer(false)
+{
+	setFileName(fileName);
+}
+
+XMFileMemory::~XMFileMemory()
+{
+	if (ownsBuffer)
+		delete[] buffer;
+
+	delete[] fileName;
+	delete[] fileNameASCII;
+}
+
+void XMFileMemory::setFileName(const SYSCHAR* fileName)
+{
+	mp_uint32 len = 0;
+	if (fileName)
+		while (fileName[len])
+			len++;
+
+	this->fileName = new SYSCHAR[len+1];
+	for (mp_uint32 i = 0; i < len; i++)
+		this->fileName[i] = fileName[i];
+	this->fileName[len] = 0;
+}
+
+bool XMFileMemory::reserve(mp_uint32 size)
+{
+	if (size <= bufferSize)
+		return true;
+
+	if (!ownsBuffer)
+		return false;
+
+	mp_uint32 newSize = bufferSize ? bufferSize : BUFFERSIZE;
+	while (newSize < size)
+		newSize<<=1;
+
+	mp_ubyte* newBuffer = new mp_ubyte[newSize];
+	if (newBuffer == NULL)
+		return false;
+
+	if (buffer)
+	{
+		memcpy(newBuffer, buffer, length);
+		delete[] buffer;
+	}
+
+	buffer = newBuffer;
+	bufferSize = newSize;
+	return true;
+}
+
+mp_sint32 XMFileMemory::read(void* ptr, mp_sint32 size, mp_sint32 count)
+{
+	return readFromMemory(buffer, length, position, ptr, size, count);
+}
+
+mp_sint32 XMFileMemory::write(const void* ptr, mp_sint32 size, mp_sint32 count)
+{
+	if (size <= 0 || count <= 0)
+		return 0;
+
+	const mp_uint32 bytes = size*count;
+	if (!reserve(position + bytes))
+		return -1;
+
+	// writing past the end leaves a gap, fill it with zeros
+	if (position > length)
+		memset(buffer + length, 0, position - length);
+
+	memcpy(buffer + position, ptr, bytes);
+	position+=bytes;
+	if (position > length)
+		length = position;
+
+	return (mp_sint32)bytes;
+}
+
+void XMFileMemory::seek(mp_uint32 pos, SeekOffsetTypes seekOffsetType/* = SeekOffsetTypeStart*/)
+{
+	seekInMemory(length, position, pos, seekOffsetType);
+}
+
+const mp_ubyte* XMFileMemory::readDirect(mp_uint32 size)
+{
+	return readDirectFromMemory(buffer, length, position, size);
+}
+
+const char* XMFileMemory::getFileNameASCII()
+{
+	const SYSCHAR* ptr = fileName;
+	for (const SYSCHAR* p = fileName; *p; p++)
+		if (*p == '/' || *p == '\\')
+			ptr = p + 1;
+
+	mp_uint32 len = 0;
+	while (ptr[len])
+		len++;
+
+	delete[] fileNameASCII;
+	fileNameASCII = new char[len+1];
+
+	for (mp_uint32 i = 0; i <= len; i++)
+		fileNameASCII[i] = (char)ptr[i];
+
+	return fileNameASCII;
+}
+
+void XMFileMemory::clear()
+{
+	if (!ownsBuffer)
+		return;
+
+	length = position = 0;
+}
@@ -63,6 +63,11 @@ public:
 
 	virtual bool			isEOF() { return pos() >= size(); }
 
+	// pointer to the next size bytes when the stream is held in memory
+	// (e.g. a mapped file), the position is moved past them.
+	// NULL if the data has to be read into a buffer.
+	virtual const mp_ubyte*	readDirect(mp_uint32 size) { return NULL; }
+
 	virtual	const SYSCHAR*  getFileName() = 0;
 	
 	virtual	const char*		getFileNameASCII() = 0;
@@ -106,7 +111,17 @@ private:
 	mp_ubyte*		cacheBuffer;
 	mp_ubyte*		currentCacheBufferPtr;
 	
+	// files opened for reading are mapped into memory if possible
+	mp_ubyte*		mappedData;
+	mp_uint32		mappedSize;
+	mp_uint32		mappedPos;
+#ifdef WIN32
+	HANDLE			mapping;
+#endif
+	
 	void			flush();
+	void			map();
+	void			unmap();
 	
 public:
 							XMFile(const SYSCHAR* fileName, bool writeAccess = false);
@@ -126,8 +141,59 @@ public:
 	virtual bool			isOpen();
 	virtual bool			isOpenForWriting() { return isOpen() && writeAccess; }
 	
+	virtual const mp_ubyte*	readDirect(mp_uint32 size);
+	
 	static bool				exists(const SYSCHAR* file);
 	static bool				remove(const SYSCHAR* file);
 };
 
+//////////////////////////////////////////////////////////////////////////
+// Stream on a block of memory, either a growing buffer which is owned	//
+// by the stream or existing data which is wrapped read only.			//
+// The file name is only used for identification and can be anything.	//
+//////////////////////////////////////////////////////////////////////////
+class XMFileMemory : public XMFileBase
+{
+private:
+	SYSCHAR*		fileName;
+
+	char*			fileNameASCII;
+
+	mp_ubyte*		buffer;
+	mp_uint32		bufferSize;
+	mp_uint32		length;
+	mp_uint32		position;
+
+	bool			ownsBuffer;
+
+	void			setFileName(const SYSCHAR* fileName);
+	bool			reserve(mp_uint32 size);
+
+public:
+							XMFileMemory(const SYSCHAR* fileName = NULL);
+							XMFileMemory(const void* data, mp_uint32 size, const SYSCHAR* fileName = NULL);
+	virtual					~XMFileMemory();
+
+	virtual mp_sint32		read(void* ptr,mp_sint32 size,mp_sint32 count);
+	virtual mp_sint32		write(const void* ptr,mp_sint32 size,mp_sint32 count);
+
+	virtual void			seek(mp_uint32 pos, SeekOffsetTypes seekOffsetType = SeekOffsetTypeStart);
+	virtual mp_uint32		pos() { return position; }
+	virtual mp_uint32		size() { return length; }
+
+	virtual const SYSCHAR*  getFileName() { return fileName; }
+
+	virtual const char*		getFileNameASCII();
+
+	virtual bool			isOpen() { return true; }
+	virtual bool			isOpenForWriting() { return ownsBuffer; }
+
+	virtual const mp_ubyte*	readDirect(mp_uint32 size);
+
+	const mp_ubyte*			getBuffer() const { return buffer; }
+
+	// throw away the contents, only for streams which own their buffer
+	void					clear();
+};
+
 #endif
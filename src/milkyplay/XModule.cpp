@@ -1201,103 +1201,205 @@ const TXMPattern& TXMPattern::operator=(const TXMPattern& src)
 
 #endif
 
-// Constructor for loader manager (private)
-XModule::LoaderManager::LoaderManager() :
-		loaders(NULL),
-		numLoaders(0),
-		numAllocatedLoaders(0),
-		iteratorCounter(-1)
+#ifndef MP_XMONLY 
+static Loader669	loader669;
+static LoaderAMF_1	loaderAMF_1;
+static LoaderAMF_2	loaderAMF_2;
+static LoaderAMSv1	loaderAMSv1;
+static LoaderAMSv2	loaderAMSv2;
+static LoaderCBA	loaderCBA;
+static LoaderDBM	loaderDBM;
+static LoaderDIGI	loaderDIGI;
+static LoaderDSMv1	loaderDSMv1;
+static LoaderDSMv2	loaderDSMv2;
+static LoaderDSm	loaderDSm;
+static LoaderDTM_1	loaderDTM_1;
+static LoaderDTM_2	loaderDTM_2;
+static LoaderFAR	loaderFAR;
+static LoaderGDM	loaderGDM;
+static LoaderIMF	loaderIMF;
+static LoaderIT		loaderIT;
+static LoaderMDL	loaderMDL;
+static LoaderMTM	loaderMTM;
+static LoaderMXM	loaderMXM;
+static LoaderOKT	loaderOKT;
+static LoaderPLM	loaderPLM;
+static LoaderPSMv1	loaderPSMv1;
+static LoaderPSMv2	loaderPSMv2;
+static LoaderPTM	loaderPTM;
+static LoaderS3M	loaderS3M;
+static LoaderSTM	loaderSTM;
+static LoaderSFX	loaderSFX;
+static LoaderUNI	loaderUNI;
+static LoaderULT	loaderULT;
+static LoaderGMC	loaderGMC;
+static LoaderMOD	loaderMOD;
+#endif
+static LoaderXM		loaderXM;
+
+// The order matters: when more than one loader identifies a module the first one wins.
+// The signatures need to be kept in sync with the identifyModule of the loaders.
+const XModule::TLoaderInfo XModule::LoaderManager::loaders[] =
 {
 #ifndef MP_XMONLY 
-	registerLoader(new Loader669(), ModuleType_669);
-	registerLoader(new LoaderAMF_1(), ModuleType_AMF);
-	registerLoader(new LoaderAMF_2(), ModuleType_AMF);
-	registerLoader(new LoaderAMSv1(), ModuleType_AMS);
-	registerLoader(new LoaderAMSv2(), ModuleType_AMS);
-	registerLoader(new LoaderCBA(), ModuleType_CBA);
-	registerLoader(new LoaderDBM(), ModuleType_DBM);
-	registerLoader(new LoaderDIGI(), ModuleType_DIGI);
-	registerLoader(new LoaderDSMv1(), ModuleType_DSM);
-	registerLoader(new LoaderDSMv2(), ModuleType_DSM);
-	registerLoader(new LoaderDSm(), ModuleType_DSm);
-	registerLoader(new LoaderDTM_1(), ModuleType_DTM_1);
-	registerLoader(new LoaderDTM_2(), ModuleType_DTM_2);
-	registerLoader(new LoaderFAR(), ModuleType_FAR);
-	registerLoader(new LoaderGDM(), ModuleType_GDM);
-	registerLoader(new LoaderIMF(), ModuleType_IMF);
-	registerLoader(new LoaderIT(), ModuleType_IT);
-	//registerLoader(new LoaderFNK(), funk format sucks
-	registerLoader(new LoaderMDL(), ModuleType_MDL);
-	registerLoader(new LoaderMTM(), ModuleType_MTM);
-	registerLoader(new LoaderMXM(), ModuleType_MXM);
-	registerLoader(new LoaderOKT(), ModuleType_OKT);
-	registerLoader(new LoaderPLM(), ModuleType_PLM);
-	registerLoader(new LoaderPSMv1(), ModuleType_PSM);
-	registerLoader(new LoaderPSMv2(), ModuleType_PSM);
-	registerLoader(new LoaderPTM(), ModuleType_PTM);
-	registerLoader(new LoaderS3M(), ModuleType_S3M);
-	registerLoader(new LoaderSTM(), ModuleType_STM);
-	registerLoader(new LoaderSFX(), ModuleType_SFX);
-	registerLoader(new LoaderUNI(), ModuleType_UNI);
-	registerLoader(new LoaderULT(), ModuleType_ULT);	
-	registerLoader(new LoaderXM(), ModuleType_XM);	
+	{&loader669, ModuleType_669, {{0, "if", 2}, {0, "JN", 2}}, "669"},
+	{&loaderAMF_1, ModuleType_AMF, {{0, "ASYLUM Music Format", 19}}, "amf"},
+	{&loaderAMF_2, ModuleType_AMF, {{0, "DMF", 3}}, "amf|dmf"},
+	{&loaderAMSv1, ModuleType_AMS, {{0, "Extreme\x30\x1", 9}}, "ams"},
+	{&loaderAMSv2, ModuleType_AMS, {{0, "AMShdr\x1a", 7}}, "ams"},
+	{&loaderCBA, ModuleType_CBA, {{0, "CBA\xF9", 4}}, "cba"},
+	{&loaderDBM, ModuleType_DBM, {{0, "DBM0", 4}}, "dbm"},
+	{&loaderDIGI, ModuleType_DIGI, {{0, "DIGI Booster module", 19}}, "digi"},
+	{&loaderDSMv1, ModuleType_DSM, {{0, "DSM\x10", 4}}, "dsm"},
+	{&loaderDSMv2, ModuleType_DSM, {{8, "DSMFSONG", 8}}, "dsm"},
+	{&loaderDSm, ModuleType_DSm, {{0, "DSm\x1A\x20", 5}}, "dsm"},
+	{&loaderDTM_1, ModuleType_DTM_1, {{0, "SONG", 4}}, "dtm"},
+	{&loaderDTM_2, ModuleType_DTM_2, {{0, "D.T.", 4}}, "dtm"},
+	{&loaderFAR, ModuleType_FAR, {{0, "FAR\xFE", 4}}, "far"},
+	{&loaderGDM, ModuleType_GDM, {{0, "GDM\xFE", 4}}, "gdm"},
+	{&loaderIMF, ModuleType_IMF, {{0x3c, "IM10", 4}}, "imf"},
+	{&loaderIT, ModuleType_IT, {{0, "IMPM", 4}}, "it"},
+	//{&loaderFNK, funk format sucks
+	{&loaderMDL, ModuleType_MDL, {{0, "DMDL", 4}}, "mdl"},
+	{&loaderMTM, ModuleType_MTM, {{0, "MTM\x10", 4}}, "mtm"},
+	{&loaderMXM, ModuleType_MXM, {{0, "MXM", 3}}, "mxm"},
+	{&loaderOKT, ModuleType_OKT, {{0, "OKTASONG", 8}}, "okt|okta"},
+	{&loaderPLM, ModuleType_PLM, {{0, "PLM\x1A", 4}}, "plm"},
+	{&loaderPSMv1, ModuleType_PSM, {{0, "PSM\xFE", 4}}, "psm"},
+	{&loaderPSMv2, ModuleType_PSM, {{0, "PSM\x20", 4}}, "psm"},
+	{&loaderPTM, ModuleType_PTM, {{44, "PTMF", 4}}, "ptm"},
+	{&loaderS3M, ModuleType_S3M, {{0x2c, "SCRM", 4}}, "s3m"},
+	{&loaderSTM, ModuleType_STM, {{20, "!Scream!", 8}, {20, "BMOD2STM", 8}}, "stm"},
+	{&loaderSFX, ModuleType_SFX, {{60, "SONG", 4}}, "sfx"},
+	{&loaderUNI, ModuleType_UNI, {{0, "UN0", 3}}, "uni"},
+	{&loaderULT, ModuleType_ULT, {{0, "MAS_UTrack_V00", 14}}, "ult"},
+	{&loaderXM, ModuleType_XM, {{0, "Extended Module:", 16}}, "xm"},
 	// Game Music Creator may not be recognized perfectly
-	registerLoader(new LoaderGMC(), ModuleType_GMC);
+	{&loaderGMC, ModuleType_GMC, {{0}}, "gmc"},
 	// Last loader is MOD because there is a slight chance that other formats will be misinterpreted as 15 ins. MODs
-	registerLoader(new LoaderMOD(), ModuleType_MOD);
+	{&loaderMOD, ModuleType_MOD, {{0}}, "mod|m15|nst|wow"},
 #else
-	registerLoader(new LoaderXM(), ModuleType_XM);	
+	{&loaderXM, ModuleType_XM, {{0, "Extended Module:", 16}}, "xm"},
 #endif
-}
+};
 
-XModule::LoaderManager::~LoaderManager()
-{
-	for (mp_uint32 i = 0; i < numLoaders; i++)
-		delete loaders[i].loader;
-		
-	delete[] loaders;
-}
+const mp_uint32 XModule::LoaderManager::numLoaders = sizeof(loaders) / sizeof(TLoaderInfo);
 
-void XModule::LoaderManager::registerLoader(LoaderInterface* loader, ModuleTypes type)
+bool XModule::LoaderManager::matchesSignature(const TLoaderInfo& info, const mp_ubyte* buffer)
 {
-	if (numLoaders+1 > numAllocatedLoaders)
+	for (mp_uint32 i = 0; i < sizeof(info.signatures) / sizeof(TLoaderSignature); i++)
 	{
-		numAllocatedLoaders+=16;
-		
-		TLoaderInfo* newLoaders = new TLoaderInfo[numAllocatedLoaders];
-		for (mp_uint32 i = 0; i < numLoaders; i++)
-			newLoaders[i] = loaders[i];
-			
-		delete[] loaders;
-		loaders = newLoaders;
+		const TLoaderSignature& signature = info.signatures[i];
+		if (signature.length && memcmp(buffer + signature.offset, signature.bytes, signature.length) == 0)
+			return true;
 	}
 	
-	loaders[numLoaders].loader = loader;
-	loaders[numLoaders].moduleType = type;
-	
-	numLoaders++;
+	return false;
 }
 
-XModule::TLoaderInfo* XModule::LoaderManager::getFirstLoaderInfo()
+bool XModule::LoaderManager::matchesFileName(const TLoaderInfo& info, const SYSCHAR* fileName)
 {
-	if (numLoaders)
+	// strip the path
+	const SYSCHAR* name = fileName;
+	for (const SYSCHAR* ptr = fileName; *ptr; ptr++)
+		if (*ptr == '/' || *ptr == '\\' || *ptr == ':')
+			name = ptr + 1;
+
+	const SYSCHAR* firstDot = NULL;
+	const SYSCHAR* lastDot = NULL;
+	for (const SYSCHAR* ptr = name; *ptr; ptr++)
+	{
+		if (*ptr == '.')
+		{
+			if (firstDot == NULL)
+				firstDot = ptr;
+			lastDot = ptr;
+		}
+	}
+	
+	if (lastDot == NULL)
+		return false;
+
+	const char* extension = info.extensions;
+	while (*extension)
 	{
-		iteratorCounter = 0;
-		return loaders;
+		mp_uint32 len = 0;
+		while (extension[len] && extension[len] != '|')
+			len++;
+
+		// compare with the extension and the prefix (e.g. "mod.songname" on the Amiga)
+		const SYSCHAR* candidates[2] = {lastDot + 1, name};
+		const SYSCHAR* ends[2] = {NULL, firstDot};
+		for (mp_uint32 i = 0; i < 2; i++)
+		{
+			const SYSCHAR* ptr = candidates[i];
+			mp_uint32 j = 0;
+			for (; j < len && ptr[j]; j++)
+			{
+				SYSCHAR c = ptr[j];
+				if (c >= 'A' && c <= 'Z')
+					c += 'a' - 'A';
+				if (c != (SYSCHAR)extension[j])
+					break;
+			}
+			
+			if (j == len && (ends[i] ? ptr + len == ends[i] : ptr[len] == 0))
+				return true;
+		}
+
+		extension += len;
+		if (*extension == '|')
+			extension++;
 	}
-	else return NULL;
+
+	return false;
 }
 
-XModule::TLoaderInfo* XModule::LoaderManager::getNextLoaderInfo()
+const XModule::TLoaderInfo* XModule::LoaderManager::findLoader(const mp_ubyte* buffer, const SYSCHAR* fileName, const char*& id)
 {
-	iteratorCounter++;
-	if (iteratorCounter < (signed)numLoaders)
-		return loaders+iteratorCounter;
-	else
+	mp_uint32 i;
+
+	// file name and signature agree, that's almost certainly the one
+	if (fileName)
 	{
-		iteratorCounter = -1;
-		return NULL;
+		for (i = 0; i < numLoaders; i++)
+		{
+			const TLoaderInfo& info = loaders[i];
+			if (matchesFileName(info, fileName) && matchesSignature(info, buffer) &&
+				(id = info.loader->identifyModule(buffer)) != NULL)
+				return &info;
+		}
 	}
+	
+	// every loader with matching signature in the usual order
+	for (i = 0; i < numLoaders; i++)
+	{
+		const TLoaderInfo& info = loaders[i];
+		if (matchesSignature(info, buffer) && 
+			(id = info.loader->identifyModule(buffer)) != NULL)
+			return &info;
+	}
+	
+	// last resort, the formats which can only be guessed, the one named by the file name first
+	for (mp_uint32 pass = 0; pass < 2; pass++)
+	{
+		for (i = 0; i < numLoaders; i++)
+		{
+			const TLoaderInfo& info = loaders[i];
+			if (info.signatures[0].length)
+				continue;
+
+			const bool named = fileName && matchesFileName(info, fileName);
+			if (named != (pass == 0))
+				continue;
+			
+			if ((id = info.loader->identifyModule(buffer)) != NULL)
+				return &info;
+		}
+	}
+	
+	id = NULL;
+	return NULL;
 }
 
 const mp_sint32 XModule::periods[12] = {1712,1616,1524,1440,1356,1280,1208,1140,1076,1016,960,907};
@@ -1483,6 +1585,32 @@ bool XModule::loadSample(XMFileBase& f,void* buffer,mp_uint32 size,mp_uint32 len
 		
 		return true;
 	}
+	
+	// set when 16 bit data is in native byte order already
+	bool converted = false;
+	
+	const mp_uint32 bytes = (flags & ST_16BIT) ? length*2 : length;
+	const mp_ubyte* src = bytes <= size ? f.readDirect(bytes) : NULL;
+	
+	if (src)
+	{
+		// data is in memory already (e.g. mapped file),
+		// convert it while copying it into the sample buffer
+		memset((mp_ubyte*)buffer + bytes, 0, size - bytes);
+		
+		if ((flags & ST_16BIT) && !(flags & ST_DELTA_PTM))
+		{
+			if (flags & ST_BIGENDIAN)
+				BigEndian::GET_WORDS(src, (mp_uword*)buffer, length);
+			else
+				LittleEndian::GET_WORDS(src, (mp_uword*)buffer, length);
+			converted = true;
+		}
+		else
+		{
+			memcpy(buffer, src, bytes);
+		}
+	}
 	else
 	{
 		memset(buffer, 0, size);
@@ -1504,15 +1632,12 @@ bool XModule::loadSample(XMFileBase& f,void* buffer,mp_uint32 size,mp_uint32 len
 		}
 
 		mp_uint32 i;
-		if (flags & ST_BIGENDIAN)
+		if (!converted)
 		{
-			for (i = 0; i < length; i++)
-				dstPtr[i] = BigEndian::GET_WORD(srcPtr+i*2);
-		}
-		else
-		{
-			for (i = 0; i < length; i++)
-				dstPtr[i] = LittleEndian::GET_WORD(srcPtr+i*2);
+			if (flags & ST_BIGENDIAN)
+				BigEndian::GET_WORDS(srcPtr, (mp_uword*)dstPtr, length);
+			else
+				LittleEndian::GET_WORDS(srcPtr, (mp_uword*)dstPtr, length);
 		}
 		
 		// delta-storing
@@ -1656,69 +1781,153 @@ void XModule::setDefaultPanning()
 	}
 }
 
-mp_ubyte* XModule::allocSampleMem(mp_uint32 size)
+mp_uint32 XModule::getSamplePoolSlot(const mp_ubyte* mem) const
+{
+	// allocations are at least 16 byte aligned, the lower bits don't tell anything
+	const size_t key = (size_t)mem >> 4;
+	return ((mp_uint32)key ^ (mp_uint32)(key >> 16)) * 2654435761U & (samplePoolSize - 1);
+}
+
+void XModule::addSamplePoolEntry(mp_ubyte* mem, mp_uint32 size)
 {
-	// sample is always padded at start and end with 16 bytes
-	for (mp_sint32 i = 0; i < (signed)samplePointerIndex; i++)
+	// keep the table at most half full
+	if ((samplePoolNumEntries + 1) * 2 > samplePoolSize)
 	{
-		if (samplePool[i] == NULL)
+		TSamplePoolEntry* oldPool = samplePool;
+		mp_uint32 oldSize = samplePoolSize;
+
+		samplePoolSize = oldSize ? oldSize * 2 : 64;
+		samplePool = new TSamplePoolEntry[samplePoolSize];
+		memset(samplePool, 0, sizeof(TSamplePoolEntry) * samplePoolSize);
+		
+		for (mp_uint32 i = 0; i < oldSize; i++)
 		{
-			samplePool[i] = TXMSample::allocPaddedMem(size);
-			return samplePool[i];
+			if (oldPool[i].mem == NULL)
+				continue;
+				
+			mp_uint32 slot = getSamplePoolSlot(oldPool[i].mem);
+			while (samplePool[slot].mem)
+				slot = (slot + 1) & (samplePoolSize - 1);
+			samplePool[slot] = oldPool[i];
 		}
+		
+		delete[] oldPool;
 	}
 
-	samplePool[samplePointerIndex] = TXMSample::allocPaddedMem(size);
-	return samplePool[samplePointerIndex++];
+	mp_uint32 slot = getSamplePoolSlot(mem);
+	while (samplePool[slot].mem)
+	{
+		if (samplePool[slot].mem == mem)
+			return;
+		slot = (slot + 1) & (samplePoolSize - 1);
+	}
+	
+	samplePool[slot].mem = mem;
+	samplePool[slot].size = size;
+	samplePoolNumEntries++;
+	
+	sampleMemoryStatistics.numBuffers++;
+	sampleMemoryStatistics.numBytes+=size;
+	if (sampleMemoryStatistics.numBuffers > sampleMemoryStatistics.peakBuffers)
+		sampleMemoryStatistics.peakBuffers = sampleMemoryStatistics.numBuffers;
+	if (sampleMemoryStatistics.numBytes > sampleMemoryStatistics.peakBytes)
+		sampleMemoryStatistics.peakBytes = sampleMemoryStatistics.numBytes;
 }
 
-void XModule::freeSampleMem(mp_ubyte* mem, bool assertCheck/* = true*/)
+bool XModule::removeSamplePoolEntry(const mp_ubyte* mem)
 {
-	bool found = false;
-	for (mp_sint32 i = 0; i < (signed)samplePointerIndex; i++)
+	if (mem == NULL || samplePoolNumEntries == 0)
+		return false;
+
+	const mp_uint32 mask = samplePoolSize - 1;
+	
+	mp_uint32 slot = getSamplePoolSlot(mem);
+	while (samplePool[slot].mem != mem)
+	{
+		if (samplePool[slot].mem == NULL)
+			return false;
+		slot = (slot + 1) & mask;
+	}
+	
+	sampleMemoryStatistics.numBuffers--;
+	sampleMemoryStatistics.numBytes-=samplePool[slot].size;
+	samplePoolNumEntries--;
+	
+	// move following entries of the same run back into the hole, 
+	// unless that would put them before their home slot
+	mp_uint32 hole = slot;
+	for (mp_uint32 i = (slot + 1) & mask; samplePool[i].mem; i = (i + 1) & mask)
 	{
-		if (samplePool[i] == mem)
+		const mp_uint32 home = getSamplePoolSlot(samplePool[i].mem);
+		if (((i - home) & mask) >= ((i - hole) & mask))
 		{
-			found = true;
-			TXMSample::freePaddedMem(samplePool[i]);
-			samplePool[i] = NULL;
-			if (i == (signed)samplePointerIndex - 1)
-			{
-				samplePointerIndex--;
-				break;
-			}
+			samplePool[hole] = samplePool[i];
+			hole = i;
 		}
 	}
 	
+	samplePool[hole].mem = NULL;
+	samplePool[hole].size = 0;
+	
+	return true;
+}
+
+mp_ubyte* XModule::allocSampleMem(mp_uint32 size)
+{
+	// sample is always padded at start and end
+	mp_ubyte* mem = TXMSample::allocPaddedMem(size);
+	if (mem == NULL)
+		return NULL;
+		
+	addSamplePoolEntry(mem, size);
+	sampleMemoryStatistics.numAllocations++;
+	return mem;
+}
+
+void XModule::freeSampleMem(mp_ubyte* mem, bool assertCheck/* = true*/)
+{
+	bool found = removeSamplePoolEntry(mem);
+	if (found)
+	{
+		TXMSample::freePaddedMem(mem);
+		sampleMemoryStatistics.numFrees++;
+	}
+	
 	if (assertCheck)
 	{
 		ASSERT(found);
 	}
 }
 
-#ifdef MILKYTRACKER
-void XModule::insertSamplePtr(mp_ubyte* ptr)
+void XModule::freeAllSampleMem()
 {
-	for (mp_sint32 i = 0; i < (signed)samplePointerIndex; i++)
+	for (mp_uint32 i = 0; i < samplePoolSize; i++)
 	{
-		if (samplePool[i] == NULL)
+		if (samplePool[i].mem)
 		{
-			samplePool[i] = ptr;
-			return;
+			TXMSample::freePaddedMem(samplePool[i].mem);
+			sampleMemoryStatistics.numFrees++;
 		}
 	}
+	
+	delete[] samplePool;
+	samplePool = NULL;
+	samplePoolSize = samplePoolNumEntries = 0;
+	
+	sampleMemoryStatistics.numBuffers = 0;
+	sampleMemoryStatistics.numBytes = 0;
+}
 
-	samplePool[samplePointerIndex++] = ptr;
+#ifdef MILKYTRACKER
+void XModule::insertSamplePtr(mp_ubyte* ptr)
+{
+	if (ptr)
+		addSamplePoolEntry(ptr, TXMSample::getSampleSizeInBytes(ptr));
 }
+
 void XModule::removeSamplePtr(mp_ubyte* ptr)
 {
-	for (mp_sint32 i = 0; i < (signed)samplePointerIndex; i++)
-	{
-		if (samplePool[i] == ptr)
-		{
-			samplePool[i] = NULL;
-		}
-	}
+	removeSamplePoolEntry(ptr);
 }
 #endif
 
@@ -1846,15 +2055,7 @@ bool XModule::cleanUp()
 	}
 
 	// release sample-memory
-	for (i = 0; i < samplePointerIndex; i++)
-	{
-		if (samplePool[i]) 
-		{
-			TXMSample::freePaddedMem(samplePool[i]);
-			samplePool[i] = NULL;
-		}
-	}
-	samplePointerIndex = 0;
+	freeAllSampleMem();
 	
 	memset(&header,0,sizeof(TXMHeader));
 	
@@ -1888,10 +2089,10 @@ XModule::XModule()
 	// no module loaded (empty song)
 	moduleLoaded = false;
 
-	// initialise all sample pointers to NULL
-	memset(samplePool,0,sizeof(samplePool));
-	// reset current sample index
-	samplePointerIndex = 0;
+	// sample pool is allocated with the first sample
+	samplePool = NULL;
+	samplePoolSize = samplePoolNumEntries = 0;
+	memset(&sampleMemoryStatistics, 0, sizeof(sampleMemoryStatistics));
 
 	memset(&header,0,sizeof(TXMHeader));
 
@@ -1936,24 +2137,11 @@ XModule::~XModule()
 	delete[] smp;
 }
 
-const char* XModule::identifyModule(const mp_ubyte* buffer)
+const char* XModule::identifyModule(const mp_ubyte* buffer, const SYSCHAR* fileName/* = NULL*/)
 {
-	// browse through all available loaders and find suitable
-	LoaderManager loaderManager;
-	TLoaderInfo* loaderInfo;
-	loaderInfo = loaderManager.getFirstLoaderInfo();
-	while (loaderInfo)
-	{
-		// if loader can identify module return ID
-		const char* id = loaderInfo->loader->identifyModule(buffer);
-		if (id)
-		{
-			return id;
-		}
-		
-		loaderInfo = loaderManager.getNextLoaderInfo();
-	}
-	return NULL;
+	const char* id;
+	LoaderManager::findLoader(buffer, fileName, id);
+	return id;
 }
 
 mp_sint32 XModule::loadModule(const SYSCHAR* fileName, bool scanForSubSongs/* = false*/)
@@ -1970,35 +2158,27 @@ mp_sint32 XModule::loadModule(XMFileBase& f, bool scanForSubSongs/* = false*/)
 	f.setBaseOffset(f.pos());
 	f.read(buffer, 1, sizeof(buffer));
 
-	// browse through all available loaders and find suitable
-	LoaderManager loaderManager;
-	TLoaderInfo* loaderInfo;
-	loaderInfo = loaderManager.getFirstLoaderInfo();
-	while (loaderInfo)
+	const char* id;
+	const TLoaderInfo* loaderInfo = LoaderManager::findLoader(buffer, f.getFileName(), id);
+	if (loaderInfo)
 	{
-		// if loader can identify module take that loader
-		if (loaderInfo->loader->identifyModule(buffer))
+		// try to load module
+		f.seekWithBaseOffset(0);
+		mp_sint32 err = loaderInfo->loader->load(f, this);
+		if (err == MP_OK)
 		{
-			// try to load module
-			f.seekWithBaseOffset(0);
-			mp_sint32 err = loaderInfo->loader->load(f, this);
-			if (err == MP_OK)
-			{
-				moduleLoaded = true;
-				
-				bool res = validate();
+			moduleLoaded = true;
+			
+			bool res = validate();
 
-				if (!res)
-					return MP_OUT_OF_MEMORY;
-				
-				type = loaderInfo->moduleType;
-				if (scanForSubSongs)
-					buildSubSongTable();
-			}
-			return err;
+			if (!res)
+				return MP_OUT_OF_MEMORY;
+			
+			type = loaderInfo->moduleType;
+			if (scanForSubSongs)
+				buildSubSongTable();
 		}
-		
-		loaderInfo = loaderManager.getNextLoaderInfo();
+		return err;
 	}
 	
 #ifdef MILKYTRACKER
@@ -2679,16 +2859,7 @@ void XModule::createEmptySong(bool clearPatterns/* = true*/, bool clearInstrumen
 		}
 		
 		// release sample-memory
-		for (i = 0; i < samplePointerIndex; i++)
-		{
-			if (samplePool[i]) 
-			{
-				TXMSample::freePaddedMem(samplePool[i]);
-				samplePool[i] = NULL;
-			}
-		}
-
-		samplePointerIndex = 0;
+		freeAllSampleMem();
 		
 		if (instr)
 			memset(instr,0,sizeof(TXMInstrument)*256);
@@ -146,7 +146,9 @@ private:
 		EmptySize = 8,
 		LeadingPadding = sizeof(TLoopDoubleBuffProps) + LoopAreaBackupSizeMaxInBytes + EmptySize,
 		TrailingPadding = 16,
-		PaddingSpace = LeadingPadding+TrailingPadding
+		PaddingSpace = LeadingPadding+TrailingPadding,
+		// alignment of the sample data from allocPaddedMem
+		SampleAlignment = 32
 	};
 
 	void restoreLoopArea();
@@ -188,13 +190,18 @@ public:
 		return mem-TXMSample::LeadingPadding;
 	}
 
+	// the sample data is aligned to SampleAlignment bytes, the byte in front of
+	// the padding holds the distance to the start of the allocated block
 	static mp_ubyte* allocPaddedMem(mp_uint32 size)
 	{
-		mp_ubyte* result = new mp_ubyte[getPaddedSize(size)];
+		mp_ubyte* block = new mp_ubyte[getPaddedSize(size) + SampleAlignment];
 		
-		if (result == NULL)
+		if (block == NULL)
 			return NULL;
 		
+		mp_ubyte* result = (mp_ubyte*)(((size_t)(block + 1 + TXMSample::LeadingPadding) + (SampleAlignment-1)) & ~(size_t)(SampleAlignment-1)) - TXMSample::LeadingPadding;
+		result[-1] = (mp_ubyte)(result - block);
+		
 		// clear out padding space
 		memset(result, 0, TXMSample::LeadingPadding);
 		memset(result+size+TXMSample::LeadingPadding, 0, TXMSample::TrailingPadding);
@@ -211,7 +218,8 @@ public:
 		if (mem == NULL)
 			return;
 			
-		delete[] getPadStartAddr(mem);
+		mp_ubyte* padStart = getPadStartAddr(mem);
+		delete[] (padStart - padStart[-1]);
 	}
 
 	static void copyPaddedMem(void* dst, const void* src, mp_uint32 size)
@@ -371,10 +379,23 @@ public:
 	};	
 	
 private:
+	// bytes found at a fixed position in every module of a type
+	struct TLoaderSignature
+	{
+		mp_uint32 offset;
+		const char* bytes;
+		mp_uint32 length;
+	};
+
 	struct TLoaderInfo
 	{
 		LoaderInterface* loader;
 		ModuleTypes moduleType;
+		// identifyModule can only succeed if one of those is present,
+		// loaders without signature (length 0) have to be asked every time
+		TLoaderSignature signatures[2];
+		// file extensions (or Amiga style prefixes) separated by '|'
+		const char* extensions;
 	};
 	
 public:
@@ -446,11 +467,34 @@ public:
 	///////////////////////////////////////////////////////
 	void			freeSampleMem(mp_ubyte* mem, bool assertCheck = true);
 
+	///////////////////////////////////////////////////////
+	// Free all sample memory of this module at once	 //
+	///////////////////////////////////////////////////////
+	void			freeAllSampleMem();
+
 #ifdef MILKYTRACKER
 	void			insertSamplePtr(mp_ubyte* ptr);
 	void			removeSamplePtr(mp_ubyte* ptr);
 #endif
 
+	///////////////////////////////////////////////////////
+	// Sample memory usage of this module				 //
+	///////////////////////////////////////////////////////
+	struct TSampleMemoryStatistics
+	{
+		// buffers which are held right now and their sizes (without padding)
+		mp_uint32	numBuffers;
+		mp_uint32	numBytes;
+		// highest values so far
+		mp_uint32	peakBuffers;
+		mp_uint32	peakBytes;
+		// calls to allocSampleMem and freeSampleMem (including freeAllSampleMem)
+		mp_uint32	numAllocations;
+		mp_uint32	numFrees;
+	};
+	
+	const TSampleMemoryStatistics& getSampleMemoryStatistics() const { return sampleMemoryStatistics; }
+
 	///////////////////////////////////////////////////////
 	//    Clean up! (Is called before loading a song)    //
 	///////////////////////////////////////////////////////
@@ -474,9 +518,24 @@ private:
 	// Indicates whether a file is loaded or if it's just an empty song 
 	bool			moduleLoaded;
 
-	// each module comes with it's own sample-memory management (MILKYPLAY_MAXSAMPLES samples max.)
-	mp_ubyte*		samplePool[MP_MAXSAMPLES];
-	mp_uint32		samplePointerIndex;
+	// each module comes with it's own sample-memory management,
+	// the pointers are kept in a hash table (open addressing, linear probing)
+	struct TSamplePoolEntry
+	{
+		mp_ubyte*	mem;
+		mp_uint32	size;
+	};
+	
+	TSamplePoolEntry*	samplePool;
+	// number of slots, always a power of two
+	mp_uint32		samplePoolSize;
+	mp_uint32		samplePoolNumEntries;
+	
+	TSampleMemoryStatistics sampleMemoryStatistics;
+	
+	mp_uint32		getSamplePoolSlot(const mp_ubyte* mem) const;
+	void			addSamplePoolEntry(mp_ubyte* mem, mp_uint32 size);
+	bool			removeSamplePoolEntry(const mp_ubyte* mem);
 
 	// song message retrieving
 	char*			messagePtr;
@@ -490,25 +549,23 @@ private:
 	// fix broken envelopes (1 point envelope for example)
 	static void		fixEnvelopes(TEnvelope* envs, mp_uint32 numEnvs);
 	
-	// holds available loader instances
+	// holds the loader instances, the loaders don't have any state
+	// so there's only one of each shared by everyone (and every thread)
 	class LoaderManager
 	{
 	private:
-		TLoaderInfo*	loaders;
-
-		mp_uint32		numLoaders;
-		mp_uint32		numAllocatedLoaders;
+		static const TLoaderInfo	loaders[];
+		static const mp_uint32		numLoaders;
 
-		mp_sint32		iteratorCounter;
-
-		void registerLoader(LoaderInterface* loader, ModuleTypes type);
+		static bool matchesSignature(const TLoaderInfo& info, const mp_ubyte* buffer);
+		static bool matchesFileName(const TLoaderInfo& info, const SYSCHAR* fileName);
 		
 	public:
-		LoaderManager();		
-		~LoaderManager();
-		
-		TLoaderInfo* getFirstLoaderInfo();
-		TLoaderInfo* getNextLoaderInfo();
+		// Find the loader for the module in buffer (IdentificationBufferSize bytes).
+		// Only loaders whose signature is present in the buffer are asked,
+		// the file name (optional) decides between the formats which can't
+		// be told apart by their content alone.
+		static const TLoaderInfo* findLoader(const mp_ubyte* buffer, const SYSCHAR* fileName, const char*& id);
 	};
 
 	friend class	LoaderManager;
@@ -625,8 +682,9 @@ public:
 	// IMPORTANT: buffer MUST contain				 //
 	// eIdentifyBufferSize bytes from the beginning  //
 	// of the file									 //
+	// the file name is optional (just a hint)		 //
 	///////////////////////////////////////////////////
-	static const char*	identifyModule(const mp_ubyte* buffer);
+	static const char*	identifyModule(const mp_ubyte* buffer, const SYSCHAR* fileName = NULL);
 	
 	///////////////////////////////////////////////////
 	// generic module loader						 //
@@ -56,6 +56,7 @@ void AudioDriver_ALSA::async_direct_callback(snd_async_handler_t *ahandler)
 	while (1) {
 		state = snd_pcm_state(handle);
 		if (state == SND_PCM_STATE_XRUN) {
+			audioDriver->reportUnderrun();
 			err = snd_pcm_recover(handle, -EPIPE, 0);
 			if (err < 0) {
 				fprintf(stderr, "ALSA: XRUN recovery failed: %s\n", snd_strerror(err));
@@ -69,6 +70,8 @@ void AudioDriver_ALSA::async_direct_callback(snd_async_handler_t *ahandler)
 		}
 		avail = snd_pcm_avail_update(handle);
 		if (avail < 0) {
+			if (avail == -EPIPE)
+				audioDriver->reportUnderrun();
 			err = snd_pcm_recover(handle, avail, 0);
 			if (err < 0) {
 				fprintf(stderr, "ALSA: avail update failed: %s\n", snd_strerror(err));
@@ -236,6 +239,7 @@ mp_sint32 AudioDriver_ALSA::start()
 		return -1;
 	}
 	
+	resetCallbackTime();
 	deviceHasStarted = true;
 	return 0;
 }
@@ -248,6 +252,7 @@ mp_sint32 AudioDriver_ALSA::pause()
 
 mp_sint32 AudioDriver_ALSA::resume()
 {
+	resetCallbackTime();
 	snd_pcm_pause(pcm, false);
 	return 0;
 }
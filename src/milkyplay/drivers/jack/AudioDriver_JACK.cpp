@@ -63,27 +63,28 @@ int AudioDriver_JACK::jackProcess(jack_nframes_t nframes, void *arg)
 	leftBuffer = (jack_default_audio_sample_t*) audioDriver->jack_port_get_buffer(audioDriver->leftPort, nframes);
 	rightBuffer = (jack_default_audio_sample_t*) audioDriver->jack_port_get_buffer(audioDriver->rightPort, nframes);
 
-	audioDriver->fillAudioWithCompensation((char*)audioDriver->rawStream, nframes * 4);
+	// JACK uses non-interleaved floating-point samples, so let the mixer write them directly
+	audioDriver->fillAudioWithCompensation(leftBuffer, rightBuffer, nframes);
+	return 0;
+}
 
-	// JACK uses non-interleaved floating-point samples, we need to convert
-	for(int out = 0, in = 0; in < nframes; in++)
-	{
-		leftBuffer[in] = audioDriver->rawStream[out++] * (1.0/32768.0);
-		rightBuffer[in] = audioDriver->rawStream[out++] * (1.0/32768.0);
-	}
+int AudioDriver_JACK::jackXRun(void *arg)
+{
+	AudioDriver_JACK* audioDriver = (AudioDriver_JACK*)arg;
+	
+	audioDriver->reportUnderrun();
+	
 	return 0;
 }
 
 AudioDriver_JACK::AudioDriver_JACK() :
 	AudioDriver_COMPENSATE(),
-	paused(false),
-	rawStream(NULL)
+	paused(false)
 {
 }
 
 AudioDriver_JACK::~AudioDriver_JACK()
 {
-	if(rawStream) delete[] rawStream;
 }
 
 // On error return a negative value
@@ -109,6 +110,8 @@ mp_sint32 AudioDriver_JACK::initDevice(mp_sint32 bufferSizeInWords, mp_uint32 mi
 		dlsym(libJack, "jack_port_register");
 	jack_set_process_callback = (int (*)(jack_client_t*, int (*)(jack_nframes_t, void*), void*))
 		dlsym(libJack, "jack_set_process_callback");
+	jack_set_xrun_callback = (int (*)(jack_client_t*, int (*)(void*), void*))
+		dlsym(libJack, "jack_set_xrun_callback");
 	jack_get_buffer_size = (jack_nframes_t (*)(jack_client_t*))
 		dlsym(libJack, "jack_get_buffer_size");
 	jack_deactivate = (int (*)(jack_client_t*))
@@ -152,15 +155,14 @@ mp_sint32 AudioDriver_JACK::initDevice(mp_sint32 bufferSizeInWords, mp_uint32 mi
 	
 	// Set callback
 	jack_set_process_callback(hJack, jackProcess, (void *) this);
+	// count the underruns for the profiler
+	jack_set_xrun_callback(hJack, jackXRun, (void *) this);
 
 	// Get buffer-size
 	jackFrames = jack_get_buffer_size(hJack);
 	bufferSize = jackFrames * 2;
 	this->mixFrequency = jack_get_sample_rate(hJack);
 	printf("JACK: Mixer frequency: %i\n", this->mixFrequency);
-	//delete[] rawStream; // pailes: make sure this isn't allocated yet
-	assert(!rawStream);		// If it is allocated, something went wrong and we need to know about it
-	rawStream = new mp_sword[bufferSize];
 	printf("JACK: Latency = %i frames\n", jackFrames);
 	return bufferSize;
 }
@@ -176,8 +178,6 @@ mp_sint32 AudioDriver_JACK::closeDevice()
 {
 	deviceHasStarted = false;
 	jack_client_close(hJack);
-	if(rawStream) delete[] rawStream;
-	rawStream = NULL;
 	dlclose(libJack);
 	libJack = NULL;
 	return 0;
@@ -191,6 +191,7 @@ mp_sint32 AudioDriver_JACK::start()
 		dlsym(libJack, "jack_connect");
 	jack_port_name = (const char* (*)(const jack_port_t *))
 		dlsym(libJack, "jack_port_name");
+	resetCallbackTime();
 	jack_activate(hJack);
 	deviceHasStarted = true;
 	return 0;
@@ -204,6 +205,7 @@ mp_sint32 AudioDriver_JACK::pause()
 
 mp_sint32 AudioDriver_JACK::resume()
 {
+	resetCallbackTime();
 	paused = false;
 	return 0;
 }
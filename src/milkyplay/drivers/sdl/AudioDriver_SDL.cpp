@@ -144,6 +144,7 @@ mp_sint32 AudioDriver_SDL::closeDevice()
 
 mp_sint32 AudioDriver_SDL::start()
 {
+	resetCallbackTime();
 	SDL_PauseAudio(0);
 	deviceHasStarted = true;
 	return MP_OK;
@@ -157,6 +158,7 @@ mp_sint32 AudioDriver_SDL::pause()
 
 mp_sint32 AudioDriver_SDL::resume()
 {
+	resetCallbackTime();
 	SDL_PauseAudio(0);
 	return MP_OK;
 }
@@ -206,6 +206,14 @@ public:
 
 	virtual void update(const PPRect& r) = 0;
 
+	// several areas at once, devices which present the whole frame on
+	// every update should override this and present only once
+	virtual void update(const PPRect* rects, pp_int32 numRects)
+	{
+		for (pp_int32 i = 0; i < numRects; i++)
+			update(rects[i]);
+	}
+
 	virtual void setSize(const PPSize& size) { this->size = size; }
 	virtual const PPSize& getSize() const { return this->size; }
 
@@ -1585,6 +1585,10 @@ PPFont::PPFont(pp_uint8* bits, const pp_uint32 chrWidth, const pp_uint32 chrHeig
 
 	bitstream = new Bitstream(fontBits, 0);
 
+	glyphSpans = NULL;
+	glyphRows = new pp_uint32[256*chrHeight+1];
+	buildGlyphSpans();
+
 	this->fontId = fontId;
 
 	fontInstances[numFontInstances++] = this;
@@ -1592,9 +1596,63 @@ PPFont::PPFont(pp_uint8* bits, const pp_uint32 chrWidth, const pp_uint32 chrHeig
 
 PPFont::~PPFont()
 {
+	delete[] glyphRows;
+	delete[] glyphSpans;
 	delete bitstream;
 }
 
+void PPFont::buildGlyphSpans()
+{
+	const pp_uint32 numRows = 256*charHeight;
+
+	// count the runs first
+	pp_uint32 numSpans = 0;
+	pp_uint32 offset = 0;
+	for (pp_uint32 row = 0; row < numRows; row++)
+	{
+		bool last = false;
+		for (pp_uint32 x = 0; x < charWidth; x++, offset++)
+		{
+			const bool bit = bitstream->read(offset);
+			if (bit && !last)
+				numSpans++;
+			last = bit;
+		}
+	}
+
+	delete[] glyphSpans;
+	glyphSpans = new Span[numSpans ? numSpans : 1];
+
+	numSpans = 0;
+	offset = 0;
+	for (pp_uint32 row = 0; row < numRows; row++)
+	{
+		glyphRows[row] = numSpans;
+
+		pp_uint32 x = 0;
+		while (x < charWidth)
+		{
+			if (!bitstream->read(offset+x))
+			{
+				x++;
+				continue;
+			}
+
+			const pp_uint32 start = x;
+			while (x < charWidth && bitstream->read(offset+x))
+				x++;
+
+			glyphSpans[numSpans].start = (pp_uint8)start;
+			glyphSpans[numSpans].length = (pp_uint8)(x - start);
+			numSpans++;
+		}
+
+		offset+=charWidth;
+	}
+
+	glyphRows[numRows] = numSpans;
+}
+
 PPFont* PPFont::getFont(pp_uint32 fontId)
 {
 	pp_uint32 i;
@@ -1770,6 +1828,8 @@ void PPFont::selectFontFace(FontID fontID, const char* faceName)
 				fontInstances[j]->fontBits = (pp_uint8*)fontEntries[i].data;
 				fontInstances[j]->bitstream->setSource(fontInstances[j]->fontBits, fontEntries[i].width*fontEntries[i].height / 8);
 			}
+			
+			fontInstances[j]->buildGlyphSpans();
 		}
 }
 
@@ -114,6 +114,22 @@ private:
 	
 	static void createLargeFromSystem(pp_uint32 index);
 
+public:
+	// horizontal run of set pixels within a glyph row
+	struct Span
+	{
+		pp_uint8 start, length;
+	};
+
+private:
+	// glyphs expanded into runs, so they can be drawn without looking at
+	// every single bit. The runs of row y of glyph chr are
+	// glyphSpans[glyphRows[chr*charHeight+y]] up to glyphSpans[glyphRows[chr*charHeight+y+1]]
+	Span* glyphSpans;
+	pp_uint32* glyphRows;
+
+	void buildGlyphSpans();
+
 public:
 
 	pp_uint8* fontBits;
@@ -132,6 +148,10 @@ public:
 
 	bool getPixelBit(pp_uint8 chr, pp_uint32 x, pp_uint32 y) const { return bitstream->read(chr*charDim+y*charWidth+x); }
 
+	const Span* getGlyphSpans() const { return glyphSpans; }
+	// charHeight+1 indices into getGlyphSpans(), one per row plus the end of the last one
+	const pp_uint32* getGlyphRows(pp_uint8 chr) const { return glyphRows + chr*charHeight; }
+
 	pp_uint32 getStrWidth(const char* str) const;
 	
 	enum ShrinkTypes
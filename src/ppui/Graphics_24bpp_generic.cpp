@@ -309,95 +309,67 @@ void PPGraphics_24bpp_generic::blit(const pp_uint8* src, const PPPoint& p, const
 
 void PPGraphics_24bpp_generic::drawChar(pp_uint8 chr, pp_int32 x, pp_int32 y, bool underlined)
 {
-
 	if (currentFont == NULL)
 		return;
 
+	const pp_int32 charWidth = (signed)currentFont->getCharWidth();
+	const pp_int32 charHeight = (signed)currentFont->getCharHeight(); 
 
-	pp_int32 charWidth = (signed)currentFont->getCharWidth();
-	pp_int32 charHeight = (signed)currentFont->getCharHeight(); 
-	pp_int32 charDim = currentFont->charDim;
-
-	if (x + (signed)charWidth < currentClipRect.x1 ||
+	if (x + charWidth < currentClipRect.x1 ||
 		x > currentClipRect.x2 ||
-		y + (signed)charHeight < currentClipRect.y1 ||
+		y + charHeight < currentClipRect.y1 ||
 		y > currentClipRect.y2)
 		return;
-	
+
 	const pp_uint32 rgb = (currentColor.r << bitPosR) + 
 		(currentColor.g << bitPosG) +
 		(currentColor.b << bitPosB);
 
-	Bitstream* bitstream = currentFont->bitstream;
-	pp_uint8* fontbuffer = bitstream->buffer;
-
-	pp_uint8* buff = (pp_uint8*)buffer + y*pitch + x*BPP;
-	pp_uint32 cchrDim = chr*charDim;
-
-	if (x>= currentClipRect.x1 && x + charWidth < currentClipRect.x2 &&
-		y>= currentClipRect.y1 && y + charHeight < currentClipRect.y2)
-	{
-		
-		pp_uint32 yChr = cchrDim;
-		for (pp_uint32 i = 0; i < (unsigned)charHeight; i++)
-		{
-			pp_uint32 xChr = yChr;
-			for (pp_uint32 j = 0; j < (unsigned)charWidth; j++)
-			{
-				if ((fontbuffer[xChr>>3]>>(xChr&7)&1))
-				{
-#ifndef __ppc__
-					buff[0] = rgb & 255;
-					buff[1] = (rgb >> 8) & 255;
-					buff[2] = (rgb >> 16) & 255;		
-#else
-					buff[0] = (rgb >> 16) & 255;
-					buff[1] = (rgb >> 8) & 255;
-					buff[2] = rgb & 255;		
-#endif		
-				}
-				buff+=BPP;
-				xChr++;
-			}
-			buff+=pitch-(charWidth*BPP);
-			yChr+=charWidth;
-		}
-	}
-	else
+	// clip rect relative to the character
+	const pp_int32 cx1 = currentClipRect.x1 - x;
+	const pp_int32 cx2 = currentClipRect.x2 - x;
+	pp_int32 cy1 = currentClipRect.y1 - y;
+	pp_int32 cy2 = currentClipRect.y2 - y;
+	if (cy1 < 0)
+		cy1 = 0;
+	if (cy2 > charHeight)
+		cy2 = charHeight;
+
+	// fill the runs of set pixels of every row instead of testing each bit
+	const PPFont::Span* spans = currentFont->getGlyphSpans();
+	const pp_uint32* rows = currentFont->getGlyphRows(chr);
+
+	for (pp_int32 i = cy1; i < cy2; i++)
 	{
-		pp_uint32 yChr = cchrDim;
-		for (pp_uint32 i = 0; i < (unsigned)charHeight; i++)
+		pp_uint8* line = (pp_uint8*)buffer + (y+i)*pitch;
+
+		for (pp_uint32 k = rows[i]; k < rows[i+1]; k++)
 		{
-			pp_uint32 xChr = yChr;
-			for (pp_uint32 j = 0; j < (unsigned)charWidth; j++)
+			pp_int32 start = spans[k].start;
+			pp_int32 end = start + spans[k].length;
+			if (start < cx1)
+				start = cx1;
+			if (end > cx2)
+				end = cx2;
+
+			pp_uint8* dst = line + (x+start)*BPP;
+			for (; start < end; start++, dst+=BPP)
 			{
-				
-				if (y+(signed)i >= currentClipRect.y1 && y+(signed)i < currentClipRect.y2 &&
-					x+(signed)j >= currentClipRect.x1 && x+(signed)j < currentClipRect.x2 &&
-					(fontbuffer[xChr>>3]>>(xChr&7)&1))
-				{					
-					pp_uint8* buff = (pp_uint8*)buffer+((y+i)*pitch+(x+j)*BPP);
 #ifndef __ppc__
-					buff[0] = rgb & 255;
-					buff[1] = (rgb >> 8) & 255;
-					buff[2] = (rgb >> 16) & 255;		
+				dst[0] = rgb & 255;
+				dst[1] = (rgb >> 8) & 255;
+				dst[2] = (rgb >> 16) & 255;		
 #else
-					buff[0] = (rgb >> 16) & 255;
-					buff[1] = (rgb >> 8) & 255;
-					buff[2] = rgb & 255;		
-#endif		
-				}
-				xChr++;
-
+				dst[0] = (rgb >> 16) & 255;
+				dst[1] = (rgb >> 8) & 255;
+				dst[2] = rgb & 255;		
+#endif
 			}
-			yChr+=charWidth;
 		}
-
 	}
 
 	if (underlined)
 		drawHLine(x, x+charWidth, y+charHeight);
-
 }
 
 void PPGraphics_24bpp_generic::drawString(const char* str, pp_int32 x, pp_int32 y, bool underlined/* = false*/)
@@ -250,129 +250,61 @@ void PPGraphics_BGR24_SLOW::blit(const pp_uint8* src, const PPPoint& p, const PP
 
 void PPGraphics_BGR24_SLOW::drawChar(pp_uint8 chr, pp_int32 x, pp_int32 y, bool underlined)
 {
-
 	if (currentFont == NULL)
 		return;
 
+	const pp_int32 charWidth = (signed)currentFont->getCharWidth();
+	const pp_int32 charHeight = (signed)currentFont->getCharHeight(); 
 
-	pp_int32 charWidth = (signed)currentFont->getCharWidth();
-	pp_int32 charHeight = (signed)currentFont->getCharHeight(); 
-	pp_int32 charDim = currentFont->charDim;
-
-	if (x + (signed)charWidth < currentClipRect.x1 ||
+	if (x + charWidth < currentClipRect.x1 ||
 		x > currentClipRect.x2 ||
-		y + (signed)charHeight < currentClipRect.y1 ||
+		y + charHeight < currentClipRect.y1 ||
 		y > currentClipRect.y2)
 		return;
-	
-	/*pp_uint8 r = (pp_uint8)currentColor.r;
-	pp_uint8 g = (pp_uint8)currentColor.g;
-	pp_uint8 b = (pp_uint8)currentColor.b;
 
-	if (x>= currentClipRect.x1 && x + (signed)currentFont->charWidth < currentClipRect.x2 &&
-		y>= currentClipRect.y1 && y + (signed)currentFont->charHeight < currentClipRect.y2)
+	const pp_uint8 r = (pp_uint8)currentColor.r;
+	const pp_uint8 g = (pp_uint8)currentColor.g;
+	const pp_uint8 b = (pp_uint8)currentColor.b;
+
+	// clip rect relative to the character
+	const pp_int32 cx1 = currentClipRect.x1 - x;
+	const pp_int32 cx2 = currentClipRect.x2 - x;
+	pp_int32 cy1 = currentClipRect.y1 - y;
+	pp_int32 cy2 = currentClipRect.y2 - y;
+	if (cy1 < 0)
+		cy1 = 0;
+	if (cy2 > charHeight)
+		cy2 = charHeight;
+
+	// fill the runs of set pixels of every row instead of testing each bit
+	const PPFont::Span* spans = currentFont->getGlyphSpans();
+	const pp_uint32* rows = currentFont->getGlyphRows(chr);
+
+	for (pp_int32 i = cy1; i < cy2; i++)
 	{
-		for (pp_uint32 i = 0; i < currentFont->charHeight; i++)
-		{
-			pp_uint8* buff = (pp_uint8*)buffer + (y+i)*pitch + x*3;
-			for (pp_uint32 j = 0; j < currentFont->charWidth; j++)
-			{
-				
-				if (currentFont->getPixelBit(chr, j,i))
-				{
-					buff[0] = b;
-					buff[1] = g;
-					buff[2] = r;					
-				}
-				buff+=3;
-			}
-		}
-	}
-	else
-	{
-		for (pp_uint32 i = 0; i < currentFont->charHeight; i++)
-			for (pp_uint32 j = 0; j < currentFont->charWidth; j++)
-			{
-				
-				if (y+(signed)i >= currentClipRect.y1 && y+(signed)i < currentClipRect.y2 &&
-					x+(signed)j >= currentClipRect.x1 && x+(signed)j < currentClipRect.x2 &&
-					currentFont->getPixelBit(chr, j,i))
-				{
-					
-					pp_uint8* buff = (pp_uint8*)buffer+((y+i)*pitch+(x+j)*3);
-					
-					buff[0] = b;
-					buff[1] = g;
-					buff[2] = r;
-					
-				}
-			}
+		pp_uint8* line = (pp_uint8*)buffer + (y+i)*pitch;
 
-	}*/
-	pp_uint8 r = (pp_uint8)currentColor.r;
-	pp_uint8 g = (pp_uint8)currentColor.g;
-	pp_uint8 b = (pp_uint8)currentColor.b;
-
-	Bitstream* bitstream = currentFont->bitstream;
-	pp_uint8* fontbuffer = bitstream->buffer;
-
-	pp_uint8* buff = (pp_uint8*)buffer + y*pitch + x*BPP;
-	pp_uint32 cchrDim = chr*charDim;
-
-	if (x>= currentClipRect.x1 && x + charWidth < currentClipRect.x2 &&
-		y>= currentClipRect.y1 && y + charHeight < currentClipRect.y2)
-	{
-		
-		pp_uint32 yChr = cchrDim;
-		for (pp_uint32 i = 0; i < (unsigned)charHeight; i++)
-		{
-			pp_uint32 xChr = yChr;
-			for (pp_uint32 j = 0; j < (unsigned)charWidth; j++)
-			{
-				if ((fontbuffer[xChr>>3]>>(xChr&7)&1))
-				{
-					buff[0] = b;
-					buff[1] = g;
-					buff[2] = r;
-				}
-				buff+=BPP;
-				xChr++;
-			}
-			buff+=pitch-(charWidth*BPP);
-			yChr+=charWidth;
-		}
-	}
-	else
-	{
-		pp_uint32 yChr = cchrDim;
-		for (pp_uint32 i = 0; i < (unsigned)charHeight; i++)
+		for (pp_uint32 k = rows[i]; k < rows[i+1]; k++)
 		{
-			pp_uint32 xChr = yChr;
-			for (pp_uint32 j = 0; j < (unsigned)charWidth; j++)
+			pp_int32 start = spans[k].start;
+			pp_int32 end = start + spans[k].length;
+			if (start < cx1)
+				start = cx1;
+			if (end > cx2)
+				end = cx2;
+
+			pp_uint8* dst = line + (x+start)*BPP;
+			for (; start < end; start++, dst+=BPP)
 			{
-				
-				if (y+(signed)i >= currentClipRect.y1 && y+(signed)i < currentClipRect.y2 &&
-					x+(signed)j >= currentClipRect.x1 && x+(signed)j < currentClipRect.x2 &&
-					(fontbuffer[xChr>>3]>>(xChr&7)&1))
-				{
-					
-					pp_uint8* buff = (pp_uint8*)buffer+((y+i)*pitch+(x+j)*BPP);
-					
-					buff[0] = b;
-					buff[1] = g;
-					buff[2] = r;
-				}
-				xChr++;
-
+				dst[0] = b;
+				dst[1] = g;
+				dst[2] = r;
 			}
-			yChr+=charWidth;
 		}
-
 	}
 
 	if (underlined)
 		drawHLine(x, x+charWidth, y+charHeight);
-
 }
 
 void PPGraphics_BGR24_SLOW::drawString(const char* str, pp_int32 x, pp_int32 y, bool underlined/* = false*/)
@@ -56,8 +56,14 @@ PPScreen::PPScreen(PPDisplayDeviceBase* displayDevice, EventListenerInterface* e
 	modalControl(NULL),
 	showDragHilite(false),
 	rootContainer(NULL),
-	lastMouseOverControl(NULL)
+	lastMouseOverControl(NULL),
+	deferredUpdates(false),
+	numDirtyRects(0),
+	frameInterval(16),
+	lastFrameTime(0)
 {
+	resetFrameStatistics();
+
 	contextMenuControls = new PPSimpleVector<PPControl>(16, false);
 	timerEventControls = new PPSimpleVector<PPControl>(16, false);
 	
@@ -253,7 +259,7 @@ void PPScreen::clear()
 	g->fill();
 
 	displayDevice->close();		
-	displayDevice->update();
+	updateDisplay();
 }
 
 void PPScreen::paint(bool update/*= true*/, bool clean/*=false*/)
@@ -332,7 +338,7 @@ void PPScreen::paint(bool update/*= true*/, bool clean/*=false*/)
 	displayDevice->close();
 	
 	if (update)
-		displayDevice->update();
+		updateDisplay();
 }
 
 void PPScreen::paintContextMenuControl(PPControl* control, bool update/* = true*/)
@@ -372,7 +378,7 @@ void PPScreen::paintContextMenuControl(PPControl* control, bool update/* = true*
 		rect.y2++;
 		if (rect.y2 > getHeight()) rect.y2 = getHeight();
 		
-		displayDevice->update(rect);
+		updateDisplay(rect);
 	}
 
 }
@@ -470,7 +476,7 @@ void PPScreen::paintSplash(const pp_uint8* rawData, pp_uint32 width, pp_uint32 h
 
 	displayDevice->close();
 	
-	displayDevice->update();	
+	updateDisplay();	
 }
 
 void PPScreen::update()
@@ -483,7 +489,7 @@ void PPScreen::update()
 			paintDragHighlite(g);		
 			displayDevice->close();
 		}
-		displayDevice->update(); 
+		updateDisplay(); 
 	}
 }
 
@@ -501,7 +507,155 @@ void PPScreen::updateControl(PPControl* control)
 	rect.y2++;
 	if (rect.y2 > getHeight()) rect.y2 = getHeight();
 	
-	displayDevice->update(rect);
+	updateDisplay(rect);
+}
+
+void PPScreen::updateDisplay()
+{
+	if (!deferredUpdates)
+	{
+		displayDevice->update();
+		return;
+	}
+
+	updateDisplay(PPRect(0, 0, getWidth(), getHeight()));
+}
+
+void PPScreen::updateDisplay(const PPRect& rect)
+{
+	if (!deferredUpdates)
+	{
+		displayDevice->update(rect);
+		return;
+	}
+
+	// the device would have dropped it anyway
+	if (!displayDevice->isUpdateAllowed() || !displayDevice->isEnabled())
+		return;
+
+	addDirtyRect(rect);
+
+	frameStatistics.numUpdateRequests++;
+}
+
+static inline void mergeRect(PPRect& dst, const PPRect& src)
+{
+	if (src.x1 < dst.x1) dst.x1 = src.x1;
+	if (src.y1 < dst.y1) dst.y1 = src.y1;
+	if (src.x2 > dst.x2) dst.x2 = src.x2;
+	if (src.y2 > dst.y2) dst.y2 = src.y2;
+}
+
+static inline bool touches(const PPRect& r1, const PPRect& r2)
+{
+	return r1.x1 <= r2.x2 && r2.x1 <= r1.x2 && r1.y1 <= r2.y2 && r2.y1 <= r1.y2;
+}
+
+void PPScreen::addDirtyRect(const PPRect& rect)
+{
+	if (rect.x1 >= rect.x2 || rect.y1 >= rect.y2)
+		return;
+
+	PPRect r(rect);
+
+	// swallow every rect which overlaps the new one, the merged rect
+	// might overlap rects which have been checked already, so start over
+	pp_int32 i = 0;
+	while (i < numDirtyRects)
+	{
+		if (touches(r, dirtyRects[i]))
+		{
+			mergeRect(r, dirtyRects[i]);
+			dirtyRects[i] = dirtyRects[--numDirtyRects];
+			i = 0;
+		}
+		else
+			i++;
+	}
+
+	if (numDirtyRects < MaxDirtyRects)
+	{
+		dirtyRects[numDirtyRects++] = r;
+		return;
+	}
+
+	// out of rects, merge with the one which grows the least
+	pp_int32 best = 0;
+	pp_int32 bestGrowth = 0x7FFFFFFF;
+	for (i = 0; i < numDirtyRects; i++)
+	{
+		PPRect merged(dirtyRects[i]);
+		mergeRect(merged, r);
+		const pp_int32 growth = merged.width()*merged.height() - dirtyRects[i].width()*dirtyRects[i].height();
+		if (growth < bestGrowth)
+		{
+			best = i;
+			bestGrowth = growth;
+		}
+	}
+
+	mergeRect(r, dirtyRects[best]);
+	dirtyRects[best] = dirtyRects[--numDirtyRects];
+	addDirtyRect(r);
+}
+
+void PPScreen::setDeferredUpdates(bool deferredUpdates)
+{
+	if (!deferredUpdates)
+		flushUpdates();
+
+	this->deferredUpdates = deferredUpdates;
+}
+
+void PPScreen::flushUpdates(bool force/* = true*/)
+{
+	if (!numDirtyRects || displayDevice == NULL)
+		return;
+
+	const pp_uint32 time = ::PPGetTickCount();
+
+	if (!force && time - lastFrameTime < frameInterval)
+		return;
+
+	// keep the rects until the device accepts updates again
+	if (!displayDevice->isUpdateAllowed() || !displayDevice->isEnabled())
+		return;
+
+	pp_uint32 numPixels = 0;
+	for (pp_int32 i = 0; i < numDirtyRects; i++)
+		numPixels+=dirtyRects[i].width() * dirtyRects[i].height();
+
+	const PPRect& first = dirtyRects[0];
+	if (numDirtyRects == 1 && 
+		first.x1 <= 0 && first.y1 <= 0 && first.x2 >= getWidth() && first.y2 >= getHeight())
+		displayDevice->update();
+	else if (numDirtyRects == 1)
+		displayDevice->update(first);
+	else
+		displayDevice->update(dirtyRects, numDirtyRects);
+
+	numDirtyRects = 0;
+
+	const pp_uint32 updateTime = ::PPGetTickCount() - time;
+
+	frameStatistics.numFrames++;
+	frameStatistics.lastFramePixels = numPixels;
+	frameStatistics.totalUpdateTime+=updateTime;
+	if (updateTime > frameStatistics.maxUpdateTime)
+		frameStatistics.maxUpdateTime = updateTime;
+	frameStatistics.lastFrameInterval = time - lastFrameTime;
+
+	lastFrameTime = time;
+}
+
+void PPScreen::resetFrameStatistics()
+{
+	frameStatistics.numFrames = 0;
+	frameStatistics.numUpdateRequests = 0;
+	frameStatistics.lastFramePixels = 0;
+	frameStatistics.totalUpdateTime = 0;
+	frameStatistics.maxUpdateTime = 0;
+	frameStatistics.lastFrameInterval = 0;
 }
 
 void PPScreen::setFocus(PPControl* control, bool repaint/* = true*/)
@@ -838,6 +992,9 @@ PPSize PPScreen::getDisplayResolution() const
 
 void PPScreen::signalWaitState(bool b, const PPColor& color)
 {
+	// whatever has been painted before waiting should be visible
+	flushUpdates();
+
 	if (displayDevice)
 		displayDevice->signalWaitState(b, color);
 }
@@ -49,6 +49,22 @@ class GraphicsAbstract;
 
 class PPScreen : public PPObject
 {
+public:
+	struct FrameStatistics
+	{
+		// frames which have been pushed to the display device
+		pp_uint32 numFrames;
+		// update requests which went into those frames
+		pp_uint32 numUpdateRequests;
+		// number of pixels updated by the last frame
+		pp_uint32 lastFramePixels;
+		// time spent in the display device to push the frames, in ms
+		pp_uint32 totalUpdateTime;
+		pp_uint32 maxUpdateTime;
+		// time between the last two frames, in ms
+		pp_uint32 lastFrameInterval;
+	};
+
 protected:
 	PPDisplayDeviceBase* displayDevice;
 
@@ -73,8 +89,26 @@ private:
 	PPPoint lastMousePoint;
 	PPControl* lastMouseOverControl;
 	
+	// updates are collected into a few rects and pushed to the
+	// display device once per frame, when deferred updates are enabled
+	enum
+	{
+		MaxDirtyRects = 8
+	};
+
+	bool deferredUpdates;
+	PPRect dirtyRects[MaxDirtyRects];
+	pp_int32 numDirtyRects;
+	pp_uint32 frameInterval;
+	pp_uint32 lastFrameTime;
+	FrameStatistics frameStatistics;
+	
 	void paintDragHighlite(PPGraphicsAbstract* g);
 
+	void updateDisplay();
+	void updateDisplay(const PPRect& rect);
+	void addDirtyRect(const PPRect& rect);
+
 	void adjustEventMouseCoordinates(PPEvent* event);
 
 public:
@@ -96,6 +130,19 @@ public:
 	void update();
 	void updateControl(PPControl* control);
 	
+	// painting still happens right away, but the display device is only
+	// updated by flushUpdates, so everything painted in between goes out in one go
+	void setDeferredUpdates(bool deferredUpdates);
+	bool hasDeferredUpdates() const { return deferredUpdates; }
+	// minimum time between two frames in ms, for unforced flushes
+	void setFrameInterval(pp_uint32 frameInterval) { this->frameInterval = frameInterval; }
+	// push the area painted since the last frame to the display device,
+	// if force is false only when the frame interval has passed
+	void flushUpdates(bool force = true);
+
+	const FrameStatistics& getFrameStatistics() const { return frameStatistics; }
+	void resetFrameStatistics();
+
 	void pauseUpdate(bool pause);
 	void enableDisplay(bool enable);
 	bool isDisplayEnabled();
@@ -205,6 +205,37 @@ public:
 		return m_pUndoStack[m_nCurIndex+1];
 	}
 
+	//---------------------------------------------------------------------------
+	// Pre     : 
+	// Post    : 
+	// Globals : 
+	// I/O     : 
+	// Task    : Remove bottom entry, the entry for the next undo is always kept
+	//---------------------------------------------------------------------------
+	bool RemoveBottom()
+	{
+		if (m_nCurIndex <= 0)
+			return false;
+		
+		delete m_pUndoStack[0];
+		
+		// move references
+		for (pp_int32 i = 0; i < m_nStackSize; i++)
+			m_pUndoStack[i] = m_pUndoStack[i+1];
+		m_pUndoStack[m_nStackSize] = NULL;
+		
+		m_nCurIndex--;
+		m_nTopIndex--;
+		
+		m_bOverflow = true;
+		return true;
+	}
+
+	// entries which can be reached by undo and redo, 0 is the bottom
+	pp_int32 GetNumEntries() const { return m_pUndoStack[0] ? m_nTopIndex+1 : 0; }
+
+	const type* GetEntry(pp_int32 index) const { return m_pUndoStack[index]; }
+
 	bool IsEmpty() const { return (m_nCurIndex == -1); }
 
 	bool IsTop() const { return ((m_nTopIndex-1)==m_nCurIndex); }
@@ -122,6 +122,13 @@ PPModalDialog::ReturnCodes SDL_runModalLoop(PPScreen* screen, PPDialogBase* dial
 				processSDLEvents(event);
 				break;
 		}
+
+		// see main event loop
+		if (globalMutex)
+			globalMutex->lock();
+		screen->flushUpdates(!SDL_HasEvents(SDL_FIRSTEVENT, SDL_LASTEVENT));
+		if (globalMutex)
+			globalMutex->unlock();
 	}	
 
 	// pretend nothing happened at all, continue with main event loop after we're finished here
@@ -235,6 +235,34 @@ void PPDisplayDeviceFB::update(const PPRect& r)
 		return;
 	}
 
+	updateTexture(r);
+	
+	SDL_RenderClear(theRenderer);
+	SDL_RenderCopy(theRenderer, theTexture, NULL, NULL);
+	SDL_RenderPresent(theRenderer);
+}
+
+void PPDisplayDeviceFB::update(const PPRect* rects, pp_int32 numRects)
+{
+	if (!isUpdateAllowed() || !isEnabled())
+		return;
+	
+	if (theSurface->locked)
+	{
+		return;
+	}
+
+	// Upload every dirty area but present only once
+	for (pp_int32 i = 0; i < numRects; i++)
+		updateTexture(rects[i]);
+
+	SDL_RenderClear(theRenderer);
+	SDL_RenderCopy(theRenderer, theTexture, NULL, NULL);
+	SDL_RenderPresent(theRenderer);
+}
+
+void PPDisplayDeviceFB::updateTexture(const PPRect& r)
+{
 	swap(r);
 	
 	PPRect r2(r);
@@ -247,11 +275,8 @@ void PPDisplayDeviceFB::update(const PPRect& r)
 	// Calculate destination pixel data offset based on row pitch and x coordinate
 	void* surfaceOffset = (char*) theSurface->pixels + r2.y1 * theSurface->pitch + r2.x1 * theSurface->format->BytesPerPixel;
 	
-	// Update dirty area of texture and copy to renderer
+	// Update dirty area of texture
 	SDL_UpdateTexture(theTexture, &r3, surfaceOffset, theSurface->pitch);
-	SDL_RenderClear(theRenderer);
-	SDL_RenderCopy(theRenderer, theTexture, NULL, NULL);
-	SDL_RenderPresent(theRenderer);
 }
 
 void PPDisplayDeviceFB::swap(const PPRect& r2)
@@ -42,6 +42,8 @@ private:
 	
 	// used for rotating coordinates etc.
 	void swap(const PPRect& r);
+	// copy an area of the surface into the texture, without presenting it
+	void updateTexture(const PPRect& r);
 
 public:
 	PPDisplayDeviceFB(pp_int32 width,
@@ -62,6 +64,7 @@ public:
 
 	void update();
 	void update(const PPRect& r);
+	void update(const PPRect* rects, pp_int32 numRects);
 protected:
 	SDL_Surface* theSurface;
 	SDL_Texture* theTexture;
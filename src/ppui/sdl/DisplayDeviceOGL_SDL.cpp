@@ -124,4 +124,9 @@ void PPDisplayDeviceOGL::update(const PPRect& r)
 	update();
 }
 
+void PPDisplayDeviceOGL::update(const PPRect* rects, pp_int32 numRects)
+{
+	update();
+}
+
 #endif
@@ -48,6 +48,7 @@ public:
 
 	void update();
 	void update(const PPRect& r);
+	void update(const PPRect* rects, pp_int32 numRects);
 protected:
 	SDL_GLContext glContext;
 };
@@ -0,0 +1,173 @@
+/*
+ *  tools/devicebench.cpp
+ *
+ *  Copyright 2009 The MilkyTracker Team
+ *
+ *  This file is part of Milkytracker.
+ *
+ *  Milkytracker is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Milkytracker is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Milkytracker.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ *  Mixes several songs at the same time, each of them on a player of its
+ *  own which is a device of one MasterMixer, just like the tabs of the
+ *  tracker. Every run is done on the audio thread alone and with the
+ *  devices mixed on a thread pool, the checksums of both must match.
+ *
+ *  usage: devicebench threads seconds module [module ...]
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+#include <vector>
+#include "XModule.h"
+#include "PlayerSTD.h"
+#include "MasterMixer.h"
+#include "MixerThreadPool.h"
+#include "AudioDriver_NULL.h"
+
+enum
+{
+	MIXFREQUENCY = 44100,
+	BUFFERSIZE = 1024
+};
+
+static double getTime()
+{
+	timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec * (1.0 / 1000000.0);
+}
+
+// the NULL driver with a checksum of everything that has been mixed
+class AudioDriver_Checksum : public AudioDriver_NULL
+{
+public:
+	mp_uint32 checksum;
+
+	AudioDriver_Checksum() :
+		checksum(0)
+	{
+	}
+
+	virtual void advance()
+	{
+		AudioDriver_NULL::advance();
+		for (mp_sint32 i = 0; i < bufferSize; i++)
+			checksum = checksum*31 + (mp_uword)compensateBuffer[i];
+	}
+};
+
+static mp_uint32 play(std::vector<XModule*>& modules, MixerThreadPool* threadPool, double seconds,
+					  double& time, std::vector<double>& deviceTimes)
+{
+	const mp_uint32 numDevices = modules.size();
+
+	AudioDriver_Checksum driver;
+
+	MasterMixer mixer(MIXFREQUENCY, BUFFERSIZE, numDevices, &driver);
+	mixer.setSampleShift(1);
+	mixer.setThreadPool(threadPool);
+
+	std::vector<PlayerSTD*> players;
+	for (mp_uint32 i = 0; i < numDevices; i++)
+	{
+		PlayerSTD* player = new PlayerSTD(MIXFREQUENCY);
+		player->setBufferSize(BUFFERSIZE);
+		player->setResamplerType(ChannelMixer::MIXER_LAGRANGE_RAMPING);
+		// the players share the pool with the mixer like in the tracker
+		player->setThreadPool(threadPool, 0);
+		player->startPlaying(modules[i], true);
+		mixer.addDevice(player);
+		players.push_back(player);
+	}
+
+	mixer.start();
+
+	deviceTimes.assign(numDevices, 0.0);
+
+	const mp_uint32 numBuffers = (mp_uint32)(seconds * MIXFREQUENCY / BUFFERSIZE);
+	const double start = getTime();
+	for (mp_uint32 i = 0; i < numBuffers; i++)
+	{
+		driver.advance();
+		for (mp_uint32 j = 0; j < numDevices; j++)
+			deviceTimes[j]+=mixer.getDeviceMixTime(players[j]);
+	}
+	time = getTime() - start;
+
+	mixer.stop();
+	mixer.closeAudioDevice();
+
+	for (mp_uint32 i = 0; i < numDevices; i++)
+	{
+		mixer.removeDevice(players[i]);
+		players[i]->stopPlaying();
+		delete players[i];
+		deviceTimes[i]/=numBuffers ? numBuffers : 1;
+	}
+
+	return driver.checksum;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 4)
+	{
+		fprintf(stderr, "usage: %s threads seconds module [module ...]\n", argv[0]);
+		return 1;
+	}
+
+	const mp_uint32 numThreads = atoi(argv[1]);
+	const double seconds = atof(argv[2]);
+
+	std::vector<XModule*> modules;
+	for (mp_sint32 i = 3; i < argc; i++)
+	{
+		XModule* module = new XModule();
+		if (module->loadModule(argv[i]) != MP_OK)
+		{
+			fprintf(stderr, "%s: can't load module\n", argv[i]);
+			return 1;
+		}
+		modules.push_back(module);
+	}
+
+	MixerThreadPool threadPool(numThreads);
+
+	printf("%d devices, %.0f seconds\n", (mp_sint32)modules.size(), seconds);
+	printf("%-10s %10s %10s  %s\n", "threads", "ms", "checksum", "us per buffer and device");
+
+	for (mp_uint32 run = 0; run < 2; run++)
+	{
+		MixerThreadPool* pool = run ? &threadPool : NULL;
+
+		double time;
+		std::vector<double> deviceTimes;
+		const mp_uint32 checksum = play(modules, pool, seconds, time, deviceTimes);
+
+		printf("%-10d %10.1f %10x ", pool ? pool->getNumThreads() : 1, time * 1000.0, checksum);
+		for (mp_uint32 i = 0; i < deviceTimes.size(); i++)
+			printf(" %.0f", deviceTimes[i]);
+		printf("\n");
+	}
+
+	for (mp_uint32 i = 0; i < modules.size(); i++)
+		delete modules[i];
+
+	return 0;
+}
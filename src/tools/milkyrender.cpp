@@ -0,0 +1,540 @@
+/*
+ *  tools/milkyrender.cpp
+ *
+ *  Copyright 2009 The MilkyTracker Team
+ *
+ *  This file is part of Milkytracker.
+ *
+ *  Milkytracker is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Milkytracker is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Milkytracker.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ *  Renders modules to WAV files without any of the tracker front end.
+ *  Modules can be given as files or directories (searched recursively).
+ *  Every worker thread owns a PlayerGeneric and keeps taking the next
+ *  module off a shared list until the list is empty, the largest files
+ *  are handed out first so the last ones to finish are short.
+ *
+ *  usage: milkyrender [options] module|directory ...
+ *  see printUsage for the options
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <sys/time.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "MilkyPlay.h"
+#include "MilkyPlayAtomic.h"
+#include "AudioDriver_WAVWriter.h"
+#include "MixerThreadPool.h"
+#include "PlayerSTD.h"
+#include "PlayerFAR.h"
+#include "PPPathFactory.h"
+#include "PPPath.h"
+
+static double getTime()
+{
+	timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec * (1.0 / 1000000.0);
+}
+
+// resampler names in the order of ChannelMixer::ResamplerTypes,
+// each of them comes without and with volume ramping
+static const char* resamplerNames[] =
+{
+	"none", "linear", "lagrange", "spline", "sinctable", "sinc",
+	"amiga500", "amiga500led", "amiga1200", "amiga1200led", "polyphase"
+};
+
+struct Options
+{
+	std::string outputPath;
+	mp_sint32 sampleRate;
+	ChannelMixer::ResamplerTypes resamplerType;
+	mp_sint32 startOrder;
+	mp_sint32 endOrder;
+	mp_ubyte muting[256];
+	bool stems;
+	bool floatOutput;
+	mp_sint32 mixerShift;
+	mp_sint32 mixerVolume;
+	mp_uint32 numThreads;
+
+	Options() :
+		sampleRate(44100),
+		resamplerType(ChannelMixer::MIXER_LERPING_RAMPING),
+		startOrder(0),
+		endOrder(-1),
+		stems(false),
+		floatOutput(false),
+		mixerShift(1),
+		mixerVolume(256),
+		numThreads(0)
+	{
+		memset(muting, 0, sizeof(muting));
+	}
+};
+
+struct ModuleFile
+{
+	std::string fileName;
+	mp_uint32 size;
+
+	bool operator<(const ModuleFile& other) const { return size > other.size; }
+};
+
+class RenderJob : public MixerThreadPool::Job
+{
+private:
+	const Options& options;
+	const std::vector<ModuleFile>& files;
+	std::vector<PlayerGeneric*> players;
+	volatile mp_sint32 nextFile;
+
+	std::string getOutputName(const std::string& fileName, mp_sint32 stem) const
+	{
+		std::string::size_type slash = fileName.find_last_of("/\\");
+		std::string name = fileName.substr(slash == std::string::npos ? 0 : slash + 1);
+		std::string::size_type dot = name.find_last_of('.');
+		if (dot != std::string::npos && dot > 0)
+			name = name.substr(0, dot);
+
+		if (stem >= 0)
+		{
+			char buffer[16];
+			sprintf(buffer, "_%02d", stem + 1);
+			name += buffer;
+		}
+		name += ".wav";
+
+		if (options.outputPath.empty())
+			return (slash == std::string::npos ? std::string() : fileName.substr(0, slash + 1)) + name;
+
+		return options.outputPath + "/" + name;
+	}
+
+	void formatPeak(char* peakString, float peak) const
+	{
+		if (peak == 0.0f)
+			strcpy(peakString, "-inf dBFS");
+		else
+			sprintf(peakString, "%.2f dBFS%s", 20.0*log10(peak), peak >= 1.0f && !options.floatOutput ? " (clipped)" : "");
+	}
+
+	void render(PlayerGeneric& player, const ModuleFile& file)
+	{
+		XModule module;
+
+		if (module.loadModule(file.fileName.c_str()) != MP_OK)
+		{
+			fprintf(stderr, "%s: can't load module\n", file.fileName.c_str());
+			mpAtomicAdd(&numFailed, 1);
+			return;
+		}
+
+		const double startTime = getTime();
+		mp_sint32 res;
+		float peak = 0.0f;
+		
+		const mp_uint32 numChannels = module.header.channum;
+		std::vector<std::string> names(numChannels);
+		std::vector<float> peaks(numChannels, 0.0f);
+
+		if (options.stems)
+		{
+			std::vector<const SYSCHAR*> fileNames(numChannels);
+			for (mp_uint32 i = 0; i < numChannels; i++)
+			{
+				names[i] = getOutputName(file.fileName, i);
+				// muted channels don't get a stem
+				fileNames[i] = options.muting[i] ? NULL : names[i].c_str();
+			}
+
+			res = numChannels ? player.exportStemsToWAV(&fileNames[0], &module, options.startOrder, options.endOrder, NULL, &peaks[0]) : 0;
+			
+			// the song as a whole is reported with the loudest stem
+			for (mp_uint32 i = 0; i < numChannels; i++)
+			{
+				if (peaks[i] > peak)
+					peak = peaks[i];
+			}
+		}
+		else
+		{
+			WAVWriter wavWriter(getOutputName(file.fileName, -1).c_str(), options.floatOutput);
+			if (!wavWriter.isOpen())
+				res = MP_DEVICE_ERROR;
+			else
+			{
+				res = player.exportToWAV(NULL, &module, options.startOrder, options.endOrder,
+										 options.muting, module.header.channum, NULL, &wavWriter);
+				peak = wavWriter.getPeak();
+			}
+		}
+
+		const double time = getTime() - startTime;
+
+		if (res < 0)
+		{
+			fprintf(stderr, "%s: can't write output\n", file.fileName.c_str());
+			mpAtomicAdd(&numFailed, 1);
+			return;
+		}
+
+		const double seconds = (double)res / options.sampleRate;
+
+		char peakString[32];
+		formatPeak(peakString, peak);
+
+		printf("%s: %.1fs in %.2fs (%.1fx realtime), peak %s\n", file.fileName.c_str(),
+			   seconds, time, time > 0.0 ? seconds / time : 0.0, peakString);
+		
+		if (options.stems)
+		{
+			for (mp_uint32 i = 0; i < numChannels; i++)
+			{
+				if (options.muting[i])
+					continue;
+				
+				formatPeak(peakString, peaks[i]);
+				printf("%s: peak %s\n", names[i].c_str(), peakString);
+			}
+		}
+
+		mpAtomicAdd(&numRendered, 1);
+		mpAtomicAdd(&numRenderedSeconds, (mp_sint32)(seconds + 0.5));
+	}
+
+public:
+	volatile mp_sint32 numRendered;
+	volatile mp_sint32 numFailed;
+	volatile mp_sint32 numRenderedSeconds;
+
+	RenderJob(const Options& options, const std::vector<ModuleFile>& files, mp_uint32 numWorkers) :
+		options(options),
+		files(files),
+		nextFile(0),
+		numRendered(0),
+		numFailed(0),
+		numRenderedSeconds(0)
+	{
+		for (mp_uint32 i = 0; i < numWorkers; i++)
+		{
+			PlayerGeneric* player = new PlayerGeneric(options.sampleRate);
+			player->setBufferSize(1024);
+			player->setResamplerType(options.resamplerType);
+			player->setSampleShift(options.mixerShift);
+			player->setMasterVolume(options.mixerVolume);
+			player->setPeakAutoAdjust(false);
+			player->setExportFloatOutput(options.floatOutput);
+			players.push_back(player);
+		}
+	}
+
+	virtual ~RenderJob()
+	{
+		for (mp_uint32 i = 0; i < players.size(); i++)
+			delete players[i];
+	}
+
+	virtual void execute(mp_uint32 taskIndex)
+	{
+		PlayerGeneric& player = *players[taskIndex];
+
+		for (;;)
+		{
+			const mp_sint32 index = mpAtomicAdd(&nextFile, 1) - 1;
+			if (index >= (signed)files.size())
+				break;
+
+			render(player, files[index]);
+		}
+	}
+};
+
+static void printUsage()
+{
+	printf("usage: milkyrender [options] module|directory ...\n"
+		   "  -o path     output directory (default: next to the module)\n"
+		   "  -r rate     sample rate (default: 44100)\n"
+		   "  -i name     resampler: ");
+	for (mp_uint32 i = 0; i < sizeof(resamplerNames) / sizeof(const char*); i++)
+		printf("%s%s", i ? ", " : "", resamplerNames[i]);
+	printf(" (default: linear)\n"
+		   "  -n          no volume ramping\n"
+		   "  -b order    first order to render (default: 0)\n"
+		   "  -e order    last order to render (default: end of song)\n"
+		   "  -m list     mute channels, e.g. 1,3,5-8\n"
+		   "  -s          one WAV per channel (stems)\n"
+		   "  -f          32 bit float WAV\n"
+		   "  -a shift    mixer amplification, 0 = 100%%, 1 = 50%%, 2 = 25%% ... (default: 1)\n"
+		   "  -v volume   mixer volume 0-256 (default: 256)\n"
+		   "  -j threads  number of worker threads (default: number of processors)\n");
+}
+
+static bool parseMuting(const char* list, mp_ubyte* muting)
+{
+	while (*list)
+	{
+		char* end;
+		long first = strtol(list, &end, 10);
+		long last = first;
+		if (end == list)
+			return false;
+		if (*end == '-')
+		{
+			list = end + 1;
+			last = strtol(list, &end, 10);
+			if (end == list)
+				return false;
+		}
+		if (first < 1 || last > 256 || first > last)
+			return false;
+		for (long i = first; i <= last; i++)
+			muting[i-1] = 1;
+
+		list = end;
+		if (*list == ',')
+			list++;
+		else if (*list)
+			return false;
+	}
+	return true;
+}
+
+static bool addModule(const std::string& fileName, std::vector<ModuleFile>& files, bool identify)
+{
+	XMFile f(fileName.c_str());
+	if (!f.isOpen())
+	{
+		fprintf(stderr, "%s: can't open file\n", fileName.c_str());
+		return false;
+	}
+
+	// files found in directories are only taken if they look like modules
+	if (identify)
+	{
+		mp_ubyte buffer[XModule::IdentificationBufferSize];
+		memset(buffer, 0, sizeof(buffer));
+		f.read(buffer, 1, sizeof(buffer) < f.size() ? sizeof(buffer) : f.size());
+		if (XModule::identifyModule(buffer) == NULL)
+			return true;
+	}
+
+	ModuleFile file;
+	file.fileName = fileName;
+	file.size = f.size();
+	files.push_back(file);
+	return true;
+}
+
+// PPPath changes the working directory, so everything is made absolute up front
+static std::string makeAbsolute(const std::string& currentPath, const std::string& fileName)
+{
+	if (fileName.empty() || fileName[0] == '/' || fileName[0] == '\\' ||
+		(fileName.size() > 1 && fileName[1] == ':'))
+		return fileName;
+	
+	return currentPath + fileName;
+}
+
+static void addDirectory(const std::string& directory, std::vector<ModuleFile>& files)
+{
+	// unlike createPathFromString, change makes sure there's a trailing separator
+	PPPath* path = PPPathFactory::createPath();
+	if (!path->change(PPSystemString(directory.c_str())))
+	{
+		delete path;
+		return;
+	}
+
+	std::vector<std::string> subDirectories;
+	for (const PPPathEntry* entry = path->getFirstEntry(); entry; entry = path->getNextEntry())
+	{
+		if (entry->isHidden() || entry->isParent())
+			continue;
+
+		char* name = entry->getName().toASCIIZ();
+		std::string fullName = directory + "/" + name;
+		delete[] name;
+
+		if (entry->isDirectory())
+			subDirectories.push_back(fullName);
+		else if (entry->isFile())
+			addModule(fullName, files, true);
+	}
+
+	delete path;
+
+	for (mp_uint32 i = 0; i < subDirectories.size(); i++)
+		addDirectory(subDirectories[i], files);
+}
+
+int main(int argc, char** argv)
+{
+	Options options;
+	std::vector<std::string> inputs;
+	bool ramping = true;
+	mp_sint32 resampler = 1;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const char* arg = argv[i];
+		if (arg[0] != '-' || arg[1] == '\0')
+		{
+			inputs.push_back(arg);
+			continue;
+		}
+
+		// options without value
+		switch (arg[1])
+		{
+			case 'n':
+				ramping = false;
+				continue;
+			case 's':
+				options.stems = true;
+				continue;
+			case 'f':
+				options.floatOutput = true;
+				continue;
+			case 'h':
+				printUsage();
+				return 0;
+		}
+
+		if (i + 1 >= argc)
+		{
+			printUsage();
+			return 1;
+		}
+
+		const char* value = argv[++i];
+		bool valid = true;
+
+		switch (arg[1])
+		{
+			case 'o':
+				options.outputPath = value;
+				break;
+			case 'r':
+				options.sampleRate = atoi(value);
+				valid = options.sampleRate >= 8000 && options.sampleRate <= 192000;
+				break;
+			case 'i':
+				for (resampler = sizeof(resamplerNames) / sizeof(const char*) - 1; resampler >= 0; resampler--)
+					if (strcmp(value, resamplerNames[resampler]) == 0)
+						break;
+				valid = resampler >= 0;
+				break;
+			case 'b':
+				options.startOrder = atoi(value);
+				valid = options.startOrder >= 0;
+				break;
+			case 'e':
+				options.endOrder = atoi(value);
+				break;
+			case 'm':
+				valid = parseMuting(value, options.muting);
+				break;
+			case 'a':
+				options.mixerShift = atoi(value);
+				valid = options.mixerShift >= 0 && options.mixerShift <= 3;
+				break;
+			case 'v':
+				options.mixerVolume = atoi(value);
+				valid = options.mixerVolume >= 0 && options.mixerVolume <= 256;
+				break;
+			case 'j':
+				options.numThreads = atoi(value);
+				break;
+			default:
+				valid = false;
+		}
+
+		if (!valid)
+		{
+			fprintf(stderr, "invalid option %s %s\n", arg, value);
+			printUsage();
+			return 1;
+		}
+	}
+
+	if (inputs.empty())
+	{
+		printUsage();
+		return 1;
+	}
+
+	options.resamplerType = (ChannelMixer::ResamplerTypes)(resampler*2 + (ramping ? 1 : 0));
+
+	PPPath* path = PPPathFactory::createPath();
+	char* currentPath = path->getCurrent().toASCIIZ();
+	const std::string startPath(currentPath);
+	delete[] currentPath;
+
+	if (!options.outputPath.empty())
+		options.outputPath = makeAbsolute(startPath, options.outputPath);
+
+	std::vector<ModuleFile> files;
+	bool missing = false;
+	for (mp_uint32 i = 0; i < inputs.size(); i++)
+	{
+		inputs[i] = makeAbsolute(startPath, inputs[i]);
+		const bool isDirectory = path->change(PPSystemString(inputs[i].c_str()));
+
+		if (isDirectory)
+			addDirectory(inputs[i], files);
+		else if (!addModule(inputs[i], files, false))
+			missing = true;
+	}
+
+	delete path;
+
+	// big modules first, so we don't end up waiting for one of them at the end
+	std::stable_sort(files.begin(), files.end());
+
+	// the first player and resampler instances set up tables that are shared
+	// by all of them, do that before there are any other threads around
+	{
+		PlayerSTD player(options.sampleRate);
+		player.setResamplerType(options.resamplerType);
+		PlayerFAR playerFAR(options.sampleRate);
+	}
+
+	MixerThreadPool threadPool(options.numThreads);
+	mp_uint32 numWorkers = threadPool.getNumThreads();
+	if (numWorkers > files.size())
+		numWorkers = files.size() ? files.size() : 1;
+
+	printf("rendering %d module(s) on %d thread(s)\n", (int)files.size(), (int)numWorkers);
+
+	RenderJob renderJob(options, files, numWorkers);
+
+	const double startTime = getTime();
+	threadPool.run(renderJob, numWorkers);
+	const double time = getTime() - startTime;
+
+	printf("%d rendered, %d failed, %ds of audio in %.2fs (%.1fx realtime)\n",
+		   (int)renderJob.numRendered, (int)renderJob.numFailed, (int)renderJob.numRenderedSeconds,
+		   time, time > 0.0 ? renderJob.numRenderedSeconds / time : 0.0);
+
+	return (renderJob.numFailed || missing) ? 1 : 0;
+}
@@ -0,0 +1,140 @@
+/*
+ *  tools/mixerprofile.cpp
+ *
+ *  Copyright 2009 The MilkyTracker Team
+ *
+ *  This file is part of Milkytracker.
+ *
+ *  Milkytracker is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Milkytracker is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Milkytracker.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ *  Plays songs on the NULL driver with the mixer profiler of the MasterMixer
+ *  turned on, each of them on a player of its own like the tabs of the
+ *  tracker, and prints the load of the audio thread for a couple of buffer
+ *  sizes along with how the time splits up into the stages of the mixing.
+ *  The load is what the tracker shows below the peak meter.
+ *
+ *  usage: mixerprofile seconds module [module ...]
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <vector>
+#include "XModule.h"
+#include "PlayerSTD.h"
+#include "MasterMixer.h"
+#include "MixerProfiler.h"
+#include "AudioDriver_NULL.h"
+
+enum
+{
+	MIXFREQUENCY = 44100
+};
+
+static void play(std::vector<XModule*>& modules, mp_uint32 bufferSize, double seconds)
+{
+	const mp_uint32 numDevices = modules.size();
+
+	AudioDriver_NULL driver;
+
+	MasterMixer mixer(MIXFREQUENCY, bufferSize, numDevices, &driver);
+	mixer.setSampleShift(1);
+
+	std::vector<PlayerSTD*> players;
+	for (mp_uint32 i = 0; i < numDevices; i++)
+	{
+		PlayerSTD* player = new PlayerSTD(MIXFREQUENCY);
+		player->setBufferSize(bufferSize);
+		player->setResamplerType(ChannelMixer::MIXER_LAGRANGE_RAMPING);
+		player->setProfiler(&mixer.getProfiler());
+		player->startPlaying(modules[i], true);
+		mixer.addDevice(player);
+		players.push_back(player);
+	}
+
+	mixer.start();
+
+	// the stats only hold averages which favour the last buffers,
+	// sum up the times of every buffer instead
+	MixerProfiler::Stats stats;
+	double mixTime = 0.0;
+	double stageTimes[MixerProfiler::NumStages] = {0.0};
+
+	const mp_uint32 numBuffers = (mp_uint32)(seconds * MIXFREQUENCY / bufferSize);
+	for (mp_uint32 i = 0; i < numBuffers; i++)
+	{
+		driver.advance();
+		mixer.getProfiler().getStats(stats);
+		mixTime+=stats.mixTime;
+		for (mp_sint32 j = 0; j < MixerProfiler::NumStages; j++)
+			stageTimes[j]+=stats.stageTimes[j];
+	}
+
+	mixer.stop();
+	mixer.closeAudioDevice();
+
+	for (mp_uint32 i = 0; i < numDevices; i++)
+	{
+		mixer.removeDevice(players[i]);
+		players[i]->stopPlaying();
+		delete players[i];
+	}
+
+	const double scale = numBuffers ? 1.0 / numBuffers : 0.0;
+	printf("%-8d %8d %8.0f %8d %6.1f%% %6d%%", bufferSize, stats.bufferTime, mixTime * scale, stats.peakMixTime,
+		   mixTime * scale * 100.0 / stats.bufferTime, stats.getLoad(stats.peakMixTime));
+	for (mp_sint32 j = 0; j < MixerProfiler::NumStages; j++)
+		printf(" %18.1f", stageTimes[j] * scale);
+	printf("\n");
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		fprintf(stderr, "usage: %s seconds module [module ...]\n", argv[0]);
+		return 1;
+	}
+
+	const double seconds = atof(argv[1]);
+
+	std::vector<XModule*> modules;
+	for (mp_sint32 i = 2; i < argc; i++)
+	{
+		XModule* module = new XModule();
+		if (module->loadModule(argv[i]) != MP_OK)
+		{
+			fprintf(stderr, "%s: can't load module\n", argv[i]);
+			return 1;
+		}
+		modules.push_back(module);
+	}
+
+	printf("%d devices, %.0f seconds, times in us\n", (mp_sint32)modules.size(), seconds);
+	printf("%-8s %8s %8s %8s %7s %7s", "buffer", "length", "average", "peak", "load", "peak");
+	for (mp_sint32 j = 0; j < MixerProfiler::NumStages; j++)
+		printf(" %18s", MixerProfiler::getStageName((MixerProfiler::Stages)j));
+	printf("\n");
+
+	static const mp_uint32 bufferSizes[] = {256, 1024, 4096};
+	for (mp_uint32 i = 0; i < sizeof(bufferSizes) / sizeof(mp_uint32); i++)
+		play(modules, bufferSizes[i], seconds);
+
+	for (mp_uint32 i = 0; i < modules.size(); i++)
+		delete modules[i];
+
+	return 0;
+}
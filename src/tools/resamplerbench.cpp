@@ -0,0 +1,228 @@
+/*
+ *  tools/resamplerbench.cpp
+ *
+ *  Copyright 2009 The MilkyTracker Team
+ *
+ *  This file is part of Milkytracker.
+ *
+ *  Milkytracker is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Milkytracker is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Milkytracker.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ *  Micro benchmark for the ChannelMixer resamplers.
+ *  Mixes a bunch of looped 8 and 16 bit channels at different pitches 
+ *  through every resampler type, once with the scalar code and once for 
+ *  every vector instruction set the CPU supports. Reports output frames 
+ *  per second and whether the vector output is identical to the scalar one,
+ *  the version ResamplerFactory picks by default is marked.
+ *  The Amiga resamplers emulate Paula at a fixed rate and are left out.
+ *
+ *  usage: resamplerbench [mixfrequency] [seconds of audio per run]
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+#include "ResamplerFactory.h"
+
+static const char* resamplerNames[] = 
+{
+	"No interpolation",
+	"No interpolation (ramping)",
+	"Linear",
+	"Linear (ramping)",
+	"Lagrange",
+	"Lagrange (ramping)",
+	"Spline",
+	"Spline (ramping)",
+	"Sinc table",
+	"Sinc table (ramping)",
+	"Sinc",
+	"Sinc (ramping)"
+};
+
+enum 
+{
+	NUMCHANNELS = 8,
+	SAMPLELENGTH = 65536,
+	// same padding as TXMSample::allocPaddedMem
+	PADDING = 16
+};
+
+static double getTime()
+{
+	timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec * (1.0 / 1000000.0);
+}
+
+class Sample
+{
+private:
+	mp_ubyte* mem;
+	
+public:
+	mp_sbyte* data;
+
+	Sample(bool is16Bit)
+	{
+		const mp_uint32 bytes = is16Bit ? 2 : 1;
+		mem = new mp_ubyte[(SAMPLELENGTH + PADDING*2) * bytes];
+		data = (mp_sbyte*)(mem + PADDING*bytes);
+		
+		// noise plus some sines, just something with content at all frequencies
+		mp_uint32 seed = 0x1234567;
+		for (mp_sint32 i = -PADDING; i < SAMPLELENGTH + PADDING; i++)
+		{
+			seed = seed * 1664525 + 1013904223;
+			mp_sint32 s = (mp_sint32)(seed >> 17) - 16384;
+			s += ((i * 37) & 0x7FFF) - 16384;
+			if (is16Bit)
+				((mp_sword*)data)[i] = (mp_sword)s;
+			else
+				data[i] = (mp_sbyte)(s >> 8);
+		}
+	}
+	
+	~Sample()
+	{
+		delete[] mem;
+	}
+};
+
+static void setupChannels(ChannelMixer::TMixerChannel* channels, const Sample& smp8, const Sample& smp16)
+{
+	for (mp_sint32 c = 0; c < NUMCHANNELS; c++)
+	{
+		ChannelMixer::TMixerChannel& chn = channels[c];
+		chn.clear();
+		
+		chn.flags = ChannelMixer::MP_SAMPLE_PLAY | ((c & 2) ? 2 : 1) | ((c & 1) ? 4 : 0);
+		chn.sample = (c & 1) ? smp16.data : smp8.data;
+		chn.smplen = SAMPLELENGTH;
+		chn.loopstart = 1024 + c*17;
+		chn.loopend = SAMPLELENGTH - 1024 - c*13;
+		chn.smppos = c * 1000;
+		// pitches from two octaves below to more than one octave above the mixing rate
+		chn.smpadd = 65536/4 + c * 22000;
+		chn.rsmpadd = 0xFFFFFFFF / chn.smpadd;
+		chn.vol = 255;
+		chn.pan = 128;
+		chn.finalvoll = chn.finalvolr = 64*8192*256;
+		chn.index = c;
+	}
+}
+
+static mp_uint32 checksum(const mp_sint32* buffer, mp_uint32 size)
+{
+	mp_uint32 sum = 0;
+	for (mp_uint32 i = 0; i < size; i++)
+		sum = sum * 31 + (mp_uint32)buffer[i];
+	return sum;
+}
+
+int main(int argc, const char* argv[])
+{
+	const mp_sint32 mixFrequency = argc > 1 ? atoi(argv[1]) : 96000;
+	const double seconds = argc > 2 ? atof(argv[2]) : 10.0;
+	const mp_sint32 beatLength = (ChannelMixer::MP_BEATLENGTH*mixFrequency) / ChannelMixer::MP_BASEFREQ;
+	const mp_sint32 numBeats = (mp_sint32)(seconds * ChannelMixer::MP_TIMERFREQ);
+	
+	Sample smp8(false), smp16(true);
+	ChannelMixer::TMixerChannel channels[NUMCHANNELS];
+	mp_sint32* buffer = new mp_sint32[beatLength*MP_NUMCHANNELS];
+	
+	ResamplerFactory::SIMDLevels levels[4];
+	mp_sint32 numLevels = 0;
+	levels[numLevels++] = ResamplerFactory::SIMD_NONE;
+	const ResamplerFactory::SIMDLevels best = ResamplerFactory::getSIMDLevel();
+	if (best == ResamplerFactory::SIMD_AVX2)
+		levels[numLevels++] = ResamplerFactory::SIMD_SSE2;
+	if (best != ResamplerFactory::SIMD_NONE)
+		levels[numLevels++] = best;
+	
+	printf("%d Hz, %d channels, %.1f seconds per run, vector instruction set: %s\n\n", 
+		   mixFrequency, NUMCHANNELS, seconds, ResamplerFactory::getSIMDLevelName(best));
+	printf("%-28s %-6s %14s %10s %s\n", "Resampler", "SIMD", "frames/s", "x realtime", "");
+	
+	bool allExact = true;
+	
+	for (mp_sint32 type = 0; type < MixerSettings::MIXER_AMIGA500; type++)
+	{
+		mp_uint32 reference = 0;
+		
+		for (mp_sint32 l = 0; l < numLevels; l++)
+		{
+			ChannelMixer::ResamplerBase* resampler = ResamplerFactory::createResampler((MixerSettings::ResamplerTypes)type, levels[l]);
+			resampler->setFrequency(mixFrequency);
+			resampler->setNumChannels(NUMCHANNELS);
+			
+			setupChannels(channels, smp8, smp16);
+			
+			mp_uint32 sum = 0;
+			const double start = getTime();
+			for (mp_sint32 beat = 0; beat < numBeats; beat++)
+			{
+				memset(buffer, 0, beatLength*MP_NUMCHANNELS*sizeof(mp_sint32));
+				for (mp_sint32 c = 0; c < NUMCHANNELS; c++)
+				{
+					// sweep volume up and down to exercise ramping
+					if (resampler->isRamping())
+					{
+						const mp_sint32 target = ((beat + c) & 1) ? 64*8192*256 : 16*8192*256;
+						channels[c].rampFromVolStepL = (target - channels[c].finalvoll) / beatLength;
+						channels[c].rampFromVolStepR = (target - channels[c].finalvolr) / beatLength;
+					}
+					resampler->addChannel(&channels[c], buffer, beatLength, beatLength);
+				}
+				sum = sum * 17 + checksum(buffer, beatLength*MP_NUMCHANNELS);
+			}
+			const double elapsed = getTime() - start;
+			
+			delete resampler;
+			
+			const double framesPerSecond = (double)numBeats * beatLength / (elapsed > 0.0 ? elapsed : 1e-9);
+			
+			const char* result = "";
+			if (l == 0)
+				reference = sum;
+			else if (sum == reference)
+				result = "bit exact";
+			else
+			{
+				result = "MISMATCH";
+				allExact = false;
+			}
+			
+			// mark the one which is picked by default
+			const bool picked = levels[l] == ResamplerFactory::getSIMDLevel((MixerSettings::ResamplerTypes)type);
+			
+			printf("%-28s %-5s%c %14.0f %10.1f %s\n", 
+				   l == 0 ? resamplerNames[type] : "", 
+				   ResamplerFactory::getSIMDLevelName(levels[l]), 
+				   picked ? '*' : ' ',
+				   framesPerSecond, 
+				   framesPerSecond / mixFrequency, 
+				   result);
+		}
+	}
+	
+	printf("\n* picked by default\n");
+	
+	delete[] buffer;
+	
+	return allExact ? 0 : 1;
+}
@@ -0,0 +1,162 @@
+/*
+ *  tools/sampleeditorbench.cpp
+ *
+ *  Copyright 2009 The MilkyTracker Team
+ *
+ *  This file is part of Milkytracker.
+ *
+ *  Milkytracker is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Milkytracker is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Milkytracker.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ *  Times the sample editor filters on a long looped sample (16 and 8 bit).
+ *  Every filter runs on the whole sample with the undo stack disabled,
+ *  the checksum of the result is printed as well so outputs can be
+ *  compared between builds.
+ *
+ *  usage: sampleeditorbench [seconds of sample data at 44.1kHz]
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <sys/time.h>
+#include "XModule.h"
+#include "SampleEditor.h"
+#include "FilterParameters.h"
+
+static double getTime()
+{
+	timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec * (1.0 / 1000000.0);
+}
+
+static void fillSample(XModule& module, TXMSample& smp, mp_uint32 length, bool is16Bit)
+{
+	if (smp.sample)
+		module.freeSampleMem((mp_ubyte*)smp.sample);
+
+	smp.type = (is16Bit ? 16 : 0) | 1;
+	smp.samplen = length;
+	smp.loopstart = length / 4;
+	smp.looplen = length / 2;
+	smp.sample = (mp_sbyte*)module.allocSampleMem(is16Bit ? length*2 : length);
+	smp.relnote = 0;
+	smp.finetune = 0;
+
+	srand(1);
+	for (mp_uint32 i = 0; i < length; i++)
+	{
+		const float f = 0.5f*(float)sin(i*0.0313) + 0.2f*(float)sin(i*0.77) + 0.1f*((rand() & 1023) - 512) / 512.0f;
+		smp.setSampleValue(i, is16Bit ? (mp_sint32)(f*32767.0f) : (mp_sint32)(f*127.0f));
+	}
+
+	smp.postProcessSamples();
+}
+
+static mp_uint32 checksum(TXMSample& smp)
+{
+	mp_uint32 sum = 0;
+	for (mp_uint32 i = 0; i < smp.samplen; i++)
+		sum = sum*31 + (mp_uint32)smp.getSampleValue(i);
+	return sum;
+}
+
+typedef void (SampleEditor::*TTool)(const FilterParameters* par);
+
+int main(int argc, char** argv)
+{
+	const double seconds = argc > 1 ? atof(argv[1]) : 180.0;
+	const mp_uint32 length = (mp_uint32)(seconds*44100.0);
+
+	XModule module;
+	module.createEmptySong();
+
+	SampleEditor editor;
+	editor.enableUndoStack(false);
+
+	FilterParameters scale(2);
+	scale.setParameter(0, FilterParameters::Parameter(1.0f));
+	scale.setParameter(1, FilterParameters::Parameter(0.5f));
+	FilterParameters normalize(1);
+	normalize.setParameter(0, FilterParameters::Parameter(1.0f));
+	FilterParameters offset(1);
+	offset.setParameter(0, FilterParameters::Parameter(0.05f));
+	FilterParameters eq(3);
+	eq.setParameter(0, FilterParameters::Parameter(1.5f));
+	eq.setParameter(1, FilterParameters::Parameter(0.5f));
+	eq.setParameter(2, FilterParameters::Parameter(1.2f));
+	FilterParameters resample(3);
+	resample.setParameter(0, FilterParameters::Parameter(22050.0f));
+	resample.setParameter(1, FilterParameters::Parameter((pp_int32)1));
+	resample.setParameter(2, FilterParameters::Parameter((pp_int32)0));
+
+	struct Tool
+	{
+		const char* name;
+		TTool tool;
+		const FilterParameters* par;
+		bool xFadeSelection;
+	} tools[] =
+	{
+		{"scale", &SampleEditor::tool_scaleSample, &scale, false},
+		{"normalize", &SampleEditor::tool_normalizeSample, &normalize, false},
+		{"DC normalize", &SampleEditor::tool_DCNormalizeSample, NULL, false},
+		{"DC offset", &SampleEditor::tool_DCOffsetSample, &offset, false},
+		{"PT boost", &SampleEditor::tool_PTboostSample, NULL, false},
+		{"smooth (rect.)", &SampleEditor::tool_rectangularSmoothSample, NULL, false},
+		{"smooth (tri.)", &SampleEditor::tool_triangularSmoothSample, NULL, false},
+		{"3 band EQ", &SampleEditor::tool_eqSample, &eq, false},
+		{"x-fade", &SampleEditor::tool_xFadeSample, NULL, true},
+		{"resample", &SampleEditor::tool_resampleSample, &resample, false}
+	};
+
+	printf("%.0f seconds of sample data\n", seconds);
+	printf("%-16s %10s %10s %10s %10s\n", "filter", "16 bit ms", "checksum", "8 bit ms", "checksum");
+
+	for (mp_uint32 i = 0; i < sizeof(tools) / sizeof(Tool); i++)
+	{
+		printf("%-16s", tools[i].name);
+
+		for (mp_uint32 bits = 0; bits < 2; bits++)
+		{
+			TXMSample& smp = module.smp[0];
+			fillSample(module, smp, length, bits == 0);
+			editor.attachSample(&smp, &module);
+
+			if (tools[i].xFadeSelection)
+			{
+				editor.setSelectionStart(smp.loopstart - smp.looplen / 4);
+				editor.setSelectionEnd(smp.loopstart + smp.looplen / 4);
+			}
+			else
+			{
+				editor.resetSelection();
+			}
+
+			const double start = getTime();
+			(editor.*tools[i].tool)(tools[i].par);
+			const double time = getTime() - start;
+
+			printf(" %10.1f %10x", time * 1000.0, checksum(smp));
+		}
+
+		printf("\n");
+	}
+
+	return 0;
+}
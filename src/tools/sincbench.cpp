@@ -0,0 +1,262 @@
+/*
+ *  tools/sincbench.cpp
+ *
+ *  Copyright 2009 The MilkyTracker Team
+ *
+ *  This file is part of Milkytracker.
+ *
+ *  Milkytracker is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Milkytracker is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Milkytracker.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ *  Compares the sinc resamplers: the double precision MIXER_SINC, the 
+ *  fixed point MIXER_SINCTABLE and the polyphase table resampler at 
+ *  different tap counts.
+ *  Throughput is measured like in resamplerbench (looped 8 and 16 bit 
+ *  channels at different pitches). For quality a 16 bit sine is resampled
+ *  and compared against the ideal result: 
+ *  - SNR while upsampling and at moderate downsampling
+ *  - the level of what's left of a tone which lies above the output
+ *    nyquist frequency when downsampling (aliasing, lower is better)
+ *
+ *  usage: sincbench [mixfrequency] [seconds of audio per run]
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <sys/time.h>
+#include "ResamplerFactory.h"
+#include "ResamplerSinc.h"
+#include "ResamplerPolyphase.h"
+
+enum 
+{
+	NUMCHANNELS = 8,
+	SAMPLELENGTH = 65536,
+	SINELENGTH = 262144,
+	// same padding as TXMSample::allocPaddedMem
+	PADDING = 16,
+	BLOCKSIZE = 1024
+};
+
+static double getTime()
+{
+	timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec * (1.0 / 1000000.0);
+}
+
+class Sample
+{
+private:
+	mp_ubyte* mem;
+	
+public:
+	mp_sbyte* data;
+
+	// noise plus a saw when frequency is 0, a sine otherwise
+	Sample(bool is16Bit, mp_sint32 length, double frequency = 0.0)
+	{
+		const mp_uint32 bytes = is16Bit ? 2 : 1;
+		mem = new mp_ubyte[(length + PADDING*2) * bytes];
+		data = (mp_sbyte*)(mem + PADDING*bytes);
+		
+		mp_uint32 seed = 0x1234567;
+		for (mp_sint32 i = -PADDING; i < length + PADDING; i++)
+		{
+			mp_sint32 s;
+			if (frequency > 0.0)
+			{
+				s = (i >= 0 && i < length) ? (mp_sint32)floor(16384.0 * sin(2.0 * M_PI * frequency * i) + 0.5) : 0;
+			}
+			else
+			{
+				seed = seed * 1664525 + 1013904223;
+				s = (mp_sint32)(seed >> 17) - 16384;
+				s += ((i * 37) & 0x7FFF) - 16384;
+			}
+			if (is16Bit)
+				((mp_sword*)data)[i] = (mp_sword)s;
+			else
+				data[i] = (mp_sbyte)(s >> 8);
+		}
+	}
+	
+	~Sample()
+	{
+		delete[] mem;
+	}
+};
+
+struct Candidate
+{
+	const char* name;
+	ChannelMixer::ResamplerBase* resampler;
+};
+
+static double measureThroughput(ChannelMixer::ResamplerBase* resampler, mp_sint32 mixFrequency, double seconds,
+								const Sample& smp8, const Sample& smp16)
+{
+	ChannelMixer::TMixerChannel channels[NUMCHANNELS];
+	for (mp_sint32 c = 0; c < NUMCHANNELS; c++)
+	{
+		ChannelMixer::TMixerChannel& chn = channels[c];
+		chn.clear();
+		
+		chn.flags = ChannelMixer::MP_SAMPLE_PLAY | ((c & 2) ? 2 : 1) | ((c & 1) ? 4 : 0);
+		chn.sample = (c & 1) ? smp16.data : smp8.data;
+		chn.smplen = SAMPLELENGTH;
+		chn.loopstart = 1024 + c*17;
+		chn.loopend = SAMPLELENGTH - 1024 - c*13;
+		chn.smppos = c * 1000;
+		// pitches from two octaves below to more than one octave above the mixing rate
+		chn.smpadd = 65536/4 + c * 22000;
+		chn.rsmpadd = 0xFFFFFFFF / chn.smpadd;
+		chn.vol = 255;
+		chn.pan = 128;
+		chn.finalvoll = chn.finalvolr = 64*8192*256;
+		chn.index = c;
+	}
+
+	const mp_sint32 numBlocks = (mp_sint32)(seconds * mixFrequency / BLOCKSIZE);
+	mp_sint32* buffer = new mp_sint32[BLOCKSIZE*MP_NUMCHANNELS];
+	
+	const double start = getTime();
+	for (mp_sint32 b = 0; b < numBlocks; b++)
+	{
+		memset(buffer, 0, BLOCKSIZE*MP_NUMCHANNELS*sizeof(mp_sint32));
+		for (mp_sint32 c = 0; c < NUMCHANNELS; c++)
+			resampler->addChannel(&channels[c], buffer, BLOCKSIZE, BLOCKSIZE);
+	}
+	const double elapsed = getTime() - start;
+	
+	delete[] buffer;
+	
+	return (double)numBlocks * BLOCKSIZE / (elapsed > 0.0 ? elapsed : 1e-9);
+}
+
+// resample the sine at the given step and compare against the ideal sine,
+// returns the error level in dB relative to the sine (0 dB = 16384 rms/sqrt(2)).
+// if the sine is above the output nyquist the ideal result is silence
+static double measureError(ChannelMixer::ResamplerBase* resampler, const Sample& sine, double frequency, double step)
+{
+	ChannelMixer::TMixerChannel chn;
+	chn.clear();
+	chn.flags = ChannelMixer::MP_SAMPLE_PLAY | 4;
+	chn.sample = sine.data;
+	chn.smplen = SINELENGTH;
+	chn.loopstart = 0;
+	chn.loopend = SINELENGTH;
+	chn.loopendcopy = SINELENGTH;
+	chn.smppos = 4096;
+	chn.smpadd = (mp_sint32)(step * 65536.0);
+	chn.rsmpadd = 0xFFFFFFFF / chn.smpadd;
+	chn.vol = 255;
+	chn.pan = 128;
+	// unity gain: (s*(vol>>15))>>15
+	chn.finalvoll = chn.finalvolr = 1 << 30;
+
+	const double exactStep = chn.smpadd / 65536.0;
+	const bool aliasing = frequency * exactStep > 0.5;
+	const mp_sint32 numFrames = (mp_sint32)((SINELENGTH - 8192) / exactStep) / BLOCKSIZE * BLOCKSIZE;
+	
+	mp_sint32* buffer = new mp_sint32[BLOCKSIZE*MP_NUMCHANNELS];
+	double signal = 0.0, error = 0.0;
+	
+	for (mp_sint32 n = 0; n < numFrames; n+=BLOCKSIZE)
+	{
+		memset(buffer, 0, BLOCKSIZE*MP_NUMCHANNELS*sizeof(mp_sint32));
+		resampler->addChannel(&chn, buffer, BLOCKSIZE, BLOCKSIZE);
+		
+		// skip the start, where the sinc window still reaches into silence
+		if (n == 0)
+			continue;
+			
+		for (mp_sint32 i = 0; i < BLOCKSIZE; i++)
+		{
+			const double ideal = aliasing ? 0.0 : 16384.0 * sin(2.0 * M_PI * frequency * (4096.0 + (n + i) * exactStep));
+			const double diff = buffer[i*MP_NUMCHANNELS] - ideal;
+			signal += 16384.0 * 16384.0 * 0.5;
+			error += diff * diff;
+		}
+	}
+	
+	delete[] buffer;
+	
+	return 10.0 * log10((error > 0.0 ? error : 1e-9) / signal);
+}
+
+int main(int argc, const char* argv[])
+{
+	const mp_sint32 mixFrequency = argc > 1 ? atoi(argv[1]) : 96000;
+	const double seconds = argc > 2 ? atof(argv[2]) : 2.0;
+	
+	Sample smp8(false, SAMPLELENGTH), smp16(true, SAMPLELENGTH);
+	
+	Candidate candidates[] = 
+	{
+		{ "Sinc (128, double)", ResamplerFactory::createResampler(MixerSettings::MIXER_SINC) },
+		{ "Sinc table (16)", ResamplerFactory::createResampler(MixerSettings::MIXER_SINCTABLE) },
+		{ "Polyphase (16)", new ResamplerPolyphase<false, 16>() },
+		{ "Polyphase (32)", new ResamplerPolyphase<false, 32>() },
+		{ "Polyphase (64)", new ResamplerPolyphase<false, 64>() }
+	};
+	const mp_sint32 numCandidates = sizeof(candidates) / sizeof(Candidate);
+	
+	// sine frequency in cycles per source sample and playback step
+	const struct { double frequency, step; const char* name; } tests[] =
+	{
+		{ 0.05, 0.37, "up 0.37" },
+		{ 0.20, 0.74, "up 0.74" },
+		{ 0.15, 1.50, "down 1.5" },
+		{ 0.40, 2.00, "alias 2.0" },
+		{ 0.30, 3.50, "alias 3.5" }
+	};
+	const mp_sint32 numTests = sizeof(tests) / sizeof(tests[0]);
+	
+	printf("%d Hz, %.1f seconds per throughput run, vector instruction set: %s\n", 
+		   mixFrequency, seconds, ResamplerFactory::getSIMDLevelName(ResamplerFactory::getSIMDLevel()));
+	printf("error in dB relative to the input tone, lower is better\n\n");
+	
+	printf("%-20s %12s %8s", "Resampler", "frames/s", "x rt");
+	for (mp_sint32 t = 0; t < numTests; t++)
+		printf(" %10s", tests[t].name);
+	printf("\n");
+	
+	for (mp_sint32 i = 0; i < numCandidates; i++)
+	{
+		ChannelMixer::ResamplerBase* resampler = candidates[i].resampler;
+		resampler->setFrequency(mixFrequency);
+		resampler->setNumChannels(NUMCHANNELS);
+	
+		const double framesPerSecond = measureThroughput(resampler, mixFrequency, seconds, smp8, smp16);
+		
+		printf("%-20s %12.0f %8.1f", candidates[i].name, framesPerSecond, framesPerSecond / mixFrequency);
+		
+		for (mp_sint32 t = 0; t < numTests; t++)
+		{
+			Sample sine(true, SINELENGTH, tests[t].frequency);
+			printf(" %10.1f", measureError(resampler, sine, tests[t].frequency, tests[t].step));
+		}
+		printf("\n");
+		fflush(stdout);
+		
+		delete resampler;
+	}
+	
+	return 0;
+}
@@ -0,0 +1,232 @@
+/*
+ *  tools/voicebench.cpp
+ *
+ *  Copyright 2009 The MilkyTracker Team
+ *
+ *  This file is part of Milkytracker.
+ *
+ *  Milkytracker is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Milkytracker is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Milkytracker.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ *  Stress test for the virtual channel handling of PlayerIT.
+ *  Plays a generated song with a note on every row of every channel,
+ *  the instruments use all kinds of new note actions and duplicate checks,
+ *  so the virtual channels fill up quickly and voices keep being stolen.
+ *  Every run is done twice: without mixing to time the player on its own
+ *  and with mixing, which gives a checksum of the output to compare builds.
+ *
+ *  usage: voicebench [seconds of song] [max. virtual channels ...]
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+#include "XModule.h"
+#include "PlayerIT.h"
+#include "MasterMixer.h"
+#include "AudioDriver_NULL.h"
+
+enum
+{
+	NUMCHANNELS = 32,
+	NUMROWS = 64,
+	NUMPATTERNS = 4,
+	NUMINSTRUMENTS = 4,
+	NUMEFFECTS = 2,
+	SAMPLELENGTH = 8192,
+	MIXFREQUENCY = 44100,
+	BUFFERSIZE = 1024
+};
+
+static double getTime()
+{
+	timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec * (1.0 / 1000000.0);
+}
+
+// the NULL driver with a checksum of everything that has been mixed
+class AudioDriver_Checksum : public AudioDriver_NULL
+{
+public:
+	mp_uint32 checksum;
+
+	AudioDriver_Checksum() :
+		checksum(0)
+	{
+	}
+
+	virtual void advance()
+	{
+		AudioDriver_NULL::advance();
+		for (mp_sint32 i = 0; i < bufferSize; i++)
+			checksum = checksum*31 + (mp_uword)compensateBuffer[i];
+	}
+};
+
+static void createSong(XModule& module, mp_uint32 numOrders)
+{
+	module.createEmptySong(true, true, NUMCHANNELS);
+
+	TXMHeader& header = module.header;
+	header.channum = NUMCHANNELS;
+	header.insnum = NUMINSTRUMENTS;
+	header.smpnum = NUMINSTRUMENTS;
+	header.patnum = NUMPATTERNS;
+	header.ordnum = numOrders;
+	header.restart = 0;
+	header.tempo = 3;
+	header.speed = 125;
+	header.mainvol = 255;
+	header.flags = XModule::MODULE_ITNOTEOFF | XModule::MODULE_ITNEWEFFECTS;
+	for (mp_uint32 i = 0; i < numOrders; i++)
+		header.ord[i] = i % NUMPATTERNS;
+	for (mp_uint32 i = 0; i < NUMCHANNELS; i++)
+		header.pan[i] = (i & 1) ? 0x40 : 0xC0;
+
+	srand(1);
+
+	// new note action (bits 4-5), duplicate check type (bits 6-7) and action (bits 8-9)
+	static const mp_uword nna[NUMINSTRUMENTS] =
+	{
+		(1 << 4),								// continue
+		(2 << 4) | (1 << 6) | (1 << 8),			// note off, duplicate note => note off
+		(3 << 4) | (2 << 6) | (2 << 8),			// fade, duplicate sample => fade
+		(1 << 4) | (3 << 6) | (0 << 8)			// continue, duplicate instrument => cut
+	};
+
+	for (mp_uint32 i = 0; i < NUMINSTRUMENTS; i++)
+	{
+		TXMInstrument& ins = module.instr[i];
+		ins.samp = 1;
+		ins.flags = TXMInstrument::IF_ITFADEOUT | nna[i];
+		ins.volfade = 256 << i;
+		for (mp_uint32 j = 0; j < 120; j++)
+		{
+			ins.snum[j] = i;
+			ins.notemap[j] = j;
+		}
+
+		TXMSample& smp = module.smp[i];
+		smp.type = (i & 1) ? 16 | 1 : 1;
+		smp.samplen = SAMPLELENGTH;
+		smp.loopstart = SAMPLELENGTH / 4;
+		smp.looplen = SAMPLELENGTH / 2;
+		smp.vol = 0xC0 + i*0x10;
+		smp.flags = 1;
+		smp.relnote = 0;
+		smp.finetune = 0;
+		smp.sample = (mp_sbyte*)module.allocSampleMem((smp.type & 16) ? SAMPLELENGTH*2 : SAMPLELENGTH);
+		for (mp_uint32 j = 0; j < SAMPLELENGTH; j++)
+			smp.setSampleValue(j, (smp.type & 16) ? (rand() & 0x3FFF) - 0x2000 : (rand() & 0x3F) - 0x20);
+		smp.postProcessSamples();
+	}
+
+	const mp_uint32 slotSize = 2 + NUMEFFECTS*2;
+	for (mp_uint32 p = 0; p < NUMPATTERNS; p++)
+	{
+		TXMPattern& pattern = module.phead[p];
+		pattern.rows = NUMROWS;
+		pattern.channum = NUMCHANNELS;
+		pattern.effnum = NUMEFFECTS;
+		pattern.patternData = new mp_ubyte[NUMROWS*NUMCHANNELS*slotSize];
+		memset(pattern.patternData, 0, NUMROWS*NUMCHANNELS*slotSize);
+
+		mp_ubyte* slot = pattern.patternData;
+		for (mp_uint32 r = 0; r < NUMROWS; r++)
+		{
+			for (mp_uint32 c = 0; c < NUMCHANNELS; c++, slot+=slotSize)
+			{
+				// a few channels keep retriggering the same note to hit the duplicate checks
+				slot[0] = (c & 3) ? 37 + (rand() % 48) : 49;
+				slot[1] = 1 + (rand() % NUMINSTRUMENTS);
+				// set volume, quiet notes are the first ones to be stolen
+				slot[2] = 0x0C;
+				slot[3] = rand() & 0xFF;
+				// every now and then a note off
+				if (!(rand() & 15))
+				{
+					slot[0] = XModule::NOTE_OFF;
+					slot[1] = 0;
+				}
+			}
+		}
+	}
+}
+
+static mp_uint32 play(XModule& module, mp_sint32 numVirtualChannels, bool mixing, double& time)
+{
+	AudioDriver_Checksum driver;
+
+	MasterMixer mixer(MIXFREQUENCY, BUFFERSIZE, 1, &driver);
+	mixer.setDisableMixing(!mixing);
+
+	PlayerIT player(MIXFREQUENCY);
+	player.setBufferSize(BUFFERSIZE);
+	player.setResamplerType(ChannelMixer::MIXER_NORMAL);
+	player.setDisableMixing(!mixing);
+	player.setNumMaxVirChannels(numVirtualChannels);
+	mixer.addDevice(&player);
+
+	player.startPlaying(&module, false, 0, 0, -1, NULL, false, -1);
+	mixer.start();
+
+	const double start = getTime();
+	while (!player.hasSongHalted() && player.getOrder(0) < module.header.ordnum)
+		driver.advance();
+	time = getTime() - start;
+
+	player.stopPlaying();
+	mixer.stop();
+	mixer.closeAudioDevice();
+
+	return driver.checksum;
+}
+
+int main(int argc, char** argv)
+{
+	const double seconds = argc > 1 ? atof(argv[1]) : 120.0;
+
+	// about 16.7 rows per second at speed 3 / 125 BPM
+	mp_uint32 numOrders = (mp_uint32)(seconds * (125.0*2.0/5.0/3.0) / NUMROWS + 0.5);
+	if (numOrders < 1)
+		numOrders = 1;
+	if (numOrders > 255)
+		numOrders = 255;
+
+	XModule module;
+	createSong(module, numOrders);
+
+	printf("%d channels, %d orders\n", NUMCHANNELS, numOrders);
+	printf("%-16s %12s %12s %10s\n", "virt. channels", "player ms", "mixed ms", "checksum");
+
+	static const mp_sint32 defaultVirtualChannels[] = {64, 256, 1024};
+	const mp_sint32 numRuns = argc > 2 ? argc - 2 : sizeof(defaultVirtualChannels) / sizeof(mp_sint32);
+
+	for (mp_sint32 i = 0; i < numRuns; i++)
+	{
+		const mp_sint32 numVirtualChannels = argc > 2 ? atoi(argv[i + 2]) : defaultVirtualChannels[i];
+
+		double playerTime, mixedTime;
+		play(module, numVirtualChannels, false, playerTime);
+		const mp_uint32 checksum = play(module, numVirtualChannels, true, mixedTime);
+
+		printf("%-16d %12.1f %12.1f %10x\n", numVirtualChannels, playerTime * 1000.0, mixedTime * 1000.0, checksum);
+	}
+
+	return 0;
+}
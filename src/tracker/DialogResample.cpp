@@ -39,52 +39,7 @@
 #include "Seperator.h"
 #include "XModule.h"
 #include "ResamplerHelper.h"
-
-float getc4spd(mp_sint32 relnote,mp_sint32 finetune)
-{
-	static const mp_sint32	table[] = {65536,69432,73561,77935,82570,87480,92681,98193,104031,110217,116771,123715,
-						   65536,65565,65595,65624,65654,65684,65713,65743,65773,65802,65832,65862,65891,
-						   65921,65951,65981,66010,66040,66070,66100,66130,66160,66189,66219,66249,66279,
-						   66309,66339,66369,66399,66429,66459,66489,66519,66549,66579,66609,66639,66669,
-						   66699,66729,66759,66789,66820,66850,66880,66910,66940,66971,67001,67031,67061,
-						   67092,67122,67152,67182,67213,67243,67273,67304,67334,67365,67395,67425,67456,
-						   67486,67517,67547,67578,67608,67639,67669,67700,67730,67761,67792,67822,67853,
-						   67883,67914,67945,67975,68006,68037,68067,68098,68129,68160,68190,68221,68252,
-						   68283,68314,68344,68375,68406,68437,68468,68499,68530,68561,68592,68623,68654,
-						   68685,68716,68747,68778,68809,68840,68871,68902,68933,68964,68995,69026,69057,
-						   69089,69120,69151,69182,69213,69245,69276,69307,69339,69370,69401};
-
-	mp_sint32 c4spd = 8363;
-	mp_sbyte xmfine = finetune;
-
-	mp_sbyte octave = (relnote+96)/12;
-	mp_sbyte note = (relnote+96)%12;
-	
-	mp_sbyte o2 = octave-8;
-	
-	if (xmfine<0)
-	{
-		xmfine+=(mp_sbyte)128;
-		note--;
-		if (note<0)
-		{
-			note+=12;
-			o2--;
-		}
-	}
-
-	if (o2>=0)
-	{
-		c4spd<<=o2;		
-	}
-	else
-	{
-		c4spd>>=-o2;
-	}
-
-	float f = table[(mp_ubyte)note]*(1.0f/65536.0f) * c4spd;
-	return f * (table[(mp_ubyte)xmfine+12]*(1.0f/65536.0f));
-}
+#include "SampleEditorResampler.h"
 
 DialogResample::DialogResample(PPScreen* screen, 
 							   DialogResponder* responder,
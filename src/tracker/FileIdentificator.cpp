@@ -35,7 +35,8 @@
 #include "Decompressor.h"
 
 FileIdentificator::FileIdentificator(const PPSystemString& fileName) :
-	fileName(fileName)
+	fileName(fileName),
+	ownFile(true)
 {
 	f = new XMFile(fileName);
 	if (!f->isOpen())
@@ -45,9 +46,17 @@ FileIdentificator::FileIdentificator(const PPSystemString& fileName) :
 	}
 }
 
+FileIdentificator::FileIdentificator(XMFileBase& f) :
+	fileName(f.getFileName()),
+	f(&f),
+	ownFile(false)
+{
+}
+
 FileIdentificator::~FileIdentificator() 
 {
-	delete f;
+	if (ownFile)
+		delete f;
 }
 
 FileIdentificator::FileTypes FileIdentificator::getFileType()
@@ -83,12 +92,13 @@ FileIdentificator::FileTypes FileIdentificator::getFileType()
 
 bool FileIdentificator::isModule()
 {
-	mp_ubyte buffer[2048];
+	mp_ubyte buffer[XModule::IdentificationBufferSize];
+	memset(buffer, 0, sizeof(buffer));
 	
 	f->seek(0);
-	f->read(buffer, 1, 2048);
+	f->read(buffer, 1, sizeof(buffer));
 	
-	return XModule::identifyModule(buffer) != NULL;
+	return XModule::identifyModule(buffer, f->getFileName()) != NULL;
 }
 
 bool FileIdentificator::isInstrument()
@@ -106,6 +116,11 @@ bool FileIdentificator::isInstrument()
 
 bool FileIdentificator::isSample()
 {
+	// the sample loaders only work on files, streams are taken as samples
+	// and will be identified for real when they're loaded
+	if (!ownFile)
+		return true;
+
 	XModule* module = NULL;
 
 	SampleLoaderGeneric sampleLoader(fileName, *module);
@@ -163,6 +178,10 @@ bool FileIdentificator::isTrack()
 
 bool FileIdentificator::isCompressed()
 {
+	// decompressors only work on files
+	if (!ownFile)
+		return false;
+
 	Decompressor decompressor(fileName);
 	f->seek(0);
 	return decompressor.identify(*f);
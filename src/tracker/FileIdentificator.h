@@ -33,7 +33,7 @@
 
 #include "BasicTypes.h"
 
-class XMFile;
+class XMFileBase;
 
 class FileIdentificator
 {
@@ -51,7 +51,8 @@ public:
 	
 private:
 	PPSystemString fileName;
-	XMFile* f;
+	XMFileBase* f;
+	bool ownFile;
 	
 	bool isModule();
 	bool isInstrument();
@@ -62,6 +63,8 @@ private:
 	
 public:
 	FileIdentificator(const PPSystemString& fileName);
+	// identify the contents of a stream, e.g. a decompressed file in memory
+	FileIdentificator(XMFileBase& f);
 	~FileIdentificator();
 	
 	bool isValid() { return f != NULL; }
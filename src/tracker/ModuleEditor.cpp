@@ -25,6 +25,7 @@
 #include "SampleEditor.h"
 #include "EnvelopeEditor.h"
 #include "ModuleServices.h"
+#include "SongCheckpointIndex.h"
 #include "PlayerCriticalSection.h"
 #include "TrackerConfig.h"
 #include "PPSystem.h"
@@ -73,9 +74,13 @@ private:
 		{
 			case EditorBase::NotificationChanges:
 			{
+				// the sample editor keeps track of its changes itself
 				if (sender == moduleEditor.sampleEditor)
-					moduleEditor.finishSamples();
-				moduleEditor.setChanged();
+					moduleEditor.module->postProcessSamples();
+				if (sender == moduleEditor.patternEditor)
+					moduleEditor.setPatternChanged(moduleEditor.getCurrentPatternIndex());
+				else
+					moduleEditor.setChanged();
 				break;
 			}
 			
@@ -124,6 +129,10 @@ ModuleEditor::ModuleEditor() :
 
 	module = new XModule();
 	
+	songCheckpointIndex = new SongCheckpointIndex(module);
+	
+	moduleServices = new ModuleServices(*module);
+
 	createNewSong();
 
 	changesListener = new ChangesListener(*this);
@@ -143,14 +152,13 @@ ModuleEditor::ModuleEditor() :
 	envelopeEditor->addNotificationListener(changesListener);
 	envelopeEditor->attachEnvelope(NULL, module);
 	
-	moduleServices = new ModuleServices(*module);
-
 	currentCursorPosition.row = currentCursorPosition.channel = currentCursorPosition.inner = 0;	
 }
 
 ModuleEditor::~ModuleEditor()
 {
 	delete moduleServices;
+	delete songCheckpointIndex;
 	delete sampleEditor;
 	delete patternEditor;
 	delete envelopeEditor;
@@ -161,6 +169,20 @@ ModuleEditor::~ModuleEditor()
 	delete[] instruments;
 }
 
+void ModuleEditor::setChanged()
+{
+	changed = true;
+	songCheckpointIndex->invalidate();
+	moduleServices->songChanged();
+}
+
+void ModuleEditor::setPatternChanged(mp_sint32 patternIndex)
+{
+	changed = true;
+	songCheckpointIndex->invalidatePattern(patternIndex);
+	moduleServices->patternChanged(patternIndex);
+}
+
 PPSystemString ModuleEditor::getModuleFileNameFull(ModSaveTypes extension/* = ModSaveTypeDefault*/) 
 { 
 	PPSystemString s = moduleFileName;
@@ -574,6 +596,14 @@ void ModuleEditor::createEmptySong(bool clearPatterns/* = true*/, bool clearInst
 	
 		module->createEmptySong(clearPatterns, clearInstruments, numChannels);
 
+		songCheckpointIndex->invalidate();
+		moduleServices->songChanged();
+		// a new song is created before the editors are
+		if (sampleEditor)
+			sampleEditor->invalidatePeaks();
+		if (patternEditor)
+			patternEditor->clearUndo();
+
 		if (clearPatterns && clearInstruments)
 		{
 			changed = false;
@@ -602,6 +632,11 @@ bool ModuleEditor::createNewSong(mp_uword numChannels/*= 8*/)
 {
 	module->createEmptySong(true, true, numChannels);
 
+	songCheckpointIndex->invalidate();
+	moduleServices->songChanged();
+	// the first song is created before the editors are
+	if (patternEditor)
+		patternEditor->clearUndo();
 	changed = false;
 
 	eSaveType = ModSaveTypeXM;
@@ -664,7 +699,13 @@ bool ModuleEditor::openSong(const SYSCHAR* fileName, const SYSCHAR* preferredFil
 	if (!XMFile::exists(fileName))
 		return false;
 
-	mp_sint32 nRes = module->loadModule(fileName);
+	XMFile f(fileName);
+	return openSong(f, preferredFileName);
+}
+
+bool ModuleEditor::openSong(XMFileBase& f, const SYSCHAR* preferredFileName/* = NULL*/)
+{
+	mp_sint32 nRes = module->loadModule(f);
 	
 	// unknown format
 	if (nRes == MP_UNKNOWN_FORMAT)
@@ -726,6 +767,11 @@ bool ModuleEditor::openSong(const SYSCHAR* fileName, const SYSCHAR* preferredFil
 
 	lastRequestedPatternIndex = 0;
 	
+	songCheckpointIndex->invalidate();
+	moduleServices->songChanged();
+	sampleEditor->invalidatePeaks();
+	patternEditor->clearUndo();
+
 	if (res)
 	{
 		changed = false;
@@ -736,7 +782,7 @@ bool ModuleEditor::openSong(const SYSCHAR* fileName, const SYSCHAR* preferredFil
 		for (mp_sint32 i = 0; i < module->header.patnum; i++)
 			getPattern(i);
 		
-		PPSystemString strFileName = preferredFileName ? preferredFileName : fileName;
+		PPSystemString strFileName = preferredFileName ? preferredFileName : f.getFileName();
 
 		moduleFileName = strFileName.stripExtension();
 		
@@ -909,6 +955,7 @@ bool ModuleEditor::seqCurrentOrderPosition(mp_sint32 index, bool clone/* = false
 	{
 		// now clone pattern
 		module->phead[dstPatternIndex] = module->phead[srcPatternIndex];
+		patternEditor->clearUndo(&module->phead[dstPatternIndex]);
 	}
 
 	changed = true;
@@ -1147,6 +1194,7 @@ mp_sint32 ModuleEditor::allocateSample(mp_sint32 index)
 void ModuleEditor::finishSamples()
 {
 	module->postProcessSamples();
+	sampleEditor->invalidatePeaks();
 }
 
 mp_sint32 ModuleEditor::allocateInstrument()
@@ -2018,12 +2066,18 @@ pp_int32 ModuleEditor::insRemapSong(pp_int32 oldIns, pp_int32 newIns)
 
 	PatternEditorTools patternEditorTools;
 
+	patternEditor->beginUndoGroup();
+
 	for (mp_sint32 k = 0; k < module->header.patnum; k++)
 	{
+		patternEditor->prepareUndo(&module->phead[k]);
 		patternEditorTools.attachPattern(&module->phead[k]);
 		resCnt+=patternEditorTools.insRemap(oldIns, newIns);				
+		patternEditor->finishUndo(&module->phead[k]);
 	}
 
+	patternEditor->endUndoGroup();
+
 	if (resCnt)
 		changed = true;
 		
@@ -2037,6 +2091,9 @@ pp_int32 ModuleEditor::noteTransposeSong(const PatternEditorTools::TransposePara
 
 	PatternEditorTools patternEditorTools;
 
+	if (!evaluate)
+		patternEditor->beginUndoGroup();
+
 	for (mp_sint32 k = 0; k < module->header.patnum; k++)
 	{
 		patternEditorTools.attachPattern(&module->phead[k]);
@@ -2044,9 +2101,16 @@ pp_int32 ModuleEditor::noteTransposeSong(const PatternEditorTools::TransposePara
 		if (evaluate)
 			fuckupCnt+=patternEditorTools.noteTranspose(transposeParameters, evaluate);				
 		else
+		{
+			patternEditor->prepareUndo(&module->phead[k]);
 			resCnt+=patternEditorTools.noteTranspose(transposeParameters, evaluate);				
+			patternEditor->finishUndo(&module->phead[k]);
+		}
 	}
 
+	if (!evaluate)
+		patternEditor->endUndoGroup();
+
 	if (!evaluate)
 	{
 		if (resCnt)
@@ -2062,6 +2126,8 @@ pp_int32 ModuleEditor::panConvertSong(PanConversionTypes type)
 {
 	mp_sint32 resCnt = 0;
 
+	patternEditor->beginUndoGroup();
+
 	for (mp_sint32 k = 0; k < module->header.patnum; k++)
 	{
 		TXMPattern* pattern = &module->phead[k];
@@ -2069,6 +2135,8 @@ pp_int32 ModuleEditor::panConvertSong(PanConversionTypes type)
 		if (pattern->patternData == NULL)
 			continue;
 			
+		patternEditor->prepareUndo(pattern);
+
 		mp_sint32 slotSize = pattern->effnum * 2 + 2;
 		mp_sint32 rowSizeSrc = slotSize*pattern->channum;
 		
@@ -2111,8 +2179,11 @@ pp_int32 ModuleEditor::panConvertSong(PanConversionTypes type)
 				}
 			}
 				
+		patternEditor->finishUndo(pattern);
 	}
 	
+	patternEditor->endUndoGroup();
+
 	if (resCnt)
 		changed = true;
 
@@ -2125,6 +2196,8 @@ pp_int32 ModuleEditor::removeUnusedPatterns(bool evaluate)
 
 	if (!evaluate && result)
 	{
+		// the patterns have moved to other slots
+		patternEditor->clearUndo();
 		changed = true;
 		if (currentPatternIndex > module->header.patnum - 1)
 			currentPatternIndex = module->header.patnum - 1;
@@ -2367,11 +2440,21 @@ pp_int32 ModuleEditor::relocateCommands(const PatternEditorTools::RelocateParame
 
 	PatternEditorTools patternEditorTools;
 
+	if (!evaluate)
+		patternEditor->beginUndoGroup();
+
 	for (mp_sint32 k = 0; k < module->header.patnum; k++)
 	{
+		if (!evaluate)
+			patternEditor->prepareUndo(&module->phead[k]);
 		patternEditorTools.attachPattern(&module->phead[k]);
 		result+=patternEditorTools.relocateCommands(relocateParameters, evaluate);				
+		if (!evaluate)
+			patternEditor->finishUndo(&module->phead[k]);
 	}
+
+	if (!evaluate)
+		patternEditor->endUndoGroup();
 	
 	if (!evaluate && result)
 		changed = true;
@@ -2385,12 +2468,22 @@ pp_int32 ModuleEditor::zeroOperands(const PatternEditorTools::OperandOptimizePar
 
 	PatternEditorTools patternEditorTools;
 
+	if (!evaluate)
+		patternEditor->beginUndoGroup();
+
 	for (mp_sint32 k = 0; k < module->header.patnum; k++)
 	{
+		if (!evaluate)
+			patternEditor->prepareUndo(&module->phead[k]);
 		patternEditorTools.attachPattern(&module->phead[k]);
 		result+=patternEditorTools.zeroOperands(optimizeParameters, evaluate);				
+		if (!evaluate)
+			patternEditor->finishUndo(&module->phead[k]);
 	}
 
+	if (!evaluate)
+		patternEditor->endUndoGroup();
+
 	if (!evaluate && result)
 		changed = true;
 
@@ -2403,12 +2496,22 @@ pp_int32 ModuleEditor::fillOperands(const PatternEditorTools::OperandOptimizePar
 
 	PatternEditorTools patternEditorTools;
 
+	if (!evaluate)
+		patternEditor->beginUndoGroup();
+
 	for (mp_sint32 k = 0; k < module->header.patnum; k++)
 	{
+		if (!evaluate)
+			patternEditor->prepareUndo(&module->phead[k]);
 		patternEditorTools.attachPattern(&module->phead[k]);
 		result+=patternEditorTools.fillOperands(optimizeParameters, evaluate);				
+		if (!evaluate)
+			patternEditor->finishUndo(&module->phead[k]);
 	}
 
+	if (!evaluate)
+		patternEditor->endUndoGroup();
+
 	if (!evaluate && result)
 		changed = true;
 
@@ -33,6 +33,7 @@ class PatternEditor;
 class SampleEditor;
 class EnvelopeEditor;
 class ModuleServices;
+class SongCheckpointIndex;
 class PlayerCriticalSection;
 
 class ModuleEditor
@@ -96,6 +97,7 @@ private:
 	EnvelopeEditor* envelopeEditor;
 	class ChangesListener* changesListener;
 	ModuleServices* moduleServices;
+	SongCheckpointIndex* songCheckpointIndex;
 	PlayerCriticalSection* playerCriticalSection;
 
 	bool changed;
@@ -147,6 +149,7 @@ public:
 	SampleEditor* getSampleEditor() { return sampleEditor; }
 	EnvelopeEditor* getEnvelopeEditor() { return envelopeEditor; }
 	ModuleServices* getModuleServices() { return moduleServices; }
+	SongCheckpointIndex* getSongCheckpointIndex() { return songCheckpointIndex; }
 	
 	void attachPlayerCriticalSection(PlayerCriticalSection* playerCriticalSection) { this->playerCriticalSection = playerCriticalSection; }
 
@@ -170,7 +173,9 @@ public:
 	void setCurrentCursorPosition(const PatternEditorTools::Position& currentCursorPosition) { this->currentCursorPosition = currentCursorPosition; }
 	const PatternEditorTools::Position& getCurrentCursorPosition() { return currentCursorPosition; }
 
-	void setChanged() { changed = true; }
+	void setChanged();
+	// same as above for changes which only affect the given pattern
+	void setPatternChanged(mp_sint32 patternIndex);
 	bool hasChanged() const { return changed; }
 
 	void reloadCurrentPattern();
@@ -237,6 +242,8 @@ public:
 	bool isEmpty() const;
 						 
 	bool openSong(const SYSCHAR* fileName, const SYSCHAR* preferredFileName = NULL);	
+	// load from the current position of a stream (e.g. a decompressed file in memory)
+	bool openSong(XMFileBase& f, const SYSCHAR* preferredFileName = NULL);
 	bool saveSong(const SYSCHAR* fileName, ModSaveTypes saveType = ModSaveTypeXM);
 	mp_sint32 saveBackup(const SYSCHAR* fileName);
 	
@@ -32,17 +32,65 @@
 #include "SongLengthEstimator.h"
 #include "PlayerGeneric.h"
 #include "AudioDriver_NULL.h"
+#include "MixerThreadPool.h"
 #include "XModule.h"
 
+ModuleServices::ModuleServices(XModule& module) :
+	module(module),
+	songLengthEstimator(new SongLengthEstimator(&module)),
+	estimatedSongLength(-1)
+{
+}
+
+ModuleServices::~ModuleServices()
+{
+	delete songLengthEstimator;
+}
+
 void ModuleServices::estimateSongLength()
 {
-	SongLengthEstimator estimator(&module);
-	estimatedSongLength = estimator.estimateSongLengthInSeconds();
+	estimatedSongLength = songLengthEstimator->estimateSongLengthInSeconds();
+}
+
+pp_int32 ModuleServices::getEstimatedSongLength()
+{
+	// this is cheap when nothing has changed since the last time
+	if (estimatedSongLength != -1)
+		estimatedSongLength = songLengthEstimator->estimateSongLengthInSeconds();
+		
+	return estimatedSongLength;
+}
+
+pp_int32 ModuleServices::getOrderStartTime(pp_int32 orderIndex)
+{
+	if (estimatedSongLength == -1)
+		return -1;
+		
+	return songLengthEstimator->getOrderStartInSeconds(orderIndex);
+}
+
+void ModuleServices::songChanged()
+{
+	songLengthEstimator->invalidate();
+}
+
+void ModuleServices::patternChanged(pp_int32 patternIndex)
+{
+	songLengthEstimator->invalidatePattern(patternIndex);
 }
 
 pp_int32 ModuleServices::estimateMixerVolume(WAVWriterParameters& parameters, 
 											 pp_int32* numSamplesProgressed/* = NULL*/)
 {
+	// float output doesn't clip, so there is no headroom to guess
+	// and no need to render the whole song just to find the peak
+	if (parameters.floatOutput)
+	{
+		if (numSamplesProgressed)
+			*numSamplesProgressed = 0;
+		return 256;
+	}
+
 	PlayerGeneric* player = new PlayerGeneric(parameters.sampleRate);
 
 	player->setBufferSize(1024);
@@ -108,39 +156,55 @@ pp_int32 ModuleServices::exportToWAV(const PPSystemString& fileName, WAVWriterPa
 	player->setResamplerType((ChannelMixer::ResamplerTypes)parameters.resamplerType);
 	player->setSampleShift(parameters.mixerShift);
 	player->setMasterVolume(parameters.mixerVolume);
+	player->setExportFloatOutput(parameters.floatOutput);
 	
 	pp_int32 res = 0;
 	
 	if (parameters.multiTrack)
 	{
-		mp_ubyte* muting = new mp_ubyte[module.header.channum];
+		const pp_uint32 numChannels = module.header.channum;
+		PPSystemString* fileNames = new PPSystemString[numChannels];
+		const SYSCHAR** stemFileNames = new const SYSCHAR*[numChannels];
+		pp_uint32 numStems = 0;
 		
 		PPSystemString baseName = fileName.stripExtension();
 		PPSystemString extension = fileName.getExtension();
 		
-		for (pp_uint32 i = 0; i < module.header.channum; i++)
+		for (pp_uint32 i = 0; i < numChannels; i++)
 		{
-			PPSystemString fileName = baseName;
+			stemFileNames[i] = NULL;
+			if (parameters.muting[i])
+				continue;
+		
+			fileNames[i] = baseName;
 			
 			char infix[80];
 			sprintf(infix, "_%02d", i+1);
 			
-			fileName.append(infix);
-			fileName.append(extension);
+			fileNames[i].append(infix);
+			fileNames[i].append(extension);
+			
+			stemFileNames[i] = fileNames[i];
+			numStems++;
+		}
 		
-			if (!parameters.muting[i])
-			{
-				memset(muting, 1, module.header.channum);				
-				muting[i] = 0;				
-				res = player->exportToWAV(fileName, &module, 
-										  parameters.fromOrder, parameters.toOrder, 
-										  muting, 
-										  module.header.channum, 
-										  parameters.panning);
-			}
+		if (numStems)
+		{
+			// all channels are rendered in a single pass over the song, 
+			// spread over all available processors
+			MixerThreadPool* threadPool = new MixerThreadPool(0);
+			player->setThreadPool(threadPool, 0);
+		
+			res = player->exportStemsToWAV(stemFileNames, &module, 
+										   parameters.fromOrder, parameters.toOrder, 
+										   parameters.panning);
+			
+			player->setThreadPool(NULL, 0);
+			delete threadPool;
 		}
 		
-		delete[] muting;
+		delete[] stemFileNames;
+		delete[] fileNames;
 	}
 	else
 	{
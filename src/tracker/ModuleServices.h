@@ -39,18 +39,25 @@ class ModuleServices
 private:
 	class XModule& module;
 
+	class SongLengthEstimator* songLengthEstimator;
 	pp_int32 estimatedSongLength;
 
 public:
-	ModuleServices(XModule& module) :
-		module(module),
-		estimatedSongLength(-1)
-	{
-	}
+	ModuleServices(XModule& module);
+	~ModuleServices();
 	
 	void estimateSongLength();
-	pp_int32 getEstimatedSongLength() const { return estimatedSongLength; }
+	// once the song length has been estimated it's kept up to date with the song
+	pp_int32 getEstimatedSongLength();
 	void resetEstimatedSongLength() { estimatedSongLength = -1; }
+	// time in seconds when the order is played first, -1 if it isn't played
+	// or the song length isn't estimated
+	pp_int32 getOrderStartTime(pp_int32 orderIndex);
+	
+	// the song has been changed
+	void songChanged();
+	// a pattern has been edited, only the song from where it's played first needs to be followed again
+	void patternChanged(pp_int32 patternIndex);
 	
 	struct WAVWriterParameters
 	{
@@ -66,6 +73,7 @@ public:
 		const pp_uint8* panning;
 		
 		bool multiTrack;
+		bool floatOutput;
 		
 		WAVWriterParameters() :
 			sampleRate(0),
@@ -77,7 +85,8 @@ public:
 			toOrder(0),
 			muting(NULL),
 			panning(NULL),
-			multiTrack(false)
+			multiTrack(false),
+			floatOutput(false)
 		{
 		}
 	};
@@ -58,58 +58,59 @@ PatternEditor::ClipBoard* PatternEditor::ClipBoard::getInstance(ClipBoardTypes t
 }
 
 void PatternEditor::prepareUndo()
+{
+	prepareUndo(pattern);
+}
+
+void PatternEditor::prepareUndo(TXMPattern* pattern)
 {
 	PatternEditorTools patternEditorTools(pattern); 
 	patternEditorTools.normalize(); 
 
 	undoUserData.clear();
-	notifyListener(NotificationFeedUndoData);
+	if (pattern == this->pattern)
+		notifyListener(NotificationFeedUndoData);
 
-	delete before; 
-	before = new PatternUndoStackEntry(*pattern, cursor.channel, cursor.row, cursor.inner, &undoUserData);
+	PatternUndoStackEntry::CursorPosition cursorPosition = {cursor.channel, cursor.row, cursor.inner};
+	undoJournal->prepare(*pattern, cursorPosition, undoUserData);
 }
 
 bool PatternEditor::finishUndo(LastChanges lastChange, bool nonRepeat/* = false*/)
 {
-	bool result = false;
+	// Special treatment for non repeating changes (e.g. resizing):
+	// if the last change has been the same, the new one is added to it
+	bool result = storeUndo(pattern, nonRepeat && this->lastChange == lastChange);
+
+	this->lastChange = lastChange; 
 
+	return result;
+}
+
+bool PatternEditor::storeUndo(TXMPattern* pattern, bool merge)
+{
 	PatternEditorTools patternEditorTools(pattern); 
 	patternEditorTools.normalize(); 
 
 	undoUserData.clear();
-	notifyListener(NotificationFeedUndoData);
-
-	PatternUndoStackEntry after(*pattern, cursor.channel, cursor.row, cursor.inner, &undoUserData); 
-	if (*before != after) 
-	{ 
-		PatternEditorTools::Position afterPos;
-		afterPos.channel = after.getCursorPositionChannel();
-		afterPos.row = after.getCursorPositionRow();
-		afterPos.inner = after.getCursorPositionInner();
-
-		PatternEditorTools::Position beforePos;		
-		beforePos.channel = before->getCursorPositionChannel();
-		beforePos.row = before->getCursorPositionRow();
-		beforePos.inner = before->getCursorPositionInner();
-	
-		result = true;
+	if (pattern == this->pattern)
+		notifyListener(NotificationFeedUndoData);
+
+	PatternUndoStackEntry::CursorPosition cursorPosition = {cursor.channel, cursor.row, cursor.inner};
+	if (!undoJournal->finish(pattern, cursorPosition, undoUserData, merge))
+		return false;
+
+	if (pattern == this->pattern)
+	{
+		const PatternUndoStackEntry::CursorPosition& cursorBefore = undoJournal->getCursorBefore();
 		
-		lastOperationDidChangeRows = after.GetPattern().rows != before->GetPattern().rows;
-		lastOperationDidChangeCursor = beforePos != afterPos;
+		lastOperationDidChangeRows = undoJournal->getPatternBefore().rows != pattern->rows;
+		lastOperationDidChangeCursor = cursorBefore.channel != cursor.channel ||
+			cursorBefore.row != cursor.row ||
+			cursorBefore.inner != cursor.inner;
 		notifyListener(NotificationChanges);
-		if (undoStack) 
-		{ 
-			if (nonRepeat && this->lastChange != lastChange)
-				undoStack->Push(*before); 	
-			else if (!nonRepeat)
-				undoStack->Push(*before); 				
-			undoStack->Push(after); 
-			undoStack->Pop(); 
-		} 
-	} 
-	this->lastChange = lastChange; 
+	}
 
-	return result;
+	return true;
 }
 
 PatternEditor::PatternEditor() :
@@ -121,12 +122,9 @@ PatternEditor::PatternEditor() :
 	instrumentEnabled(true),
 	instrumentBackTrace(false),
 	currentOctave(5),
-	before(NULL),
-	undoStack(NULL),
 	lastChange(LastChangeNone)	
 {
-	// Undo history
-	undoHistory = new UndoHistory<TXMPattern, PatternUndoStackEntry>(UNDOHISTORYSIZE_PATTERNEDITOR);
+	undoJournal = new PatternUndoJournal();
 	
 	resetCursor();
 	resetSelection();
@@ -136,9 +134,7 @@ PatternEditor::PatternEditor() :
 
 PatternEditor::~PatternEditor()
 {
-	delete undoHistory;
-	delete undoStack;
-	delete before;
+	delete undoJournal;
 }
 
 void PatternEditor::attachPattern(TXMPattern* pattern, XModule* module) 
@@ -146,33 +142,9 @@ void PatternEditor::attachPattern(TXMPattern* pattern, XModule* module)
 	if (this->pattern == pattern && this->module == module)
 		return;
 
-	// --------- update undo history information --------------------	
-	if (undoStack)
-	{	
-		// if the undo stack is empty, we don't need to save current undo stack
-		if (!undoStack->IsEmpty() || !undoStack->IsTop())
-		{	
-			undoStack = undoHistory->getUndoStack(pattern, this->pattern, undoStack);
-		}
-		// delete it if it's empty
-		else
-		{
-			delete undoStack;
-			undoStack = NULL;
-
-			undoStack = undoHistory->getUndoStack(pattern, NULL, NULL);
-		}
-	}
-
 	attachModule(module);	
 	this->pattern = pattern; 
 	
-	// couldn't get any from history, create new one
-	if (!undoStack)
-	{
-		undoStack = new PPUndoStack<PatternUndoStackEntry>(UNDODEPTH_PATTERNEDITOR);
-	}
-
 	notifyListener(NotificationReload);
 }
 
@@ -180,11 +152,7 @@ void PatternEditor::reset()
 {
 	resetSelection();
 
-	delete undoHistory;
-	undoHistory = new UndoHistory<TXMPattern, PatternUndoStackEntry>(UNDOHISTORYSIZE_PATTERNEDITOR);
-			
-	delete undoStack;
-	undoStack = new PPUndoStack<PatternUndoStackEntry>(UNDODEPTH_PATTERNEDITOR);	
+	undoJournal->clear();
 }
 
 pp_int32 PatternEditor::getNumChannels() const
@@ -272,67 +240,40 @@ pp_int32 PatternEditor::getCurrentActiveInstrument()
 
 bool PatternEditor::undo()
 {
-	if (undoStack->IsEmpty()) return false;
-	if (undoStack)
-		return revoke(undoStack->Pop());
-	return false;	
+	return revoke(true);
 }
 
 bool PatternEditor::redo()
 {
-	if (undoStack->IsTop()) return false;
-	if (undoStack)
-		return revoke(undoStack->Advance());
-	return false;
+	return revoke(false);
 }
 
-bool PatternEditor::revoke(const PatternUndoStackEntry* stackEntry)
+bool PatternEditor::revoke(bool undo)
 {
-	const TXMPattern& stackPattern = stackEntry->GetPattern();
+	if (pattern == NULL)
+		return false;
 
 	enterCriticalSection();
 
-	bool res = false;
+	const PatternUndoStackEntry* stackEntry = undo ? undoJournal->undo(pattern) : undoJournal->redo(pattern);
 
-	if (stackPattern.rows != pattern->rows ||
-		stackPattern.channum != pattern->channum ||
-		stackPattern.effnum != pattern->effnum)
+	if (stackEntry)
 	{
-		pattern->rows = stackPattern.rows;
-		pattern->channum = stackPattern.channum;
-		pattern->effnum = stackPattern.effnum;
-	
-		mp_sint32 patternSize = pattern->rows*pattern->channum*(2+pattern->effnum*2);	
-
-		if (pattern->patternData)
-		{
-			delete[] pattern->patternData;
-			pattern->patternData = new mp_ubyte[patternSize];
-			memset(pattern->patternData, 0, patternSize);
-		}
-	}
-	
-	if (stackPattern.rows == pattern->rows &&
-		stackPattern.channum == pattern->channum &&
-		stackPattern.effnum == pattern->effnum)
-	{
-		cursor.channel = stackEntry->getCursorPositionChannel();
-		cursor.row = stackEntry->getCursorPositionRow();
-		cursor.inner = stackEntry->getCursorPositionInner();
+		const PatternUndoStackEntry::CursorPosition& cursorPosition = stackEntry->getCursorPosition(undo);
+		cursor.channel = cursorPosition.channel;
+		cursor.row = cursorPosition.row;
+		cursor.inner = cursorPosition.inner;
 		
-		pattern->decompress(stackPattern.patternData, stackPattern.len);
-
 		// keep over userdata
-		undoUserData = stackEntry->getUserData();
+		undoUserData = stackEntry->getUserData(undo);
 		notifyListener(NotificationFetchUndoData);
 
 		notifyListener(NotificationChanges);
-		res = true;
 	}
 	
 	leaveCriticalSection();
 	
-	return res;
+	return stackEntry != NULL;
 }
 
 void PatternEditor::clearRange(const PatternEditorTools::Position& rangeStart, const PatternEditorTools::Position& rangeEnd)
@@ -206,9 +206,7 @@ private:
 		
 	// undo/redo information
 	UndoStackEntry::UserData undoUserData;
-	PatternUndoStackEntry* before;
-	PPUndoStack<PatternUndoStackEntry>* undoStack;	
-	UndoHistory<TXMPattern, PatternUndoStackEntry>* undoHistory;
+	PatternUndoJournal* undoJournal;
 	LastChanges lastChange;	
 	bool lastOperationDidChangeRows;
 	bool lastOperationDidChangeCursor;
@@ -217,8 +215,9 @@ private:
 
 	void prepareUndo();
 	bool finishUndo(LastChanges lastChange, bool nonRepeat = false);
+	bool storeUndo(TXMPattern* pattern, bool merge);
 	
-	bool revoke(const PatternUndoStackEntry* stackEntry);
+	bool revoke(bool undo);
 
 	void cut(ClipBoard& clipBoard);
 	void copy(ClipBoard& clipBoard);
@@ -276,8 +275,8 @@ public:
 	void decreaseCurrentOctave() { if (currentOctave > 1) currentOctave--; }	
 
 	// --- Multilevel UNDO / REDO --------------------------------------------
-	bool canUndo() const { if (undoStack) return !undoStack->IsEmpty(); else return false; }
-	bool canRedo() const { if (undoStack) return !undoStack->IsTop(); else return false; }
+	bool canUndo() const { return undoJournal->canUndo(pattern); }
+	bool canRedo() const { return undoJournal->canRedo(pattern); }
 	// undo last changes
 	bool undo();
 	// redo last changes
@@ -285,6 +284,16 @@ public:
 	void setUndoUserData(const void* data, pp_uint32 dataLen) { this->undoUserData = UndoStackEntry::UserData((pp_uint8*)data, dataLen); }
 	pp_uint32 getUndoUserDataLen() const { return undoUserData.getDataLen(); }
 	const void* getUndoUserData() const { return (void*)undoUserData.getData(); }
+	// Changes of any pattern of the song (song wide operations):
+	// call prepareUndo before and finishUndo after changing the pattern.
+	// The changes made between beginUndoGroup and endUndoGroup are undone at once
+	void beginUndoGroup() { undoJournal->beginGroup(); }
+	void endUndoGroup() { undoJournal->endGroup(); }
+	void prepareUndo(TXMPattern* pattern);
+	bool finishUndo(TXMPattern* pattern) { return storeUndo(pattern, false); }
+	// The pattern storage has been moved or replaced behind the editor's back:
+	// forget the changes of the pattern or of all patterns
+	void clearUndo(const TXMPattern* pattern = NULL) { if (pattern) undoJournal->clear(pattern); else undoJournal->clear(); }
 	
 	// --- dealing with the pattern data -------------------------------------
 	void clearSelection();
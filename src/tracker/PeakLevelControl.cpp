@@ -52,6 +52,7 @@ PeakLevelControl::PeakLevelControl(pp_int32 id,
 	visibleHeight = size.height - 2;
 	
 	peak[0] = peak[1] = 0;
+	load = 0;
 	
 	buildColorLUT();
 }
@@ -84,6 +85,10 @@ void PeakLevelControl::paint(PPGraphicsAbstract* g)
 
 	pp_int32 centerx = location.x + xOffset + (visibleWidth >> 1)-1;
 
+	// the load of the audio thread goes along the bottom
+	const pp_int32 loady = location.y + size.height - 4;
+	const pp_int32 peaky = loady - 1;
+
 	pp_int32 i;
 
 	pp_int32 pixelPeak = ((visibleWidth >> 1)*peak[0]) >> 16;
@@ -94,7 +99,7 @@ void PeakLevelControl::paint(PPGraphicsAbstract* g)
 	{
 		pp_int32 c = i*256/maxPeak; 
 		g->setColor(peakColorLUT[c][0], peakColorLUT[c][1], peakColorLUT[c][2]);
-		g->drawVLine(location.y + yOffset, location.y + yOffset + visibleHeight, centerx - i);
+		g->drawVLine(location.y + yOffset, peaky, centerx - i);
 	}
 
 	pixelPeak = ((visibleWidth >> 1)*peak[1]) >> 16;
@@ -102,7 +107,16 @@ void PeakLevelControl::paint(PPGraphicsAbstract* g)
 	{
 		pp_int32 c = i*256/maxPeak; 
 		g->setColor(peakColorLUT[c][0], peakColorLUT[c][1], peakColorLUT[c][2]);
-		g->drawVLine(location.y + yOffset, location.y + yOffset + visibleHeight, centerx + i);
+		g->drawVLine(location.y + yOffset, peaky, centerx + i);
+	}
+
+	const pp_int32 maxLoad = visibleWidth - 2;
+	const pp_int32 pixelLoad = (maxLoad*load) / 100;
+	for (i = 0; i < pixelLoad; i+=2)
+	{
+		pp_int32 c = i*256/maxLoad; 
+		g->setColor(peakColorLUT[c][0], peakColorLUT[c][1], peakColorLUT[c][2]);
+		g->drawVLine(loady, loady + 2, location.x + xOffset + i);
 	}
 }
 
@@ -49,6 +49,8 @@ private:
 	pp_int32 visibleHeight;
 
 	pp_int32 peak[2];
+	// audio thread load in percent
+	pp_int32 load;
 	
 	pp_uint8 peakColorLUT[256][3];
 
@@ -69,6 +71,9 @@ public:
 	void setPeak(pp_int32 whichPeak, pp_int32 p) { if (p>65536) p = 65536; if (p < 0) p = 0; peak[whichPeak] = p; }
 	pp_int32 getPeak(pp_int32 whichPeak) const { return peak[whichPeak]; } 
 
+	void setLoad(pp_int32 load) { if (load > 100) load = 100; if (load < 0) load = 0; this->load = load; }
+	pp_int32 getLoad() const { return load; }
+
 	// from PPControl
 	virtual void paint(PPGraphicsAbstract* graphics);
 	
@@ -35,58 +35,66 @@
 #include "PPSystem.h"
 #include "PlayerCriticalSection.h"
 #include "ModuleEditor.h"
+#include "SongCheckpointIndex.h"
+#include "LockFreeQueue.h"
 
-class PlayerStatusTracker : public PlayerSTD::StatusEventListener
+// Everything the UI wants to change while the song is playing goes through
+// this single producer/single consumer queue. The mixing thread applies 
+// the commands at the start of every beat packet, so the player never 
+// sees a half done change and the UI never has to suspend the player.
+class PlayerStatusTracker : public PlayerSTD::StatusEventListener, public ChannelMixer::CommandHandler
 {
 public:
+	enum CommandCodes
+	{
+		CommandCodeInvalid = 0,
+		// channel, data[0] = note, data[1] = instrument, data[2] = volume
+		CommandCodeNote,
+		// channel, pointer = sample, data[0] = note, data[1] = range start, data[2] = range end
+		CommandCodeSample,
+		// channel
+		CommandCodeStopSample,
+		// data[0] = instrument, data[1] = number of channels to look at
+		CommandCodeStopInstrument,
+		// channel, data[0] = mute
+		CommandCodeMute,
+		// channel, data[0] = panning
+		CommandCodePanning,
+		// data[0] = order position, data[1] = row
+		CommandCodePatternPos
+	};
+	
+	struct Command
+	{
+		mp_ubyte code;
+		mp_sint32 channel;
+		mp_sint32 data[4];
+		const void* pointer;
+	};
+
 	PlayerStatusTracker(PlayerController& playerController) :
-		playerController(playerController)
+		playerController(playerController),
+		numPendingNotes(0)
 	{
-		clearUpdateCommandBuff();
+	}
+	
+	// this is being called from the mixer callback in a serialized fashion
+	virtual void handleCommands(ChannelMixer& mixer)
+	{
+		PlayerSTD& player = static_cast<PlayerSTD&>(mixer);
+	
+		Command command;
+		while (commands.pop(command))
+			handleCommand(player, command);
 	}
 	
 	// this is being called from the player callback in a serialized fashion
 	virtual void playerTickStarted(PlayerSTD& player, XModule& module) 
 	{ 
-		while (rbReadIndex < rbWriteIndex)
-		{			
-			mp_sint32 idx = rbReadIndex & (UPDATEBUFFSIZE-1);			
+		for (mp_sint32 i = 0; i < numPendingNotes; i++)
+			executeCommand(player, pendingNotes[i]);
 			
-			// handle notes that are played from external source
-			// i.e. keyboard playback
-			switch (updateCommandBuff[idx].code)
-			{
-				case UpdateCommandCodeNote:
-				{
-					UpdateCommandNote* command = reinterpret_cast<UpdateCommandNote*>(&updateCommandBuff[idx]);
-					mp_sint32 note = command->note;
-					if (note)
-					{
-						player.playNote(command->channel, note, 
-										command->ins, 
-										command->volume);
-						command->note = 0;
-					}
-					break;
-				}
-
-				case UpdateCommandCodeSample:
-				{
-					UpdateCommandSample* command = reinterpret_cast<UpdateCommandSample*>(&updateCommandBuff[idx]);
-					const TXMSample* smp = command->smp;
-					if (smp)
-					{
-						playSampleInternal(player, command->channel, smp, command->currentSamplePlayNote,
-										   command->rangeStart,  command->rangeEnd);
-						command->smp = NULL;
-					}
-					
-					break;
-				}
-				
-			}
-			rbReadIndex++;
-		}
+		numPendingNotes = 0;
 	}	
 	
 	virtual void patternEndReached(PlayerSTD& player, XModule& module, mp_sint32& newOrderIndex) 
@@ -94,38 +102,145 @@ public:
 		handleQueuedPositions(player, newOrderIndex);
 	}
 
-	void playNote(mp_ubyte chn, mp_sint32 note, mp_sint32 ins, mp_sint32 vol/* = -1*/)
-	{	
-		// fill ring buffer with note entries
-		// the callback will query these notes and play them 
-		mp_sint32 idx = rbWriteIndex & (UPDATEBUFFSIZE-1);
-		UpdateCommandNote* command = reinterpret_cast<UpdateCommandNote*>(&updateCommandBuff[idx]);
-		command->channel = chn;
-		command->ins = ins;
-		command->volume = vol;
-		command->note = note;
-		// code needs to be filled in last
-		command->code = UpdateCommandCodeNote;
-		rbWriteIndex++;
+	// Queue up a command for the mixer callback. Nothing picks up the queue
+	// while the player isn't being mixed, the command is then handled right
+	// away together with whatever is still queued, so nothing stale is left
+	// behind to be replayed after the player has been set up anew. 
+	// If the queue is full anything which changes state is applied 
+	// right away, like it would be without the queue, notes get lost.
+	void postCommand(PlayerSTD& player, const Command& command)
+	{
+		if (!playerController.isPlayerMixed())
+		{
+			flushCommands(player);
+			handleCommand(player, command);
+			return;
+		}
+	
+		if (commands.push(command))
+			return;
+			
+		if (command.code != CommandCodeNote && command.code != CommandCodeSample)
+			executeCommand(player, command);
 	}
-
-	void playSample(mp_ubyte chn, const TXMSample& smp, mp_sint32 currentSamplePlayNote, mp_sint32 rangeStart, mp_sint32 rangeEnd)
+	
+	// handle everything that's still queued up on the calling thread,
+	// only call this when the player is no longer being mixed
+	void flushCommands(PlayerSTD& player)
+	{
+		Command command;
+		while (commands.pop(command))
+			handleCommand(player, command);
+	}
+	
+	// only call this when the player is no longer being mixed
+	void clearCommands()
+	{
+		Command command;
+		while (commands.pop(command))
+		{
+		}
+		numPendingNotes = 0;
+	}
+	
+	static Command makeCommand(CommandCodes code, mp_sint32 channel = 0, 
+							   mp_sint32 data0 = 0, mp_sint32 data1 = 0, 
+							   mp_sint32 data2 = 0, mp_sint32 data3 = 0, 
+							   const void* pointer = NULL)
 	{
-		// fill ring buffer with sample playback entries
-		mp_sint32 idx = rbWriteIndex & (UPDATEBUFFSIZE-1);
-		UpdateCommandSample* command = reinterpret_cast<UpdateCommandSample*>(&updateCommandBuff[idx]);
-		command->channel = chn;
-		command->currentSamplePlayNote = currentSamplePlayNote;
-		command->rangeStart = rangeStart;
-		command->rangeEnd = rangeEnd;
-		command->smp = &smp;
-		command->code = UpdateCommandCodeSample;
-		rbWriteIndex++;
+		Command command;
+		command.code = (mp_ubyte)code;
+		command.channel = channel;
+		command.data[0] = data0;
+		command.data[1] = data1;
+		command.data[2] = data2;
+		command.data[3] = data3;
+		command.pointer = pointer;
+		return command;
 	}
-				  
+	
 private:
+	enum
+	{
+		// must be 2^n
+		COMMANDQUEUESIZE = 256,
+		MAXPENDINGNOTES = 128
+	};
+
 	PlayerController& playerController;
 	
+	LockFreeQueue<Command, COMMANDQUEUESIZE> commands;
+	
+	// only touched by the mixer callback or while the player isn't being mixed
+	Command pendingNotes[MAXPENDINGNOTES];
+	mp_sint32 numPendingNotes;
+	
+	void handleCommand(PlayerSTD& player, const Command& command)
+	{
+		switch (command.code)
+		{
+			// notes are played from an external source (i.e. keyboard playback),
+			// they're triggered together with the next player tick
+			case CommandCodeNote:
+			case CommandCodeSample:
+				if (numPendingNotes < MAXPENDINGNOTES)
+					pendingNotes[numPendingNotes++] = command;
+				break;
+				
+			default:
+				executeCommand(player, command);
+		}
+	}
+	
+	void executeCommand(PlayerSTD& player, const Command& command)
+	{
+		switch (command.code)
+		{
+			case CommandCodeNote:
+				if (command.data[0])
+					player.playNote((mp_ubyte)command.channel, command.data[0], command.data[1], command.data[2]);
+				break;
+				
+			case CommandCodeSample:
+				playSampleInternal(player, (mp_ubyte)command.channel, (const TXMSample*)command.pointer, 
+								   command.data[0], command.data[1], command.data[2]);
+				break;
+				
+			case CommandCodeStopSample:
+				player.stopSample(command.channel);
+				player.chninfo[command.channel].flags &= ~0x100; // CHANNEL_FLAGS_UPDATE_IGNORE
+				break;
+				
+			case CommandCodeStopInstrument:
+				for (mp_sint32 i = 0; i < command.data[1]; i++)
+				{
+					if (player.chninfo[i].ins == command.data[0])
+					{
+						player.stopSample(i);
+						player.chninfo[i].flags &= ~0x100; // CHANNEL_FLAGS_UPDATE_IGNORE
+					}
+				}
+				break;
+				
+			case CommandCodeMute:
+				player.muteChannel(command.channel, command.data[0] != 0);
+				break;
+				
+			case CommandCodePanning:
+				player.setPanning((mp_ubyte)command.channel, (mp_ubyte)command.data[0]);
+				break;
+				
+			case CommandCodePatternPos:
+			{
+				// carry over the song state of the new position if it's known already
+				SongCheckpointIndex* songCheckpointIndex = playerController.getSongCheckpointIndex();
+				if (songCheckpointIndex == NULL || !songCheckpointIndex->seek(player, command.data[0], command.data[1]))
+					player.setPatternPos(command.data[0], command.data[1], false, false);
+				break;
+			}
+		}
+	}
+	
 	void handleQueuedPositions(PlayerSTD& player, mp_sint32& poscnt)
 	{
 		// there is a queued position
@@ -189,60 +304,6 @@ private:
 			player.playSample(chn, smp->sample, smp->samplen, rangeStart, 0, false, 0, rangeEnd, flags);
 		}
 	}
-
-	void clearUpdateCommandBuff()
-	{
-		memset(updateCommandBuff, 0, sizeof(updateCommandBuff));
-		rbReadIndex = rbWriteIndex = 0;
-	}
-	
-	enum
-	{
-		// must be 2^n
-		UPDATEBUFFSIZE = 128
-	};
-	
-	enum UpdateCommandCodes
-	{
-		UpdateCommandCodeInvalid = 0,
-		UpdateCommandCodeNote,
-		UpdateCommandCodeSample,
-	};
-	
-	struct UpdateCommand
-	{
-		mp_ubyte code;			
-		mp_uint32 data[8];
-		void* pdata[8];
-	};
-
-	struct UpdateCommandNote
-	{
-		mp_ubyte code;			
-		mp_sint32 note;
-		mp_sint32 channel;
-		mp_sint32 ins;
-		mp_sint32 volume;
-		mp_uint32 data[4];
-		void* pdata[8];
-	};
-	
-	struct UpdateCommandSample
-	{
-		mp_ubyte code;
-		mp_uint32 currentSamplePlayNote;
-		mp_uint32 rangeStart;
-		mp_uint32 rangeEnd;
-		mp_sint32 channel;
-		mp_uint32 data[4];
-		const TXMSample* smp;
-		void* pdata[7];
-	};
-	
-	UpdateCommand updateCommandBuff[UPDATEBUFFSIZE];
-	
-	mp_sint32 rbReadIndex;
-	mp_sint32 rbWriteIndex;	
 };
 
 void PlayerController::assureNotSuspended()
@@ -255,6 +316,11 @@ void PlayerController::assureNotSuspended()
 	}
 }
 
+bool PlayerController::isPlayerMixed()
+{
+	return mixer->isActive() && !mixer->isDeviceRemoved(player) && !mixer->isDevicePaused(player);
+}
+
 void PlayerController::reset()
 {
 	if (!player)
@@ -295,15 +361,19 @@ PlayerController::PlayerController(MasterMixer* mixer, bool fakeScopes) :
 	useVirtualChannels(TrackerConfig::useVirtualChannels),
 	multiChannelKeyJazz(true),
 	multiChannelRecord(true),
-	mixerDataCacheSize(fakeScopes ? 0 : 512*2),
-	mixerDataCache(fakeScopes ? NULL : new mp_sint32[mixerDataCacheSize])
+	scopeTapCacheSize(0),
+	scopeTapCache(NULL)
 {
 	criticalSection = new PlayerCriticalSection(*this);
 
 	player = new PlayerSTD(mixer->getSampleRate(), playerStatusTracker);
+	player->setCommandHandler(playerStatusTracker);
 	player->setPlayMode(PlayerBase::PlayMode_FastTracker2);
 	player->resetMainVolumeOnStartPlay(false);
 	player->setBufferSize(mixer->getBufferSize());
+	// let the mixer record what the channels are playing for the scopes
+	player->setScopeTap(!fakeScopes);
+	player->setProfiler(&mixer->getProfiler());
 
 	currentPlayingChannel = useVirtualChannels ? numPlayerChannels : 0;
 	
@@ -337,7 +407,7 @@ PlayerController::PlayerController(MasterMixer* mixer, bool fakeScopes) :
 
 PlayerController::~PlayerController()
 {
-	delete[] mixerDataCache;
+	delete[] scopeTapCache;
 
 	if (player)
 	{
@@ -360,6 +430,9 @@ void PlayerController::attachModuleEditor(ModuleEditor* moduleEditor)
 
 	if (!mixer->isDeviceRemoved(player))
 		mixer->removeDevice(player);
+		
+	// whatever is still queued up refers to the previous module
+	playerStatusTracker->clearCommands();
 
 	ASSERT(sizeof(muteChannels)/sizeof(bool) >= (unsigned)totalPlayerChannels);
 
@@ -405,6 +478,14 @@ void PlayerController::playSong(mp_sint32 startIndex, mp_sint32 rowPosition, boo
 	player->restart(startIndex, rowPosition, false, panning);
 	player->setIdle(false);
 	//resetPlayTimeCounter();
+	
+	// start with the song state we'd have when playing from the beginning
+	SongCheckpointIndex* songCheckpointIndex = getSongCheckpointIndex();
+	if (songCheckpointIndex && (startIndex || rowPosition))
+	{
+		songCheckpointIndex->validate(*player, panning);
+		songCheckpointIndex->seek(*player, startIndex, rowPosition);
+	}
 
 	patternPlay = false;
 	playRowOnly = false;
@@ -556,6 +637,13 @@ void PlayerController::continuePlaying(bool assureNotSuspended)
 	player->restart(lastPosition, lastRow, false, panning);
 	player->setIdle(false);
 
+	SongCheckpointIndex* songCheckpointIndex = getSongCheckpointIndex();
+	if (songCheckpointIndex && !wasPlayingPattern)
+	{
+		songCheckpointIndex->validate(*player, panning);
+		songCheckpointIndex->seek(*player, lastPosition, lastRow);
+	}
+
 	patternPlay = wasPlayingPattern;
 	playRowOnly = false;
 	
@@ -735,7 +823,8 @@ void PlayerController::playSample(const TXMSample& smp, mp_sint32 currentSampleP
 	{
 		pp_int32 i = numPlayerChannels + numVirtualChannels + 1;
 
-		playerStatusTracker->playSample(i, smp, currentSamplePlayNote, rangeStart, rangeEnd);		
+		playerStatusTracker->postCommand(*player, PlayerStatusTracker::makeCommand(PlayerStatusTracker::CommandCodeSample, i, 
+																				   currentSamplePlayNote, rangeStart, rangeEnd, 0, &smp));
 	}	
 
 }
@@ -747,12 +836,9 @@ void PlayerController::stopSample()
 
 	if (player->isPlaying())
 	{
-		// doesn't seem to be a critical race condition
 		pp_int32 i = numPlayerChannels + numVirtualChannels + 1;
 
-		player->stopSample(i);
-
-		player->chninfo[i].flags &= ~0x100; // CHANNEL_FLAGS_UPDATE_IGNORE		
+		playerStatusTracker->postCommand(*player, PlayerStatusTracker::makeCommand(PlayerStatusTracker::CommandCodeStopSample, i));
 	}	
 
 }
@@ -764,15 +850,8 @@ void PlayerController::stopInstrument(mp_sint32 insIndex)
 
 	if (player->isPlaying())
 	{
-		// doesn't seem to be a critical race condition
-		for (pp_int32 i = 0; i < numPlayerChannels + numVirtualChannels; i++)
-		{
-			if (player->chninfo[i].ins == insIndex)
-			{
-				player->stopSample(i);
-				player->chninfo[i].flags &= ~0x100; // CHANNEL_FLAGS_UPDATE_IGNORE
-			}
-		}
+		playerStatusTracker->postCommand(*player, PlayerStatusTracker::makeCommand(PlayerStatusTracker::CommandCodeStopInstrument, 0, 
+																				   insIndex, numPlayerChannels + numVirtualChannels));
 	}	
 }
 
@@ -784,7 +863,7 @@ void PlayerController::playNote(mp_ubyte chn, mp_sint32 note, mp_sint32 i, mp_si
 	assureNotSuspended();
 
 	// note playing goes synchronized in the playback callback
-	playerStatusTracker->playNote(chn, note, i, vol);
+	playerStatusTracker->postCommand(*player, PlayerStatusTracker::makeCommand(PlayerStatusTracker::CommandCodeNote, chn, note, i, vol));
 }
 
 void PlayerController::suspendPlayer(bool bResetMainVolume/* = true*/, bool stopPlaying/* = true*/)
@@ -795,6 +874,9 @@ void PlayerController::suspendPlayer(bool bResetMainVolume/* = true*/, bool stop
 	mixer->pauseDevice(player);
 	suspended = true;
 
+	// apply what's still queued before the player state is changed from here
+	playerStatusTracker->flushCommands(*player);
+
 	if (stopPlaying)
 	{
 		stopSample();
@@ -822,7 +904,7 @@ void PlayerController::muteChannel(mp_sint32 c, bool m)
 	muteChannels[c] = m;
 	
 	if (player)
-		player->muteChannel(c, m);
+		playerStatusTracker->postCommand(*player, PlayerStatusTracker::makeCommand(PlayerStatusTracker::CommandCodeMute, c, m));
 }
 
 bool PlayerController::isChannelMuted(mp_sint32 c)
@@ -1009,11 +1091,8 @@ void PlayerController::setPanning(mp_ubyte chn, mp_ubyte pan)
 
 	panning[chn] = pan;
 	
-	if (player && player->isPlaying())
-	{
-		for (mp_sint32 i = 0; i < TrackerConfig::numPlayerChannels; i++)
-			player->setPanning((mp_ubyte)i, panning[i]);
-	}
+	if (player && player->isPlaying() && chn < TrackerConfig::numPlayerChannels)
+		playerStatusTracker->postCommand(*player, PlayerStatusTracker::makeCommand(PlayerStatusTracker::CommandCodePanning, chn, pan));
 }
 
 void PlayerController::getPosition(mp_sint32& pos, mp_sint32& row)
@@ -1030,7 +1109,29 @@ void PlayerController::getPosition(mp_sint32& order, mp_sint32& row, mp_sint32&
 
 void PlayerController::setPatternPos(mp_sint32 pos, mp_sint32 row)
 {
-	player->setPatternPos(pos, row, false, false);
+	SongCheckpointIndex* songCheckpointIndex = getSongCheckpointIndex();
+	if (songCheckpointIndex)
+		songCheckpointIndex->validate(*player, panning);
+
+	playerStatusTracker->postCommand(*player, PlayerStatusTracker::makeCommand(PlayerStatusTracker::CommandCodePatternPos, 0, pos, row));
+}
+
+void PlayerController::buildSongCheckpoints()
+{
+	SongCheckpointIndex* songCheckpointIndex = getSongCheckpointIndex();
+	if (songCheckpointIndex == NULL || !module->isModuleLoaded())
+		return;
+	
+	songCheckpointIndex->validate(*player, panning);
+	songCheckpointIndex->build(BuildRowsPerUpdate);
+}
+
+SongCheckpointIndex* PlayerController::getSongCheckpointIndex()
+{
+	if (!player || !moduleEditor)
+		return NULL;
+		
+	return moduleEditor->getSongCheckpointIndex();
 }
 
 void PlayerController::switchPlayMode(PlayModes playMode, bool exactSwitch/* = true*/)
@@ -1149,6 +1250,14 @@ mp_sint32 PlayerController::getPlayerNumPlayingChannels()
 	return player->initialNumChannels;
 }
 
+mp_uint32 PlayerController::getMixTime()
+{
+	if (!player || !mixer)
+		return 0;
+	
+	return mixer->getDeviceMixTime(player);
+}
+
 mp_sint32 PlayerController::getCurrentSamplePosition()
 {
 	if (mixer && mixer->getAudioDriver())
@@ -1172,18 +1281,20 @@ bool PlayerController::isSamplePlaying(const TXMSample& smp, mp_sint32 channel,
 		
 	ChannelMixer* mixer = player;
 
-	// this rather critical
-	// maybe someday this entire decision should go into the
-	// player or mixer class itself, so I don't need to access it here
-	pp_int32 j = getCurrentBeatIndex();
-	pos = mixer->channel[channel].timeRecord[j].smppos;
+	ChannelMixer::TTimeRecord state;
+	// the scope tap keeps the states in a ring buffer which isn't written to
+	// while we're reading, otherwise this is rather critical
+	if (!mixer->getScopeTapState(channel, getCurrentSamplePosition(), state))
+		state = mixer->channel[channel].timeRecord[getCurrentBeatIndex()];
+
+	pos = state.smppos;
 	
 	// compare sample from sample editor against sample from current mixer channel
 	if (pos >= 0 && 
-		(void*)mixer->channel[channel].timeRecord[j].sample == (void*)smp.sample)
+		(void*)state.sample == (void*)smp.sample)
 	{
-		vol = (mixer->channel[channel].timeRecord[j].volPan & 0xFFFF) >> 1;
-		pan = (mixer->channel[channel].timeRecord[j].volPan) >> 16;
+		vol = (state.volPan & 0xFFFF) >> 1;
+		pan = state.volPan >> 16;
 		return true;
 	}
 	
@@ -1278,14 +1389,33 @@ void PlayerController::grabSampleData(mp_uint32 chnIndex, mp_sint32 count, mp_si
 	if (!player)
 		return;	
 
-	if (mixerDataCache && (count * 2 > mixerDataCacheSize))
+	ChannelMixer* mixer = player;
+
+	if (mixer->isScopeTapEnabled())
 	{
-		delete[] mixerDataCache;
-		mixerDataCacheSize = count * 2 * 2;		
-		mixerDataCache = new mp_sint32[mixerDataCacheSize];
+		// the last fMul frames the mixer has put out for this channel, 
+		// stretched to count samples
+		const mp_sint32 numTapSamples = fMul / ChannelMixer::MP_SCOPETAPDECIMATION + 1;
+		if (numTapSamples > scopeTapCacheSize)
+		{
+			delete[] scopeTapCache;
+			scopeTapCacheSize = numTapSamples * 2;
+			scopeTapCache = new mp_sword[scopeTapCacheSize];
+		}
+		
+		if (count > 0 && mixer->getScopeTapData(chnIndex, getCurrentSamplePosition(), scopeTapCache, numTapSamples))
+		{
+			const mp_sint32 step = ((numTapSamples - 1) << 16) / count;
+			mp_sint32 pos = 0;
+			for (mp_sint32 i = 0; i < count; i++, pos+=step)
+			{
+				const mp_sint32 sd1 = scopeTapCache[pos >> 16];
+				const mp_sint32 sd2 = scopeTapCache[(pos >> 16) + 1];
+				fetcher.fetchSampleData(sd1 + (((pos & 0xFFFF) * (sd2 - sd1)) >> 16));
+			}
+			return;
+		}
 	}
-	
-	ChannelMixer* mixer = player;
 
 	ChannelMixer::TMixerChannel* chn = &mixer->channel[chnIndex];
 	
@@ -1317,38 +1447,13 @@ void PlayerController::grabSampleData(mp_uint32 chnIndex, mp_sint32 count, mp_si
 			channel.flags &= ~3;
 		channel.vol = chn->timeRecord[j].volPan & 0xFFFF;
 		channel.pan = chn->timeRecord[j].volPan >> 16;
-		channel.fixedtimefrac = chn->timeRecord[j].fixedtimefrac;
-		channel.cutoff = ChannelMixer::MP_INVALID_VALUE;
-		channel.resonance = ChannelMixer::MP_INVALID_VALUE;
-//		channel.index = chnIndex; Uncomment this if you like crackly audio
-		// The scopes (which I assume is what this function is for) are currently
-		// using channel 33, to avoid interfering with playback
 		
 		channel.smpadd = (channel.smpadd*fMul) / (!count ? 1 : count);		
 		chn = &channel;
 				
-		if (mixerDataCache && channel.smpadd <= 65536)
-		{
-			memset(mixerDataCache, 0, count*2*sizeof(mp_sint32));
-
-			channel.rsmpadd = (mp_sint32)((1.0 / channel.smpadd) * 65536.0);
-
-			// we only need the left channel as no panning is involved
-			channel.finalvoll = (channel.vol*128*256)<<6; 
-			channel.finalvolr = 0;
-			channel.rampFromVolStepL = channel.rampFromVolStepR = 0;
-			
-			player->getCurrentResampler()->addChannel(chn, mixerDataCache, count, count);
-		
-			for (mp_sint32 i = 0; i < count; i++)
-				fetcher.fetchSampleData(mixerDataCache[i*2]);
-		}
-		else
-		{
-			pp_int32 vol = chn->vol;	
-			mp_sint32 y;		
-			FULLMIXER_TEMPLATE(FULLMIXER_8BIT_NORMAL_TEMP, FULLMIXER_16BIT_NORMAL_TEMP, 16, 0);
-		}		
+		pp_int32 vol = chn->vol;	
+		mp_sint32 y;		
+		FULLMIXER_TEMPLATE(FULLMIXER_8BIT_NORMAL_TEMP, FULLMIXER_16BIT_NORMAL_TEMP, 16, 0);
 	}
 	else
 	{
@@ -1365,9 +1470,9 @@ bool PlayerController::hasSampleData(mp_uint32 chnIndex)
 
 	ChannelMixer* mixer = player;
 
-	ChannelMixer::TMixerChannel* chn = &mixer->channel[chnIndex];
-
-	pp_int32 j = getCurrentBeatIndex();
+	ChannelMixer::TTimeRecord state;
+	if (!mixer->getScopeTapState(chnIndex, getCurrentSamplePosition(), state))
+		state = mixer->channel[chnIndex].timeRecord[getCurrentBeatIndex()];
 
-	return ((chn->timeRecord[j].flags & ChannelMixer::MP_SAMPLE_PLAY) && (chn->timeRecord[j].volPan & 0xFFFF));
+	return ((state.flags & ChannelMixer::MP_SAMPLE_PLAY) && (state.volPan & 0xFFFF));
 }
@@ -60,6 +60,12 @@ public:
 	};
 
 private:
+	enum
+	{
+		// number of rows indexed per buildSongCheckpoints() call
+		BuildRowsPerUpdate = 128
+	};
+
 	class MasterMixer* mixer;
 	class PlayerSTD* player;
 	class ModuleEditor* moduleEditor;
@@ -92,8 +98,8 @@ private:
 	bool multiChannelKeyJazz;
 	bool multiChannelRecord;
 
-	mp_sint32 mixerDataCacheSize;
-	mp_sint32* mixerDataCache;
+	mp_sint32 scopeTapCacheSize;
+	mp_sword* scopeTapCache;
 
 	void assureNotSuspended();
 	void continuePlaying(bool assureNotSuspended);
@@ -105,6 +111,8 @@ private:
 
 	void reset();
 	
+	class SongCheckpointIndex* getSongCheckpointIndex();
+	
 public:
 	~PlayerController();
 	
@@ -193,6 +201,10 @@ public:
 	void getPosition(mp_sint32& order, mp_sint32& row, mp_sint32& ticker);
 	void setPatternPos(mp_sint32 pos, mp_sint32 row);
 	
+	// keep the song state checkpoints for seeking up to date,
+	// call this periodically from the UI thread
+	void buildSongCheckpoints();
+	
 	// change playmode
 	void switchPlayMode(PlayModes playMode, bool exactSwitch = true);
 	PlayModes getPlayMode();
@@ -203,10 +215,15 @@ public:
 	// queries on the mixer
 	mp_sint32 getAllNumPlayingChannels();
 	mp_sint32 getPlayerNumPlayingChannels();
+	// microseconds it took to mix the last buffer of this player
+	mp_uint32 getMixTime();
 
 private:
 	mp_sint32 getCurrentSamplePosition();
 	mp_sint32 getCurrentBeatIndex();
+	
+	// whether the audio thread picks up the commands for the player
+	bool isPlayerMixed();
 
 public:
 	bool isSamplePlaying(const TXMSample& smp, mp_sint32 channel, mp_sint32& pos, mp_sint32& vol, mp_sint32& pan);
@@ -30,6 +30,7 @@
 
 #include "PlayerMaster.h"
 #include "MasterMixer.h"
+#include "MixerThreadPool.h"
 #include "SimpleVector.h"
 #include "PlayerController.h"
 #include "PlayerCriticalSection.h"
@@ -115,10 +116,54 @@ void PlayerMaster::applySettingsToPlayerController(PlayerController& playerContr
 		playerController.getCriticalSection()->leave();
 	}
 	
+	playerController.getCriticalSection()->enter();
+	player->setThreadPool(mixerThreadPool, settings.mixerThreadThreshold >= 0 ? settings.mixerThreadThreshold : 0);
+	playerController.getCriticalSection()->leave();
+	
 	if (!player->isPlaying() && wasPlaying)
 		player->resumePlaying(false);	
 }
 
+void PlayerMaster::setMixerThreads(pp_int32 numThreads)
+{
+	const pp_int32 numProcessors = MixerThreadPool::getNumProcessors();
+	if (numThreads == 0 || numThreads > numProcessors)
+		numThreads = numProcessors;
+
+	if ((mixerThreadPool ? (pp_int32)mixerThreadPool->getNumThreads() : 1) == numThreads)
+		return;
+
+	// players must not use the old pool anymore
+	for (pp_int32 i = 0; i < playerControllers->size(); i++)
+	{
+		PlayerController* playerController = playerControllers->get(i);
+		playerController->getCriticalSection()->enter();
+		playerController->player->setThreadPool(NULL, 0);
+		playerController->getCriticalSection()->leave();
+	}
+	if (mixer->setThreadPool(NULL))
+	{
+		// the audio thread is done with every pool handed to it before
+		delete retiredThreadPool;
+		retiredThreadPool = NULL;
+		delete mixerThreadPool;
+	}
+	else
+	{
+		// the audio thread is late, it might still be mixing with the pool.
+		// Two late handovers in a row rather leak the older pool.
+		retiredThreadPool = mixerThreadPool;
+	}
+	mixerThreadPool = NULL;
+	
+	if (numThreads > 1)
+	{
+		mixerThreadPool = new MixerThreadPool(numThreads);
+		// several tabs and the previewer can play at the same time
+		mixer->setThreadPool(mixerThreadPool);
+	}
+}
+
 const char* PlayerMaster::getPreferredAudioDriverID()
 {
 	AudioDriverManager audioDriverManager;
@@ -156,6 +201,8 @@ float PlayerMaster::convertBufferSizeToMillis(pp_uint32 sampleRate, pp_uint32 bu
 
 PlayerMaster::PlayerMaster(pp_uint32 numDevices/* = DefaultMaxDevices*/) :
 	listener(NULL),
+	mixerThreadPool(NULL),
+	retiredThreadPool(NULL),
 	oldBufferSize(getPreferredBufferSize()),
 	forcePowerOfTwoBufferSize(false),
 	multiChannelKeyJazz(true),
@@ -194,6 +241,8 @@ PlayerMaster::~PlayerMaster()
 	delete playerControllers;
 	delete mixer;
 	delete listener;
+	delete mixerThreadPool;
+	delete retiredThreadPool;
 }
 
 PlayerController* PlayerMaster::createPlayerController(bool fakeScopes)
@@ -317,6 +366,15 @@ bool PlayerMaster::applyNewMixerSettings(const TMixerSettings& settings, bool al
 	if (settings.resampler >= 0)
 		currentSettings.resampler = settings.resampler;
 	
+	if (settings.mixerThreads >= 0)
+	{
+		currentSettings.mixerThreads = settings.mixerThreads;
+		setMixerThreads(settings.mixerThreads);
+	}
+
+	if (settings.mixerThreadThreshold >= 0)
+		currentSettings.mixerThreadThreshold = settings.mixerThreadThreshold;
+	
 	// take over settings like sample rate and buffer size 
 	// those are retrieved from the master mixer and set for all players
 	// accordingly
@@ -442,6 +500,22 @@ void PlayerMaster::getCurrentSamplePeak(pp_int32& left, pp_int32& right)
 	right = mixer->getCurrentSamplePeak(pos, 1);
 }
 
+pp_int32 PlayerMaster::getAudioLoad()
+{
+	if (!mixer->isActive())
+		return 0;
+	
+	MixerProfiler::Stats stats;
+	mixer->getProfiler().getStats(stats);
+	
+	return stats.getLoad(stats.averageMixTime);
+}
+
+MixerProfiler& PlayerMaster::getMixerProfiler()
+{
+	return mixer->getProfiler();
+}
+
 void PlayerMaster::resetQueuedPositions()
 {
 	for (pp_int32 i = 0; i < playerControllers->size(); i++)
@@ -54,6 +54,10 @@ struct TMixerSettings
 	char* audioDriverName;
 	// 0 means disable virtual channels, negative value means ignore
 	pp_int32 numVirtualChannels;
+	// 1 = single threaded mixing, 0 = one thread per processor, negative value means ignore
+	pp_int32 mixerThreads;
+	// minimum number of playing channels for threaded mixing, negative values means ignore
+	pp_int32 mixerThreadThreshold;
 
 	TMixerSettings() :
 		mixFreq(-1),
@@ -64,7 +68,9 @@ struct TMixerSettings
 		resampler(-1),
 		ramping(-1),
 		audioDriverName(NULL),
-		numVirtualChannels(-1)
+		numVirtualChannels(-1),
+		mixerThreads(-1),
+		mixerThreadThreshold(-1)
 	{
 	}
 
@@ -111,6 +117,12 @@ struct TMixerSettings
 		if (numVirtualChannels != source.numVirtualChannels)
 			return false;
 
+		if (mixerThreads != source.mixerThreads)
+			return false;
+
+		if (mixerThreadThreshold != source.mixerThreadThreshold)
+			return false;
+
 		return strcmp(audioDriverName, source.audioDriverName) == 0;
 	}
 	
@@ -135,6 +147,9 @@ private:
 
 	class MasterMixer* mixer;
 	class MasterMixerNotificationListener* listener;
+	class MixerThreadPool* mixerThreadPool;
+	// replaced pool the audio thread might not have let go of yet
+	class MixerThreadPool* retiredThreadPool;
 	PPSimpleVector<PlayerController>* playerControllers;
 	
 	TMixerSettings currentSettings;
@@ -148,6 +163,7 @@ private:
 	bool multiChannelRecord;
 	
 	void adjustSettings();
+	void setMixerThreads(pp_int32 numThreads);
 	void applySettingsToPlayerController(PlayerController& playerController, const TMixerSettings& settings);
 	
 public:
@@ -188,6 +204,11 @@ public:
 	
 	void getCurrentSamplePeak(pp_int32& left, pp_int32& right);
 	
+	// load of the audio thread in percent of the buffer time, 0 when nothing is mixed
+	pp_int32 getAudioLoad();
+	// audio thread load and dropouts in detail, see MixerProfiler
+	class MixerProfiler& getMixerProfiler();
+	
 	void resetQueuedPositions();
 	
 	friend class MasterMixerNotificationListener;
@@ -41,7 +41,8 @@ const char* ResamplerHelper::resamplerNames[] =
 	"Amiga 500",
 	"Amiga 500 LED",
 	"Amiga 1200",
-	"Amiga 1200 LED"
+	"Amiga 1200 LED",
+	"Polyphase Sinc"
 };
 
 const char* ResamplerHelper::resamplerNamesShort[] =
@@ -55,7 +56,8 @@ const char* ResamplerHelper::resamplerNamesShort[] =
 	"A500",
 	"A500LED",
 	"A1200",
-	"A1200LED"
+	"A1200LED",
+	"Polyphase"
 };
 
 pp_uint32 ResamplerHelper::getNumResamplers()
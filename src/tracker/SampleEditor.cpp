@@ -36,6 +36,7 @@
 #include "EQConstants.h"
 #include "FilterParameters.h"
 #include "SampleEditorResampler.h"
+#include "SamplePeakCache.h"
 
 SampleEditor::ClipBoard::ClipBoard() :
 		buffer(NULL)
@@ -171,20 +172,57 @@ void SampleEditor::ClipBoard::paste(TXMSample& sample, XModule& module, pp_int32
 
 }
 
-void SampleEditor::prepareUndo()
+void SampleEditor::prepareUndo(pp_int32 from/* = -1*/, pp_int32 to/* = -1*/)
 {
 	delete before; 
 	before = NULL; 
+	
+	undoRangeStart = from;
+	undoRangeEnd = to;
 		
 	if (undoStackEnabled && undoStackActivated && undoStack) 
 	{
 		undoUserData.clear();
 		notifyListener(NotificationFeedUndoData);
 
+		// as long as the sample is where the last state has been taken from, 
+		// nothing has changed it since, otherwise everything is compared
+		const bool unchanged = lastState && lastStateBuffer == sample->sample &&
+							   lastState->getSampLen() == sample->samplen &&
+							   (lastState->getFlags() & 16) == (sample->type & 16);
+
 		before = new SampleUndoStackEntry(*sample, 
 										  getSelectionStart(), 
 										  getSelectionEnd(), 
-										  &undoUserData);
+										  &undoUserData,
+										  lastState,
+										  unchanged ? 0 : -1, 
+										  0);
+	}
+}
+
+void SampleEditor::extendUndoRange(pp_int32 from, pp_int32 to)
+{
+	// an unknown range stays unknown
+	if (undoRangeStart < 0)
+		return;
+	
+	if (from < 0)
+		from = 0;
+	if (to <= from)
+		to = from + 1;
+	
+	if (undoRangeStart >= undoRangeEnd)
+	{
+		undoRangeStart = from;
+		undoRangeEnd = to;
+	}
+	else
+	{
+		if (from < undoRangeStart)
+			undoRangeStart = from;
+		if (to > undoRangeEnd)
+			undoRangeEnd = to;
 	}
 }
 
@@ -205,7 +243,18 @@ void SampleEditor::finishUndo()
 		SampleUndoStackEntry after(SampleUndoStackEntry(*sample, 
 										 getSelectionStart(), 
 										 getSelectionEnd(), 
-										 &undoUserData)); 
+										 &undoUserData,
+										 before,
+										 undoRangeStart,
+										 undoRangeEnd)); 
+		
+		// the entries know which part of the sample has changed
+		pp_int32 from, to;
+		if (after.getChangedRange(*before, from, to))
+			peakCache->invalidate(from, to);
+		else
+			peakCache->invalidate();
+		
 		if (*before != after) 
 		{ 
 			if (undoStack) 
@@ -213,9 +262,22 @@ void SampleEditor::finishUndo()
 				undoStack->Push(*before); 
 				undoStack->Push(after); 
 				undoStack->Pop(); 
+				
+				limitUndoSize();
 			} 
 		} 
+		
+		delete lastState;
+		lastState = new SampleUndoStackEntry(after);
+		lastStateBuffer = sample->sample;
 	} 
+	else
+	{
+		peakCache->invalidate();
+		
+		// changes without undo, the last state can't be trusted anymore
+		invalidateLastState();
+	}
 	
 	// we're done, client might want to refresh the screen or whatever
 	notifyListener(NotificationChanges);			
@@ -247,27 +309,57 @@ bool SampleEditor::revoke(const SampleUndoStackEntry* stackEntry)
 		sample->sample = NULL;
 	}
 	
-	if (stackEntry->getBuffer())
+	if (stackEntry->hasBuffer())
 	{			
 		if (sample->type & 16)
-		{
 			sample->sample = (mp_sbyte*)module->allocSampleMem(sample->samplen*2);
-			TXMSample::copyPaddedMem(sample->sample, stackEntry->getBuffer(), sample->samplen*2);
-		}
 		else
-		{
 			sample->sample = (mp_sbyte*)module->allocSampleMem(sample->samplen);
-			TXMSample::copyPaddedMem(sample->sample, stackEntry->getBuffer(), sample->samplen);
-		}
+
+		if (sample->sample)
+			stackEntry->copyBuffer(sample->sample);
 	}
 	
 	leaveCriticalSection();
+	
+	peakCache->invalidate();
+	
+	delete lastState;
+	lastState = new SampleUndoStackEntry(*stackEntry);
+	lastStateBuffer = sample->sample;
+	
 	undoUserData = stackEntry->getUserData();
 	notifyListener(NotificationFetchUndoData);
 	notifyListener(NotificationChanges);
 	return true;
 }
 
+void SampleEditor::limitUndoSize()
+{
+	pp_uint32 stackSize = getUndoStackSize(undoStack);
+	
+	// the undo stacks of other samples go first, least recently used first
+	while (undoHistory && stackSize + undoHistory->getSize() > UNDOSIZE_SAMPLEEDITOR)
+	{
+		if (!undoHistory->removeOldest())
+			break;
+	}
+	
+	while (stackSize > UNDOSIZE_SAMPLEEDITOR)
+	{
+		if (!undoStack->RemoveBottom())
+			break;
+		stackSize = getUndoStackSize(undoStack);
+	}
+}
+
+void SampleEditor::invalidateLastState()
+{
+	delete lastState;
+	lastState = NULL;
+	lastStateBuffer = NULL;
+}
+
 void SampleEditor::notifyChanges(bool condition, bool lazy/* = true*/)
 {
 	lastOperation = OperationRegular;	
@@ -292,11 +384,17 @@ SampleEditor::SampleEditor() :
 	undoStackEnabled(true), 
 	undoStackActivated(true),	
 	before(NULL),
+	lastState(NULL),
+	lastStateBuffer(NULL),
+	undoRangeStart(-1),
+	undoRangeEnd(-1),
 	undoStack(NULL),
 	lastOperationDidChangeSize(false),
 	lastOperation(OperationRegular),
 	drawing(false),
 	lastSamplePos(-1),
+	peakCache(new SamplePeakCache()),
+	floatBlock(new float[FloatBlockSize*2 + FloatBlockMargin*2]),
 	lastParameters(NULL),
 	lastFilterFunc(NULL)
 {
@@ -310,10 +408,13 @@ SampleEditor::SampleEditor() :
 
 SampleEditor::~SampleEditor()
 {
+	delete[] floatBlock;
+	delete peakCache;
 	delete lastParameters;
 	delete undoHistory;
 	delete undoStack;
 	delete before;
+	delete lastState;
 }
 
 void SampleEditor::attachSample(TXMSample* sample, XModule* module) 
@@ -351,9 +452,14 @@ void SampleEditor::attachSample(TXMSample* sample, XModule* module)
 		}
 	}
 
+	if (sample != this->sample)
+		invalidateLastState();
+
 	this->sample = sample;
 	attachModule(module);
 
+	peakCache->invalidate();
+
 	resetSelection();
 	
 	notifyListener(NotificationReload);
@@ -361,6 +467,9 @@ void SampleEditor::attachSample(TXMSample* sample, XModule* module)
 
 void SampleEditor::reset()
 {
+	peakCache->invalidate();
+	invalidateLastState();
+
 	if (undoStackEnabled)
 	{
 		if (undoHistory)
@@ -391,6 +500,17 @@ void SampleEditor::reset()
 	}
 }
 
+bool SampleEditor::getPeak(pp_int32 from, pp_int32 to, pp_int32& min, pp_int32& max, pp_int32& rms)
+{
+	return peakCache->getPeak(sample, from, to, min, max, rms);
+}
+
+void SampleEditor::invalidatePeaks()
+{
+	peakCache->invalidate();
+	invalidateLastState();
+}
+
 bool SampleEditor::isEmptySample() const  
 {
 	if (!isValidSample())
@@ -791,7 +911,8 @@ void SampleEditor::startDrawing()
 
 	drawing = true;
 	lastSamplePos = -1;
-	prepareUndo();
+	// the strokes tell which part they change
+	prepareUndo(0, 0);
 }
 
 void SampleEditor::drawSample(pp_int32 sampleIndex, float s)
@@ -825,6 +946,9 @@ void SampleEditor::drawSample(pp_int32 sampleIndex, float s)
 		setFloatSampleInWaveform(si, froms);
 		froms+=step;
 	}	
+	
+	peakCache->invalidate(from, to+1);
+	extendUndoRange(from, to+1);
 }
 
 void SampleEditor::endDrawing()
@@ -1094,6 +1218,86 @@ void SampleEditor::setFloatSampleInWaveform(pp_int32 index, float singleSample,
 	}
 }
 
+// The block conversions do exactly what the single sample versions do,
+// but as plain loops over arrays which the compiler can vectorize
+static void convertSamplesToFloats(const mp_sword* src, float* dst, pp_int32 count)
+{
+	for (pp_int32 i = 0; i < count; i++)
+	{
+		const float f = (float)src[i];
+		dst[i] = src[i] > 0 ? f*(1.0f/32767.0f) : f*(1.0f/32768.0f);
+	}
+}
+
+static void convertSamplesToFloats(const mp_sbyte* src, float* dst, pp_int32 count)
+{
+	for (pp_int32 i = 0; i < count; i++)
+	{
+		const float f = (float)src[i];
+		dst[i] = src[i] > 0 ? f*(1.0f/127.0f) : f*(1.0f/128.0f);
+	}
+}
+
+static void convertFloatsToSamples(const float* src, mp_sword* dst, pp_int32 count)
+{
+	for (pp_int32 i = 0; i < count; i++)
+	{
+		float f = src[i];
+		if (f > 1.0f)
+			f = 1.0f;
+		if (f < -1.0f)
+			f = -1.0f;
+		dst[i] = f > 0 ? (mp_sword)(f*32767.0f+0.5f) : (mp_sword)(f*32768.0f-0.5f);
+	}
+}
+
+static void convertFloatsToSamples(const float* src, mp_sbyte* dst, pp_int32 count)
+{
+	for (pp_int32 i = 0; i < count; i++)
+	{
+		float f = src[i];
+		if (f > 1.0f)
+			f = 1.0f;
+		if (f < -1.0f)
+			f = -1.0f;
+		dst[i] = f > 0 ? (mp_sbyte)(f*127.0f+0.5f) : (mp_sbyte)(f*128.0f-0.5f);
+	}
+}
+
+void SampleEditor::getFloatSamplesFromWaveform(pp_int32 index, float* dst, pp_int32 count)
+{
+	if (isEmptySample())
+	{
+		memset(dst, 0, count*sizeof(float));
+		return;
+	}
+
+	ASSERT(index >= 0 && index + count <= (signed)sample->samplen);
+
+	// get the real data back from the loop double buffer
+	sample->restoreOriginalState();
+
+	if (sample->type & 16)
+		convertSamplesToFloats((const mp_sword*)sample->sample + index, dst, count);
+	else
+		convertSamplesToFloats(sample->sample + index, dst, count);
+}
+
+void SampleEditor::setFloatSamplesInWaveform(pp_int32 index, const float* src, pp_int32 count)
+{
+	if (isEmptySample())
+		return;
+
+	ASSERT(index >= 0 && index + count <= (signed)sample->samplen);
+
+	sample->restoreOriginalState();
+
+	if (sample->type & 16)
+		convertFloatsToSamples(src, (mp_sword*)sample->sample + index, count);
+	else
+		convertFloatsToSamples(src, sample->sample + index, count);
+}
+
 void SampleEditor::preFilter(TFilterFunc filterFuncPtr, const FilterParameters* par)
 {
 	if (filterFuncPtr)
@@ -1369,26 +1573,32 @@ void SampleEditor::tool_mixPasteSample(const FilterParameters* par)
 	
 	preFilter(NULL, NULL);
 	
-	prepareUndo();
+	prepareUndo(sStart, sEnd);
 	
 	ClipBoard* clipBoard = ClipBoard::getInstance();
 	
 	float step = (float)clipBoard->getWidth() / (float)(sEnd-sStart);
 	
 	float j = 0.0f;
-	for (pp_int32 i = sStart; i < sEnd; i++)
+	for (pp_int32 i = sStart; i < sEnd; i+=FloatBlockSize)
 	{
-		float frac = j - (float)floor(j);
-	
-		pp_int16 s = clipBoard->getSampleWord((pp_int32)j);
-		float f1 = s < 0 ? (s/32768.0f) : (s/32767.0f);
-		s = clipBoard->getSampleWord((pp_int32)j+1);
-		float f2 = s < 0 ? (s/32768.0f) : (s/32767.0f);
+		const pp_int32 count = (sEnd - i) < FloatBlockSize ? (sEnd - i) : FloatBlockSize;
+		getFloatSamplesFromWaveform(i, floatBlock, count);
 
-		float f = (1.0f-frac)*f1 + frac*f2;
+		for (pp_int32 k = 0; k < count; k++)
+		{
+			float frac = j - (float)floor(j);
 		
-		setFloatSampleInWaveform(i, f + getFloatSampleFromWaveform(i));
-		j+=step;
+			pp_int16 s = clipBoard->getSampleWord((pp_int32)j);
+			float f1 = s < 0 ? (s/32768.0f) : (s/32767.0f);
+			s = clipBoard->getSampleWord((pp_int32)j+1);
+			float f2 = s < 0 ? (s/32768.0f) : (s/32767.0f);
+
+			floatBlock[k] += (1.0f-frac)*f1 + frac*f2;
+			j+=step;
+		}
+
+		setFloatSamplesInWaveform(i, floatBlock, count);
 	}
 				
 	finishUndo();	
@@ -1423,18 +1633,25 @@ void SampleEditor::tool_scaleSample(const FilterParameters* par)
 	
 	preFilter(&SampleEditor::tool_scaleSample, par);
 	
-	prepareUndo();
+	prepareUndo(sStart, sEnd);
 	
 	float startScale = par->getParameter(0).floatPart;
 	float endScale = par->getParameter(1).floatPart;
 	
 	float step = (endScale - startScale) / (float)(sEnd - sStart);
 	
-	for (pp_int32 i = sStart; i < sEnd; i++)
+	for (pp_int32 i = sStart; i < sEnd; i+=FloatBlockSize)
 	{
-		float f = getFloatSampleFromWaveform(i);
-		setFloatSampleInWaveform(i, f*startScale);
-		startScale+=step;
+		const pp_int32 count = (sEnd - i) < FloatBlockSize ? (sEnd - i) : FloatBlockSize;
+		getFloatSamplesFromWaveform(i, floatBlock, count);
+
+		for (pp_int32 k = 0; k < count; k++)
+		{
+			floatBlock[k]*=startScale;
+			startScale+=step;
+		}
+
+		setFloatSamplesInWaveform(i, floatBlock, count);
 	}
 				
 	finishUndo();	
@@ -1468,7 +1685,7 @@ void SampleEditor::tool_normalizeSample(const FilterParameters* par)
 	
 	preFilter(&SampleEditor::tool_normalizeSample, par);
 	
-	prepareUndo();
+	prepareUndo(sStart, sEnd);
 	
 	float maxLevel = ((par == NULL)? 1.0f : par->getParameter(0).floatPart);
 	float peak = 0.0f;
@@ -1476,18 +1693,26 @@ void SampleEditor::tool_normalizeSample(const FilterParameters* par)
 	pp_int32 i;
 
 	// find peak value
-	for (i = sStart; i < sEnd; i++)
+	for (i = sStart; i < sEnd; i+=FloatBlockSize)
 	{
-		float f = getFloatSampleFromWaveform(i);
-		if (ppfabs(f) > peak) peak = ppfabs(f);
+		const pp_int32 count = (sEnd - i) < FloatBlockSize ? (sEnd - i) : FloatBlockSize;
+		getFloatSamplesFromWaveform(i, floatBlock, count);
+
+		for (pp_int32 k = 0; k < count; k++)
+			if (ppfabs(floatBlock[k]) > peak) peak = ppfabs(floatBlock[k]);
 	}
 	
 	float scale = maxLevel / peak;
 	
-	for (i = sStart; i < sEnd; i++)
+	for (i = sStart; i < sEnd; i+=FloatBlockSize)
 	{
-		float f = getFloatSampleFromWaveform(i);
-		setFloatSampleInWaveform(i, f*scale);
+		const pp_int32 count = (sEnd - i) < FloatBlockSize ? (sEnd - i) : FloatBlockSize;
+		getFloatSamplesFromWaveform(i, floatBlock, count);
+
+		for (pp_int32 k = 0; k < count; k++)
+			floatBlock[k]*=scale;
+
+		setFloatSamplesInWaveform(i, floatBlock, count);
 	}
 				
 	finishUndo();	
@@ -1521,7 +1746,7 @@ void SampleEditor::tool_reverseSample(const FilterParameters* par)
 	
 	preFilter(&SampleEditor::tool_reverseSample, par);
 	
-	prepareUndo();
+	prepareUndo(sStart, sEnd);
 	
 	pp_int32 i;
 	for (i = 0; i < (sEnd-sStart)>>1; i++)
@@ -1565,36 +1790,44 @@ void SampleEditor::tool_PTboostSample(const FilterParameters* par)
 	
 	preFilter(&SampleEditor::tool_PTboostSample, par);
 	
-	prepareUndo();
+	prepareUndo(sStart, sEnd);
 	
 	pp_int32 i;
 	
 	float d0 = 0.0f, d1, d2;
-	for (i = sStart; i < sEnd; i++)
+	for (i = sStart; i < sEnd; i+=FloatBlockSize)
 	{
-		d1 = d2 = getFloatSampleFromWaveform(i);
-		d1 -= d0;
-		d0 = d2;
-		
-		if (d1 < 0.0f)
-		{
-			d1 = -d1;
-			d1*= 0.25f;
-			d2 -= d1;
-		}
-		else
+		const pp_int32 count = (sEnd - i) < FloatBlockSize ? (sEnd - i) : FloatBlockSize;
+		getFloatSamplesFromWaveform(i, floatBlock, count);
+
+		for (pp_int32 k = 0; k < count; k++)
 		{
-			d1*= 0.25f;
-			d2 += d1;
+			d1 = d2 = floatBlock[k];
+			d1 -= d0;
+			d0 = d2;
+			
+			if (d1 < 0.0f)
+			{
+				d1 = -d1;
+				d1*= 0.25f;
+				d2 -= d1;
+			}
+			else
+			{
+				d1*= 0.25f;
+				d2 += d1;
+			}
+			
+			if (d2 > 1.0f)
+				d2 = 1.0f;
+			
+			if (d2 < -1.0f)
+				d2 = -1.0f;
+			
+			floatBlock[k] = d2;
 		}
-		
-		if (d2 > 1.0f)
-			d2 = 1.0f;
-		
-		if (d2 < -1.0f)
-			d2 = -1.0f;
-		
-		setFloatSampleInWaveform(i, d2);
+
+		setFloatSamplesInWaveform(i, floatBlock, count);
 	}
 	
 	finishUndo();	
@@ -1629,6 +1862,29 @@ bool SampleEditor::isValidxFadeSelection()
 	return true;
 }
 
+void SampleEditor::xFadeRange(void* source, pp_int32 from, pp_int32 to, bool fadeIn, pp_int32 other, pp_int32 direction)
+{
+	for (pp_int32 i = from; i < to; i+=FloatBlockSize)
+	{
+		const pp_int32 count = (to - i) < FloatBlockSize ? (to - i) : FloatBlockSize;
+		
+		for (pp_int32 k = 0; k < count; k++)
+		{
+			const pp_int32 j = i + k;
+			float t = (((float)j - from) / (float)(to - from))*0.5f;
+			if (!fadeIn)
+				t = 0.5f - t;
+			
+			float f1 = getFloatSampleFromWaveform(j, source, sample->samplen);
+			float f2 = getFloatSampleFromWaveform(other + (j - from)*direction, source, sample->samplen);		
+			
+			floatBlock[k] = f1*(1.0f-t) + f2*t;
+		}
+		
+		setFloatSamplesInWaveform(i, floatBlock, count);
+	}
+}
+
 void SampleEditor::tool_xFadeSample(const FilterParameters* par)
 {
 	if (!isValidxFadeSelection())
@@ -1667,36 +1923,18 @@ void SampleEditor::tool_xFadeSample(const FilterParameters* par)
 	if (!buffer)
 		return;
 
+	// the copy needs the real data, not what's in the loop double buffer 
+	sample->restoreOriginalState();
 	memcpy(buffer, sample->sample, (sample->type & 16) ? sample->samplen*2 : sample->samplen);
 
-	prepareUndo();	
-	
-	pp_int32 i = 0;
+	// forward loops are faded at the loop end as well
+	prepareUndo(sStart, (sample->type & 3) == 1 ? sEnd + (pp_int32)sample->looplen : sEnd);	
 	
 	// loop start
 	if ((sample->type & 3) == 1)
 	{	
-		for (i = sStart; i < (signed)sample->loopstart; i++)
-		{
-			float t = (((float)i - sStart) / (float)(sample->loopstart - sStart))*0.5f;
-			
-			float f1 = getFloatSampleFromWaveform(i, buffer, sample->samplen);
-			float f2 = getFloatSampleFromWaveform(loopend - (sample->loopstart - sStart) + (i - sStart), buffer, sample->samplen);		
-			
-			float f = f1*(1.0f-t) + f2*t;
-			setFloatSampleInWaveform(i, f);
-		}
-		
-		for (i = sample->loopstart; i < sEnd; i++)
-		{
-			float t = 0.5f - ((((float)i - sample->loopstart) / (float)(sEnd-sample->loopstart))*0.5f);
-			
-			float f1 = getFloatSampleFromWaveform(i, buffer, sample->samplen);
-			float f2 = getFloatSampleFromWaveform(loopend + (i - sample->loopstart), buffer, sample->samplen);		
-			
-			float f = f1*(1.0f-t) + f2*t;
-			setFloatSampleInWaveform(i, f);
-		}
+		xFadeRange(buffer, sStart, sample->loopstart, true, loopend - (sample->loopstart - sStart), 1);
+		xFadeRange(buffer, sample->loopstart, sEnd, false, loopend, 1);
 		
 		// loop end
 		sStart-=sample->loopstart;
@@ -1704,52 +1942,13 @@ void SampleEditor::tool_xFadeSample(const FilterParameters* par)
 		sEnd-=sample->loopstart;
 		sEnd+=loopend;	
 		
-		for (i = sStart; i < loopend; i++)
-		{
-			float t = (((float)i - sStart) / (float)(loopend - sStart))*0.5f;
-			
-			float f1 = getFloatSampleFromWaveform(i, buffer, sample->samplen);
-			float f2 = getFloatSampleFromWaveform(sample->loopstart - (loopend - sStart) + (i - sStart), buffer, sample->samplen);		
-			
-			float f = f1*(1.0f-t) + f2*t;
-			setFloatSampleInWaveform(i, f);
-		}	
-		
-		for (i = loopend; i < sEnd; i++)
-		{
-			float t = 0.5f - ((((float)i - loopend) / (float)(sEnd-loopend))*0.5f);
-			
-			float f1 = getFloatSampleFromWaveform(i, buffer, sample->samplen);
-			float f2 = getFloatSampleFromWaveform(sample->loopstart + (i - loopend), buffer, sample->samplen);		
-			
-			float f = f1*(1.0f-t) + f2*t;
-			setFloatSampleInWaveform(i, f);
-		}
-		
+		xFadeRange(buffer, sStart, loopend, true, sample->loopstart - (loopend - sStart), 1);
+		xFadeRange(buffer, loopend, sEnd, false, sample->loopstart, 1);
 	}
 	else if ((sample->type & 3) == 2)
 	{
-		for (i = sStart; i < (signed)sample->loopstart; i++)
-		{
-			float t = (((float)i - sStart) / (float)(sample->loopstart - sStart))*0.5f;
-			
-			float f1 = getFloatSampleFromWaveform(i, buffer, sample->samplen);
-			float f2 = getFloatSampleFromWaveform(sample->loopstart + (i - sStart), buffer, sample->samplen);		
-			
-			float f = f1*(1.0f-t) + f2*t;
-			setFloatSampleInWaveform(i, f);
-		}
-		
-		for (i = sample->loopstart; i < sEnd; i++)
-		{
-			float t = 0.5f - ((((float)i - sample->loopstart) / (float)(sEnd-sample->loopstart))*0.5f);
-			
-			float f1 = getFloatSampleFromWaveform(i, buffer, sample->samplen);
-			float f2 = getFloatSampleFromWaveform(sample->loopstart - (i - sample->loopstart), buffer, sample->samplen);		
-			
-			float f = f1*(1.0f-t) + f2*t;
-			setFloatSampleInWaveform(i, f);
-		}
+		xFadeRange(buffer, sStart, sample->loopstart, true, sample->loopstart, 1);
+		xFadeRange(buffer, sample->loopstart, sEnd, false, sample->loopstart, -1);
 	}
 	
 	delete[] buffer;
@@ -1785,7 +1984,7 @@ void SampleEditor::tool_changeSignSample(const FilterParameters* par)
 	
 	preFilter(&SampleEditor::tool_changeSignSample, par);
 	
-	prepareUndo();
+	prepareUndo(sStart, sEnd);
 	
 	pp_int32 i;
 	// lazyness follows
@@ -1837,7 +2036,7 @@ void SampleEditor::tool_swapByteOrderSample(const FilterParameters* par)
 	
 	preFilter(&SampleEditor::tool_swapByteOrderSample, par);
 	
-	prepareUndo();
+	prepareUndo(sStart, sEnd);
 	
 	pp_int32 i;
 
@@ -1853,7 +2052,6 @@ void SampleEditor::tool_swapByteOrderSample(const FilterParameters* par)
 	postFilter();
 }
 
-float getc4spd(mp_sint32 relnote,mp_sint32 finetune);
 
 void SampleEditor::tool_resampleSample(const FilterParameters* par)
 {
@@ -1921,19 +2119,29 @@ void SampleEditor::tool_DCNormalizeSample(const FilterParameters* par)
 	
 	preFilter(&SampleEditor::tool_DCNormalizeSample, par);
 	
-	prepareUndo();
+	prepareUndo(sStart, sEnd);
 	
 	pp_int32 i;
 
 	float DC = 0.0f;
-	for (i = sStart; i < sEnd; i++)
+	for (i = sStart; i < sEnd; i+=FloatBlockSize)
 	{
-		DC += getFloatSampleFromWaveform(i);		
+		const pp_int32 count = (sEnd - i) < FloatBlockSize ? (sEnd - i) : FloatBlockSize;
+		getFloatSamplesFromWaveform(i, floatBlock, count);
+
+		for (pp_int32 k = 0; k < count; k++)
+			DC += floatBlock[k];
 	}
 	DC = DC / (float)(sEnd-sStart);
-	for (i = sStart; i < sEnd; i++)
+	for (i = sStart; i < sEnd; i+=FloatBlockSize)
 	{
-		setFloatSampleInWaveform(i, getFloatSampleFromWaveform(i) - DC);
+		const pp_int32 count = (sEnd - i) < FloatBlockSize ? (sEnd - i) : FloatBlockSize;
+		getFloatSamplesFromWaveform(i, floatBlock, count);
+
+		for (pp_int32 k = 0; k < count; k++)
+			floatBlock[k] -= DC;
+
+		setFloatSamplesInWaveform(i, floatBlock, count);
 	}
 	
 	finishUndo();	
@@ -1967,14 +2175,20 @@ void SampleEditor::tool_DCOffsetSample(const FilterParameters* par)
 	
 	preFilter(&SampleEditor::tool_DCOffsetSample, par);
 	
-	prepareUndo();
+	prepareUndo(sStart, sEnd);
 	
 	pp_int32 i;
 
 	float DC = par->getParameter(0).floatPart;
-	for (i = sStart; i < sEnd; i++)
+	for (i = sStart; i < sEnd; i+=FloatBlockSize)
 	{
-		setFloatSampleInWaveform(i, getFloatSampleFromWaveform(i) + DC);
+		const pp_int32 count = (sEnd - i) < FloatBlockSize ? (sEnd - i) : FloatBlockSize;
+		getFloatSamplesFromWaveform(i, floatBlock, count);
+
+		for (pp_int32 k = 0; k < count; k++)
+			floatBlock[k] += DC;
+
+		setFloatSamplesInWaveform(i, floatBlock, count);
 	}
 	
 	finishUndo();	
@@ -2008,29 +2222,35 @@ void SampleEditor::tool_rectangularSmoothSample(const FilterParameters* par)
 	
 	preFilter(&SampleEditor::tool_rectangularSmoothSample, par);
 	
-	mp_sint32 sLen = sEnd - sStart;
-	
-	mp_ubyte* buffer = new mp_ubyte[(sample->type & 16) ? sLen*2 : sLen];
-	if (!buffer)
-		return;
-
-	memcpy(buffer, sample->sample + sStart, (sample->type & 16) ? sLen*2 : sLen);
-
-	prepareUndo();	
+	prepareUndo(sStart, sEnd);	
 	
 	pp_int32 i;
 
-	for (i = sStart; i < sEnd; i++)
+	// one neighbour to each side, the selection edges are repeated
+	float* src = floatBlock + FloatBlockMargin;
+	float* dst = floatBlock + FloatBlockSize + FloatBlockMargin*2;
+
+	for (i = sStart; i < sEnd; i+=FloatBlockSize)
 	{
-		float f = (getFloatSampleFromWaveform(i - sStart - 1, buffer, sLen) +
-				  getFloatSampleFromWaveform(i - sStart, buffer, sLen) +
-				  getFloatSampleFromWaveform(i - sStart + 1, buffer, sLen)) * (1.0f/3.0f);
-				  
-		setFloatSampleInWaveform(i, f);		
+		const pp_int32 count = (sEnd - i) < FloatBlockSize ? (sEnd - i) : FloatBlockSize;
+		
+		// read ahead what's needed on the right, the neighbours on the left
+		// are kept from the last block because they're overwritten by now
+		const pp_int32 ahead = (sEnd - i - count) < 1 ? (sEnd - i - count) : 1;
+		getFloatSamplesFromWaveform(i, src, count + ahead);
+		if (ahead < 1)
+			src[count] = src[count - 1];
+		if (i == sStart)
+			src[-1] = src[0];
+		
+		for (pp_int32 k = 0; k < count; k++)
+			dst[k] = (src[k - 1] + src[k] + src[k + 1]) * (1.0f/3.0f);
+
+		setFloatSamplesInWaveform(i, dst, count);
+		
+		src[-1] = src[count - 1];
 	}
 	
-	delete[] buffer;
-	
 	finishUndo();	
 	
 	postFilter();
@@ -2062,31 +2282,40 @@ void SampleEditor::tool_triangularSmoothSample(const FilterParameters* par)
 	
 	preFilter(&SampleEditor::tool_triangularSmoothSample, par);
 	
-	mp_sint32 sLen = sEnd - sStart;
-	
-	mp_ubyte* buffer = new mp_ubyte[(sample->type & 16) ? sLen*2 : sLen];
-	if (!buffer)
-		return;
-
-	memcpy(buffer, sample->sample + sStart, (sample->type & 16) ? sLen*2 : sLen);
-
-	prepareUndo();	
+	prepareUndo(sStart, sEnd);	
 	
 	pp_int32 i;
 
-	for (i = sStart; i < sEnd; i++)
+	// two neighbours to each side, the selection edges are repeated
+	float* src = floatBlock + FloatBlockMargin;
+	float* dst = floatBlock + FloatBlockSize + FloatBlockMargin*2;
+
+	for (i = sStart; i < sEnd; i+=FloatBlockSize)
 	{
-		float f = (getFloatSampleFromWaveform(i - sStart - 2, buffer, sLen) +
-				   getFloatSampleFromWaveform(i - sStart - 1, buffer, sLen)*2.0f +
-				   getFloatSampleFromWaveform(i - sStart, buffer, sLen)*3.0f +
-				   getFloatSampleFromWaveform(i - sStart + 1, buffer, sLen)*2.0f +
-				   getFloatSampleFromWaveform(i - sStart + 2, buffer, sLen)) * (1.0f/9.0f);
-				  
-		setFloatSampleInWaveform(i, f);		
+		const pp_int32 count = (sEnd - i) < FloatBlockSize ? (sEnd - i) : FloatBlockSize;
+		
+		const pp_int32 ahead = (sEnd - i - count) < 2 ? (sEnd - i - count) : 2;
+		getFloatSamplesFromWaveform(i, src, count + ahead);
+		for (pp_int32 k = count + ahead; k < count + 2; k++)
+			src[k] = src[count + ahead - 1];
+		if (i == sStart)
+			src[-2] = src[-1] = src[0];
+		
+		for (pp_int32 k = 0; k < count; k++)
+		{
+			dst[k] = (src[k - 2] +
+					  src[k - 1]*2.0f +
+					  src[k]*3.0f +
+					  src[k + 1]*2.0f +
+					  src[k + 2]) * (1.0f/9.0f);
+		}
+
+		setFloatSamplesInWaveform(i, dst, count);
+		
+		src[-2] = src[count - 2];
+		src[-1] = src[count - 1];
 	}
 	
-	delete[] buffer;
-	
 	finishUndo();	
 
 	postFilter();
@@ -2118,7 +2347,7 @@ void SampleEditor::tool_eqSample(const FilterParameters* par)
 	
 	preFilter(&SampleEditor::tool_eqSample, par);
 	
-	prepareUndo();	
+	prepareUndo(sStart, sEnd);	
 	
 	float c4spd = getc4spd(sample->relnote, sample->finetune);
 	float scale = c4spd / 44100.0f;
@@ -2153,23 +2382,31 @@ void SampleEditor::tool_eqSample(const FilterParameters* par)
 	// apply EQ here
 	pp_int32 i;
 
-	for (i = sStart; i < sEnd; i++)
+	for (i = sStart; i < sEnd; i+=FloatBlockSize)
 	{
-		// Fetch a stereo signal
-		double xL = getFloatSampleFromWaveform(i);
-		double xR = xL;
-			
-		for (pp_int32 j = 0; j < par->getNumParameters(); j++)
+		const pp_int32 count = (sEnd - i) < FloatBlockSize ? (sEnd - i) : FloatBlockSize;
+		getFloatSamplesFromWaveform(i, floatBlock, count);
+
+		for (pp_int32 k = 0; k < count; k++)
 		{
-			double yL, yR;
-			// Pass the stereo input
-			eqs[j]->Filter(xL, xR, yL, yR);
+			// Fetch a stereo signal
+			double xL = floatBlock[k];
+			double xR = xL;
+				
+			for (pp_int32 j = 0; j < par->getNumParameters(); j++)
+			{
+				double yL, yR;
+				// Pass the stereo input
+				eqs[j]->Filter(xL, xR, yL, yR);
+				
+				xL = yL;
+				xR = yR;
+			}
 			
-			xL = yL;
-			xR = yR;
+			floatBlock[k] = (float)xL;
 		}
-		
-		setFloatSampleInWaveform(i, (float)xL);
+
+		setFloatSamplesInWaveform(i, floatBlock, count);
 	}
 	
 	for (i = 0; i < par->getNumParameters(); i++)
@@ -2295,7 +2532,7 @@ void SampleEditor::tool_generateNoise(const FilterParameters* par)
 	
 	preFilter(&SampleEditor::tool_generateNoise, par);
 	
-	prepareUndo();	
+	prepareUndo(sStart, sEnd);	
 	
 	pp_int32 i;
 
@@ -2353,7 +2590,7 @@ void SampleEditor::tool_generateSine(const FilterParameters* par)
 	
 	mp_sint32 sLen = sEnd - sStart;
 	
-	prepareUndo();	
+	prepareUndo(sStart, sEnd);	
 	
 	pp_int32 i;
 
@@ -2400,7 +2637,7 @@ void SampleEditor::tool_generateSquare(const FilterParameters* par)
 	
 	mp_sint32 sLen = sEnd - sStart;
 	
-	prepareUndo();	
+	prepareUndo(sStart, sEnd);	
 	
 	pp_int32 i;
 
@@ -2448,7 +2685,7 @@ void SampleEditor::tool_generateTriangle(const FilterParameters* par)
 	
 	mp_sint32 sLen = sEnd - sStart;
 	
-	prepareUndo();	
+	prepareUndo(sStart, sEnd);	
 	
 	pp_int32 i;
 
@@ -2501,7 +2738,7 @@ void SampleEditor::tool_generateSawtooth(const FilterParameters* par)
 	
 	mp_sint32 sLen = sEnd - sStart;
 	
-	prepareUndo();	
+	prepareUndo(sStart, sEnd);	
 	
 	pp_int32 i;
 
@@ -38,6 +38,7 @@
 struct TXMSample;
 
 class FilterParameters;
+class SamplePeakCache;
 
 class SampleEditor : public EditorBase
 {
@@ -112,6 +113,12 @@ private:
 	bool undoStackActivated;
 	UndoStackEntry::UserData undoUserData;
 	SampleUndoStackEntry* before;
+	// state after the last operation, new undo entries share its unchanged chunks
+	SampleUndoStackEntry* lastState;
+	// sample memory lastState has been taken from
+	const mp_sbyte* lastStateBuffer;
+	// range of samples the current operation changes, -1 if unknown
+	pp_int32 undoRangeStart, undoRangeEnd;
 	PPUndoStack<SampleUndoStackEntry>* undoStack;	
 	UndoHistory<TXMSample, SampleUndoStackEntry>* undoHistory;
 	bool lastOperationDidChangeSize;
@@ -120,8 +127,13 @@ private:
 	bool drawing;
 	pp_int32 lastSamplePos;
 
-	void prepareUndo();
+	SamplePeakCache* peakCache;
+
+	void prepareUndo(pp_int32 from = -1, pp_int32 to = -1);
+	void extendUndoRange(pp_int32 from, pp_int32 to);
 	void finishUndo();
+	void limitUndoSize();
+	void invalidateLastState();
 	
 	bool revoke(const SampleUndoStackEntry* stackEntry);
 	
@@ -145,6 +157,11 @@ public:
 	bool canMinimize() const;
 	bool isEditableSample() const;
 
+	// min, max and RMS of the samples in [from, to) for drawing the waveform
+	bool getPeak(pp_int32 from, pp_int32 to, pp_int32& min, pp_int32& max, pp_int32& rms);
+	// sample data has been changed from outside the editor
+	void invalidatePeaks();
+
 	void setSelectionStart(pp_int32 selectionStart) { this->selectionStart = selectionStart; }
 	pp_int32& getSelectionStart() { return selectionStart; }
 
@@ -299,6 +316,28 @@ private:
 
 	float getFloatSampleFromWaveform(pp_int32 index, void* source = NULL, pp_int32 size = 0);
 	void setFloatSampleInWaveform(pp_int32 index, float singleSample, void* source = NULL);
+
+	// the filters work on blocks of float samples
+	enum
+	{
+		FloatBlockSize = 4096,
+		// room for the neighbours of the first and last sample (smoothing)
+		FloatBlockMargin = 4
+	};
+	
+	// FloatBlockSize input samples with FloatBlockMargin samples to each side 
+	// followed by FloatBlockSize output samples
+	float* floatBlock;
+	
+	// Bulk versions of the above. The original loop area is restored
+	// first, so they see the real sample data and don't need any of the
+	// per sample loop checks. Only to be called between pre and postFilter.
+	void getFloatSamplesFromWaveform(pp_int32 index, float* dst, pp_int32 count);
+	void setFloatSamplesInWaveform(pp_int32 index, const float* src, pp_int32 count);
+
+	// x-fade helper: fades [from, to) in or out against the samples starting at other 
+	// (going forward or backward with direction) taken from the unmodified copy in source
+	void xFadeRange(void* source, pp_int32 from, pp_int32 to, bool fadeIn, pp_int32 other, pp_int32 direction);
 	
 	typedef void (SampleEditor::*TFilterFunc)(const FilterParameters* par);
 	FilterParameters* lastParameters;
@@ -410,6 +410,15 @@ void SampleEditorControl::paint(PPGraphicsAbstract* g)
 	
 	mp_sint32 lasty = -(pp_int32)(sample->getSampleValue((pp_int32)(startPos*xScale))*scale);
 	
+	// with several samples per pixel draw the peaks of each column instead of
+	// picking single samples, they're taken from the editor's peak cache
+	const bool drawPeaks = xScale >= 2.0f;
+	mp_sint32 lastTop = lasty, lastBottom = lasty;
+	
+	PPColor rmsColor = TrackerConfig::colorSampleEditorWaveform;
+	rmsColor.interpolateFixed(PPColor(255, 255, 255), 32768);
+	PPColor selectionRmsColor(192, 192, 192);
+	
 	g->setColor(*borderColor);
 	g->setPixel(xOffset, yOffset);
 	
@@ -417,11 +426,13 @@ void SampleEditorControl::paint(PPGraphicsAbstract* g)
 	{
 		if ((pp_int32)((startPos+x)*xScale) < getVisibleLength())
 		{
+			bool selected = false;
 			if (sel && x >= (pp_int32)((sStart/xScale)-startPos) && x <= (pp_int32)((sEnd/xScale)-startPos) && (selectionTicker == -1))
 			{
 				g->setColor(255-dColor.r,255-dColor.g,255-dColor.b);
 				g->setPixel(xOffset + x, yOffset);
 				g->setColor(255, 255, 255);
+				selected = true;
 			}
 			else
 			{
@@ -430,6 +441,33 @@ void SampleEditorControl::paint(PPGraphicsAbstract* g)
 				g->setColor(TrackerConfig::colorSampleEditorWaveform);
 			}
 			
+			pp_int32 min, max, rms;
+			if (drawPeaks && 
+				sampleEditor->getPeak((pp_int32)((startPos+x)*xScale), (pp_int32)((startPos+x+1)*xScale), min, max, rms))
+			{
+				mp_sint32 top = -(mp_sint32)(max*scale);
+				mp_sint32 bottom = -(mp_sint32)(min*scale);
+				
+				// close the gap to the previous column
+				if (top > lastBottom)
+					top = lastBottom;
+				if (bottom < lastTop)
+					bottom = lastTop;
+				
+				g->drawVLine(yOffset + top, yOffset + bottom + 1, xOffset + x);
+				
+				mp_sint32 rmsy = (mp_sint32)(rms*scale);
+				if (rmsy)
+				{
+					g->setColor(selected ? selectionRmsColor : rmsColor);
+					g->drawVLine(yOffset - rmsy, yOffset + rmsy + 1, xOffset + x);
+				}
+				
+				lastTop = -(mp_sint32)(max*scale);
+				lastBottom = -(mp_sint32)(min*scale);
+				continue;
+			}
+			
 			float findex = ((startPos+x)*xScale);
 			pp_int32 index = (pp_int32)(floor(findex));
 			pp_int32 index2 = index+1;
@@ -33,6 +33,9 @@
 
 #include "BasicTypes.h"
 
+// sample rate of a C-4 with the given relative note and finetune
+float getc4spd(pp_int32 relnote, pp_int32 finetune);
+
 class SampleEditorResampler
 {
 private:
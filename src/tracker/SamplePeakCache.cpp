@@ -0,0 +1,289 @@
+/*
+ *  tracker/SamplePeakCache.cpp
+ *
+ *  Copyright 2009 Peter Barth
+ *
+ *  This file is part of Milkytracker.
+ *
+ *  Milkytracker is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Milkytracker is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Milkytracker.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ *  SamplePeakCache.cpp
+ *  MilkyTracker
+ *
+ */
+
+#include "SamplePeakCache.h"
+#include "XModule.h"
+#include <math.h>
+
+// samples after the loop end might hold a copy of the loop start,
+// they're always read through TXMSample::getSampleValue
+#define LOOPAREASIZE 8
+
+SamplePeakCache::SamplePeakCache() :
+	sample(NULL),
+	data(NULL),
+	samplen(0),
+	type(0),
+	numLevels(0),
+	dirtyStart(0),
+	dirtyEnd(0)
+{
+	for (pp_int32 i = 0; i < MaxLevels; i++)
+	{
+		levels[i] = NULL;
+		levelSizes[i] = 0;
+	}
+}
+
+SamplePeakCache::~SamplePeakCache()
+{
+	freeLevels();
+}
+
+void SamplePeakCache::freeLevels()
+{
+	for (pp_int32 i = 0; i < numLevels; i++)
+	{
+		delete[] levels[i];
+		levels[i] = NULL;
+		levelSizes[i] = 0;
+	}
+
+	numLevels = 0;
+}
+
+void SamplePeakCache::invalidate()
+{
+	dirtyStart = 0;
+	dirtyEnd = 0x7FFFFFFF;
+}
+
+void SamplePeakCache::invalidate(pp_int32 from, pp_int32 to)
+{
+	if (from < 0)
+		from = 0;
+	if (from >= to)
+		return;
+
+	if (dirtyStart >= dirtyEnd)
+	{
+		dirtyStart = from;
+		dirtyEnd = to;
+	}
+	else
+	{
+		if (from < dirtyStart)
+			dirtyStart = from;
+		if (to > dirtyEnd)
+			dirtyEnd = to;
+	}
+}
+
+void SamplePeakCache::validate(TXMSample* sample)
+{
+	if (sample == this->sample &&
+		sample->sample == data &&
+		sample->samplen == samplen &&
+		(sample->type & 16) == (type & 16))
+		return;
+
+	this->sample = sample;
+	data = sample->sample;
+	samplen = sample->samplen;
+	type = sample->type;
+
+	freeLevels();
+	invalidate();
+}
+
+void SamplePeakCache::rebuild()
+{
+	freeLevels();
+
+	for (pp_int32 i = 0; i < MaxLevels; i++)
+	{
+		const pp_int32 shift = getBlockShift(i);
+		levelSizes[i] = (samplen + (1 << shift) - 1) >> shift;
+		levels[i] = new Peak[levelSizes[i]];
+		numLevels++;
+
+		if (levelSizes[i] <= 1)
+			break;
+	}
+}
+
+void SamplePeakCache::update()
+{
+	if (dirtyStart >= dirtyEnd)
+		return;
+
+	if (numLevels == 0)
+	{
+		rebuild();
+		invalidate();
+	}
+
+	if (dirtyEnd > (signed)samplen)
+		dirtyEnd = samplen;
+	if (dirtyStart >= dirtyEnd)
+	{
+		dirtyStart = dirtyEnd = 0;
+		return;
+	}
+
+	pp_int32 loopAreaStart = (sample->type & 3) ? sample->loopstart + sample->looplen : -LOOPAREASIZE;
+
+	// lowest level from the sample data
+	pp_int32 first = dirtyStart >> BlockShift;
+	pp_int32 last = (dirtyEnd - 1) >> BlockShift;
+
+	for (pp_int32 i = first; i <= last; i++)
+	{
+		const pp_int32 start = i << BlockShift;
+		pp_int32 end = start + (1 << BlockShift);
+		if (end > (signed)samplen)
+			end = samplen;
+
+		pp_int32 min = 32767, max = -32768;
+		float power = 0.0f;
+
+		if (end > loopAreaStart && start < loopAreaStart + LOOPAREASIZE)
+		{
+			for (pp_int32 j = start; j < end; j++)
+			{
+				const pp_int32 s = sample->getSampleValue(j);
+				if (s < min) min = s;
+				if (s > max) max = s;
+				power+=(float)(s*s);
+			}
+		}
+		else if (sample->type & 16)
+		{
+			const mp_sword* src = (const mp_sword*)sample->sample;
+			for (pp_int32 j = start; j < end; j++)
+			{
+				const pp_int32 s = src[j];
+				if (s < min) min = s;
+				if (s > max) max = s;
+				power+=(float)(s*s);
+			}
+		}
+		else
+		{
+			const mp_sbyte* src = sample->sample;
+			for (pp_int32 j = start; j < end; j++)
+			{
+				const pp_int32 s = src[j];
+				if (s < min) min = s;
+				if (s > max) max = s;
+				power+=(float)(s*s);
+			}
+		}
+
+		levels[0][i].min = (pp_int16)min;
+		levels[0][i].max = (pp_int16)max;
+		levels[0][i].power = power;
+	}
+
+	// every other level from the one below
+	for (pp_int32 l = 1; l < numLevels; l++)
+	{
+		first >>= LevelShift;
+		last >>= LevelShift;
+
+		const Peak* src = levels[l-1];
+		for (pp_int32 i = first; i <= last; i++)
+		{
+			const pp_int32 start = i << LevelShift;
+			pp_int32 end = start + (1 << LevelShift);
+			if (end > (signed)levelSizes[l-1])
+				end = levelSizes[l-1];
+
+			Peak peak = src[start];
+			for (pp_int32 j = start+1; j < end; j++)
+			{
+				if (src[j].min < peak.min) peak.min = src[j].min;
+				if (src[j].max > peak.max) peak.max = src[j].max;
+				peak.power+=src[j].power;
+			}
+
+			levels[l][i] = peak;
+		}
+	}
+
+	dirtyStart = dirtyEnd = 0;
+}
+
+bool SamplePeakCache::getPeak(TXMSample* sample, pp_int32 from, pp_int32 to, pp_int32& min, pp_int32& max, pp_int32& rms)
+{
+	if (sample == NULL || sample->sample == NULL || sample->samplen == 0)
+		return false;
+
+	validate(sample);
+	update();
+
+	if (from < 0)
+		from = 0;
+	if (to > (signed)samplen)
+		to = samplen;
+	if (from >= to)
+	{
+		if (from >= (signed)samplen)
+			return false;
+		to = from + 1;
+	}
+
+	min = 32767;
+	max = -32768;
+	float power = 0.0f;
+
+	pp_int32 pos = from;
+	while (pos < to)
+	{
+		// largest block which starts here and fits into the range
+		pp_int32 level = numLevels - 1;
+		for (; level >= 0; level--)
+		{
+			const pp_int32 size = 1 << getBlockShift(level);
+			if (!(pos & (size - 1)) && pos + size <= to)
+				break;
+		}
+
+		if (level >= 0)
+		{
+			const pp_int32 shift = getBlockShift(level);
+			const Peak& peak = levels[level][pos >> shift];
+			if (peak.min < min) min = peak.min;
+			if (peak.max > max) max = peak.max;
+			power+=peak.power;
+			pos+=1 << shift;
+		}
+		else
+		{
+			const pp_int32 s = sample->getSampleValue(pos);
+			if (s < min) min = s;
+			if (s > max) max = s;
+			power+=(float)(s*s);
+			pos++;
+		}
+	}
+
+	rms = (pp_int32)sqrtf(power / (float)(to - from));
+
+	return true;
+}
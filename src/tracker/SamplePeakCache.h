@@ -0,0 +1,93 @@
+/*
+ *  tracker/SamplePeakCache.h
+ *
+ *  Copyright 2009 Peter Barth
+ *
+ *  This file is part of Milkytracker.
+ *
+ *  Milkytracker is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Milkytracker is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Milkytracker.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ *  SamplePeakCache.h
+ *  MilkyTracker
+ *
+ *  Min/max/power pyramid of a sample, so the waveform of any range can be
+ *  summarized with a handful of lookups regardless of its length.
+ *  Levels are built when they're needed and only the ranges which have been
+ *  invalidated get rebuilt.
+ *
+ */
+
+#ifndef __SAMPLEPEAKCACHE_H__
+#define __SAMPLEPEAKCACHE_H__
+
+#include "BasicTypes.h"
+
+struct TXMSample;
+
+class SamplePeakCache
+{
+private:
+	enum
+	{
+		// a block of the lowest level covers 1 << BlockShift samples
+		BlockShift = 5,
+		// every level combines 1 << LevelShift blocks of the level below
+		LevelShift = 2,
+		MaxLevels = 12
+	};
+
+	struct Peak
+	{
+		pp_int16 min, max;
+		// sum of the squared sample values
+		float power;
+	};
+
+	TXMSample* sample;
+	const void* data;
+	pp_uint32 samplen;
+	pp_uint32 type;
+	pp_uint32 loopEnd;
+
+	Peak* levels[MaxLevels];
+	pp_uint32 levelSizes[MaxLevels];
+	pp_int32 numLevels;
+
+	// range of samples which needs to be rebuilt
+	pp_int32 dirtyStart, dirtyEnd;
+
+	static pp_int32 getBlockShift(pp_int32 level) { return BlockShift + level*LevelShift; }
+
+	void freeLevels();
+	void rebuild();
+	void update();
+	void validate(TXMSample* sample);
+
+public:
+	SamplePeakCache();
+	~SamplePeakCache();
+
+	// everything needs to be rebuilt
+	void invalidate();
+	// samples in [from, to) have changed
+	void invalidate(pp_int32 from, pp_int32 to);
+
+	// min, max and RMS of the samples in [from, to), returns false if there is no sample data
+	bool getPeak(TXMSample* sample, pp_int32 from, pp_int32 to, pp_int32& min, pp_int32& max, pp_int32& rms);
+};
+
+#endif
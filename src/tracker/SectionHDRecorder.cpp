@@ -81,6 +81,7 @@ enum ControlIDs
 	HDRECORD_BUTTON_SMP_PLUS,
 	HDRECORD_BUTTON_SMP_MINUS,
 	HDRECORD_BUTTON_MIXER_AUTO,
+	HDRECORD_CHECKBOX_FLOATOUTPUT,
 	
 	RESPONDMESSAGEBOX_SELECTRESAMPLER
 };
@@ -187,6 +188,22 @@ void SectionHDRecorder::setSettingsAllowMuting(bool b)
 	checkBox->checkIt(b);
 }
 
+bool SectionHDRecorder::getSettingsFloatOutput()
+{
+	PPContainer* container = static_cast<PPContainer*>(sectionContainer);
+	PPCheckBox* checkBox = static_cast<PPCheckBox*>(container->getControlByID(HDRECORD_CHECKBOX_FLOATOUTPUT));
+	ASSERT(checkBox);
+	return checkBox->isChecked();
+}
+
+void SectionHDRecorder::setSettingsFloatOutput(bool b)
+{
+	PPContainer* container = static_cast<PPContainer*>(sectionContainer);
+	PPCheckBox* checkBox = static_cast<PPCheckBox*>(container->getControlByID(HDRECORD_CHECKBOX_FLOATOUTPUT));
+	ASSERT(checkBox);
+	checkBox->checkIt(b);
+}
+
 pp_int32 SectionHDRecorder::getSettingsFrequency()
 {
 	PPContainer* container = static_cast<PPContainer*>(sectionContainer);
@@ -507,6 +524,9 @@ void SectionHDRecorder::init(pp_int32 px, pp_int32 py)
 	container->addControl(new PPStaticText(0, NULL, NULL, PPPoint(x2, y2), "Allow muting:", true));
 	container->addControl(new PPCheckBox(HDRECORD_CHECKBOX_ALLOWMUTING, screen, this, PPPoint(x2 + 15*8, y2-1), false));	
 
+	container->addControl(new PPStaticText(0, NULL, NULL, PPPoint(x2, y2 + 12), "Float WAV:", true));
+	container->addControl(new PPCheckBox(HDRECORD_CHECKBOX_FLOATOUTPUT, screen, this, PPPoint(x2 + 15*8, y2-1+12), false));	
+
 	x2 += 18*8-4;
 	container->addControl(new PPSeperator(0, screen, PPPoint(x2 - 6, py+16 - 2), container->getSize().height - (dy+28), TrackerConfig::colorThemeMain, false));
 
@@ -766,6 +786,7 @@ void SectionHDRecorder::exportWAVAsFileName(const PPSystemString& fileName)
 	parameters.playMode = tracker.playerController->getPlayMode();
 	parameters.mixerShift = getSettingsMixerShift(); 
 	parameters.mixerVolume = mixerVolume;
+	parameters.floatOutput = getSettingsFloatOutput();
 
 	mp_ubyte* muting = new mp_ubyte[moduleEditor->getNumChannels()];
 	memset(muting, 0, moduleEditor->getNumChannels());
@@ -811,6 +832,8 @@ void SectionHDRecorder::getPeakLevel()
 	parameters.playMode = tracker.playerController->getPlayMode();
 	parameters.mixerShift = getSettingsMixerShift(); 
 	parameters.mixerVolume = 256;
+	// samples are always recorded with 16 bits
+	parameters.floatOutput = recorderMode == RecorderModeToFile && getSettingsFloatOutput();
 
 	mp_ubyte* muting = new mp_ubyte[moduleEditor->getNumChannels()];
 	memset(muting, 0, moduleEditor->getNumChannels());
@@ -67,6 +67,8 @@ private:
 	
 	bool getSettingsAllowMuting();
 	void setSettingsAllowMuting(bool b);
+	bool getSettingsFloatOutput();
+	void setSettingsFloatOutput(bool b);
 	
 	pp_int32 getSettingsFrequency();
 	void setSettingsFrequency(pp_int32 freq);
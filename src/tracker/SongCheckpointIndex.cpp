@@ -0,0 +1,300 @@
+/*
+ *  tracker/SongCheckpointIndex.cpp
+ *
+ *  Copyright 2009 Peter Barth
+ *
+ *  This file is part of Milkytracker.
+ *
+ *  Milkytracker is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Milkytracker is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Milkytracker.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ *  SongCheckpointIndex.cpp
+ *  MilkyTracker
+ *
+ */
+
+#include "SongCheckpointIndex.h"
+#include "MilkyPlay.h"
+#include "MilkyPlayAtomic.h"
+
+SongCheckpointIndex::SongCheckpointIndex(XModule* theModule) :
+	module(theModule),
+	builder(NULL),
+	seeker(NULL),
+	seekState(NULL),
+	stateSize(0),
+	restartPlayers(true),
+	checkpoints(new Checkpoint[MaxCheckpoints]),
+	numCheckpoints(0),
+	numSeeking(0),
+	building(false),
+	complete(false),
+	lastOrder(-1)
+{
+	memset(&configuration, 0, sizeof(configuration));
+	memset(checkpoints, 0, sizeof(Checkpoint)*MaxCheckpoints);
+	memset(positionHits, 0, sizeof(positionHits));
+}
+
+SongCheckpointIndex::~SongCheckpointIndex()
+{
+	for (mp_sint32 i = 0; i < MaxCheckpoints; i++)
+		delete[] checkpoints[i].state;
+	delete[] checkpoints;
+
+	delete[] seekState;
+	delete seeker;
+	delete builder;
+}
+
+void SongCheckpointIndex::truncate(mp_sint32 num)
+{
+	if (num < numCheckpoints)
+	{
+		mpAtomicStore(&numCheckpoints, num);
+
+		// a seek might still be using the checkpoints we've just given up
+		mpMemoryBarrier();
+		while (mpAtomicLoad(&numSeeking))
+		{
+		}
+
+		memset(positionHits, 0, sizeof(positionHits));
+		for (mp_sint32 i = 0; i < num; i++)
+			hitPosition(checkpoints[i].order, checkpoints[i].row);
+	}
+
+	// the builder might have played past the point we're going back to
+	building = false;
+	complete = false;
+}
+
+void SongCheckpointIndex::invalidate()
+{
+	truncate(0);
+	restartPlayers = true;
+}
+
+void SongCheckpointIndex::invalidatePattern(mp_sint32 patternIndex)
+{
+	for (mp_sint32 i = 0; i < numCheckpoints; i++)
+	{
+		if (module->header.ord[checkpoints[i].order] != patternIndex)
+			continue;
+
+		// the first checkpoint of an order has been taken before any of its rows were played
+		if (i == 0 || checkpoints[i-1].order != checkpoints[i].order)
+			i++;
+
+		truncate(i);
+		return;
+	}
+
+	// the pattern isn't played before the last checkpoint but the builder might be in it right now
+	if (building)
+		truncate(numCheckpoints);
+}
+
+void SongCheckpointIndex::validate(const PlayerBase& player, const mp_ubyte* customPanningTable)
+{
+	Configuration current;
+	memset(&current, 0, sizeof(current));
+
+	current.ordnum = module->header.ordnum;
+	current.restart = module->header.restart;
+	current.channum = module->header.channum;
+	current.freqtab = module->header.freqtab;
+	current.flags = module->header.flags;
+	current.tempo = module->header.tempo;
+	current.speed = module->header.speed;
+	current.mainvol = module->header.mainvol;
+	memcpy(current.ord, module->header.ord, sizeof(current.ord));
+	memcpy(current.panning, customPanningTable ? customPanningTable : module->header.pan, module->header.channum);
+
+	// the player keeps pointers to the envelopes
+	current.envelopes[0] = module->venvs;
+	current.envelopes[1] = module->penvs;
+	current.envelopes[2] = module->fenvs;
+	current.envelopes[3] = module->vibenvs;
+	current.numEnvelopes[0] = module->numVEnvs;
+	current.numEnvelopes[1] = module->numPEnvs;
+	current.numEnvelopes[2] = module->numFEnvs;
+	current.numEnvelopes[3] = module->numVibEnvs;
+
+	current.playMode = player.getPlayMode();
+	for (mp_sint32 i = PlayModeSettings::PlayModeOptionFirst; i < PlayModeSettings::PlayModeOptionLast; i++)
+		current.options[i] = player.isEnabled((PlayModeSettings::PlayModeOptions)i);
+
+	if (memcmp(&current, &configuration, sizeof(configuration)) != 0)
+	{
+		invalidate();
+		configuration = current;
+	}
+}
+
+bool SongCheckpointIndex::startBuilding()
+{
+	if (!module->isModuleLoaded() || module->header.channum == 0)
+		return false;
+
+	// nobody is seeking when there are no checkpoints
+	if (restartPlayers)
+	{
+		ASSERT(numCheckpoints == 0);
+
+		if (builder == NULL)
+			builder = new PlayerSTD(44100);
+		if (seeker == NULL)
+			seeker = new PlayerSTD(44100);
+
+		PlayerSTD* players[2] = {builder, seeker};
+		for (mp_sint32 i = 0; i < 2; i++)
+		{
+			players[i]->setDisableMixing(true);
+			players[i]->setPlayMode(configuration.playMode);
+			for (mp_sint32 j = PlayModeSettings::PlayModeOptionFirst; j < PlayModeSettings::PlayModeOptionLast; j++)
+				players[i]->enable((PlayModeSettings::PlayModeOptions)j, configuration.options[j]);
+			players[i]->startPlaying(module, false, 0, 0, -1, configuration.panning, false, -1);
+		}
+
+		if (builder->getStateSize() != stateSize)
+		{
+			for (mp_sint32 i = 0; i < MaxCheckpoints; i++)
+			{
+				delete[] checkpoints[i].state;
+				checkpoints[i].state = NULL;
+			}
+			delete[] seekState;
+
+			stateSize = builder->getStateSize();
+			seekState = new mp_ubyte[stateSize];
+		}
+
+		restartPlayers = false;
+	}
+	else if (numCheckpoints == 0)
+	{
+		builder->startPlaying(module, false, 0, 0, -1, configuration.panning, false, -1);
+	}
+
+	// continue where the last valid checkpoint has been taken
+	if (numCheckpoints)
+	{
+		const Checkpoint& checkpoint = checkpoints[numCheckpoints-1];
+		if (!builder->restoreState(checkpoint.state))
+			return false;
+		lastOrder = checkpoint.order;
+	}
+	else
+	{
+		lastOrder = -1;
+	}
+
+	building = true;
+	return true;
+}
+
+void SongCheckpointIndex::addCheckpoint(mp_sint32 order, mp_sint32 row)
+{
+	const mp_sint32 num = numCheckpoints;
+	if (num >= MaxCheckpoints)
+		return;
+
+	Checkpoint& checkpoint = checkpoints[num];
+	if (checkpoint.state == NULL)
+		checkpoint.state = new mp_ubyte[stateSize];
+
+	if (!builder->saveState(checkpoint.state))
+		return;
+
+	checkpoint.order = order;
+	checkpoint.row = row;
+	hitPosition(order, row);
+
+	// make it visible to seek()
+	mpAtomicStore(&numCheckpoints, num+1);
+}
+
+bool SongCheckpointIndex::build(mp_sint32 maxRows)
+{
+	if (complete)
+		return true;
+
+	if (!building && !startBuilding())
+	{
+		complete = true;
+		return true;
+	}
+
+	for (mp_sint32 i = 0; i < maxRows; i++)
+	{
+		mp_sint32 order, row;
+		builder->getCurrentPosition(order, row);
+
+		if (order >= 0 && order < module->header.ordnum &&
+			row >= 0 && row < module->phead[module->header.ord[order]].rows &&
+			(order != lastOrder || (row % RowInterval) == 0) &&
+			!isPositionHit(order, row))
+		{
+			addCheckpoint(order, row);
+		}
+
+		lastOrder = order;
+
+		if (!builder->skipRow())
+		{
+			building = false;
+			complete = true;
+			break;
+		}
+	}
+
+	return complete;
+}
+
+bool SongCheckpointIndex::seek(PlayerBase& player, mp_sint32 order, mp_sint32 row)
+{
+	// we can only seek within the song
+	if (player.isIdle() || player.getPatternToPlay() != -1)
+		return false;
+
+	bool res = false;
+
+	mpAtomicAdd(&numSeeking, 1);
+
+	const mp_sint32 num = mpAtomicLoad(&numCheckpoints);
+
+	// closest checkpoint in front of the position
+	const Checkpoint* checkpoint = NULL;
+	for (mp_sint32 i = 0; i < num; i++)
+	{
+		if (checkpoints[i].order == order && checkpoints[i].row <= row &&
+			(checkpoint == NULL || checkpoints[i].row > checkpoint->row))
+			checkpoint = &checkpoints[i];
+	}
+
+	if (checkpoint &&
+		seeker->restoreState(checkpoint->state) &&
+		seeker->skipToPosition(order, row, MaxSkipRows) &&
+		seeker->saveState(seekState))
+	{
+		res = player.restoreState(seekState);
+	}
+
+	mpAtomicAdd(&numSeeking, -1);
+
+	return res;
+}
@@ -0,0 +1,141 @@
+/*
+ *  tracker/SongCheckpointIndex.h
+ *
+ *  Copyright 2009 Peter Barth
+ *
+ *  This file is part of Milkytracker.
+ *
+ *  Milkytracker is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Milkytracker is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Milkytracker.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ *  SongCheckpointIndex.h
+ *  MilkyTracker
+ *
+ *  Snapshots of the player state taken while silently playing through
+ *  the song, so playback can be started anywhere in the song with the
+ *  speed, volumes and effect memory it would have when playing there
+ *  from the start.
+ *
+ */
+
+#ifndef __SONGCHECKPOINTINDEX_H__
+#define __SONGCHECKPOINTINDEX_H__
+
+#include "MilkyPlayTypes.h"
+#include "PlayerBase.h"
+
+class PlayerSTD;
+class XModule;
+
+class SongCheckpointIndex
+{
+private:
+	enum
+	{
+		// a checkpoint is taken every RowInterval rows and whenever a new order starts
+		RowInterval = 32,
+		MaxCheckpoints = 2048,
+		// seeking gives up if the position can't be reached within that many rows
+		MaxSkipRows = 256
+	};
+
+	struct Checkpoint
+	{
+		mp_sint32 order;
+		mp_sint32 row;
+		mp_ubyte* state;
+	};
+
+	// everything the checkpoints depend on apart from the pattern data
+	struct Configuration
+	{
+		mp_uword ordnum;
+		mp_uword restart;
+		mp_uword channum;
+		mp_uword freqtab;
+		mp_dword flags;
+		mp_uword tempo;
+		mp_uword speed;
+		mp_uword mainvol;
+		mp_ubyte ord[256];
+		mp_ubyte panning[256];
+		const void* envelopes[4];
+		mp_uint32 numEnvelopes[4];
+		PlayModeSettings::PlayModes playMode;
+		bool options[PlayModeSettings::PlayModeOptionLast];
+	};
+
+	XModule* module;
+	Configuration configuration;
+
+	// plays through the song and takes the snapshots (UI thread)
+	PlayerSTD* builder;
+	// fast forwards from a checkpoint when seeking (audio thread)
+	PlayerSTD* seeker;
+	mp_ubyte* seekState;
+	mp_uint32 stateSize;
+	bool restartPlayers;
+
+	Checkpoint* checkpoints;
+	// checkpoints below this index can be used for seeking
+	volatile mp_sint32 numCheckpoints;
+	volatile mp_sint32 numSeeking;
+	// bitmap of order/row positions we already have
+	mp_ubyte positionHits[256*256/8];
+
+	bool building;
+	bool complete;
+	mp_sint32 lastOrder;
+
+	void truncate(mp_sint32 num);
+	bool startBuilding();
+	void addCheckpoint(mp_sint32 order, mp_sint32 row);
+
+	bool isPositionHit(mp_sint32 order, mp_sint32 row) const
+	{
+		const mp_sint32 pos = order*256+row;
+		return (positionHits[pos>>3]>>(pos&7))&1;
+	}
+
+	void hitPosition(mp_sint32 order, mp_sint32 row)
+	{
+		const mp_sint32 pos = order*256+row;
+		positionHits[pos>>3] |= (1<<(pos&7));
+	}
+
+public:
+	SongCheckpointIndex(XModule* module);
+	~SongCheckpointIndex();
+
+	// everything needs to be rebuilt, e.g. a new song has been loaded
+	void invalidate();
+	// a pattern has been edited, rebuild what has been played after it
+	void invalidatePattern(mp_sint32 patternIndex);
+
+	// UI thread: take over the play mode and panning of the player which is going
+	// to seek and check whether the song has changed in a way that needs a rebuild
+	void validate(const PlayerBase& player, const mp_ubyte* customPanningTable);
+	// UI thread: continue playing through the song for at most maxRows rows
+	// returns true when the whole song has been indexed
+	bool build(mp_sint32 maxRows);
+
+	// Let the (playing) player continue at order/row with the song state from
+	// the closest checkpoint in front of it. This is safe to be called from
+	// the audio thread, returns false if there is no such checkpoint (yet).
+	bool seek(PlayerBase& player, mp_sint32 order, mp_sint32 row);
+};
+
+#endif
@@ -30,23 +30,45 @@
 
 #include "SongLengthEstimator.h"
 #include "MilkyPlay.h"
-#include "AudioDriver_NULL.h"
 
 SongLengthEstimator::SongLengthEstimator(XModule* theModule) :
-	player(NULL),
-	module(theModule)
+	module(theModule),
+	visits(NULL),
+	numVisits(0),
+	maxVisits(0),
+	rowVisits(new mp_uword[256*256]),
+	complete(false),
+	songLength(0),
+	loops(NULL),
+	numLoops(0),
+	attick(NULL)
 {
+	memset(&configuration, 0, sizeof(configuration));
+	memset(rowVisits, 0, sizeof(mp_uword)*256*256);
 }
 
 SongLengthEstimator::SongLengthEstimator(const SongLengthEstimator& src) :
-	player(NULL),
-	module(src.module)
+	module(src.module),
+	visits(NULL),
+	numVisits(0),
+	maxVisits(0),
+	rowVisits(new mp_uword[256*256]),
+	complete(false),
+	songLength(0),
+	loops(NULL),
+	numLoops(0),
+	attick(NULL)
 {
+	memset(&configuration, 0, sizeof(configuration));
+	memset(rowVisits, 0, sizeof(mp_uword)*256*256);
 }
 
 SongLengthEstimator::~SongLengthEstimator() 
 {
-	delete player;
+	delete[] attick;
+	delete[] loops;
+	delete[] rowVisits;
+	delete[] visits;
 }
 
 const SongLengthEstimator& SongLengthEstimator::operator=(const SongLengthEstimator& src)
@@ -54,29 +76,488 @@ const SongLengthEstimator& SongLengthEstimator::operator=(const SongLengthEstima
 	if (&src != this)
 	{
 		module = src.module;
+		invalidate();
 	}
 	return *this;
 }
 
-mp_sint32 SongLengthEstimator::estimateSongLengthInSeconds()
+mp_uint32 SongLengthEstimator::getBPMRate(mp_sint32 bpm) const
+{
+	// same as PlayerSTD::getbpmrate
+	mp_uint32 realCiaTempo = (bpm * (baseBpm << 8) / 125) >> 8;
+
+	if (!realCiaTempo) realCiaTempo++;
+	
+	mp_int64 t = ((mp_int64)realCiaTempo)<<(32+2);
+	
+	const mp_uint32 timerBase = (mp_uint32)(5.0f*500.0f*(ChannelMixer::MP_BEATLENGTH*ChannelMixer::MP_TIMERFREQ / (float)ChannelMixer::MP_BASEFREQ));
+	
+	return (mp_uint32)(t/timerBase);
+}
+
+mp_sint32 SongLengthEstimator::getSeconds(mp_sint32 beatPackets)
 {
-	if (!player)
+	// the mixer plays whole samples per beat packet, e.g. 176 instead of 176.4 at 44.1kHz
+	const mp_int64 beatPacketSize = (ChannelMixer::MP_BEATLENGTH*MixFrequency)/ChannelMixer::MP_BASEFREQ;
+	return (mp_sint32)(beatPackets*beatPacketSize/MixFrequency);
+}
+
+void SongLengthEstimator::truncate(mp_sint32 num)
+{
+	// the last visit we keep is followed again as well
+	if (num <= numVisits)
 	{
-		player = new PlayerGeneric(44100);
-		
-		if (!player)
-			return -1;
-		
-		player->setBufferSize(1024);
-		player->setResamplerType((ChannelMixer::ResamplerTypes)0);
-		player->setMasterVolume(256);
-		player->setDisableMixing(true);
+		numVisits = num;
+
+		// forget the rows played by the visits we're going to follow again
+		for (mp_sint32 i = 0; i < 256*256; i++)
+			if (rowVisits[i] >= num)
+				rowVisits[i] = 0;
 	}
+
+	complete = false;
+}
+
+void SongLengthEstimator::invalidate()
+{
+	numVisits = 0;
+	memset(rowVisits, 0, sizeof(mp_uword)*256*256);
+	complete = false;
+}
+
+void SongLengthEstimator::invalidatePattern(mp_sint32 patternIndex)
+{
+	for (mp_sint32 i = 0; i < numVisits; i++)
+	{
+		if (module->header.ord[visits[i].order] != patternIndex)
+			continue;
+
+		// the last row of the order before already looks at the length of this pattern
+		truncate(i ? i : 1);
+		return;
+	}
+}
+
+void SongLengthEstimator::validate()
+{
+	Configuration current;
+	memset(&current, 0, sizeof(current));
+
+	current.ordnum = module->header.ordnum;
+	current.restart = module->header.restart;
+	current.channum = module->header.channum;
+	current.flags = module->header.flags;
+	current.tempo = module->header.tempo;
+	current.speed = module->header.speed;
+	memcpy(current.ord, module->header.ord, sizeof(current.ord));
+
+	if (memcmp(&current, &configuration, sizeof(configuration)) != 0)
+	{
+		invalidate();
+		configuration = current;
+	}
+}
+
+void SongLengthEstimator::addVisit()
+{
+	if (numVisits == maxVisits)
+	{
+		maxVisits = maxVisits ? maxVisits*2 : 256;
+		Visit* newVisits = new Visit[maxVisits];
+		if (visits)
+			memcpy(newVisits, visits, sizeof(Visit)*numVisits);
+		delete[] visits;
+		visits = newVisits;
+	}
+
+	Visit& visit = visits[numVisits++];
+	visit.order = order;
+	visit.row = row;
+	visit.tickSpeed = tickSpeed;
+	visit.bpm = bpm;
+	visit.baseBpm = baseBpm;
+	visit.bpmCounter = bpmCounter;
+	visit.beatPackets = beatPackets;
+	visit.startBeatPacket = -1;
 	
-	AudioDriver_NULL* audioDriver = new AudioDriver_NULL;
-	mp_sint32 res = player->exportToWAV(NULL, module, 0, -1, NULL, module->header.channum, NULL, audioDriver) / player->getMixFrequency();
-	delete audioDriver;
+	firstTick = true;
+}
+
+void SongLengthEstimator::resetLooping(mp_sint32 chn, mp_sint32 order)
+{
+	Loop& loop = loops[chn];
+	loop.loopStart = loop.loopCounter = 0;
+	loop.execLoop = loop.isLooping = false;
+	loop.loopingValidPosition = order;
+}
+
+void SongLengthEstimator::continueAt(const Visit& visit)
+{
+	order = visit.order;
+	row = visit.row;
+	tickSpeed = visit.tickSpeed;
+	bpm = visit.bpm;
+	baseBpm = visit.baseBpm;
+	adder = getBPMRate(bpm);
+	bpmCounter = visit.bpmCounter;
+	beatPackets = visit.beatPackets;
+
+	// entering an order always starts with a clean slate
+	ticker = 0;
+	startNextRow = -1;
+	patDelay = haltFlag = halted = false;
+	patDelayCount = 0;
+	newPosition = false;
+	firstTick = true;
+	for (mp_sint32 i = 0; i < numLoops; i++)
+		resetLooping(i, order);
+}
+
+void SongLengthEstimator::setNewPosition(mp_sint32 order)
+{
+	if (order == this->order)
+		return;
+
+	if (order >= module->header.ordnum)
+		order = module->header.restart;
 
-	return res;
+	for (mp_sint32 i = 0; i < numLoops; i++)
+		resetLooping(i, order);
+
+	this->order = order;
+	newPosition = true;
 }
 
+void SongLengthEstimator::doEffect(mp_sint32 chn, mp_sint32 effcnt, const mp_ubyte* slot, mp_sint32 numEffects)
+{
+	const mp_ubyte eff = slot[2+effcnt*2];
+	const mp_ubyte eop = slot[2+effcnt*2+1];
+
+	switch (eff)
+	{
+		// position jump
+		case 0x0B:
+			pjump = 1;
+			pjumpPos = eop;
+			pjumpRow = 0;
+			pjumpPriority = MP_NUMEFFECTS*chn + effcnt;
+			break;
+
+		// far position jump (PLM), the row is in the next effect
+		case 0x2B:
+			pjump = 1;
+			pjumpPos = eop;
+			pjumpRow = slot[2+((effcnt+1)%numEffects)*2+1];
+			pjumpPriority = MP_NUMEFFECTS*chn + effcnt;
+			break;
+
+		// pattern break
+		case 0x0D:
+			pbreak = 1;
+			pbreakPos = (eop>>4)*10+(eop&0xf);
+			if (pbreakPos > 63)
+				pbreakPos = 0;
+			pbreakPriority = MP_NUMEFFECTS*chn + effcnt;
+			break;
+
+		// set speed/BPM, the speed has been set before the row was played
+		case 0x0F:
+			if (eop)
+			{
+				if (eop >= 32)
+				{
+					bpm = eop;
+					adder = getBPMRate(bpm);
+				}
+			}
+			else
+				haltFlag = true;
+			break;
+
+		// set BPM
+		case 0x16:
+			if (eop)
+			{
+				bpm = eop;
+				adder = getBPMRate(bpm);
+			}
+			break;
+
+		// Digibooster set real BPM
+		case 0x52:
+			if (eop)
+			{
+				baseBpm = eop >= 32 ? eop : 32;
+				adder = getBPMRate(bpm);
+			}
+			break;
+
+		// pattern loop
+		case 0x36:
+		{
+			Loop& loop = loops[chn];
+			if (!eop)
+			{
+				loop.execLoop = false;
+				loop.loopStart = row;
+				loop.loopingValidPosition = order;
+			}
+			else if (loop.loopCounter == eop)
+			{
+				// FT2 continues the next pattern at the loop start
+				if (module->header.flags & XModule::MODULE_XMARPEGGIO)
+					startNextRow = loop.loopStart;
+				resetLooping(chn, order);
+			}
+			else
+			{
+				loop.execLoop = true;
+				loop.loopCounter++;
+			}
+			break;
+		}
+
+		// pattern delay
+		case 0x3E:
+			patDelay = true;
+			patDelayCount = tickSpeed*(eop+1);
+			break;
+	}
+}
+
+// this follows PlayerSTD::tickhandler
+void SongLengthEstimator::tick()
+{
+	if (order >= module->header.ordnum)
+	{
+		halted = true;
+		return;
+	}
+
+	TXMPattern* pattern = &module->phead[module->header.ord[order]];
+
+	if (pattern->patternData == NULL)
+	{
+		halted = true;
+		return;
+	}
+
+	if (row < pattern->rows)
+	{
+		const mp_sint32 numEffects = pattern->effnum;
+		const mp_sint32 numChannels = pattern->channum <= module->header.channum ? pattern->channum : module->header.channum;
+		const mp_sint32 slotSize = numEffects*2+2;
+		const mp_ubyte* rowData = pattern->patternData + pattern->channum*slotSize*row;
+		mp_sint32 c;
+
+		if (ticker == 0)
+		{
+			const mp_sint32 pos = order*256+row;
+			if (rowVisits[pos])
+			{
+				// played before, only a pattern loop may come back here
+				bool b = false;
+				for (c = 0; c < numChannels; c++)
+				{
+					if (loops[c].isLooping && loops[c].loopingValidPosition == order)
+					{
+						b = true;
+						break;
+					}
+				}
+
+				if (!b)
+				{
+					halted = true;
+					return;
+				}
+			}
+			else
+			{
+				rowVisits[pos] = (mp_uword)numVisits;
+			}
+
+			pbreak = pbreakPos = pbreakPriority = pjump = pjumpPos = pjumpRow = pjumpPriority = 0;
+
+			// note delays and speed changes are picked up before the row is played
+			const mp_ubyte* slot = rowData;
+			for (c = 0; c < numChannels; c++, slot+=slotSize)
+			{
+				attick[c] = 0;
+				for (mp_sint32 effcnt = 0; effcnt < numEffects; effcnt++)
+				{
+					const mp_ubyte eff = slot[2+effcnt*2];
+					const mp_ubyte eop = slot[2+effcnt*2+1];
+
+					if (eff == 0x3D)
+						attick[c] = eop;
+					else if (eff == 0x0F && eop && eop < 32)
+						tickSpeed = eop;
+					else if (eff == 0x1C && eop)
+						tickSpeed = eop;
+				}
+			}
+		}
+
+		const mp_ubyte* slot = rowData;
+		for (c = 0; c < numChannels; c++, slot+=slotSize)
+		{
+			if ((mp_sint32)attick[c] == ticker && ticker < tickSpeed)
+			{
+				for (mp_sint32 effcnt = 0; effcnt < numEffects; effcnt++)
+					doEffect(c, effcnt, slot, numEffects);
+			}
+		}
+
+		ticker++;
+
+		const mp_sint32 maxTicks = patDelay ? patDelayCount : tickSpeed;
+		if (ticker < maxTicks)
+			return;
+
+		patDelay = false;
+		ticker = 0;
+
+		// break pattern?
+		if (pbreak && order < module->header.ordnum-1)
+		{
+			if (!pjump || pjumpPriority > pbreakPriority)
+				setNewPosition(order+1);
+			row = pbreakPos-1;
+			startNextRow = -1;
+		}
+		else if (pbreak && order == module->header.ordnum-1)
+		{
+			if (!pjump || pjumpPriority > pbreakPriority)
+				setNewPosition(module->header.restart);
+			row = pbreakPos-1;
+			startNextRow = -1;
+		}
+
+		// pattern jump?
+		if (pjump)
+		{
+			if (!pbreak || pjumpPriority > pbreakPriority)
+				row = pjumpRow-1;
+			setNewPosition(pjumpPos);
+			startNextRow = -1;
+		}
+
+		// handle loop
+		for (c = 0; c < numChannels; c++)
+		{
+			if (loops[c].execLoop)
+			{
+				row = loops[c].loopStart-1;
+				loops[c].execLoop = false;
+				loops[c].isLooping = true;
+			}
+		}
+
+		row++;
+	}
+	else
+	{
+		ticker = 0;
+	}
+
+	// reached end of pattern?
+	if (row >= module->phead[module->header.ord[order]].rows)
+	{
+		if (startNextRow != -1)
+		{
+			row = startNextRow;
+			startNextRow = -1;
+		}
+		else
+		{
+			row = 0;
+		}
+
+		setNewPosition(order+1);
+	}
+
+	if (haltFlag)
+		halted = true;
+}
+
+void SongLengthEstimator::run()
+{
+	if (complete)
+		return;
+
+	if (numLoops != module->header.channum)
+	{
+		delete[] loops;
+		delete[] attick;
+		numLoops = module->header.channum;
+		loops = new Loop[numLoops ? numLoops : 1];
+		attick = new mp_ubyte[numLoops ? numLoops : 1];
+	}
+
+	if (numVisits == 0)
+	{
+		// same as PlayerSTD::restart
+		order = row = 0;
+		tickSpeed = module->header.tempo;
+		bpm = module->header.speed;
+		baseBpm = 125;
+		bpmCounter = 0;
+		beatPackets = 0;
+		addVisit();
+	}
+
+	continueAt(visits[numVisits-1]);
+
+	while (!halted)
+	{
+		// wait for the 250Hz timer to overflow, same as PlayerSTD::timerHandler
+		const mp_uint32 numBeatPackets = (mp_uint32)((((mp_int64)1 << 32) - bpmCounter + adder - 1) / adder);
+		bpmCounter+=numBeatPackets*adder;
+		beatPackets+=numBeatPackets;
+
+		if (firstTick)
+		{
+			visits[numVisits-1].startBeatPacket = beatPackets;
+			firstTick = false;
+		}
+
+		tick();
+
+		if (beatPackets >= MaxBeatPackets)
+			break;
+
+		if (newPosition && !halted)
+		{
+			if (numVisits >= MaxVisits)
+				break;
+			newPosition = false;
+			addVisit();
+		}
+	}
+
+	songLength = getSeconds(beatPackets);
+	complete = true;
+}
+
+mp_sint32 SongLengthEstimator::estimateSongLengthInSeconds()
+{
+	validate();
+	run();
+
+	return songLength;
+}
+
+mp_sint32 SongLengthEstimator::getOrderStartInSeconds(mp_sint32 order)
+{
+	validate();
+	run();
+
+	for (mp_sint32 i = 0; i < numVisits; i++)
+	{
+		if (visits[i].order == order && visits[i].startBeatPacket >= 0)
+			return getSeconds(visits[i].startBeatPacket);
+	}
+
+	return -1;
+}
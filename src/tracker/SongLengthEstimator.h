@@ -26,6 +26,13 @@
  *
  *  Created by Peter Barth on 10.11.05.
  *
+ *  Follows the song the way PlayerSTD would play it, but only looks at
+ *  the effects which change the timing or the order of the rows (speed,
+ *  BPM, jumps, breaks, pattern loops and delays), nothing is mixed.
+ *  Every time the song enters another order the state is remembered,
+ *  so after editing a pattern only the part of the song starting with
+ *  the first order which plays it has to be followed again.
+ *
  */
 
 #ifndef SONGLENGTHESTIMATOR__H
@@ -33,23 +40,112 @@
 
 #include "MilkyPlayTypes.h"
 
-class PlayerGeneric;
 class XModule;
 
 class SongLengthEstimator
 {
 private:
-	PlayerGeneric* player;
+	enum
+	{
+		// the times are given for this mixer frequency
+		MixFrequency = 44100,
+		MaxVisits = 65535,
+		// give up on songs which don't stop within a day
+		MaxBeatPackets = 24*60*60*250
+	};
+
+	// the song entering an order, with everything needed to continue from there
+	struct Visit
+	{
+		mp_sint32 order;
+		mp_sint32 row;
+		mp_sint32 tickSpeed;
+		mp_sint32 bpm;
+		mp_sint32 baseBpm;
+		mp_uint32 bpmCounter;
+		// beat packets which have been played before
+		mp_sint32 beatPackets;
+		// beat packet of the first tick in this order
+		mp_sint32 startBeatPacket;
+	};
+
+	struct Loop
+	{
+		mp_sint32 loopStart;
+		mp_sint32 loopCounter;
+		mp_sint32 loopingValidPosition;
+		bool execLoop;
+		bool isLooping;
+	};
+
+	// everything the timing depends on apart from the pattern data
+	struct Configuration
+	{
+		mp_uword ordnum;
+		mp_uword restart;
+		mp_uword channum;
+		mp_dword flags;
+		mp_uword tempo;
+		mp_uword speed;
+		mp_ubyte ord[256];
+	};
+
 	XModule* module;
-	
+	Configuration configuration;
+
+	Visit* visits;
+	mp_sint32 numVisits;
+	mp_sint32 maxVisits;
+	// index+1 of the visit which played a row first, 0 if it hasn't been played yet
+	mp_uword* rowVisits;
+	bool complete;
+	mp_sint32 songLength;
+
+	// current state while following the song
+	mp_sint32 order, row, ticker;
+	mp_sint32 tickSpeed, bpm, baseBpm;
+	mp_uint32 adder, bpmCounter;
+	mp_sint32 beatPackets;
+	mp_sint32 startNextRow;
+	mp_sint32 patDelayCount;
+	bool patDelay, haltFlag, halted;
+	bool newPosition;
+	bool firstTick;
+	Loop* loops;
+	mp_sint32 numLoops;
+	mp_ubyte* attick;
+
+	mp_sint32 pbreak, pbreakPos, pbreakPriority;
+	mp_sint32 pjump, pjumpPos, pjumpRow, pjumpPriority;
+
+	void validate();
+	void truncate(mp_sint32 num);
+	void addVisit();
+	void continueAt(const Visit& visit);
+	void resetLooping(mp_sint32 chn, mp_sint32 order);
+	void setNewPosition(mp_sint32 order);
+	void doEffect(mp_sint32 chn, mp_sint32 effcnt, const mp_ubyte* slot, mp_sint32 numEffects);
+	void tick();
+	void run();
+
+	mp_uint32 getBPMRate(mp_sint32 bpm) const;
+	static mp_sint32 getSeconds(mp_sint32 beatPackets);
+
 public:
 	SongLengthEstimator(XModule* theModule);
 	SongLengthEstimator(const SongLengthEstimator& src);
 	~SongLengthEstimator();
 	
 	const SongLengthEstimator& operator=(const SongLengthEstimator& src);
+
+	// everything needs to be followed again, e.g. a new song has been loaded
+	void invalidate();
+	// a pattern has been edited, follow the song again from where it's played first
+	void invalidatePattern(mp_sint32 patternIndex);
 	
 	mp_sint32 estimateSongLengthInSeconds();
+	// time when the order is played first, -1 if the song never gets there
+	mp_sint32 getOrderStartInSeconds(mp_sint32 order);
 };
 
 #endif
@@ -128,6 +128,7 @@ Tracker::Tracker() :
 	dialog(NULL),
 	responder(NULL),
 	playTimeText(NULL),
+	numAudioDropouts(0),
 	instrumentChooser(NULL),
 	inputContainerCurrent(NULL),
 	inputContainerDefault(NULL),
@@ -545,6 +546,8 @@ pp_int32 Tracker::handleEvent(PPObject* sender, PPEvent* event)
 	else if (event->getID() == eTimer)
 	{
 		doFollowSong();
+		// use the idle time to index the song for seeking
+		playerController->buildSongCheckpoints();
 	}
 #ifndef __LOWRES__
 	else if (event->getID() == eLMouseDown)
@@ -2535,6 +2538,22 @@ void Tracker::finishLoadSaveUI()
 #endif
 }
 
+XMFileMemory* Tracker::decompressFile(const PPSystemString& fileName, FileTypes eType)
+{
+	// the contents are named after the archive without its extension,
+	// so a compressed "pattern.xp.gz" still looks like a pattern
+	XMFileMemory* file = new XMFileMemory(fileName.stripExtension());
+	Decompressor decompressor(fileName);
+	if (!decompressor.decompress(*file, (DecompressorBase::Hints)fileTypeToHint(eType)))
+	{
+		delete file;
+		return NULL;
+	}
+	
+	file->seek(0);
+	return file;
+}
+
 bool Tracker::loadGenericFileType(const PPSystemString& fileName)
 {
 	// we need to find out what file type this is
@@ -2546,15 +2565,18 @@ bool Tracker::loadGenericFileType(const PPSystemString& fileName)
 	if (type == FileIdentificator::FileTypeCompressed)
 	{
 		// if this is compressed, we try to uncompress it
-		// and choose that file type
-		PPSystemString tempFile(ModuleEditor::getTempFilename());
-		Decompressor decompressor(fileName);
-		if (decompressor.decompress(tempFile, (DecompressorBase::Hints)fileTypeToHint(FileTypes::FileTypeAllFiles)))
+		// and choose that file type, the decompressed data
+		// is handed on to the loading below
+		XMFileMemory* decompressedFile = decompressFile(fileName, FileTypes::FileTypeAllFiles);
+		if (decompressedFile)
 		{
-			fileIdentificator = new FileIdentificator(tempFile);
+			fileIdentificator = new FileIdentificator(*decompressedFile);
 			type = fileIdentificator->getFileType();
 			delete fileIdentificator;
-			Decompressor::removeFile(tempFile);
+			decompressedFile->seek(0);
+			
+			delete loadingParameters.decompressedFile;
+			loadingParameters.decompressedFile = decompressedFile;
 		}
 		else
 		{
@@ -2577,11 +2599,17 @@ bool Tracker::loadGenericFileType(const PPSystemString& fileName)
 			return loadTypeFromFile(FileTypes::FileTypeTrackXT, fileName);
 	}
 	
+	delete loadingParameters.decompressedFile;
+	loadingParameters.decompressedFile = NULL;
 	return false;
 }
 
 bool Tracker::prepareLoading(FileTypes eType, const PPSystemString& fileName, bool suspendPlayer, bool repaint, bool saveCheck)
 {
+	// file might have been decompressed already while identifying it
+	XMFileMemory* decompressedFile = loadingParameters.decompressedFile;
+	loadingParameters.decompressedFile = NULL;
+
 	loadingParameters.deleteFile = false;
 	loadingParameters.didOpenTab = false;
 	loadingParameters.eType = eType;
@@ -2593,7 +2621,10 @@ bool Tracker::prepareLoading(FileTypes eType, const PPSystemString& fileName, bo
 	loadingParameters.res = true;
 	
 	if (saveCheck && eType == FileTypes::FileTypeSongAllModules && !checkForChangesOpenModule())
+	{
+		delete decompressedFile;
 		return false;
+	}
 	
 	loadingParameters.lastError = "Error while loading/unknown format";	
 
@@ -2619,32 +2650,52 @@ bool Tracker::prepareLoading(FileTypes eType, const PPSystemString& fileName, bo
 		playerController->suspendPlayer();
 	}
 	
-	// check for compressed file type
-	FileIdentificator* fileIdentificator = new FileIdentificator(fileName);
-	FileIdentificator::FileTypes type = fileIdentificator->getFileType();
-	delete fileIdentificator;
+	if (decompressedFile == NULL)
+	{
+		// check for compressed file type
+		FileIdentificator* fileIdentificator = new FileIdentificator(fileName);
+		FileIdentificator::FileTypes type = fileIdentificator->getFileType();
+		delete fileIdentificator;
+		
+		if (type == FileIdentificator::FileTypeCompressed)
+		{
+			// if this is compressed, try to decompress
+			decompressedFile = decompressFile(fileName, eType);
+			if (decompressedFile == NULL)
+			{
+				loadingParameters.lastError = "Unrecognized type/corrupt file";
+				loadingParameters.res = false;
+				finishLoading();
+				return false;
+			}
+		}
+	}
 	
-	if (type == FileIdentificator::FileTypeCompressed)
+	if (decompressedFile)
 	{
-		// if this is compressed, try to decompress
-		PPSystemString tempFile(ModuleEditor::getTempFilename());
-		Decompressor decompressor(fileName);
-		if (decompressor.decompress(tempFile, (DecompressorBase::Hints)fileTypeToHint(eType)))
+		// load the decompressed data instead, but keep the original file name 
+		// as preferred base name for the module we're going to edit
+		loadingParameters.preferredFilename = loadingParameters.filename;
+		
+		if (eType == FileTypes::FileTypeSongAllModules)
 		{
-			// we compressed to a temporary file
-			// load that instead, but keep the original file name as preferred 
-			// base name for the module we're going to edit
-			loadingParameters.preferredFilename = loadingParameters.filename;
-			loadingParameters.filename = tempFile;
-			// delete file after loading, it's temporary
-			loadingParameters.deleteFile = true;
+			// modules are loaded straight from memory
+			loadingParameters.decompressedFile = decompressedFile;
 		}
 		else
 		{
-			loadingParameters.lastError = "Unrecognized type/corrupt file";
-			loadingParameters.res = false;
-			finishLoading();
-			return false;
+			// everything else is only loaded from files,
+			// store the decompressed data in a temporary one
+			PPSystemString tempFile(ModuleEditor::getTempFilename());
+			{
+				XMFile f(tempFile, true);
+				f.write(decompressedFile->getBuffer(), 1, decompressedFile->size());
+			}
+			delete decompressedFile;
+			
+			loadingParameters.filename = tempFile;
+			// delete file after loading, it's temporary
+			loadingParameters.deleteFile = true;
 		}
 	}
 	
@@ -2672,6 +2723,9 @@ bool Tracker::finishLoading()
 	
 	if (loadingParameters.deleteFile)
 		Decompressor::removeFile(loadingParameters.filename);
+	
+	delete loadingParameters.decompressedFile;
+	loadingParameters.decompressedFile = NULL;
 		
 	if (!loadingParameters.res && loadingParameters.didOpenTab)
 		tabManager->closeTab();
@@ -2689,7 +2743,10 @@ bool Tracker::loadTypeFromFile(FileTypes eType, const PPSystemString& fileName,
 	{
 		case FileTypes::FileTypeSongAllModules:
 		{
-			if (loadingParameters.preferredFilename.length())
+			if (loadingParameters.decompressedFile)
+				loadingParameters.res = moduleEditor->openSong(*loadingParameters.decompressedFile,
+				loadingParameters.preferredFilename);
+			else if (loadingParameters.preferredFilename.length())
 				loadingParameters.res = moduleEditor->openSong(loadingParameters.filename,
 				loadingParameters.preferredFilename);
 			else
@@ -125,6 +125,8 @@ private:
 	PeakLevelControl* peakLevelControl;
 	ScopesControl* scopesControl;
 	PPStaticText* playTimeText;
+	// underruns and late callbacks of the audio driver seen so far
+	pp_uint32 numAudioDropouts;
 	
 	// - Sections --------------------------------------------------------------
 	class SectionSwitcher* sectionSwitcher;
@@ -383,16 +385,20 @@ private:
 		bool abortLoading;
 		bool deleteFile;
 		bool didOpenTab;
+		// contents of a compressed file, decompressed only once
+		XMFileMemory* decompressedFile;
 		
 		TPrepareLoadingParameters() :
 			abortLoading(false),
 			deleteFile(false),
-			didOpenTab(false)
+			didOpenTab(false),
+			decompressedFile(NULL)
 		{
 		}
 	} loadingParameters;
 
 	static pp_uint32 fileTypeToHint(FileTypes type);
+	static XMFileMemory* decompressFile(const PPSystemString& fileName, FileTypes eType);
 
 	void prepareLoadSaveUI();
 	void finishLoadSaveUI();
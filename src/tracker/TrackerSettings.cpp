@@ -77,6 +77,9 @@ void Tracker::buildDefaultSettings()
 	settingsDatabase->store("RAMPING", 1);
 	settingsDatabase->store("INTERPOLATION", 1);
 	settingsDatabase->store("MIXERFREQ", PlayerMaster::getPreferredSampleRate());
+	// single threaded mixing unless requested
+	settingsDatabase->store("MIXERTHREADS", 1);
+	settingsDatabase->store("MIXERTHREADTHRESHOLD", 64);
 #ifdef __FORCEPOWEROFTWOBUFFERSIZE__
 	settingsDatabase->store("FORCEPOWEROFTWOBUFFERSIZE", 1);
 #else
@@ -237,6 +240,7 @@ void Tracker::buildDefaultSettings()
 	settingsDatabase->store("HDRECORDER_RAMPING", 1);
 	settingsDatabase->store("HDRECORDER_INTERPOLATION", 1);
 	settingsDatabase->store("HDRECORDER_ALLOWMUTING", 0);
+	settingsDatabase->store("HDRECORDER_FLOATOUTPUT", 0);
 
 	for (i = 0; i < NUMEFFECTMACROS; i++)
 	{
@@ -293,6 +297,14 @@ void Tracker::applySettingByKey(PPDictionaryKey* theKey, TMixerSettings& setting
 	{
 		settings.resampler = v2;
 	}
+	else if (theKey->getKey().compareTo("MIXERTHREADS") == 0)
+	{
+		settings.mixerThreads = v2;
+	}
+	else if (theKey->getKey().compareTo("MIXERTHREADTHRESHOLD") == 0)
+	{
+		settings.mixerThreadThreshold = v2;
+	}
 	else if (theKey->getKey().compareTo("FORCEPOWEROFTWOBUFFERSIZE") == 0)
 	{
 		settings.powerOfTwoCompensation = v2;
@@ -546,6 +558,10 @@ void Tracker::applySettingByKey(PPDictionaryKey* theKey, TMixerSettings& setting
 	{
 		sectionHDRecorder->setSettingsAllowMuting(v2 != 0);
 	}
+	else if (theKey->getKey().compareTo("HDRECORDER_FLOATOUTPUT") == 0)
+	{
+		sectionHDRecorder->setSettingsFloatOutput(v2 != 0);
+	}
 	// ---------------- Recording & stuff ------------------
 	else if (theKey->getKey().compareTo("MULTICHN_RECORD") == 0)
 	{
@@ -689,6 +705,8 @@ void Tracker::getMixerSettingsFromDatabase(TMixerSettings& mixerSettings,
 	mixerSettings.ramping = currentSettings.restore("RAMPING")->getIntValue();
 	mixerSettings.setAudioDriverName(currentSettings.restore("AUDIODRIVER")->getStringValue());
 	mixerSettings.numVirtualChannels = currentSettings.restore("VIRTUALCHANNELS")->getIntValue();
+	mixerSettings.mixerThreads = currentSettings.restore("MIXERTHREADS")->getIntValue();
+	mixerSettings.mixerThreadThreshold = currentSettings.restore("MIXERTHREADTHRESHOLD")->getIntValue();
 }
 
 void Tracker::applySettings(TrackerSettingsDatabase* newSettings, 
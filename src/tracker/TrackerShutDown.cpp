@@ -176,6 +176,7 @@ bool Tracker::shutDown()
 		settingsDatabase->store("HDRECORDER_RAMPING", sectionHDRecorder->getSettingsRamping() ? 1 : 0);
 		settingsDatabase->store("HDRECORDER_INTERPOLATION", sectionHDRecorder->getSettingsResampler());
 		settingsDatabase->store("HDRECORDER_ALLOWMUTING", sectionHDRecorder->getSettingsAllowMuting() ? 1 : 0);
+		settingsDatabase->store("HDRECORDER_FLOATOUTPUT", sectionHDRecorder->getSettingsFloatOutput() ? 1 : 0);
 
 		// sample editor
 		settingsDatabase->store("SAMPLEEDITORDECIMALOFFSETS", sectionSamples->getOffsetFormat());
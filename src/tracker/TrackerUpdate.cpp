@@ -25,6 +25,7 @@
 #include "TrackerConfig.h"
 #include "PlayerController.h"
 #include "PlayerMaster.h"
+#include "MixerProfiler.h"
 #include "ModuleEditor.h"
 #include "ModuleServices.h"
 #include "TabTitleProvider.h"
@@ -170,6 +171,29 @@ bool Tracker::updatePeakLevelControl()
 		bUpdateR = true;
 	}
 	
+	// audio thread load, dropouts light up the heading like clipping
+	const pp_int32 load = playerMaster->getAudioLoad();
+	if (load != peakLevelControl->getLoad())
+	{
+		peakLevelControl->setLoad(load);
+		bUpdateL = true;
+	}
+	
+	MixerProfiler::Stats stats;
+	playerMaster->getMixerProfiler().getStats(stats);
+	
+	const pp_uint32 numDropouts = stats.numUnderruns + stats.numLateCallbacks;
+	if (numDropouts != numAudioDropouts)
+	{
+		if (numDropouts > numAudioDropouts)
+		{
+			TitlePageManager titlePageManager(*screen);
+			titlePageManager.setPeakControlHeadingColor(TrackerConfig::colorPeakClipIndicator, false);
+			bUpdateEntire = true;
+		}
+		numAudioDropouts = numDropouts;
+	}
+	
 	if (bUpdateEntire)
 	{
 		screen->paintControl(screen->getControlByID(CONTAINER_ABOUT), false);
@@ -199,7 +223,12 @@ bool Tracker::updatePlayTime()
 	pp_int32 playtime = (pp_int32)playerController->getPlayTime();
 	
 	if (!playerController->isPlaying())
-		playtime = 0;
+	{
+		// show where the selected order starts when the song length is estimated
+		playtime = moduleEditor->getModuleServices()->getOrderStartTime(getOrderListBoxIndex());
+		if (playtime < 0)
+			playtime = 0;
+	}
 		
 	pp_int32 seconds = playtime % 60;
 	pp_int32 minutes = (playtime / 60) % 60;
@@ -28,63 +28,91 @@
 //														patterns
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+PatternUndoStackEntry::Layout PatternUndoStackEntry::getLayout(const TXMPattern& pattern)
+{
+	Layout layout;
+	layout.rows = pattern.rows;
+	layout.channum = pattern.channum;
+	layout.effnum = pattern.effnum;
+	return layout;
+}
+
 //---------------------------------------------------------------------------
-// Pre     : 
+// Pre     : before.patternData holds the uncompressed pattern data
 // Post    : 
 // Globals : 
 // I/O     : 
-// Task    : Create new stack entry
+// Task    : Create new stack entry from the differences
 //---------------------------------------------------------------------------
-PatternUndoStackEntry::PatternUndoStackEntry(const TXMPattern& pattern, 
-											 const pp_int32 cursorPositionChannel, 
-											 const pp_int32 cursorPositionRow, 
-											 const pp_int32 cursorPositionInner,
-											 const UserData* userData/* = NULL*/) :
-	UndoStackEntry(userData)
+PatternUndoStackEntry::PatternUndoStackEntry(TXMPattern* pattern,
+											 const TXMPattern& before,
+											 const CursorPosition& cursorBefore,
+											 const CursorPosition& cursorAfter,
+											 const UserData* userDataBefore/* = NULL*/,
+											 const UserData* userDataAfter/* = NULL*/) :
+	UndoStackEntry(userDataBefore),
+	pattern(pattern),
+	group(0),
+	undone(false),
+	cursorBefore(cursorBefore),
+	cursorAfter(cursorAfter),
+	data(NULL),
+	dataLen(0),
+	numSlots(0),
+	lenBefore(0)
 {
-	this->cursorPositionChannel = cursorPositionChannel;
-	this->cursorPositionRow = cursorPositionRow;
-	this->cursorPositionInner = cursorPositionInner;
+	if (userDataAfter)
+		this->userDataAfter = *userDataAfter;
+
+	layoutBefore = getLayout(before);
+	layoutAfter = getLayout(*pattern);
+	layoutChanged = layoutBefore != layoutAfter;
 	
-	if (pattern.patternData)
+	if (before.patternData == NULL || pattern->patternData == NULL)
 	{
-		this->pattern.rows = pattern.rows;
-		this->pattern.channum = pattern.channum;
-		this->pattern.effnum = pattern.effnum;
-	
-		this->pattern.len = pattern.compress(NULL);
-		
-		this->pattern.patternData = new mp_ubyte[this->pattern.len];
+		layoutChanged = false;
+		return;
+	}
 
-		mp_sint32 len = pattern.compress(this->pattern.patternData);
+	if (layoutChanged)
+	{
+		lenBefore = before.compress(NULL);
+		dataLen = lenBefore + pattern->compress(NULL);
+		data = new mp_ubyte[dataLen];
 		
-		ASSERT(len == (signed)this->pattern.len);
+		before.compress(data);
+		pattern->compress(data + lenBefore);
+		return;
 	}
-	else
-		memset(&this->pattern, 0, sizeof(pattern));
-}
-
-//---------------------------------------------------------------------------
-// Pre     : 
-// Post    : 
-// Globals : 
-// I/O     : 
-// Task    : Copy constructor
-//---------------------------------------------------------------------------
-PatternUndoStackEntry::PatternUndoStackEntry(const PatternUndoStackEntry& source) :
-	UndoStackEntry(&source.getUserData())
-{
-	cursorPositionChannel = source.cursorPositionChannel;
-	cursorPositionRow = source.cursorPositionRow;
-	cursorPositionInner = source.cursorPositionInner;
+	
+	const pp_uint32 slotSize = pattern->effnum * 2 + 2;
+	const pp_uint32 numPatternSlots = pattern->rows * pattern->channum;
+	const mp_ubyte* src = before.patternData;
+	const mp_ubyte* dst = pattern->patternData;
+
+	pp_uint32 i;
+	for (i = 0; i < numPatternSlots; i++)
+		if (memcmp(src + i*slotSize, dst + i*slotSize, slotSize) != 0)
+			numSlots++;
+	
+	if (numSlots == 0)
+		return;
 
-	pattern.len = source.pattern.len;
-	pattern.rows = source.pattern.rows;
-	pattern.channum = source.pattern.channum;
-	pattern.effnum = source.pattern.effnum;
+	dataLen = numSlots * (sizeof(pp_uint32) + slotSize*2);
+	data = new mp_ubyte[dataLen];
 	
-	pattern.patternData = new mp_ubyte[pattern.len];
-	memcpy(pattern.patternData, source.pattern.patternData, pattern.len);
+	pp_uint32* indices = (pp_uint32*)data;
+	mp_ubyte* slots = data + numSlots*sizeof(pp_uint32);
+	for (i = 0; i < numPatternSlots; i++)
+	{
+		if (memcmp(src + i*slotSize, dst + i*slotSize, slotSize) != 0)
+		{
+			*indices++ = i;
+			memcpy(slots, src + i*slotSize, slotSize);
+			memcpy(slots + slotSize, dst + i*slotSize, slotSize);
+			slots+=slotSize*2;
+		}
+	}
 }
 
 //---------------------------------------------------------------------------
@@ -96,71 +124,315 @@ PatternUndoStackEntry::PatternUndoStackEntry(const PatternUndoStackEntry& source
 //---------------------------------------------------------------------------
 PatternUndoStackEntry::~PatternUndoStackEntry()
 {
-	delete[] pattern.patternData;
+	delete[] data;
 }
 
-//---------------------------------------------------------------------------
-// Pre     : 
-// Post    : 
-// Globals : 
-// I/O     : 
-// Task    : assignment operator
-//---------------------------------------------------------------------------
-PatternUndoStackEntry& PatternUndoStackEntry::operator=(const PatternUndoStackEntry& source)
+pp_uint32 PatternUndoStackEntry::getSize() const
 {
-	// no self-assignment
-	if (this != &source)
+	return sizeof(PatternUndoStackEntry) + dataLen + 
+		UndoStackEntry::getUserData().getDataLen() + userDataAfter.getDataLen();
+}
+
+bool PatternUndoStackEntry::apply(bool undo)
+{
+	const Layout& from = undo ? layoutAfter : layoutBefore;
+	const Layout& to = undo ? layoutBefore : layoutAfter;
+
+	if (pattern->patternData == NULL || getLayout(*pattern) != from)
+		return false;
+
+	if (layoutChanged)
 	{
-		copyBasePart(source);
+		// the whole pattern has to be what the change has been made from/to
+		const mp_ubyte* expected = undo ? data + lenBefore : data;
+		const pp_uint32 expectedLen = undo ? dataLen - lenBefore : lenBefore;
+		const pp_uint32 len = (pp_uint32)pattern->compress(NULL);
+		if (len != expectedLen)
+			return false;
+			
+		mp_ubyte* current = new mp_ubyte[len];
+		pattern->compress(current);
+		const bool equal = memcmp(current, expected, len) == 0;
+		delete[] current;
+		if (!equal)
+			return false;
 	
-		cursorPositionChannel = source.cursorPositionChannel;
-		cursorPositionRow = source.cursorPositionRow;
-		cursorPositionInner = source.cursorPositionInner;	
-		
-		if (pattern.patternData)
-			delete[] pattern.patternData;
+		pattern->rows = to.rows;
+		pattern->channum = to.channum;
+		pattern->effnum = to.effnum;
 	
-		pattern.len = source.pattern.len;
-		pattern.rows = source.pattern.rows;
-		pattern.channum = source.pattern.channum;
-		pattern.effnum = source.pattern.effnum;
+		mp_sint32 patternSize = pattern->rows*pattern->channum*(2+pattern->effnum*2);	
+
+		delete[] pattern->patternData;
+		pattern->patternData = new mp_ubyte[patternSize];
+		memset(pattern->patternData, 0, patternSize);
+
+		if (undo)
+			pattern->decompress(data, lenBefore);
+		else
+			pattern->decompress(data + lenBefore, dataLen - lenBefore);
 		
-		pattern.patternData = new mp_ubyte[pattern.len];
-		memcpy(pattern.patternData, source.pattern.patternData, pattern.len);
+		return true;
 	}
 
-	return *this;
+	const pp_uint32 slotSize = pattern->effnum * 2 + 2;
+	const pp_uint32* indices = (const pp_uint32*)data;
+	const mp_ubyte* slots = data + numSlots*sizeof(pp_uint32) + (undo ? 0 : slotSize);
+	const mp_ubyte* expected = data + numSlots*sizeof(pp_uint32) + (undo ? slotSize : 0);
+	
+	// every slot has to hold what the change has left behind (undo) or started 
+	// from (redo), otherwise the pattern isn't the one the change has been made in
+	pp_uint32 i;
+	for (i = 0; i < numSlots; i++)
+	{
+		if (memcmp(pattern->patternData + indices[i]*slotSize, expected, slotSize) != 0)
+			return false;
+		expected+=slotSize*2;
+	}
+	
+	for (i = 0; i < numSlots; i++)
+	{
+		memcpy(pattern->patternData + indices[i]*slotSize, slots, slotSize);
+		slots+=slotSize*2;
+	}
+
+	return true;
 }
 
-//---------------------------------------------------------------------------
-// Pre     : 
-// Post    : 
-// Globals : 
-// I/O     : 
-// Task    : comparison operators
-//---------------------------------------------------------------------------
-bool PatternUndoStackEntry::operator==(const PatternUndoStackEntry& source)
+bool PatternUndoStackEntry::merge(const PatternUndoStackEntry& next)
+{
+	if (next.pattern != pattern || !layoutChanged || !next.layoutChanged || 
+		next.layoutBefore != layoutAfter)
+		return false;
+	
+	const pp_uint32 lenAfter = next.dataLen - next.lenBefore;
+	mp_ubyte* newData = new mp_ubyte[lenBefore + lenAfter];
+	memcpy(newData, data, lenBefore);
+	memcpy(newData + lenBefore, next.data + next.lenBefore, lenAfter);
+	
+	delete[] data;
+	data = newData;
+	dataLen = lenBefore + lenAfter;
+	
+	layoutAfter = next.layoutAfter;
+	cursorAfter = next.cursorAfter;
+	userDataAfter = next.userDataAfter;
+	
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//														pattern journal
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+PatternUndoJournal::PatternUndoJournal(pp_uint32 maxSize/* = UNDOJOURNALSIZE_PATTERNEDITOR*/) :
+	entries(NULL),
+	numEntries(0),
+	maxEntries(0),
+	size(0),
+	maxSize(maxSize),
+	nextGroup(1),
+	currentGroup(0),
+	groupDepth(0),
+	beforeAllocated(0)
 {
-	ASSERT(source.pattern.patternData);
-	ASSERT(pattern.patternData);
+	memset(&before, 0, sizeof(before));
+	memset(&cursorBefore, 0, sizeof(cursorBefore));
+}
+
+PatternUndoJournal::~PatternUndoJournal()
+{
+	clear();
+	delete[] entries;
+	delete[] before.patternData;
+}
+
+void PatternUndoJournal::prepare(const TXMPattern& pattern, 
+								 const PatternUndoStackEntry::CursorPosition& cursor, 
+								 const UndoStackEntry::UserData& userData)
+{
+	cursorBefore = cursor;
+	userDataBefore = userData;
+
+	before.rows = pattern.rows;
+	before.channum = pattern.channum;
+	before.effnum = pattern.effnum;
+	
+	if (pattern.patternData == NULL)
+	{
+		delete[] before.patternData;
+		before.patternData = NULL;
+		beforeAllocated = 0;
+		return;
+	}
+	
+	const pp_uint32 patternSize = pattern.rows*pattern.channum*(2+pattern.effnum*2);
+	if (patternSize > beforeAllocated || before.patternData == NULL)
+	{
+		delete[] before.patternData;
+		before.patternData = new mp_ubyte[patternSize];
+		beforeAllocated = patternSize;
+	}
+	
+	memcpy(before.patternData, pattern.patternData, patternSize);
+}
 
-	if (pattern.len == source.pattern.len &&
-		pattern.rows == source.pattern.rows &&
-		pattern.channum == source.pattern.channum &&
-		pattern.effnum == source.pattern.effnum)
+bool PatternUndoJournal::finish(TXMPattern* pattern, 
+								const PatternUndoStackEntry::CursorPosition& cursor, 
+								const UndoStackEntry::UserData& userData,
+								bool merge/* = false*/)
+{
+	PatternUndoStackEntry* entry = new PatternUndoStackEntry(pattern, before, cursorBefore, cursor, &userDataBefore, &userData);
+	
+	if (entry->isEmpty())
+	{
+		delete entry;
+		return false;
+	}
+	
+	// the last change has to be the newest change of this pattern
+	if (merge && numEntries && groupDepth == 0 && !entries[numEntries-1]->undone)
 	{
-		if (memcmp(pattern.patternData, source.pattern.patternData, pattern.len) == 0)
+		PatternUndoStackEntry* last = entries[numEntries-1];
+		size-=last->getSize();
+		bool merged = last->merge(*entry);
+		size+=last->getSize();
+		
+		if (merged)
+		{
+			delete entry;
 			return true;
-		else
-			return false;
+		}
 	}
-	else
-		return false;
+	
+	add(entry);
+	return true;
 }
 
-bool PatternUndoStackEntry::operator!=(const PatternUndoStackEntry& source)
+void PatternUndoJournal::beginGroup()
 {
-	return !(*this==source);
+	if (groupDepth++ == 0)
+		currentGroup = nextGroup++;
+}
+
+void PatternUndoJournal::endGroup()
+{
+	ASSERT(groupDepth > 0);
+	if (groupDepth > 0)
+		groupDepth--;
+}
+
+pp_int32 PatternUndoJournal::findUndo(const TXMPattern* pattern) const
+{
+	for (pp_int32 i = numEntries-1; i >= 0; i--)
+		if (entries[i]->pattern == pattern && !entries[i]->undone)
+			return i;
+	
+	return -1;
+}
+
+pp_int32 PatternUndoJournal::findRedo(const TXMPattern* pattern) const
+{
+	pp_int32 result = -1;
+	// undone changes of a pattern always follow the ones which are still applied
+	for (pp_int32 i = numEntries-1; i >= 0; i--)
+	{
+		if (entries[i]->pattern != pattern)
+			continue;
+		if (!entries[i]->undone)
+			break;
+		result = i;
+	}
+	
+	return result;
+}
+
+void PatternUndoJournal::add(PatternUndoStackEntry* entry)
+{
+	// changes which have been undone can't be redone anymore
+	for (pp_int32 i = numEntries-1; i >= 0; i--)
+		if (entries[i]->pattern == entry->pattern && entries[i]->undone)
+			remove(i);
+
+	if (numEntries == maxEntries)
+	{
+		maxEntries = maxEntries ? maxEntries*2 : 256;
+		PatternUndoStackEntry** newEntries = new PatternUndoStackEntry*[maxEntries];
+		if (numEntries)
+			memcpy(newEntries, entries, numEntries*sizeof(PatternUndoStackEntry*));
+		delete[] entries;
+		entries = newEntries;
+	}
+	
+	entry->group = groupDepth ? currentGroup : nextGroup++;
+	entries[numEntries++] = entry;
+	size+=entry->getSize();
+	
+	while (size > maxSize && numEntries > 1)
+		remove(0);
+}
+
+void PatternUndoJournal::remove(pp_int32 index)
+{
+	size-=entries[index]->getSize();
+	delete entries[index];
+	
+	numEntries--;
+	for (pp_int32 i = index; i < numEntries; i++)
+		entries[i] = entries[i+1];
+}
+
+const PatternUndoStackEntry* PatternUndoJournal::revoke(TXMPattern* pattern, bool undo)
+{
+	pp_int32 index = undo ? findUndo(pattern) : findRedo(pattern);
+	if (index < 0)
+		return NULL;
+		
+	PatternUndoStackEntry* entry = entries[index];
+	if (!entry->apply(undo))
+		return NULL;
+	entry->undone = undo;
+
+	// the other patterns of the group, if nothing has happened to them since
+	for (pp_int32 j = 0; j < numEntries; j++)
+	{
+		// newest first when undoing, oldest first when redoing
+		const pp_int32 i = undo ? numEntries-1-j : j;
+		PatternUndoStackEntry* other = entries[i];
+		if (other->group != entry->group || other->pattern == pattern)
+			continue;
+			
+		if ((undo ? findUndo(other->pattern) : findRedo(other->pattern)) == i &&
+			other->apply(undo))
+			other->undone = undo;
+	}
+	
+	return entry;
+}
+
+const PatternUndoStackEntry* PatternUndoJournal::undo(TXMPattern* pattern)
+{
+	return revoke(pattern, true);
+}
+
+const PatternUndoStackEntry* PatternUndoJournal::redo(TXMPattern* pattern)
+{
+	return revoke(pattern, false);
+}
+
+void PatternUndoJournal::clear()
+{
+	for (pp_int32 i = 0; i < numEntries; i++)
+		delete entries[i];
+	numEntries = 0;
+	size = 0;
+}
+
+void PatternUndoJournal::clear(const TXMPattern* pattern)
+{
+	for (pp_int32 i = numEntries-1; i >= 0; i--)
+		if (entries[i]->pattern == pattern)
+			remove(i);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -229,24 +501,18 @@ void EnvelopeUndoStackEntry::GetEnvelope(TEnvelope& env) const
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //														samples
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-void SampleUndoStackEntry::calcCheckSum()
+// does the chunk overlap the byte range [start, end) of the padded data
+static inline bool chunkOverlaps(pp_uint32 chunkStart, pp_uint32 chunkSize, pp_uint32 start, pp_uint32 end)
 {
-	checkSum = 0;
-	if (!buffer)
-		return;
-	mp_uint32 size = (flags & 16) ? samplen*2 : samplen;
-	if (size)
-	{
-		mp_ubyte* mem = TXMSample::getPadStartAddr(buffer);
-		mp_uint32 realSize = TXMSample::getPaddedSize(size);
-		for (pp_uint32 i = 0; i < realSize; i++)
-			checkSum+=(pp_uint32)mem[i];		
-	}
+	return start < end && chunkStart < end && chunkStart + chunkSize > start;
 }
 
 SampleUndoStackEntry::SampleUndoStackEntry(const TXMSample& sample, 
 										   pp_int32 selectionStart, pp_int32 selectionEnd, 
-										   const UserData* userData/* = NULL*/) :
+										   const UserData* userData/* = NULL*/,
+										   const SampleUndoStackEntry* reference/* = NULL*/,
+										   pp_int32 from/* = -1*/,
+										   pp_int32 to/* = -1*/) :
 	UndoStackEntry(userData)
 {
 	samplen = sample.samplen;
@@ -258,26 +524,69 @@ SampleUndoStackEntry::SampleUndoStackEntry(const TXMSample& sample,
 	this->selectionStart = selectionStart;
 	this->selectionEnd = selectionEnd;
 	
-	buffer = NULL;
-
-	checkSum = 0;
+	chunks = NULL;
+	numChunks = 0;
+	size = 0;
 	
 	if (sample.samplen && sample.sample)
 	{
-		// 16 bit sample
-		if (flags & 16)
+		size = TXMSample::getPaddedSize((flags & 16) ? samplen*2 : samplen);
+		numChunks = (size + ChunkSize - 1) / ChunkSize;
+		chunks = new Chunk*[numChunks];
+		
+		const mp_ubyte* mem = TXMSample::getPadStartAddr((mp_ubyte*)sample.sample);
+		
+		// the range only tells something when the reference has the same layout
+		const bool ranged = reference && from >= 0 && 
+			reference->size == size && (reference->flags & 16) == (flags & 16);
+		
+		// range in bytes of the padded data, rounded outwards by the padding
+		const pp_uint32 shift = (flags & 16) ? 1 : 0;
+		const pp_uint32 padding = TXMSample::getPaddedSize(0);
+		pp_uint32 rangeStart = 0, rangeEnd = 0;
+		if (ranged && from < to)
 		{
-			buffer = TXMSample::allocPaddedMem(samplen*2);
-			if (buffer)
-				TXMSample::copyPaddedMem(buffer, sample.sample, samplen*2);				
+			if (to > (signed)samplen)
+				to = samplen;
+			rangeStart = (pp_uint32)from << shift;
+			rangeEnd = ((pp_uint32)to << shift) + padding;
 		}
-		else
+		
+		// the loop double buffering keeps its state in the leading padding and 
+		// writes behind the loop end while playing, so that's always looked at
+		const pp_uint32 loopEnd = (loopstart + looplen) << shift;
+		const pp_uint32 refLoopEnd = reference ? (reference->loopstart + reference->looplen) << shift : loopEnd;
+		
+		for (pp_uint32 i = 0; i < numChunks; i++)
 		{
-			buffer = TXMSample::allocPaddedMem(samplen);
-			if (buffer)
-				TXMSample::copyPaddedMem(buffer, sample.sample, samplen);
+			const pp_uint32 chunkSize = getChunkSize(i);
+			const mp_ubyte* src = mem + i*ChunkSize;
+			
+			// outside of the range nothing has changed since the reference has been taken
+			if (ranged && i != 0 &&
+				!chunkOverlaps(i*ChunkSize, chunkSize, rangeStart, rangeEnd) &&
+				!chunkOverlaps(i*ChunkSize, chunkSize, loopEnd, loopEnd + padding) &&
+				!chunkOverlaps(i*ChunkSize, chunkSize, refLoopEnd, refLoopEnd + padding))
+			{
+				chunks[i] = reference->chunks[i];
+				chunks[i]->refCount++;
+			}
+			// share what hasn't changed since the reference has been taken
+			else if (reference && i < reference->numChunks && 
+				reference->getChunkSize(i) == chunkSize &&
+				memcmp(reference->chunks[i]->data, src, chunkSize) == 0)
+			{
+				chunks[i] = reference->chunks[i];
+				chunks[i]->refCount++;
+			}
+			else
+			{
+				chunks[i] = new Chunk;
+				chunks[i]->refCount = 1;
+				chunks[i]->data = new pp_uint8[chunkSize];
+				memcpy(chunks[i]->data, src, chunkSize);
+			}
 		}
-		calcCheckSum();
 	}
 }
 
@@ -290,32 +599,107 @@ SampleUndoStackEntry::SampleUndoStackEntry(const SampleUndoStackEntry& src)	:
 	relnote = src.relnote;
 	finetune = src.finetune;
 	flags = src.flags;
-	checkSum = src.checkSum;
 	this->selectionStart = src.selectionStart;
 	this->selectionEnd = src.selectionEnd;
 	
-	buffer = NULL;
-	if (src.buffer && samplen)
-	{	
-		// 16 bit sample
-		if (flags & 16)
-		{			
-			buffer = TXMSample::allocPaddedMem(samplen*2);
-			if (buffer)
-				TXMSample::copyPaddedMem(buffer, src.buffer, samplen*2);
+	chunks = NULL;
+	numChunks = 0;
+	size = 0;
+	copyChunks(src);
+}
+
+SampleUndoStackEntry::~SampleUndoStackEntry()
+{
+	releaseChunks();
+}
+
+void SampleUndoStackEntry::copyChunks(const SampleUndoStackEntry& src)
+{
+	ASSERT(chunks == NULL);
+
+	if (src.chunks == NULL)
+		return;
+
+	numChunks = src.numChunks;
+	size = src.size;
+	chunks = new Chunk*[numChunks];
+	for (pp_uint32 i = 0; i < numChunks; i++)
+	{
+		chunks[i] = src.chunks[i];
+		chunks[i]->refCount++;
+	}
+}
+
+void SampleUndoStackEntry::releaseChunks()
+{
+	for (pp_uint32 i = 0; i < numChunks; i++)
+	{
+		if (--chunks[i]->refCount == 0)
+		{
+			delete[] chunks[i]->data;
+			delete chunks[i];
 		}
-		else
+	}
+	
+	delete[] chunks;
+	chunks = NULL;
+	numChunks = 0;
+	size = 0;
+}
+
+bool SampleUndoStackEntry::getChangedRange(const SampleUndoStackEntry& src, pp_int32& from, pp_int32& to) const
+{
+	if (samplen != src.samplen || (flags & 16) != (src.flags & 16) || 
+		size != src.size || numChunks != src.numChunks)
+		return false;
+
+	from = to = 0;
+	
+	pp_int32 first = -1, last = -1;
+	for (pp_uint32 i = 0; i < numChunks; i++)
+	{
+		if (chunks[i] != src.chunks[i] && 
+			memcmp(chunks[i]->data, src.chunks[i]->data, getChunkSize(i)) != 0)
 		{
-			buffer = TXMSample::allocPaddedMem(samplen);
-			if (buffer)
-				TXMSample::copyPaddedMem(buffer, src.buffer, samplen);
-		}	
+			if (first == -1)
+				first = i;
+			last = i;
+		}
 	}
+	
+	if (first == -1)
+		return true;
+	
+	// chunks hold the padded data, rounding outwards by the padding is good enough
+	const pp_int32 shift = (flags & 16) ? 1 : 0;
+	from = (first*ChunkSize - (pp_int32)TXMSample::getPaddedSize(0)) >> shift;
+	to = (last*ChunkSize + (pp_int32)getChunkSize(last)) >> shift;
+	
+	if (from < 0)
+		from = 0;
+	if (to > (signed)samplen)
+		to = samplen;
+	
+	return true;
 }
 
-SampleUndoStackEntry::~SampleUndoStackEntry()
+pp_uint32 SampleUndoStackEntry::getSize(const SampleUndoStackEntry* src/* = NULL*/) const
+{
+	pp_uint32 result = 0;
+	for (pp_uint32 i = 0; i < numChunks; i++)
+	{
+		if (src == NULL || i >= src->numChunks || chunks[i] != src->chunks[i])
+			result+=getChunkSize(i);
+	}
+	
+	return result;
+}
+
+void SampleUndoStackEntry::copyBuffer(void* dst) const
 {
-	TXMSample::freePaddedMem(buffer);
+	mp_ubyte* mem = TXMSample::getPadStartAddr((mp_ubyte*)dst);
+	for (pp_uint32 i = 0; i < numChunks; i++)
+		memcpy(mem + i*ChunkSize, chunks[i]->data, getChunkSize(i));
 }
 
 // assignment operator
@@ -331,30 +715,11 @@ SampleUndoStackEntry& SampleUndoStackEntry::operator=(const SampleUndoStackEntry
 		relnote = src.relnote;
 		finetune = src.finetune;
 		flags = src.flags;
-		checkSum = src.checkSum;
-		
-		if (buffer)
-		{
-			TXMSample::freePaddedMem(buffer);
-			buffer = NULL;
-		}
+		selectionStart = src.selectionStart;
+		selectionEnd = src.selectionEnd;
 		
-		if (src.buffer && samplen)
-		{	
-			// 16 bit sample
-			if (flags & 16)
-			{
-				buffer = TXMSample::allocPaddedMem(samplen*2);
-				if (buffer)
-					TXMSample::copyPaddedMem(buffer, src.buffer, samplen*2);
-			}
-			else
-			{
-				buffer = TXMSample::allocPaddedMem(samplen);
-				if (buffer)
-					TXMSample::copyPaddedMem(buffer, src.buffer, samplen);
-			}	
-		}
+		releaseChunks();
+		copyChunks(src);
 	}
 
 	return (*this);
@@ -366,9 +731,6 @@ bool SampleUndoStackEntry::operator==(const SampleUndoStackEntry& src)
 	if (samplen != src.samplen)
 		return false;
 		
-	if (checkSum != src.checkSum)
-		return false;
-
 	if (loopstart != src.loopstart)
 		return false;
 		
@@ -384,24 +746,15 @@ bool SampleUndoStackEntry::operator==(const SampleUndoStackEntry& src)
 	if (flags != src.flags)
 		return false;
 	
-	if (buffer == NULL && src.buffer != NULL)
-		return false;
-
-	if (buffer != NULL && src.buffer == NULL)
+	if (size != src.size || numChunks != src.numChunks)
 		return false;
 	
-	mp_uint32 size = (flags & 16) ? samplen*2 : samplen;
-	if (size)
+	// shared chunks are equal without looking at them
+	for (pp_uint32 i = 0; i < numChunks; i++)
 	{
-		mp_ubyte* _src = src.buffer;
-		mp_ubyte* _dst = buffer;
-
-		mp_ubyte* srcmem = TXMSample::getPadStartAddr(_src);
-		mp_ubyte* dstmem = TXMSample::getPadStartAddr(_dst);
-		mp_uint32 realSize = TXMSample::getPaddedSize(size);
-		for (pp_uint32 i = 0; i < realSize; i++)
-			if (srcmem[i] != dstmem[i])
-				return false;
+		if (chunks[i] != src.chunks[i] && 
+			memcmp(chunks[i]->data, src.chunks[i]->data, getChunkSize(i)) != 0)
+			return false;
 	}
 
 	return true;
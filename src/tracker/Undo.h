@@ -30,11 +30,14 @@
 #define UNDODEPTH_ENVELOPEEDITOR		32
 #define UNDOHISTORYSIZE_ENVELOPEEDITOR	8
 
-#define UNDODEPTH_PATTERNEDITOR			32
-#define UNDOHISTORYSIZE_PATTERNEDITOR	8
+// the pattern journal holds the changes of all patterns up to this many bytes
+#define UNDOJOURNALSIZE_PATTERNEDITOR	(16*1024*1024)
 
-#define UNDODEPTH_SAMPLEEDITOR			16
-#define UNDOHISTORYSIZE_SAMPLEEDITOR	4
+// the sample undo stacks together hold up to this many bytes of sample data,
+// the depth and history size only bound the number of entries
+#define UNDOSIZE_SAMPLEEDITOR			(128*1024*1024)
+#define UNDODEPTH_SAMPLEEDITOR			256
+#define UNDOHISTORYSIZE_SAMPLEEDITOR	32
 
 //--- This is what we save --------------------------------------------------
 class UndoStackEntry
@@ -123,42 +126,157 @@ public:
 };
 
 // Undo information from pattern editor
+// One change of one pattern: only the slots which have been changed are kept
+// (old and new contents), unless the layout of the pattern (rows, channels,
+// effects) has changed. The whole pattern is saved compressed in that case.
 class PatternUndoStackEntry : public UndoStackEntry
 {
 public:
-	// Construction (new element)
-	PatternUndoStackEntry(const TXMPattern& pattern, 
-						  const pp_int32 cursorPositionChannel, 
-						  const pp_int32 cursorPositionRow, 
-						  const pp_int32 cursorPositionInner,
-						  const UserData* userData = NULL);
-	// Copy ctor
-	PatternUndoStackEntry(const PatternUndoStackEntry& source);
+	struct CursorPosition
+	{
+		pp_int32 channel, row, inner;
+	};
+
+	// Construction from a copy of the pattern before the change (uncompressed)
+	// and the changed pattern
+	PatternUndoStackEntry(TXMPattern* pattern,
+						  const TXMPattern& before,
+						  const CursorPosition& cursorBefore,
+						  const CursorPosition& cursorAfter,
+						  const UserData* userDataBefore = NULL,
+						  const UserData* userDataAfter = NULL);
 
 	// dtor
 	virtual ~PatternUndoStackEntry();
 
-	// get your pattern
-	const TXMPattern& GetPattern() const { return pattern; }
+	TXMPattern* getPattern() const { return pattern; }
+	pp_uint32 getGroup() const { return group; }
+	bool isUndone() const { return undone; }
 
-	pp_int32 getCursorPositionChannel() const { return cursorPositionChannel; }
-	pp_int32 getCursorPositionRow() const { return cursorPositionRow; }
-	pp_int32 getCursorPositionInner() const { return cursorPositionInner; }
+	// nothing has been changed
+	bool isEmpty() const { return !layoutChanged && numSlots == 0; }
+	// bytes used by this entry
+	pp_uint32 getSize() const;
 
-	// assignment operator
+	const CursorPosition& getCursorPosition(bool before) const { return before ? cursorBefore : cursorAfter; }
+	const UserData& getUserData(bool before) const { return before ? UndoStackEntry::getUserData() : userDataAfter; }
+
+	// put the pattern into the state before (undo) or after (redo) the change,
+	// fails without touching the pattern if it doesn't hold what the change
+	// has left behind (undo) or started from (redo)
+	bool apply(bool undo);
+
+	// a following change of the same pattern becomes part of this one,
+	// this is only possible if both have changed the layout
+	bool merge(const PatternUndoStackEntry& next);
+
+private:
+	struct Layout
+	{
+		mp_uword rows;
+		mp_ubyte channum, effnum;
+
+		bool operator==(const Layout& layout) const { return rows == layout.rows && channum == layout.channum && effnum == layout.effnum; }
+		bool operator!=(const Layout& layout) const { return !(*this == layout); }
+	};
+
+	TXMPattern* pattern;
+	pp_uint32 group;
+	bool undone;
+
+	Layout layoutBefore, layoutAfter;
+	bool layoutChanged;
+
+	CursorPosition cursorBefore, cursorAfter;
+	UserData userDataAfter;
+
+	// layout unchanged: numSlots slot indices followed by the old and new contents of each slot
+	// layout changed: the compressed patterns before (lenBefore bytes) and after
+	mp_ubyte* data;
+	pp_uint32 dataLen;
+	pp_uint32 numSlots;
+	pp_uint32 lenBefore;
+
+	static Layout getLayout(const TXMPattern& pattern);
+
+	// not copyable
+	PatternUndoStackEntry(const PatternUndoStackEntry& source);
 	PatternUndoStackEntry& operator=(const PatternUndoStackEntry& source);
-	
-	// comparison is necessary too
-	bool operator==(const PatternUndoStackEntry& source);
-	bool operator!=(const PatternUndoStackEntry& source);
 
+	friend class PatternUndoJournal;
+};
 
-private:	
-	TXMPattern pattern;
-	
-	pp_int32 cursorPositionChannel;
-	pp_int32 cursorPositionRow;
-	pp_int32 cursorPositionInner;
+// Changes of all patterns of a song in the order they have been made.
+// Every pattern has its own history: undo/redo only revert the changes of the
+// given pattern. Changes of several patterns which are made in one go
+// (a group, e.g. a song wide transpose) are reverted together as long as
+// none of these patterns has been changed afterwards.
+// The oldest changes are thrown away when the journal exceeds its size.
+class PatternUndoJournal
+{
+public:
+	PatternUndoJournal(pp_uint32 maxSize = UNDOJOURNALSIZE_PATTERNEDITOR);
+	~PatternUndoJournal();
+
+	// save the state of a pattern which is about to be changed
+	void prepare(const TXMPattern& pattern, 
+				 const PatternUndoStackEntry::CursorPosition& cursor, 
+				 const UndoStackEntry::UserData& userData);
+	// state saved by the last call to prepare
+	const TXMPattern& getPatternBefore() const { return before; }
+	const PatternUndoStackEntry::CursorPosition& getCursorBefore() const { return cursorBefore; }
+
+	// store the changes since the last call to prepare, returns false if there are none.
+	// The undone changes of the pattern are dropped, with merge set the changes
+	// are added to the last change of the pattern if possible.
+	bool finish(TXMPattern* pattern, 
+				const PatternUndoStackEntry::CursorPosition& cursor, 
+				const UndoStackEntry::UserData& userData,
+				bool merge = false);
+
+	// changes made between beginGroup and endGroup are reverted together
+	void beginGroup();
+	void endGroup();
+
+	bool canUndo(const TXMPattern* pattern) const { return findUndo(pattern) >= 0; }
+	bool canRedo(const TXMPattern* pattern) const { return findRedo(pattern) >= 0; }
+
+	// revert the last change of the pattern, returns the reverted change or NULL
+	const PatternUndoStackEntry* undo(TXMPattern* pattern);
+	// restore the last reverted change of the pattern, returns the change or NULL
+	const PatternUndoStackEntry* redo(TXMPattern* pattern);
+
+	void clear();
+	// drop the changes of one pattern, e.g. when its storage has been replaced
+	void clear(const TXMPattern* pattern);
+
+private:
+	PatternUndoStackEntry** entries;
+	pp_int32 numEntries;
+	pp_int32 maxEntries;
+
+	pp_uint32 size;
+	pp_uint32 maxSize;
+
+	pp_uint32 nextGroup;
+	pp_uint32 currentGroup;
+	pp_int32 groupDepth;
+
+	// pattern before the current change, patternData is uncompressed
+	TXMPattern before;
+	pp_uint32 beforeAllocated;
+	PatternUndoStackEntry::CursorPosition cursorBefore;
+	UndoStackEntry::UserData userDataBefore;
+
+	// newest change of the pattern which hasn't been undone
+	pp_int32 findUndo(const TXMPattern* pattern) const;
+	// oldest change of the pattern which has been undone
+	pp_int32 findRedo(const TXMPattern* pattern) const;
+
+	void add(PatternUndoStackEntry* entry);
+	void remove(pp_int32 index);
+
+	const PatternUndoStackEntry* revoke(TXMPattern* pattern, bool undo);
 };
 
 // Less memory consumption than TEnvelope because XMs can only handle 12 envelope points
@@ -224,18 +342,35 @@ private:
 struct TXMSample;
 
 // Undo information from Sample Editor
+// The sample data is kept in reference counted chunks. A new entry shares
+// every chunk which equals the one of a reference entry (usually the
+// previous state), so an edit only costs the memory of the chunks it touched.
 class SampleUndoStackEntry : public UndoStackEntry
 {
 public:
+	enum
+	{
+		ChunkSize = 65536
+	};
+
 	SampleUndoStackEntry() : 
-		UndoStackEntry(NULL)
+		UndoStackEntry(NULL),
+		chunks(NULL),
+		numChunks(0),
+		size(0)
 	{
 	}
 
+	// from/to is the range of samples which may differ from the reference,
+	// everything outside of it is shared with the reference without looking
+	// at it. Without a range the whole sample is compared.
 	SampleUndoStackEntry(const TXMSample& sample, 
 						 pp_int32 selectionStart, 
 						 pp_int32 selectionEnd, 
-						 const UserData* userData = NULL);
+						 const UserData* userData = NULL,
+						 const SampleUndoStackEntry* reference = NULL,
+						 pp_int32 from = -1,
+						 pp_int32 to = -1);
 						 
 	SampleUndoStackEntry(const SampleUndoStackEntry& src);
 						 
@@ -255,27 +390,63 @@ public:
 	mp_sbyte getRelNote() const { return relnote; }
 	mp_sbyte getFineTune() const { return finetune; }
 	
-	const pp_uint8* getBuffer() const { return buffer; }
+	bool hasBuffer() const { return chunks != NULL; }
+	// range of samples which differ from the given entry, false if the sample layouts differ
+	bool getChangedRange(const SampleUndoStackEntry& src, pp_int32& from, pp_int32& to) const;
+	// copy the saved data including padding into memory from TXMSample::allocPaddedMem
+	void copyBuffer(void* dst) const;
+	// bytes of the chunks which aren't shared with the given entry
+	pp_uint32 getSize(const SampleUndoStackEntry* src = NULL) const;
 	
 	pp_int32 getSelectionStart() const { return selectionStart; }
 	pp_int32 getSelectionEnd() const { return selectionEnd; }
 	
 private:
+	struct Chunk
+	{
+		pp_int32 refCount;
+		pp_uint8* data;
+	};
+
 	// from sample
 	pp_uint32 samplen, loopstart, looplen;
 	mp_sbyte relnote, finetune;
-	pp_uint8* buffer;
 	pp_uint8 flags;
 
+	// padded sample data
+	Chunk** chunks;
+	pp_uint32 numChunks;
+	pp_uint32 size;
+
 	// from sample editor
 	pp_int32 selectionStart;
 	pp_int32 selectionEnd;
 
-	pp_int32 checkSum;
-	
-	void calcCheckSum();
+	pp_uint32 getChunkSize(pp_uint32 index) const
+	{
+		return (index < numChunks-1) ? (pp_uint32)ChunkSize : size - index*ChunkSize;
+	}
+
+	void copyChunks(const SampleUndoStackEntry& src);
+	void releaseChunks();
 };
 
+// bytes held by an undo stack, entries only count what they don't share with the one below
+template<class Type>
+pp_uint32 getUndoStackSize(const PPUndoStack<Type>* undoStack)
+{
+	pp_uint32 size = 0;
+	const Type* below = NULL;
+	for (pp_int32 i = 0; i < undoStack->GetNumEntries(); i++)
+	{
+		const Type* entry = undoStack->GetEntry(i);
+		size+=entry->getSize(below);
+		below = entry;
+	}
+	
+	return size;
+}
+
 // undo history maintainance
 template<class Key, class Type>
 struct HistoryEntry
@@ -371,6 +542,32 @@ public:
 			
 		return NULL;
 	}
+	
+	// bytes held by the saved undo stacks
+	pp_uint32 getSize() const
+	{
+		pp_uint32 size = 0;
+		for (pp_int32 i = 0; i < patternHistoryNumEntries; i++)
+			size+=getUndoStackSize(patternHistory[i].undoStack);
+			
+		return size;
+	}
+	
+	// delete the least recently used undo stack
+	bool removeOldest()
+	{
+		if (patternHistoryNumEntries == 0)
+			return false;
+			
+		delete patternHistory[0].undoStack;
+		for (pp_int32 i = 0; i < patternHistoryNumEntries-1; i++)
+			patternHistory[i] = patternHistory[i+1];
+		
+		patternHistoryNumEntries--;
+		patternHistory[patternHistoryNumEntries].key = NULL;
+		patternHistory[patternHistoryNumEntries].undoStack = NULL;
+		return true;
+	}
 };
 
 #endif
@@ -809,6 +809,9 @@ void initTracker(pp_uint32 bpp, PPDisplayDevice::Orientations orientation,
 	// Start capturing text input events
 	SDL_StartTextInput();
 
+	// From now on the window is only updated once per frame, see the event loop
+	myTrackerScreen->setDeferredUpdates(true);
+
 	ticking = true;
 }
 
@@ -1001,6 +1004,12 @@ unrecognizedCommandLineSwitch:
 				processSDLEvents(event);
 				break;
 		}
+
+		// Show what has been painted once the queue is empty, or once per
+		// frame if events keep coming in
+		globalMutex->lock();
+		myTrackerScreen->flushUpdates(!SDL_HasEvents(SDL_FIRSTEVENT, SDL_LASTEVENT));
+		globalMutex->unlock();
 	}
 
 	ticking = false;